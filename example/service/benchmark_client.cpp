@@ -0,0 +1,95 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <thread>
+#include <vector>
+
+#include <mrpc/service/application.h>
+#include <mrpc/service/global_proxy.h>
+#include <mrpc/util/log.h>
+
+#include "service_example.mrpc.h"
+
+// 对比同一个EchoService在TCP回环、UDP、Unix domain socket(pipe)和共享内存(shm)上的同步调用性能, 以及TCP服务端的libuv和io_uring两种实现.
+// client.json中EchoService走TCP(libuv), EchoServiceUring走TCP(服务端io_uring), EchoServiceUdp走UDP, EchoServicePipe走pipe, EchoServiceShm走shm, 服务端见server.json.
+
+static constexpr int kThreadNum = 4;
+static constexpr int kCallNum = 10000;     // 每个线程的调用次数
+
+static void Benchmark(const std::string& stub_name, size_t data_size)
+{
+    std::atomic<int> failed = 0;
+    std::vector<std::vector<double>> latencies(kThreadNum);   // 每次调用的耗时(微秒)
+    auto start = std::chrono::steady_clock::now();
+
+    std::vector<std::thread> threads;
+    for (int t = 0; t < kThreadNum; ++t)
+    {
+        threads.emplace_back([&, t]()
+        {
+            auto stub = mrpc::GlobalProxy::FindServiceStub<example::EchoServiceStub>(stub_name);
+            example::EchoRequest req;
+            req.data.assign(data_size, 'x');
+            example::EchoResponse rsp;
+            latencies[t].reserve(kCallNum);
+            for (int i = 0; i < kCallNum; ++i)
+            {
+                auto call_start = std::chrono::steady_clock::now();
+                if (stub->Echo(req, rsp) != 0 || rsp.data.size() != data_size)
+                {
+                    ++failed;
+                }
+                latencies[t].push_back(std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - call_start).count());
+            }
+        });
+    }
+    for (auto& thread : threads)
+    {
+        thread.join();
+    }
+
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    int total = kThreadNum * kCallNum;
+
+    std::vector<double> all_latencies;
+    all_latencies.reserve(total);
+    for (const auto& thread_latencies : latencies)
+    {
+        all_latencies.insert(all_latencies.end(), thread_latencies.begin(), thread_latencies.end());
+    }
+    auto p99 = all_latencies.begin() + all_latencies.size() * 99 / 100;
+    std::nth_element(all_latencies.begin(), p99, all_latencies.end());
+
+    printf("%-16s %8zu %10.0f %12.1f %10.1f %8d\n", stub_name.c_str(), data_size, total / seconds, seconds * 1e6 * kThreadNum / total, *p99, failed.load());
+}
+
+int main(int argc, char* argv[])
+{
+    mrpc::Application app;
+    int ret = app.ParseArgs(argc, argv);
+    if (ret != 0)
+    {
+        LOG_ERROR("Parse args error, {}", ret);
+        return ret;
+    }
+
+    ret = app.Initialize();
+    if (ret != 0)
+    {
+        LOG_ERROR("Init error, {}", ret);
+        return ret;
+    }
+
+    printf("%-16s %8s %10s %12s %10s %8s\n", "stub", "bytes", "qps", "latency(us)", "p99(us)", "failed");
+    for (size_t data_size : { 16, 1024, 16384 })
+    {
+        Benchmark("EchoService", data_size);
+        Benchmark("EchoServiceUring", data_size);
+        Benchmark("EchoServiceUdp", data_size);
+        Benchmark("EchoServicePipe", data_size);
+        Benchmark("EchoServiceShm", data_size);
+    }
+
+    app.Finalize();
+    return 0;
+}
@@ -0,0 +1,85 @@
+#include <mrpc/service/application.h>
+#include <mrpc/service/global_proxy.h>
+#include <mrpc/util/log.h>
+#include <mrpc/util/task.h>
+
+#include "service_example.mrpc.h"
+
+// 协程中的调用不阻塞主线程, 回包到达后协程在主线程中恢复.
+// 参数按值传递, 引用在协程第一次挂起之后可能已经失效
+static mrpc::Task<> EchoThenAdd(std::string message, int32_t a, int32_t b)
+{
+    auto echo_stub = mrpc::GlobalProxy::FindServiceStub<example::EchoServiceStub>("EchoService");
+    example::EchoRequest echo_req;
+    echo_req.data = message;
+    example::EchoResponse echo_rsp;
+    int32_t ret = co_await echo_stub->Echo_Co(echo_req, echo_rsp);
+    LOG_INFO("data {}, ret {}", echo_rsp.data, ret);
+    if (ret != 0)
+    {
+        co_return;
+    }
+
+    auto math_stub = mrpc::GlobalProxy::FindServiceStub<example::MathServiceStub>("MathService");
+    example::AddRequest add_req;
+    add_req.a = a;
+    add_req.b = b;
+    example::AddResponse add_rsp;
+    ret = co_await math_stub->Add_Co(add_req, add_rsp);
+    LOG_INFO("{} + {} = {}, ret {}", a, b, add_rsp.sum, ret);
+}
+
+// 同一请求并行发给多个地址, 任意两个成功即完成
+static mrpc::Task<> EchoQuorum(std::string message)
+{
+    const char* names[] = { "EchoService", "EchoServicePipe", "EchoServiceUring" };
+    mrpc::ParallelCall<example::EchoResponse> call(std::size(names));
+    call.SetQuorum(2);
+    call.SetTimeout(1000);
+
+    example::EchoRequest req;
+    req.data = message;
+    for (const char* name : names)
+    {
+        auto stub = mrpc::GlobalProxy::FindServiceStub<example::EchoServiceStub>(name);
+        stub->Echo_Parallel(call, req);
+    }
+
+    size_t success_num = co_await call;
+    const auto& results = call.GetResults();
+    for (size_t i = 0; i < results.size(); ++i)
+    {
+        LOG_INFO("{}: data {}, ret {}", names[i], results[i].rsp.data, results[i].ret);
+    }
+    LOG_INFO("{} of {} succeeded", success_num, results.size());
+}
+
+int main(int argc, char* argv[])
+{
+    mrpc::Application app;
+    int ret = app.ParseArgs(argc, argv);
+    if (ret != 0)
+    {
+        LOG_ERROR("Parse args error, {}", ret);
+        return ret;
+    }
+
+    ret = app.Initialize();
+    if (ret != 0)
+    {
+        LOG_ERROR("Init error, {}", ret);
+        return ret;
+    }
+
+    // 三个协程并发执行
+    const char* message[] = { "Hello!!!", "123456", "OK." };
+    for (int i = 0; i < 3; ++i)
+    {
+        mrpc::Spawn(EchoThenAdd(message[i], i, i * 10));
+    }
+    mrpc::Spawn(EchoQuorum("Parallel"));
+
+    app.MainLoop();
+    app.Finalize();
+    return 0;
+}
@@ -1,4 +1,5 @@
 #include <mrpc/service/application.h>
+#include <mrpc/service/global_proxy.h>
 #include <mrpc/util/log.h>
 
 #include "service_example.mrpc.h"
@@ -23,6 +24,18 @@ class MathServiceImpl : public example::MathService
     }
 };
 
+class EchoRelayServiceImpl : public example::EchoRelayService
+{
+    // 等待下游回包时worker线程继续处理其他请求
+    mrpc::Task<int32_t> Echo(const example::EchoRequest& req, example::EchoResponse& rsp) override
+    {
+        auto stub = mrpc::GlobalProxy::FindServiceStub<example::EchoServiceStub>("EchoService");
+        int32_t ret = co_await stub->Echo_Co(req, rsp);
+        LOG_DEBUG("Relay msg, {}, ret {}", rsp.data, ret);
+        co_return ret;
+    }
+};
+
 void Loop(uint64_t now)
 {
     (void)now;
@@ -41,6 +54,7 @@ int main(int argc, char* argv[])
 
     app.RegisterService<EchoServiceImpl>("EchoService");
     app.RegisterService<MathServiceImpl>("MathService");
+    app.RegisterService<EchoRelayServiceImpl>("EchoRelayService");
     app.RegisterLoopCallback(Loop);
 
     ret = app.Initialize();
@@ -1,45 +1,97 @@
+#include <algorithm>
+#include <atomic>
 #include <cassert>
+#include <memory>
+#include <mutex>
 #include <unordered_map>
 #include <mrpc/message/descriptor.h>
 
 namespace mrpc
 {
 
+static constexpr size_t kMaxDenseFieldNumber = 1024;
+
 class DescriptorPoolImpl
 {
 public:
-    const Descriptor* FindDescriptorByFullName(std::string_view full_name) const;
+    const Descriptor* FindDescriptorByFullName(std::string_view full_name);
     void AddDescriptorByFullName(std::string_view full_name, const Descriptor* descriptor);
+    void Freeze();
 
     static DescriptorPoolImpl* GetInstance();
 
 private:
-    std::unordered_map<std::string_view, const Descriptor*> pool_;
-    static DescriptorPoolImpl* instance_;
-};
+    // 只读索引, 发布后不再修改, 查找时无需加锁.
+    struct Snapshot
+    {
+        uint64_t version = 0;
+        std::unordered_map<std::string_view, const Descriptor*> index;
+    };
 
-DescriptorPoolImpl* DescriptorPoolImpl::instance_ = nullptr;
+    std::mutex mutex_;
+    std::vector<std::pair<std::string_view, const Descriptor*>> registered_;
+    std::vector<std::unique_ptr<Snapshot>> snapshots_;  // 旧索引可能仍被其他线程读取, 不释放
+    std::atomic<uint64_t> version_ = 0;
+    std::atomic<const Snapshot*> snapshot_ = nullptr;
+
+    const Snapshot* Rebuild();
+};
 
 DescriptorPoolImpl* DescriptorPoolImpl::GetInstance()
 {
-    if (instance_ == nullptr)
-    {
-        instance_ = new DescriptorPoolImpl;
-    }
-    return instance_;
+    // 静态初始化阶段就会被调用, 不析构以免依赖各编译单元的析构顺序.
+    static DescriptorPoolImpl* instance = new DescriptorPoolImpl;
+    return instance;
 }
 
-const Descriptor* DescriptorPoolImpl::FindDescriptorByFullName(std::string_view full_name) const
+const Descriptor* DescriptorPoolImpl::FindDescriptorByFullName(std::string_view full_name)
 {
-    auto it = pool_.find(full_name);
-    if (it == pool_.end()) return nullptr;
+    const Snapshot* snapshot = snapshot_.load(std::memory_order_acquire);
+    if (snapshot == nullptr || snapshot->version != version_.load(std::memory_order_acquire))
+    {
+        snapshot = Rebuild();
+    }
+
+    auto it = snapshot->index.find(full_name);
+    if (it == snapshot->index.end()) return nullptr;
     return it->second;
 }
 
 void DescriptorPoolImpl::AddDescriptorByFullName(std::string_view full_name, const Descriptor* descriptor)
 {
-    assert(pool_.find(full_name) == pool_.end());
-    pool_.emplace(full_name, descriptor);
+    std::lock_guard<std::mutex> lock(mutex_);
+    registered_.emplace_back(full_name, descriptor);
+    version_.fetch_add(1, std::memory_order_release);
+}
+
+void DescriptorPoolImpl::Freeze()
+{
+    Rebuild();
+}
+
+const DescriptorPoolImpl::Snapshot* DescriptorPoolImpl::Rebuild()
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    const Snapshot* current = snapshot_.load(std::memory_order_acquire);
+    uint64_t version = version_.load(std::memory_order_acquire);
+    if (current != nullptr && current->version == version)
+    {
+        return current;
+    }
+
+    std::unique_ptr<Snapshot> snapshot(new Snapshot);
+    snapshot->version = version;
+    snapshot->index.reserve(registered_.size());
+    for (auto& [full_name, descriptor] : registered_)
+    {
+        bool inserted = snapshot->index.emplace(full_name, descriptor).second;
+        (void)inserted;
+        assert(inserted);
+    }
+
+    snapshot_.store(snapshot.get(), std::memory_order_release);
+    snapshots_.emplace_back(std::move(snapshot));
+    return snapshots_.back().get();
 }
 
 EnumDescriptor::EnumDescriptor(std::string_view name,
@@ -57,11 +109,76 @@ EnumDescriptor::EnumDescriptor(std::string_view name,
 
 Descriptor::Descriptor(std::string_view name,
         std::string_view full_name,
-        std::initializer_list<const FieldDescriptor*> fields) :
+        std::initializer_list<const FieldDescriptor*> fields,
+        std::initializer_list<PodRun> pod_runs) :
     name_(name),
     full_name_(full_name),
     fields_(fields)
 {
+    int32_t max_number = 0;
+    for (auto& field : fields_)
+    {
+        max_number = std::max(max_number, field->GetNumber());
+    }
+
+    if (static_cast<size_t>(max_number) <= std::max(fields_.size() * 2, kMaxDenseFieldNumber))
+    {
+        fields_by_number_.resize(max_number + 1, nullptr);
+        for (auto& field : fields_)
+        {
+            fields_by_number_[field->GetNumber()] = field;
+        }
+    }
+
+    // 插件给出的区间可能包含字段间的填充, 按字段偏移重新拆分, 保证memcmp的结果与逐字段比较一致.
+    std::vector<const FieldDescriptor*> scalar_fields;
+    for (auto& field : fields_)
+    {
+        if (field->GetSize() > 0) scalar_fields.push_back(field);
+    }
+    std::sort(scalar_fields.begin(), scalar_fields.end(), [](const FieldDescriptor* a, const FieldDescriptor* b)
+    {
+        return a->GetOffset() < b->GetOffset();
+    });
+
+    pod_run_field_begins_.push_back(0);
+    PodRun current;
+    auto flush = [this, &current]()
+    {
+        if (current.size == 0) return;
+        pod_runs_.push_back(current);
+        pod_run_field_begins_.push_back(pod_run_fields_.size());
+        current = PodRun();
+    };
+    for (auto& run : pod_runs)
+    {
+        for (auto& field : scalar_fields)
+        {
+            if (field->GetOffset() < run.offset || field->GetOffset() >= run.offset + run.size) continue;
+            assert(field->GetOffset() + field->GetSize() <= run.offset + run.size);
+
+            if (current.size > 0 && current.offset + current.size != field->GetOffset())
+            {
+                flush();
+            }
+            if (current.size == 0)
+            {
+                current.offset = field->GetOffset();
+            }
+            current.size += field->GetSize();
+            pod_run_fields_.push_back(field);
+        }
+        flush();
+    }
+
+    for (auto& field : fields_)
+    {
+        if (std::find(pod_run_fields_.begin(), pod_run_fields_.end(), field) == pod_run_fields_.end())
+        {
+            non_pod_fields_.push_back(field);
+        }
+    }
+
     DescriptorPoolImpl::GetInstance()->AddDescriptorByFullName(full_name_, this);
 }
 
@@ -77,95 +194,161 @@ const FieldDescriptor* Descriptor::FindFieldByName(std::string_view name) const
     return nullptr;
 }
 
+const FieldDescriptor* Descriptor::FindFieldByNumber(int32_t number) const
+{
+    if (!fields_by_number_.empty())
+    {
+        if (number <= 0 || static_cast<size_t>(number) >= fields_by_number_.size()) return nullptr;
+        return fields_by_number_[number];
+    }
+
+    for (auto& field : fields_)
+    {
+        if (field->GetNumber() == number)
+        {
+            return field;
+        }
+    }
+    return nullptr;
+}
+
+std::span<const FieldDescriptor* const> Descriptor::GetPodRunFields(size_t index) const
+{
+    assert(index < pod_runs_.size());
+    return std::span<const FieldDescriptor* const>(pod_run_fields_.data() + pod_run_field_begins_[index],
+            pod_run_field_begins_[index + 1] - pod_run_field_begins_[index]);
+}
+
 FieldDescriptor::FieldDescriptor(std::string_view name,
+        int32_t number,
         CppType cpp_type,
+        FieldType field_type,
         size_t offset) :
     name_(name),
+    number_(number),
     cpp_type_(cpp_type),
+    field_type_(field_type),
     offset_(offset)
 {
 }
 
+size_t FieldDescriptor::GetSize() const
+{
+    switch (cpp_type_)
+    {
+        case CPPTYPE_INT32:
+        case CPPTYPE_UINT32:
+        case CPPTYPE_ENUM:
+            return sizeof(int32_t);
+        case CPPTYPE_INT64:
+        case CPPTYPE_UINT64:
+            return sizeof(int64_t);
+        case CPPTYPE_FLOAT:
+            return sizeof(float);
+        case CPPTYPE_DOUBLE:
+            return sizeof(double);
+        case CPPTYPE_BOOL:
+            return sizeof(bool);
+        default:
+            return 0;
+    }
+}
+
 EnumFieldDescriptor::EnumFieldDescriptor(std::string_view name,
+        int32_t number,
         CppType cpp_type,
         size_t offset,
         const EnumDescriptor* enum_descriptor) :
-    FieldDescriptor(name, cpp_type, offset),
+    FieldDescriptor(name, number, cpp_type, TYPE_VAR_INT32, offset),
     enum_descriptor_(enum_descriptor)
 {
 }
 
 MessageFieldDescriptor::MessageFieldDescriptor(std::string_view name,
+        int32_t number,
         CppType cpp_type,
         size_t offset,
         const Descriptor* descriptor) :
-    FieldDescriptor(name, cpp_type, offset),
+    FieldDescriptor(name, number, cpp_type, TYPE_MESSAGE, offset),
     descriptor_(descriptor)
 {
 }
 
 RepeatedFieldDescriptor::RepeatedFieldDescriptor(std::string_view name,
+        int32_t number,
         CppType cpp_type,
         size_t offset,
-        CppType value_cpp_type) :
-    FieldDescriptor(name, cpp_type, offset),
+        CppType value_cpp_type,
+        FieldType value_field_type) :
+    FieldDescriptor(name, number, cpp_type, value_field_type, offset),
     value_cpp_type_(value_cpp_type)
 {
 }
 
 RepeatedFieldDescriptor::RepeatedFieldDescriptor(std::string_view name,
+        int32_t number,
         CppType cpp_type,
         size_t offset,
         CppType value_cpp_type,
+        FieldType value_field_type,
         const EnumDescriptor* enum_descriptor) :
-    RepeatedFieldDescriptor(name, cpp_type, offset, value_cpp_type)
+    RepeatedFieldDescriptor(name, number, cpp_type, offset, value_cpp_type, value_field_type)
 {
     enum_descriptor_ = enum_descriptor;
 }
 
 RepeatedFieldDescriptor::RepeatedFieldDescriptor(std::string_view name,
+        int32_t number,
         CppType cpp_type,
         size_t offset,
         CppType value_cpp_type,
+        FieldType value_field_type,
         const Descriptor* descriptor) :
-    RepeatedFieldDescriptor(name, cpp_type, offset, value_cpp_type)
+    RepeatedFieldDescriptor(name, number, cpp_type, offset, value_cpp_type, value_field_type)
 {
     descriptor_ = descriptor;
 }
 
 MapFieldDescriptor::MapFieldDescriptor(std::string_view name,
+        int32_t number,
         CppType cpp_type,
         size_t offset,
         CppType key_cpp_type,
-        CppType value_cpp_type) :
-    FieldDescriptor(name, cpp_type, offset),
+        FieldType key_field_type,
+        CppType value_cpp_type,
+        FieldType value_field_type) :
+    FieldDescriptor(name, number, cpp_type, TYPE_MESSAGE, offset),
     key_cpp_type_(key_cpp_type),
-    value_cpp_type_(value_cpp_type)
+    key_field_type_(key_field_type),
+    value_cpp_type_(value_cpp_type),
+    value_field_type_(value_field_type)
 {
 }
 
 MapFieldDescriptor::MapFieldDescriptor(std::string_view name,
+        int32_t number,
         CppType cpp_type,
         size_t offset,
         CppType key_cpp_type,
+        FieldType key_field_type,
         CppType value_cpp_type,
+        FieldType value_field_type,
         const EnumDescriptor* enum_descriptor) :
-    FieldDescriptor(name, cpp_type, offset),
-    key_cpp_type_(key_cpp_type),
-    value_cpp_type_(value_cpp_type)
+    MapFieldDescriptor(name, number, cpp_type, offset, key_cpp_type, key_field_type, value_cpp_type, value_field_type)
 {
     enum_descriptor_ = enum_descriptor;
 }
 
 MapFieldDescriptor::MapFieldDescriptor(std::string_view name,
+        int32_t number,
         CppType cpp_type,
         size_t offset,
         CppType key_cpp_type,
+        FieldType key_field_type,
         CppType value_cpp_type,
+        FieldType value_field_type,
         const Descriptor* descriptor) :
-    FieldDescriptor(name, cpp_type, offset),
-    key_cpp_type_(key_cpp_type),
-    value_cpp_type_(value_cpp_type)
+    MapFieldDescriptor(name, number, cpp_type, offset, key_cpp_type, key_field_type, value_cpp_type, value_field_type)
 {
     descriptor_ = descriptor;
 }
@@ -175,4 +358,9 @@ const Descriptor* DescriptorPool::FindDescriptorByFullName(std::string_view full
     return DescriptorPoolImpl::GetInstance()->FindDescriptorByFullName(full_name);
 }
 
+void DescriptorPool::Freeze()
+{
+    DescriptorPoolImpl::GetInstance()->Freeze();
+}
+
 }
@@ -2,10 +2,12 @@
 
 #include <cstdint>
 #include <initializer_list>
+#include <span>
 #include <string_view>
 #include <vector>
 
 #include <mrpc/message/common.mrpc.h>
+#include <mrpc/message/field_type.h>
 #include <mrpc/message/message.h>
 
 namespace mrpc
@@ -38,12 +40,21 @@ private:
     bool (*name_parser_)(std::string_view, int32_t&);
 };
 
+// 内存中连续且默认值为0的一段标量字段, 可以整体memcpy/memcmp/memset.
+struct PodRun
+{
+    size_t offset = 0;
+    size_t size = 0;
+};
+
 class Descriptor
 {
 public:
+    // pod_runs由protoc插件按字段声明顺序给出, 构造时会在字段间的填充处拆分.
     Descriptor(std::string_view name,
             std::string_view full_name,
-            std::initializer_list<const FieldDescriptor*> fields);
+            std::initializer_list<const FieldDescriptor*> fields,
+            std::initializer_list<PodRun> pod_runs = {});
     virtual ~Descriptor() = default;
 
     inline std::string_view GetName() const { return name_; }
@@ -51,31 +62,55 @@ public:
     inline const std::vector<const FieldDescriptor*>& GetFields() const { return fields_; }
 
     const FieldDescriptor* FindFieldByName(std::string_view name) const;
+    const FieldDescriptor* FindFieldByNumber(int32_t number) const;
+
+    inline const std::vector<PodRun>& GetPodRuns() const { return pod_runs_; }
+    // 第index个PodRun内的字段, 按偏移排序.
+    std::span<const FieldDescriptor* const> GetPodRunFields(size_t index) const;
+    // 不在任何PodRun内的字段.
+    inline const std::vector<const FieldDescriptor*>& GetNonPodFields() const { return non_pod_fields_; }
 
     virtual Message* New() const = 0;
     virtual Message* Clone(const Message& msg) const = 0;
+    // 所有字段都是声明的默认值(proto2可以不为0)的消息.
+    virtual const Message& GetDefaultInstance() const = 0;
 
 private:
     std::string_view name_;
     std::string_view full_name_;
     std::vector<const FieldDescriptor*> fields_;
+    std::vector<PodRun> pod_runs_;
+    std::vector<const FieldDescriptor*> pod_run_fields_;
+    std::vector<size_t> pod_run_field_begins_;  // 大小为pod_runs_.size() + 1
+    std::vector<const FieldDescriptor*> non_pod_fields_;
+    // 以字段编号为下标的解析表, 字段编号过于稀疏时为空.
+    std::vector<const FieldDescriptor*> fields_by_number_;
 };
 
 class FieldDescriptor
 {
 public:
     FieldDescriptor(std::string_view name,
+            int32_t number,
             CppType cpp_type,
+            FieldType field_type,
             size_t offset);
     virtual ~FieldDescriptor() = default;
 
     inline std::string_view GetName() const { return name_; }
+    inline int32_t GetNumber() const { return number_; }
     inline CppType GetCppType() const { return cpp_type_; }
+    inline FieldType GetFieldType() const { return field_type_; }
+    inline WireType GetWireType() const { return FieldTypeToWireType(field_type_); }
     inline size_t GetOffset() const { return offset_; }
+    // 标量字段在消息中占用的字节数, 其他字段为0.
+    size_t GetSize() const;
 
 private:
     std::string_view name_;
+    int32_t number_ = 0;
     CppType cpp_type_ = CPPTYPE_UNKNOWN;
+    FieldType field_type_ = TYPE_UNKNOWN;
     size_t offset_ = 0;
 };
 
@@ -83,6 +118,7 @@ class EnumFieldDescriptor : public FieldDescriptor
 {
 public:
     EnumFieldDescriptor(std::string_view name,
+            int32_t number,
             CppType cpp_type,
             size_t offset,
             const EnumDescriptor* enum_descriptor);
@@ -97,6 +133,7 @@ class MessageFieldDescriptor : public FieldDescriptor
 {
 public:
     MessageFieldDescriptor(std::string_view name,
+            int32_t number,
             CppType cpp_type,
             size_t offset,
             const Descriptor* descriptor);
@@ -130,25 +167,40 @@ public:
     };
 
     RepeatedFieldDescriptor(std::string_view name,
+            int32_t number,
             CppType cpp_type,
             size_t offset,
-            CppType value_cpp_type);
+            CppType value_cpp_type,
+            FieldType value_field_type);
     RepeatedFieldDescriptor(std::string_view name,
+            int32_t number,
             CppType cpp_type,
             size_t offset,
             CppType value_cpp_type,
+            FieldType value_field_type,
             const EnumDescriptor* enum_descriptor);
     RepeatedFieldDescriptor(std::string_view name,
+            int32_t number,
             CppType cpp_type,
             size_t offset,
             CppType value_cpp_type,
+            FieldType value_field_type,
             const Descriptor* descriptor);
 
     inline CppType GetValueCppType() const { return value_cpp_type_; }
+    inline FieldType GetValueFieldType() const { return GetFieldType(); }
     inline const EnumDescriptor* GetEnumDescriptor() const { return enum_descriptor_; }
     inline const Descriptor* GetDescriptor() const { return descriptor_; }
 
+    // 迭代器的最大尺寸, 可以在栈上构造迭代器(见Reflection::RepeatedStackIterator).
+    static constexpr size_t kIteratorBufferSize = 4 * sizeof(void*);
+
     virtual Iterator* NewIterator(const Message& msg) const = 0;
+    // 在buffer上构造迭代器, 不分配内存, 由调用方析构.
+    virtual Iterator* NewIterator(const Message& msg, void* buffer) const = 0;
+
+    virtual size_t Size(const Message& msg) const = 0;
+    virtual void Resize(Message& msg, size_t size) const = 0;
 
     template<typename T>
     inline T& Add(Message& msg) const
@@ -198,29 +250,47 @@ public:
     };
 
     MapFieldDescriptor(std::string_view name,
+            int32_t number,
             CppType cpp_type,
             size_t offset,
             CppType key_cpp_type,
-            CppType value_cpp_type);
+            FieldType key_field_type,
+            CppType value_cpp_type,
+            FieldType value_field_type);
     MapFieldDescriptor(std::string_view name,
+            int32_t number,
             CppType cpp_type,
             size_t offset,
             CppType key_cpp_type,
+            FieldType key_field_type,
             CppType value_cpp_type,
+            FieldType value_field_type,
             const EnumDescriptor* enum_descriptor);
     MapFieldDescriptor(std::string_view name,
+            int32_t number,
             CppType cpp_type,
             size_t offset,
             CppType key_cpp_type,
+            FieldType key_field_type,
             CppType value_cpp_type,
+            FieldType value_field_type,
             const Descriptor* descriptor);
 
     inline CppType GetKeyCppType() const { return key_cpp_type_; }
+    inline FieldType GetKeyFieldType() const { return key_field_type_; }
     inline CppType GetValueCppType() const { return value_cpp_type_; }
+    inline FieldType GetValueFieldType() const { return value_field_type_; }
     inline const EnumDescriptor* GetEnumDescriptor() const { return enum_descriptor_; }
     inline const Descriptor* GetDescriptor() const { return descriptor_; }
 
+    // 迭代器的最大尺寸, 可以在栈上构造迭代器(见Reflection::MapStackIterator).
+    static constexpr size_t kIteratorBufferSize = 4 * sizeof(void*);
+
     virtual Iterator* NewIterator(const Message& msg) const = 0;
+    // 在buffer上构造迭代器, 不分配内存, 由调用方析构.
+    virtual Iterator* NewIterator(const Message& msg, void* buffer) const = 0;
+
+    virtual size_t Size(const Message& msg) const = 0;
 
     template<typename K, typename V>
     inline V* Find(Message& msg, const K& key, bool create_if_not_exist) const
@@ -228,12 +298,28 @@ public:
         return reinterpret_cast<V*>(FindDataPtr(msg, &key, create_if_not_exist));
     }
 
+    template<typename K, typename V>
+    inline const V* Find(const Message& msg, const K& key) const
+    {
+        // create_if_not_exist为false时不会修改msg
+        return reinterpret_cast<const V*>(FindDataPtr(const_cast<Message&>(msg), &key, false));
+    }
+
+    template<typename K>
+    inline bool Erase(Message& msg, const K& key) const
+    {
+        return EraseDataPtr(msg, &key);
+    }
+
 protected:
     virtual void* FindDataPtr(Message& msg, const void* key, bool create_if_not_exist) const = 0;
+    virtual bool EraseDataPtr(Message& msg, const void* key) const = 0;
 
 private:
     CppType key_cpp_type_ = CPPTYPE_UNKNOWN;
+    FieldType key_field_type_ = TYPE_UNKNOWN;
     CppType value_cpp_type_ = CPPTYPE_UNKNOWN;
+    FieldType value_field_type_ = TYPE_UNKNOWN;
     union
     {
         const EnumDescriptor* enum_descriptor_ = nullptr;
@@ -241,10 +327,14 @@ private:
     };
 };
 
+// 描述符在静态初始化阶段注册, 查找使用只读索引, 不加锁.
 class DescriptorPool final
 {
 public:
     static const Descriptor* FindDescriptorByFullName(std::string_view full_name);
+
+    // 启动完成后建立索引. 之后注册的描述符(如dlopen加载的库)会在下次查找时重建索引.
+    static void Freeze();
 };
 
 }
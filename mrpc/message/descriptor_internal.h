@@ -1,5 +1,6 @@
 #pragma once
 
+#include <new>
 #include <vector>
 #include <list>
 #include <map>
@@ -24,17 +25,20 @@ class DescriptorImpl : public Descriptor
 public:
     DescriptorImpl(std::string_view name,
             std::string_view full_name,
-            std::initializer_list<const FieldDescriptor*> fields);
+            std::initializer_list<const FieldDescriptor*> fields,
+            std::initializer_list<PodRun> pod_runs = {});
 
     Message* New() const override;
     Message* Clone(const Message& msg) const override;
+    const Message& GetDefaultInstance() const override;
 };
 
 template<typename T>
 DescriptorImpl<T>::DescriptorImpl(std::string_view name,
         std::string_view full_name,
-        std::initializer_list<const FieldDescriptor*> fields) :
-    Descriptor(name, full_name, fields)
+        std::initializer_list<const FieldDescriptor*> fields,
+        std::initializer_list<PodRun> pod_runs) :
+    Descriptor(name, full_name, fields, pod_runs)
 {
 }
 
@@ -53,6 +57,13 @@ Message* DescriptorImpl<T>::Clone(const Message& msg) const
     return new T(*t);
 }
 
+template<typename T>
+const Message& DescriptorImpl<T>::GetDefaultInstance() const
+{
+    static const T t;
+    return t;
+}
+
 template<typename T>
 class VectorFieldDescriptorImpl : public RepeatedFieldDescriptor
 {
@@ -73,21 +84,31 @@ public:
     };
 
     VectorFieldDescriptorImpl(std::string_view name,
+            int32_t number,
             CppType cpp_type,
             size_t offset,
-            CppType value_cpp_type);
+            CppType value_cpp_type,
+            FieldType value_field_type);
     VectorFieldDescriptorImpl(std::string_view name,
+            int32_t number,
             CppType cpp_type,
             size_t offset,
             CppType value_cpp_type,
+            FieldType value_field_type,
             const EnumDescriptor* enum_descriptor);
     VectorFieldDescriptorImpl(std::string_view name,
+            int32_t number,
             CppType cpp_type,
             size_t offset,
             CppType value_cpp_type,
+            FieldType value_field_type,
             const Descriptor* descriptor);
 
     Iterator* NewIterator(const Message& msg) const override;
+    Iterator* NewIterator(const Message& msg, void* buffer) const override;
+
+    size_t Size(const Message& msg) const override;
+    void Resize(Message& msg, size_t size) const override;
 
 protected:
     void* AddDataPtr(Message& msg) const override;
@@ -119,30 +140,36 @@ const void* VectorFieldDescriptorImpl<T>::IteratorImpl::GetDataPtr() const
 
 template<typename T>
 VectorFieldDescriptorImpl<T>::VectorFieldDescriptorImpl(std::string_view name,
+        int32_t number,
         CppType cpp_type,
         size_t offset,
-        CppType value_cpp_type) :
-    RepeatedFieldDescriptor(name, cpp_type, offset, value_cpp_type)
+        CppType value_cpp_type,
+        FieldType value_field_type) :
+    RepeatedFieldDescriptor(name, number, cpp_type, offset, value_cpp_type, value_field_type)
 {
 }
 
 template<typename T>
 VectorFieldDescriptorImpl<T>::VectorFieldDescriptorImpl(std::string_view name,
+        int32_t number,
         CppType cpp_type,
         size_t offset,
         CppType value_cpp_type,
+        FieldType value_field_type,
         const EnumDescriptor* enum_descriptor) :
-    RepeatedFieldDescriptor(name, cpp_type, offset, value_cpp_type, enum_descriptor)
+    RepeatedFieldDescriptor(name, number, cpp_type, offset, value_cpp_type, value_field_type, enum_descriptor)
 {
 }
 
 template<typename T>
 VectorFieldDescriptorImpl<T>::VectorFieldDescriptorImpl(std::string_view name,
+        int32_t number,
         CppType cpp_type,
         size_t offset,
         CppType value_cpp_type,
+        FieldType value_field_type,
         const Descriptor* descriptor) :
-    RepeatedFieldDescriptor(name, cpp_type, offset, value_cpp_type, descriptor)
+    RepeatedFieldDescriptor(name, number, cpp_type, offset, value_cpp_type, value_field_type, descriptor)
 {
 }
 
@@ -153,6 +180,28 @@ RepeatedFieldDescriptor::Iterator* VectorFieldDescriptorImpl<T>::NewIterator(con
     return new IteratorImpl(*c);
 }
 
+template<typename T>
+RepeatedFieldDescriptor::Iterator* VectorFieldDescriptorImpl<T>::NewIterator(const Message& msg, void* buffer) const
+{
+    static_assert(sizeof(IteratorImpl) <= kIteratorBufferSize);
+    const std::vector<T>* c = reinterpret_cast<const std::vector<T>*>(reinterpret_cast<const char*>(&msg) + this->GetOffset());
+    return new (buffer) IteratorImpl(*c);
+}
+
+template<typename T>
+size_t VectorFieldDescriptorImpl<T>::Size(const Message& msg) const
+{
+    const std::vector<T>* c = reinterpret_cast<const std::vector<T>*>(reinterpret_cast<const char*>(&msg) + this->GetOffset());
+    return c->size();
+}
+
+template<typename T>
+void VectorFieldDescriptorImpl<T>::Resize(Message& msg, size_t size) const
+{
+    std::vector<T>* c = reinterpret_cast<std::vector<T>*>(reinterpret_cast<char*>(&msg) + this->GetOffset());
+    c->resize(size);
+}
+
 template<typename T>
 void* VectorFieldDescriptorImpl<T>::AddDataPtr(Message& msg) const
 {
@@ -180,21 +229,31 @@ public:
     };
 
     ListFieldDescriptorImpl(std::string_view name,
+            int32_t number,
             CppType cpp_type,
             size_t offset,
-            CppType value_cpp_type);
+            CppType value_cpp_type,
+            FieldType value_field_type);
     ListFieldDescriptorImpl(std::string_view name,
+            int32_t number,
             CppType cpp_type,
             size_t offset,
             CppType value_cpp_type,
+            FieldType value_field_type,
             const EnumDescriptor* enum_descriptor);
     ListFieldDescriptorImpl(std::string_view name,
+            int32_t number,
             CppType cpp_type,
             size_t offset,
             CppType value_cpp_type,
+            FieldType value_field_type,
             const Descriptor* descriptor);
 
     Iterator* NewIterator(const Message& msg) const override;
+    Iterator* NewIterator(const Message& msg, void* buffer) const override;
+
+    size_t Size(const Message& msg) const override;
+    void Resize(Message& msg, size_t size) const override;
 
 protected:
     void* AddDataPtr(Message& msg) const override;
@@ -226,30 +285,36 @@ const void* ListFieldDescriptorImpl<T>::IteratorImpl::GetDataPtr() const
 
 template<typename T>
 ListFieldDescriptorImpl<T>::ListFieldDescriptorImpl(std::string_view name,
+        int32_t number,
         CppType cpp_type,
         size_t offset,
-        CppType value_cpp_type) :
-    RepeatedFieldDescriptor(name, cpp_type, offset, value_cpp_type)
+        CppType value_cpp_type,
+        FieldType value_field_type) :
+    RepeatedFieldDescriptor(name, number, cpp_type, offset, value_cpp_type, value_field_type)
 {
 }
 
 template<typename T>
 ListFieldDescriptorImpl<T>::ListFieldDescriptorImpl(std::string_view name,
+        int32_t number,
         CppType cpp_type,
         size_t offset,
         CppType value_cpp_type,
+        FieldType value_field_type,
         const EnumDescriptor* enum_descriptor) :
-    RepeatedFieldDescriptor(name, cpp_type, offset, value_cpp_type, enum_descriptor)
+    RepeatedFieldDescriptor(name, number, cpp_type, offset, value_cpp_type, value_field_type, enum_descriptor)
 {
 }
 
 template<typename T>
 ListFieldDescriptorImpl<T>::ListFieldDescriptorImpl(std::string_view name,
+        int32_t number,
         CppType cpp_type,
         size_t offset,
         CppType value_cpp_type,
+        FieldType value_field_type,
         const Descriptor* descriptor) :
-    RepeatedFieldDescriptor(name, cpp_type, offset, value_cpp_type, descriptor)
+    RepeatedFieldDescriptor(name, number, cpp_type, offset, value_cpp_type, value_field_type, descriptor)
 {
 }
 
@@ -260,6 +325,28 @@ RepeatedFieldDescriptor::Iterator* ListFieldDescriptorImpl<T>::NewIterator(const
     return new IteratorImpl(*c);
 }
 
+template<typename T>
+RepeatedFieldDescriptor::Iterator* ListFieldDescriptorImpl<T>::NewIterator(const Message& msg, void* buffer) const
+{
+    static_assert(sizeof(IteratorImpl) <= kIteratorBufferSize);
+    const std::list<T>* c = reinterpret_cast<const std::list<T>*>(reinterpret_cast<const char*>(&msg) + this->GetOffset());
+    return new (buffer) IteratorImpl(*c);
+}
+
+template<typename T>
+size_t ListFieldDescriptorImpl<T>::Size(const Message& msg) const
+{
+    const std::list<T>* c = reinterpret_cast<const std::list<T>*>(reinterpret_cast<const char*>(&msg) + this->GetOffset());
+    return c->size();
+}
+
+template<typename T>
+void ListFieldDescriptorImpl<T>::Resize(Message& msg, size_t size) const
+{
+    std::list<T>* c = reinterpret_cast<std::list<T>*>(reinterpret_cast<char*>(&msg) + this->GetOffset());
+    c->resize(size);
+}
+
 template<typename T>
 void* ListFieldDescriptorImpl<T>::AddDataPtr(Message& msg) const
 {
@@ -288,27 +375,40 @@ public:
     };
 
     MapFieldDescriptorImpl(std::string_view name,
+            int32_t number,
             CppType cpp_type,
             size_t offset,
             CppType key_cpp_type,
-            CppType value_cpp_type);
+            FieldType key_field_type,
+            CppType value_cpp_type,
+            FieldType value_field_type);
     MapFieldDescriptorImpl(std::string_view name,
+            int32_t number,
             CppType cpp_type,
             size_t offset,
             CppType key_cpp_type,
+            FieldType key_field_type,
             CppType value_cpp_type,
+            FieldType value_field_type,
             const EnumDescriptor* enum_descriptor);
     MapFieldDescriptorImpl(std::string_view name,
+            int32_t number,
             CppType cpp_type,
             size_t offset,
             CppType key_cpp_type,
+            FieldType key_field_type,
             CppType value_cpp_type,
+            FieldType value_field_type,
             const Descriptor* descriptor);
 
     Iterator* NewIterator(const Message& msg) const override;
+    Iterator* NewIterator(const Message& msg, void* buffer) const override;
+
+    size_t Size(const Message& msg) const override;
 
 protected:
     void* FindDataPtr(Message& msg, const void* key, bool create_if_not_exist) const override;
+    bool EraseDataPtr(Message& msg, const void* key) const override;
 };
 
 template<typename K, typename V>
@@ -343,33 +443,42 @@ const void* MapFieldDescriptorImpl<K, V>::IteratorImpl::GetValueDataPtr() const
 
 template<typename K, typename V>
 MapFieldDescriptorImpl<K, V>::MapFieldDescriptorImpl(std::string_view name,
+        int32_t number,
         CppType cpp_type,
         size_t offset,
         CppType key_cpp_type,
-        CppType value_cpp_type) :
-    MapFieldDescriptor(name, cpp_type, offset, key_cpp_type, value_cpp_type)
+        FieldType key_field_type,
+        CppType value_cpp_type,
+        FieldType value_field_type) :
+    MapFieldDescriptor(name, number, cpp_type, offset, key_cpp_type, key_field_type, value_cpp_type, value_field_type)
 {
 }
 
 template<typename K, typename V>
 MapFieldDescriptorImpl<K, V>::MapFieldDescriptorImpl(std::string_view name,
+        int32_t number,
         CppType cpp_type,
         size_t offset,
         CppType key_cpp_type,
+        FieldType key_field_type,
         CppType value_cpp_type,
+        FieldType value_field_type,
         const EnumDescriptor* enum_descriptor) :
-    MapFieldDescriptor(name, cpp_type, offset, key_cpp_type, value_cpp_type, enum_descriptor)
+    MapFieldDescriptor(name, number, cpp_type, offset, key_cpp_type, key_field_type, value_cpp_type, value_field_type, enum_descriptor)
 {
 }
 
 template<typename K, typename V>
 MapFieldDescriptorImpl<K, V>::MapFieldDescriptorImpl(std::string_view name,
+        int32_t number,
         CppType cpp_type,
         size_t offset,
         CppType key_cpp_type,
+        FieldType key_field_type,
         CppType value_cpp_type,
+        FieldType value_field_type,
         const Descriptor* descriptor) :
-    MapFieldDescriptor(name, cpp_type, offset, key_cpp_type, value_cpp_type, descriptor)
+    MapFieldDescriptor(name, number, cpp_type, offset, key_cpp_type, key_field_type, value_cpp_type, value_field_type, descriptor)
 {
 }
 
@@ -380,6 +489,21 @@ MapFieldDescriptor::Iterator* MapFieldDescriptorImpl<K, V>::NewIterator(const Me
     return new IteratorImpl(*c);
 }
 
+template<typename K, typename V>
+MapFieldDescriptor::Iterator* MapFieldDescriptorImpl<K, V>::NewIterator(const Message& msg, void* buffer) const
+{
+    static_assert(sizeof(IteratorImpl) <= kIteratorBufferSize);
+    const std::map<K, V>* c = reinterpret_cast<const std::map<K, V>*>(reinterpret_cast<const char*>(&msg) + this->GetOffset());
+    return new (buffer) IteratorImpl(*c);
+}
+
+template<typename K, typename V>
+size_t MapFieldDescriptorImpl<K, V>::Size(const Message& msg) const
+{
+    const std::map<K, V>* c = reinterpret_cast<const std::map<K, V>*>(reinterpret_cast<const char*>(&msg) + this->GetOffset());
+    return c->size();
+}
+
 template<typename K, typename V>
 void* MapFieldDescriptorImpl<K, V>::FindDataPtr(Message& msg, const void* key, bool create_if_not_exist) const
 {
@@ -391,6 +515,13 @@ void* MapFieldDescriptorImpl<K, V>::FindDataPtr(Message& msg, const void* key, b
     return nullptr;
 }
 
+template<typename K, typename V>
+bool MapFieldDescriptorImpl<K, V>::EraseDataPtr(Message& msg, const void* key) const
+{
+    std::map<K, V>* c = reinterpret_cast<std::map<K, V>*>(reinterpret_cast<char*>(&msg) + this->GetOffset());
+    return c->erase(*reinterpret_cast<const K*>(key)) > 0;
+}
+
 template<typename K, typename V>
 class UnorderedMapFieldDescriptorImpl : public MapFieldDescriptor
 {
@@ -412,27 +543,40 @@ public:
     };
 
     UnorderedMapFieldDescriptorImpl(std::string_view name,
+            int32_t number,
             CppType cpp_type,
             size_t offset,
             CppType key_cpp_type,
-            CppType value_cpp_type);
+            FieldType key_field_type,
+            CppType value_cpp_type,
+            FieldType value_field_type);
     UnorderedMapFieldDescriptorImpl(std::string_view name,
+            int32_t number,
             CppType cpp_type,
             size_t offset,
             CppType key_cpp_type,
+            FieldType key_field_type,
             CppType value_cpp_type,
+            FieldType value_field_type,
             const EnumDescriptor* enum_descriptor);
     UnorderedMapFieldDescriptorImpl(std::string_view name,
+            int32_t number,
             CppType cpp_type,
             size_t offset,
             CppType key_cpp_type,
+            FieldType key_field_type,
             CppType value_cpp_type,
+            FieldType value_field_type,
             const Descriptor* descriptor);
 
     Iterator* NewIterator(const Message& msg) const override;
+    Iterator* NewIterator(const Message& msg, void* buffer) const override;
+
+    size_t Size(const Message& msg) const override;
 
 protected:
     void* FindDataPtr(Message& msg, const void* key, bool create_if_not_exist) const override;
+    bool EraseDataPtr(Message& msg, const void* key) const override;
 };
 
 template<typename K, typename V>
@@ -467,33 +611,42 @@ const void* UnorderedMapFieldDescriptorImpl<K, V>::IteratorImpl::GetValueDataPtr
 
 template<typename K, typename V>
 UnorderedMapFieldDescriptorImpl<K, V>::UnorderedMapFieldDescriptorImpl(std::string_view name,
+        int32_t number,
         CppType cpp_type,
         size_t offset,
         CppType key_cpp_type,
-        CppType value_cpp_type) :
-    MapFieldDescriptor(name, cpp_type, offset, key_cpp_type, value_cpp_type)
+        FieldType key_field_type,
+        CppType value_cpp_type,
+        FieldType value_field_type) :
+    MapFieldDescriptor(name, number, cpp_type, offset, key_cpp_type, key_field_type, value_cpp_type, value_field_type)
 {
 }
 
 template<typename K, typename V>
 UnorderedMapFieldDescriptorImpl<K, V>::UnorderedMapFieldDescriptorImpl(std::string_view name,
+        int32_t number,
         CppType cpp_type,
         size_t offset,
         CppType key_cpp_type,
+        FieldType key_field_type,
         CppType value_cpp_type,
+        FieldType value_field_type,
         const EnumDescriptor* enum_descriptor) :
-    MapFieldDescriptor(name, cpp_type, offset, key_cpp_type, value_cpp_type, enum_descriptor)
+    MapFieldDescriptor(name, number, cpp_type, offset, key_cpp_type, key_field_type, value_cpp_type, value_field_type, enum_descriptor)
 {
 }
 
 template<typename K, typename V>
 UnorderedMapFieldDescriptorImpl<K, V>::UnorderedMapFieldDescriptorImpl(std::string_view name,
+        int32_t number,
         CppType cpp_type,
         size_t offset,
         CppType key_cpp_type,
+        FieldType key_field_type,
         CppType value_cpp_type,
+        FieldType value_field_type,
         const Descriptor* descriptor) :
-    MapFieldDescriptor(name, cpp_type, offset, key_cpp_type, value_cpp_type, descriptor)
+    MapFieldDescriptor(name, number, cpp_type, offset, key_cpp_type, key_field_type, value_cpp_type, value_field_type, descriptor)
 {
 }
 
@@ -504,6 +657,21 @@ MapFieldDescriptor::Iterator* UnorderedMapFieldDescriptorImpl<K, V>::NewIterator
     return new IteratorImpl(*c);
 }
 
+template<typename K, typename V>
+MapFieldDescriptor::Iterator* UnorderedMapFieldDescriptorImpl<K, V>::NewIterator(const Message& msg, void* buffer) const
+{
+    static_assert(sizeof(IteratorImpl) <= kIteratorBufferSize);
+    const std::unordered_map<K, V>* c = reinterpret_cast<const std::unordered_map<K, V>*>(reinterpret_cast<const char*>(&msg) + this->GetOffset());
+    return new (buffer) IteratorImpl(*c);
+}
+
+template<typename K, typename V>
+size_t UnorderedMapFieldDescriptorImpl<K, V>::Size(const Message& msg) const
+{
+    const std::unordered_map<K, V>* c = reinterpret_cast<const std::unordered_map<K, V>*>(reinterpret_cast<const char*>(&msg) + this->GetOffset());
+    return c->size();
+}
+
 template<typename K, typename V>
 void* UnorderedMapFieldDescriptorImpl<K, V>::FindDataPtr(Message& msg, const void* key, bool create_if_not_exist) const
 {
@@ -515,4 +683,11 @@ void* UnorderedMapFieldDescriptorImpl<K, V>::FindDataPtr(Message& msg, const voi
     return nullptr;
 }
 
+template<typename K, typename V>
+bool UnorderedMapFieldDescriptorImpl<K, V>::EraseDataPtr(Message& msg, const void* key) const
+{
+    std::unordered_map<K, V>* c = reinterpret_cast<std::unordered_map<K, V>*>(reinterpret_cast<char*>(&msg) + this->GetOffset());
+    return c->erase(*reinterpret_cast<const K*>(key)) > 0;
+}
+
 }
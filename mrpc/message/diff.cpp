@@ -0,0 +1,502 @@
+#include <cassert>
+#include <cstring>
+
+#include <mrpc/message/diff.h>
+#include <mrpc/message/reflection.h>
+#include <mrpc/message/reflection_internal.h>
+
+namespace mrpc
+{
+
+// 补丁由若干条记录组成, 每条记录以(字段编号 << 3 | PatchOp)开头:
+//   PATCH_SET       标量字段的新值
+//   PATCH_MESSAGE   长度 + 子消息的补丁
+//   PATCH_REPEATED  长度 + 新的元素个数 + 若干(下标增量, 元素)
+//                   新增的消息元素为完整编码, 原有的消息元素为长度 + 补丁
+//   PATCH_MAP       长度 + 若干(MapEntryOp, key[, value])
+enum PatchOp : uint32_t
+{
+    PATCH_SET           = 0,
+    PATCH_MESSAGE       = 1,
+    PATCH_REPEATED      = 2,
+    PATCH_MAP           = 3,
+};
+
+enum MapEntryOp : uint32_t
+{
+    MAP_ENTRY_SET       = 0,    // value为完整编码
+    MAP_ENTRY_PATCH     = 1,    // 长度 + 消息value的补丁
+    MAP_ENTRY_ERASE     = 2,
+};
+
+static constexpr size_t kMaxLengthSize = 5;
+
+template<FieldType field_type>
+static inline bool IsEqual(const FieldValueType<field_type>& a, const FieldValueType<field_type>& b)
+{
+    if constexpr (field_type == TYPE_FLOAT || field_type == TYPE_DOUBLE)
+    {
+        // 按位比较, NaN不会产生多余的补丁, -0.0也能正确还原.
+        return memcmp(&a, &b, sizeof(a)) == 0;
+    }
+    else
+    {
+        return a == b;
+    }
+}
+
+static inline void SerializeRecordTag(std::string& s, int32_t number, PatchOp op)
+{
+    Serialize<TYPE_VAR_UINT32>(s, (static_cast<uint32_t>(number) << 3) | op);
+}
+
+// 预留长度的位置, 返回内容的起始位置.
+static inline size_t BeginLength(std::string& s)
+{
+    s.append(kMaxLengthSize, '\0');
+    return s.size();
+}
+
+// 回填长度, 并去掉多余的预留字节.
+static inline void EndLength(std::string& s, size_t body_begin)
+{
+    uint32_t size = static_cast<uint32_t>(s.size() - body_begin);
+    char buf[kMaxLengthSize];
+    size_t n = 0;
+    while (size >= 0x80)
+    {
+        buf[n++] = static_cast<char>(size | 0x80);
+        size >>= 7;
+    }
+    buf[n++] = static_cast<char>(size);
+
+    size_t length_begin = body_begin - kMaxLengthSize;
+    memcpy(&s[length_begin], buf, n);
+    s.erase(length_begin + n, kMaxLengthSize - n);
+}
+
+static inline void SerializeFullMessage(std::string& s, const Message& msg)
+{
+    msg.ByteSize();
+    Serialize<true>(s, msg);
+}
+
+//
+// Diff
+//
+static void DiffMessage(const Message& from, const Message& to, std::string& s);
+
+// 写入"长度 + 子消息补丁", 没有差异时回退到record_begin并返回false.
+static bool DiffNestedMessage(const Message& from, const Message& to, std::string& s, size_t record_begin)
+{
+    size_t body_begin = BeginLength(s);
+    DiffMessage(from, to, s);
+    if (s.size() == body_begin)
+    {
+        s.resize(record_begin);
+        return false;
+    }
+
+    EndLength(s, body_begin);
+    return true;
+}
+
+static void DiffRepeatedField(const Message& from, const Message& to, const RepeatedFieldDescriptor& field, std::string& s)
+{
+    size_t from_size = field.Size(from);
+    size_t to_size = field.Size(to);
+
+    size_t record_begin = s.size();
+    SerializeRecordTag(s, field.GetNumber(), PATCH_REPEATED);
+    size_t body_begin = BeginLength(s);
+    Serialize<TYPE_VAR_UINT32>(s, static_cast<uint32_t>(to_size));
+    size_t elements_begin = s.size();
+
+    Reflection::RepeatedStackIterator from_it(field, from);
+    Reflection::RepeatedStackIterator to_it(field, to);
+    uint32_t next_index = 0;
+
+    if (field.GetValueCppType() == CPPTYPE_MESSAGE)
+    {
+        for (uint32_t index = 0; to_it->HasNext(); ++index, to_it->Next())
+        {
+            size_t element_begin = s.size();
+            Serialize<TYPE_VAR_UINT32>(s, index - next_index);
+            if (from_it->HasNext())
+            {
+                bool changed = DiffNestedMessage(from_it->Get<Message>(), to_it->Get<Message>(), s, element_begin);
+                from_it->Next();
+                if (!changed) continue;
+            }
+            else
+            {
+                SerializeFullMessage(s, to_it->Get<Message>());
+            }
+            next_index = index + 1;
+        }
+    }
+    else
+    {
+        VisitFieldType(field.GetValueFieldType(), [&]<FieldType field_type>()
+        {
+            for (uint32_t index = 0; to_it->HasNext(); ++index, to_it->Next())
+            {
+                const FieldValueType<field_type>& to_value = to_it->Get<FieldValueType<field_type>>();
+                if (from_it->HasNext())
+                {
+                    bool equal = IsEqual<field_type>(from_it->Get<FieldValueType<field_type>>(), to_value);
+                    from_it->Next();
+                    if (equal) continue;
+                }
+                else if (IsEqual<field_type>(FieldValueType<field_type>(), to_value))
+                {
+                    // Resize出来的新元素就是默认值
+                    continue;
+                }
+
+                Serialize<TYPE_VAR_UINT32>(s, index - next_index);
+                Serialize<field_type>(s, to_value);
+                next_index = index + 1;
+            }
+        });
+    }
+
+    if (from_size == to_size && s.size() == elements_begin)
+    {
+        s.resize(record_begin);
+        return;
+    }
+    EndLength(s, body_begin);
+}
+
+template<FieldType key_field_type>
+static void DiffMapErasedKeys(const Message& from, const Message& to, const MapFieldDescriptor& field, std::string& s)
+{
+    using K = FieldValueType<key_field_type>;
+    for (Reflection::MapStackIterator it(field, from); it->HasNext(); it->Next())
+    {
+        const K& key = it->GetKey<K>();
+        if (field.Find<K, Message>(to, key) != nullptr) continue;
+
+        Serialize<TYPE_VAR_UINT32>(s, MAP_ENTRY_ERASE);
+        Serialize<key_field_type>(s, key);
+    }
+}
+
+static void DiffMapField(const Message& from, const Message& to, const MapFieldDescriptor& field, std::string& s)
+{
+    size_t record_begin = s.size();
+    SerializeRecordTag(s, field.GetNumber(), PATCH_MAP);
+    size_t body_begin = BeginLength(s);
+
+    VisitFieldType(field.GetKeyFieldType(), [&]<FieldType key_field_type>()
+    {
+        using K = FieldValueType<key_field_type>;
+        if (field.GetValueCppType() == CPPTYPE_MESSAGE)
+        {
+            for (Reflection::MapStackIterator it(field, to); it->HasNext(); it->Next())
+            {
+                const K& key = it->GetKey<K>();
+                const Message& to_value = it->GetValue<Message>();
+                const Message* from_value = field.Find<K, Message>(from, key);
+
+                size_t entry_begin = s.size();
+                if (from_value == nullptr)
+                {
+                    Serialize<TYPE_VAR_UINT32>(s, MAP_ENTRY_SET);
+                    Serialize<key_field_type>(s, key);
+                    SerializeFullMessage(s, to_value);
+                }
+                else
+                {
+                    Serialize<TYPE_VAR_UINT32>(s, MAP_ENTRY_PATCH);
+                    Serialize<key_field_type>(s, key);
+                    DiffNestedMessage(*from_value, to_value, s, entry_begin);
+                }
+            }
+        }
+        else
+        {
+            VisitFieldType(field.GetValueFieldType(), [&]<FieldType value_field_type>()
+            {
+                using V = FieldValueType<value_field_type>;
+                for (Reflection::MapStackIterator it(field, to); it->HasNext(); it->Next())
+                {
+                    const K& key = it->GetKey<K>();
+                    const V& to_value = it->GetValue<V>();
+                    const V* from_value = field.Find<K, V>(from, key);
+                    if (from_value != nullptr && IsEqual<value_field_type>(*from_value, to_value)) continue;
+
+                    Serialize<TYPE_VAR_UINT32>(s, MAP_ENTRY_SET);
+                    Serialize<key_field_type>(s, key);
+                    Serialize<value_field_type>(s, to_value);
+                }
+            });
+        }
+
+        DiffMapErasedKeys<key_field_type>(from, to, field, s);
+    });
+
+    if (s.size() == body_begin)
+    {
+        s.resize(record_begin);
+        return;
+    }
+    EndLength(s, body_begin);
+}
+
+static void DiffField(const Message& from, const Message& to, const FieldDescriptor& field, std::string& s)
+{
+    switch (field.GetCppType())
+    {
+        case CPPTYPE_MESSAGE:
+        {
+            size_t record_begin = s.size();
+            SerializeRecordTag(s, field.GetNumber(), PATCH_MESSAGE);
+            DiffNestedMessage(Reflection::GetMessage(from, field), Reflection::GetMessage(to, field), s, record_begin);
+            return;
+        }
+        case CPPTYPE_VECTOR:
+        case CPPTYPE_LIST:
+            DiffRepeatedField(from, to, static_cast<const RepeatedFieldDescriptor&>(field), s);
+            return;
+        case CPPTYPE_MAP:
+        case CPPTYPE_UNORDERED_MAP:
+            DiffMapField(from, to, static_cast<const MapFieldDescriptor&>(field), s);
+            return;
+        default:
+            break;
+    }
+
+    const char* from_data = reinterpret_cast<const char*>(&from) + field.GetOffset();
+    const char* to_data = reinterpret_cast<const char*>(&to) + field.GetOffset();
+    VisitFieldType(field.GetFieldType(), [&]<FieldType field_type>()
+    {
+        const FieldValueType<field_type>& from_value = *reinterpret_cast<const FieldValueType<field_type>*>(from_data);
+        const FieldValueType<field_type>& to_value = *reinterpret_cast<const FieldValueType<field_type>*>(to_data);
+        if (IsEqual<field_type>(from_value, to_value)) return;
+
+        SerializeRecordTag(s, field.GetNumber(), PATCH_SET);
+        Serialize<field_type>(s, to_value);
+    });
+}
+
+void DiffMessage(const Message& from, const Message& to, std::string& s)
+{
+    const Descriptor* desc = to.GetDescriptor();
+    assert(desc != nullptr);
+    assert(from.GetDescriptor() == desc);
+
+    // 标量字段先整段比较, 相同时跳过整段
+    const std::vector<PodRun>& runs = desc->GetPodRuns();
+    for (size_t i = 0; i < runs.size(); ++i)
+    {
+        if (memcmp(reinterpret_cast<const char*>(&from) + runs[i].offset, reinterpret_cast<const char*>(&to) + runs[i].offset, runs[i].size) == 0)
+        {
+            continue;
+        }
+        for (const FieldDescriptor* field : desc->GetPodRunFields(i))
+        {
+            DiffField(from, to, *field, s);
+        }
+    }
+
+    for (const FieldDescriptor* field : desc->GetNonPodFields())
+    {
+        DiffField(from, to, *field, s);
+    }
+}
+
+//
+// ApplyPatch
+//
+static bool ApplyMessage(Message& msg, const uint8_t*& begin, const uint8_t* const end);
+
+static inline bool ParseLength(const uint8_t*& begin, const uint8_t* const end, const uint8_t*& body_end)
+{
+    uint32_t size = 0;
+    if (!Parse<TYPE_VAR_UINT32>(size, begin, end)) return false;
+    if (size > static_cast<size_t>(end - begin)) return false;
+
+    body_end = begin + size;
+    return true;
+}
+
+static bool ApplyNestedMessage(Message& msg, const uint8_t*& begin, const uint8_t* const end)
+{
+    const uint8_t* body_end = nullptr;
+    if (!ParseLength(begin, end, body_end)) return false;
+    return ApplyMessage(msg, begin, body_end);
+}
+
+static bool ApplyRepeatedField(Message& msg, const RepeatedFieldDescriptor& field, const uint8_t*& begin, const uint8_t* const end)
+{
+    const uint8_t* body_end = nullptr;
+    if (!ParseLength(begin, end, body_end)) return false;
+
+    uint32_t size = 0;
+    if (!Parse<TYPE_VAR_UINT32>(size, begin, body_end)) return false;
+
+    size_t old_size = field.Size(msg);
+    field.Resize(msg, size);
+
+    // msg本身可修改, 迭代器只提供const访问.
+    Reflection::RepeatedStackIterator it(field, msg);
+    uint64_t index = 0;
+    uint64_t next_index = 0;
+    auto seek = [&]() -> bool
+    {
+        uint32_t delta = 0;
+        if (!Parse<TYPE_VAR_UINT32>(delta, begin, body_end)) return false;
+
+        uint64_t target = next_index + delta;
+        if (target >= size) return false;
+        for (; index < target; ++index)
+        {
+            it->Next();
+        }
+        next_index = target + 1;
+        return true;
+    };
+
+    if (field.GetValueCppType() == CPPTYPE_MESSAGE)
+    {
+        while (begin < body_end)
+        {
+            if (!seek()) return false;
+
+            Message& value = const_cast<Message&>(it->Get<Message>());
+            bool result = index < old_size ? ApplyNestedMessage(value, begin, body_end) : Parse(value, begin, body_end);
+            if (!result) return false;
+        }
+        return true;
+    }
+
+    return VisitFieldType(field.GetValueFieldType(), [&]<FieldType field_type>() -> bool
+    {
+        while (begin < body_end)
+        {
+            if (!seek()) return false;
+
+            FieldValueType<field_type>& value = const_cast<FieldValueType<field_type>&>(it->Get<FieldValueType<field_type>>());
+            if (!Parse<field_type>(value, begin, body_end)) return false;
+        }
+        return true;
+    });
+}
+
+static bool ApplyMapField(Message& msg, const MapFieldDescriptor& field, const uint8_t*& begin, const uint8_t* const end)
+{
+    const uint8_t* body_end = nullptr;
+    if (!ParseLength(begin, end, body_end)) return false;
+
+    return VisitFieldType(field.GetKeyFieldType(), [&]<FieldType key_field_type>() -> bool
+    {
+        using K = FieldValueType<key_field_type>;
+        while (begin < body_end)
+        {
+            uint32_t op = 0;
+            if (!Parse<TYPE_VAR_UINT32>(op, begin, body_end)) return false;
+
+            K key;
+            if (!Parse<key_field_type>(key, begin, body_end)) return false;
+
+            switch (op)
+            {
+                case MAP_ENTRY_SET:
+                {
+                    if (field.GetValueCppType() == CPPTYPE_MESSAGE)
+                    {
+                        Message* value = field.Find<K, Message>(msg, key, true);
+                        value->Clear();
+                        if (!Parse(*value, begin, body_end)) return false;
+                        break;
+                    }
+
+                    bool result = VisitFieldType(field.GetValueFieldType(), [&]<FieldType value_field_type>() -> bool
+                    {
+                        using V = FieldValueType<value_field_type>;
+                        return Parse<value_field_type>(*field.Find<K, V>(msg, key, true), begin, body_end);
+                    });
+                    if (!result) return false;
+                    break;
+                }
+                case MAP_ENTRY_PATCH:
+                {
+                    if (field.GetValueCppType() != CPPTYPE_MESSAGE) return false;
+
+                    Message* value = field.Find<K, Message>(msg, key, false);
+                    if (value == nullptr) return false;
+                    if (!ApplyNestedMessage(*value, begin, body_end)) return false;
+                    break;
+                }
+                case MAP_ENTRY_ERASE:
+                    field.Erase(msg, key);
+                    break;
+                default:
+                    return false;
+            }
+        }
+        return true;
+    });
+}
+
+static bool ApplyField(Message& msg, const FieldDescriptor& field, uint32_t op, const uint8_t*& begin, const uint8_t* const end)
+{
+    switch (field.GetCppType())
+    {
+        case CPPTYPE_MESSAGE:
+            if (op != PATCH_MESSAGE) return false;
+            return ApplyNestedMessage(Reflection::GetMessage(msg, field), begin, end);
+        case CPPTYPE_VECTOR:
+        case CPPTYPE_LIST:
+            if (op != PATCH_REPEATED) return false;
+            return ApplyRepeatedField(msg, static_cast<const RepeatedFieldDescriptor&>(field), begin, end);
+        case CPPTYPE_MAP:
+        case CPPTYPE_UNORDERED_MAP:
+            if (op != PATCH_MAP) return false;
+            return ApplyMapField(msg, static_cast<const MapFieldDescriptor&>(field), begin, end);
+        default:
+            break;
+    }
+
+    if (op != PATCH_SET) return false;
+
+    char* data = reinterpret_cast<char*>(&msg) + field.GetOffset();
+    return VisitFieldType(field.GetFieldType(), [&]<FieldType field_type>() -> bool
+    {
+        return Parse<field_type>(*reinterpret_cast<FieldValueType<field_type>*>(data), begin, end);
+    });
+}
+
+bool ApplyMessage(Message& msg, const uint8_t*& begin, const uint8_t* const end)
+{
+    const Descriptor* desc = msg.GetDescriptor();
+    assert(desc != nullptr);
+
+    uint32_t number = 0, op = 0;
+    while (begin < end)
+    {
+        if (!ParseTag(number, op, begin, end)) return false;
+
+        const FieldDescriptor* field = desc->FindFieldByNumber(static_cast<int32_t>(number));
+        if (field == nullptr) return false;
+
+        if (!ApplyField(msg, *field, op, begin, end)) return false;
+    }
+    return true;
+}
+
+void Diff(const Message& from, const Message& to, std::string& patch)
+{
+    patch.clear();
+    DiffMessage(from, to, patch);
+}
+
+bool ApplyPatch(Message& msg, std::string_view patch)
+{
+    const uint8_t* begin = reinterpret_cast<const uint8_t*>(patch.data());
+    return ApplyMessage(msg, begin, begin + patch.size());
+}
+
+}
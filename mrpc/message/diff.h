@@ -0,0 +1,25 @@
+#pragma once
+
+#include <string>
+#include <string_view>
+
+#include <mrpc/message/message.h>
+
+namespace mrpc
+{
+
+// 计算把from变为to的二进制补丁, from和to必须是同一类型的消息, 两者相同时补丁为空.
+// 标量字段直接比较, 子消息递归比较, repeated按下标比较, map按key比较.
+void Diff(const Message& from, const Message& to, std::string& patch);
+
+inline std::string Diff(const Message& from, const Message& to)
+{
+    std::string patch;
+    Diff(from, to, patch);
+    return patch;
+}
+
+// 在msg上原地应用补丁, msg应与计算补丁时的from相同. 补丁不合法时返回false, 此时msg可能已被部分修改.
+bool ApplyPatch(Message& msg, std::string_view patch);
+
+}
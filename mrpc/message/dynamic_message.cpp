@@ -0,0 +1,46 @@
+#include <cassert>
+#include <mrpc/message/dynamic_message.h>
+#include <mrpc/message/reflection_codec.h>
+
+namespace mrpc
+{
+
+DynamicMessage::DynamicMessage(const Descriptor* descriptor) :
+    descriptor_(descriptor)
+{
+    if (descriptor_ != nullptr)
+    {
+        message_.reset(descriptor_->New());
+    }
+}
+
+DynamicMessage::DynamicMessage(std::string_view full_name) :
+    DynamicMessage(DescriptorPool::FindDescriptorByFullName(full_name))
+{
+}
+
+void DynamicMessage::Clear()
+{
+    assert(IsValid());
+    message_->Clear();
+}
+
+size_t DynamicMessage::ByteSize(bool skip_default/* = true*/) const
+{
+    assert(IsValid());
+    return ReflectionCodec::ByteSize(*message_, skip_default);
+}
+
+void DynamicMessage::SerializeToString(std::string& s, bool skip_default/* = true*/) const
+{
+    assert(IsValid());
+    ReflectionCodec::SerializeToString(*message_, s, skip_default);
+}
+
+bool DynamicMessage::ParseFromString(std::string_view s)
+{
+    assert(IsValid());
+    return ReflectionCodec::ParseFromString(*message_, s);
+}
+
+}
@@ -0,0 +1,42 @@
+#pragma once
+
+#include <memory>
+#include <string>
+#include <string_view>
+
+#include <mrpc/message/descriptor.h>
+
+namespace mrpc
+{
+
+// 按Descriptor(或消息全名)创建的消息, 编解码走ReflectionCodec,
+// 调用方不需要包含具体消息类型的头文件.
+class DynamicMessage final
+{
+public:
+    explicit DynamicMessage(const Descriptor* descriptor);
+    explicit DynamicMessage(std::string_view full_name);
+    DynamicMessage(DynamicMessage&&) = default;
+    DynamicMessage& operator=(DynamicMessage&&) = default;
+    ~DynamicMessage() = default;
+
+    DynamicMessage(const DynamicMessage&) = delete;
+    DynamicMessage& operator=(const DynamicMessage&) = delete;
+
+    inline bool IsValid() const { return message_ != nullptr; }
+    inline const Descriptor* GetDescriptor() const { return descriptor_; }
+    inline Message& GetMessage() { return *message_; }
+    inline const Message& GetMessage() const { return *message_; }
+
+    void Clear();
+
+    size_t ByteSize(bool skip_default = true) const;
+    void SerializeToString(std::string& s, bool skip_default = true) const;
+    bool ParseFromString(std::string_view s);
+
+private:
+    const Descriptor* descriptor_ = nullptr;
+    std::unique_ptr<Message> message_;
+};
+
+}
@@ -0,0 +1,142 @@
+#include <algorithm>
+
+#include <mrpc/message/descriptor.h>
+#include <mrpc/message/field_mask.h>
+
+namespace mrpc
+{
+
+// 字段(或repeated/map的元素)为消息时返回其描述符, 否则返回nullptr.
+static const Descriptor* GetMessageDescriptor(const FieldDescriptor& field)
+{
+    switch (field.GetCppType())
+    {
+        case CPPTYPE_MESSAGE:
+            return static_cast<const MessageFieldDescriptor&>(field).GetDescriptor();
+        case CPPTYPE_VECTOR:
+        case CPPTYPE_LIST:
+        {
+            const RepeatedFieldDescriptor& repeated_field = static_cast<const RepeatedFieldDescriptor&>(field);
+            if (repeated_field.GetValueCppType() != CPPTYPE_MESSAGE) return nullptr;
+            return repeated_field.GetDescriptor();
+        }
+        case CPPTYPE_MAP:
+        case CPPTYPE_UNORDERED_MAP:
+        {
+            const MapFieldDescriptor& map_field = static_cast<const MapFieldDescriptor&>(field);
+            if (map_field.GetValueCppType() != CPPTYPE_MESSAGE) return nullptr;
+            return map_field.GetDescriptor();
+        }
+        default:
+            break;
+    }
+    return nullptr;
+}
+
+bool FieldMask::AddPath(const Descriptor* descriptor, std::string_view path)
+{
+    if (descriptor == nullptr || path.empty()) return false;
+    if (descriptor_ != nullptr && descriptor_ != descriptor) return false;
+
+    size_t pos = path.find('.');
+    std::string_view name = path.substr(0, pos);
+    std::string_view sub_path = pos == std::string_view::npos ? std::string_view() : path.substr(pos + 1);
+    if (pos != std::string_view::npos && sub_path.empty()) return false;
+
+    const FieldDescriptor* field = descriptor->FindFieldByName(name);
+    if (field == nullptr) return false;
+
+    const Descriptor* sub_descriptor = GetMessageDescriptor(*field);
+    if (!sub_path.empty() && sub_descriptor == nullptr) return false;
+
+    descriptor_ = descriptor;
+
+    auto it = std::lower_bound(children_.begin(), children_.end(), field->GetNumber(),
+            [](const FieldMask& child, int32_t number) { return child.field_->GetNumber() < number; });
+    if (it == children_.end() || it->field_ != field)
+    {
+        FieldMask child;
+        child.descriptor_ = sub_descriptor;
+        child.field_ = field;
+        if (!sub_path.empty() && !child.AddPath(sub_descriptor, sub_path)) return false;
+
+        children_.insert(it, std::move(child));
+        return true;
+    }
+
+    if (it->children_.empty())
+    {
+        // 已包含整个字段, 只检查子路径是否合法.
+        FieldMask child;
+        return sub_path.empty() || child.AddPath(sub_descriptor, sub_path);
+    }
+
+    if (sub_path.empty())
+    {
+        it->children_.clear();
+        return true;
+    }
+    return it->AddPath(sub_descriptor, sub_path);
+}
+
+bool FieldMask::ParseFromString(const Descriptor* descriptor, std::string_view paths)
+{
+    Clear();
+
+    while (!paths.empty())
+    {
+        size_t pos = paths.find(',');
+        if (!AddPath(descriptor, paths.substr(0, pos)))
+        {
+            Clear();
+            return false;
+        }
+
+        if (pos == std::string_view::npos) break;
+        paths.remove_prefix(pos + 1);
+    }
+    return true;
+}
+
+std::string FieldMask::ToString() const
+{
+    std::string prefix, s;
+    AppendPaths(prefix, s);
+    return s;
+}
+
+void FieldMask::AppendPaths(std::string& prefix, std::string& s) const
+{
+    for (const FieldMask& child : children_)
+    {
+        size_t prefix_length = prefix.length();
+        prefix.append(child.field_->GetName());
+        if (child.children_.empty())
+        {
+            if (!s.empty()) s.push_back(',');
+            s.append(prefix);
+        }
+        else
+        {
+            prefix.push_back('.');
+            child.AppendPaths(prefix, s);
+        }
+        prefix.resize(prefix_length);
+    }
+}
+
+void FieldMask::Clear()
+{
+    descriptor_ = nullptr;
+    children_.clear();
+}
+
+const FieldMask* FieldMask::FindChild(int32_t number) const
+{
+    auto it = std::lower_bound(children_.begin(), children_.end(), number,
+            [](const FieldMask& child, int32_t value) { return child.field_->GetNumber() < value; });
+    if (it == children_.end() || it->field_->GetNumber() != number) return nullptr;
+    return &*it;
+}
+
+}
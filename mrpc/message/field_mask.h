@@ -0,0 +1,46 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace mrpc
+{
+
+class Descriptor;
+class FieldDescriptor;
+
+// 字段掩码, 由若干以'.'分隔的字段路径组成, 如"obj_value.int32_value".
+// 每个节点对应一个消息, 没有子节点表示包含该消息的全部字段.
+// repeated和map中的消息, 子路径对每个元素生效.
+class FieldMask final
+{
+public:
+    FieldMask() = default;
+    ~FieldMask() = default;
+
+    bool AddPath(const Descriptor* descriptor, std::string_view path);
+
+    // 多个路径以','分隔, 与ToString互逆.
+    bool ParseFromString(const Descriptor* descriptor, std::string_view paths);
+    std::string ToString() const;
+
+    void Clear();
+    inline bool IsEmpty() const { return children_.empty(); }
+
+    inline const Descriptor* GetDescriptor() const { return descriptor_; }
+    inline const FieldDescriptor* GetField() const { return field_; }
+    inline const std::vector<FieldMask>& GetChildren() const { return children_; }
+
+    const FieldMask* FindChild(int32_t number) const;
+
+private:
+    const Descriptor* descriptor_ = nullptr;        // 本节点对应的消息
+    const FieldDescriptor* field_ = nullptr;        // 父消息中的字段, 根节点为nullptr
+    std::vector<FieldMask> children_;               // 按字段编号排序
+
+    void AppendPaths(std::string& prefix, std::string& s) const;
+};
+
+}
@@ -0,0 +1,58 @@
+#pragma once
+
+#include <cstdint>
+
+namespace mrpc
+{
+
+enum WireType : int32_t
+{
+    WIRETYPE_VARINT             = 0,
+    WIRETYPE_FIXED64            = 1,
+    WIRETYPE_LENGTH_DELIMITED   = 2,
+    // WIRETYPE_START_GROUP     = 3,
+    // WIRETYPE_END_GROUP       = 4,
+    WIRETYPE_FIXED32            = 5,
+};
+
+enum FieldType : int32_t
+{
+    TYPE_UNKNOWN            = 0,
+    TYPE_VAR_UINT32         = 1,
+    TYPE_VAR_INT32          = 2,
+    TYPE_FIXED_UINT32       = 3,
+    TYPE_FIXED_INT32        = 4,
+    TYPE_ZIGZAG_INT32       = 5,
+    TYPE_VAR_UINT64         = 6,
+    TYPE_VAR_INT64          = 7,
+    TYPE_FIXED_UINT64       = 8,
+    TYPE_FIXED_INT64        = 9,
+    TYPE_ZIGZAG_INT64       = 10,
+    TYPE_FLOAT              = 11,
+    TYPE_DOUBLE             = 12,
+    TYPE_BOOL               = 13,
+    TYPE_STRING             = 14,
+    TYPE_MESSAGE            = 15,
+};
+
+constexpr inline WireType FieldTypeToWireType(FieldType field_type)
+{
+    switch (field_type)
+    {
+        case TYPE_FIXED_UINT32:
+        case TYPE_FIXED_INT32:
+        case TYPE_FLOAT:
+            return WIRETYPE_FIXED32;
+        case TYPE_FIXED_UINT64:
+        case TYPE_FIXED_INT64:
+        case TYPE_DOUBLE:
+            return WIRETYPE_FIXED64;
+        case TYPE_STRING:
+        case TYPE_MESSAGE:
+            return WIRETYPE_LENGTH_DELIMITED;
+        default:
+            return WIRETYPE_VARINT;
+    }
+}
+
+}
@@ -1,22 +1,48 @@
 #include <cassert>
+#include <mrpc/message/field_mask.h>
 #include <mrpc/message/reflection.h>
 #include <mrpc/message/json.h>
 
 namespace mrpc
 {
 
-static void RepeatedFieldToJson(const Message& msg, const FieldDescriptor& desc, JsonObject& json, const JsonConvertParam& param);
-static void JsonToRepeatedField(const JsonObject& json, Message& msg, const FieldDescriptor& desc, const JsonConvertParam& param);
-static void MapFieldToJson(const Message& msg, const FieldDescriptor& desc, JsonObject& json, const JsonConvertParam& param);
-static void JsonToMapField(const JsonObject& json, Message& msg, const FieldDescriptor& desc, const JsonConvertParam& param);
+static void MessageToJsonImpl(const Message& msg, JsonObject& json, const FieldMask* mask, const JsonConvertParam& param);
+static void JsonToMessageImpl(const JsonObject& json, Message& msg, const FieldMask* mask, const JsonConvertParam& param);
+static void RepeatedFieldToJson(const Message& msg, const FieldDescriptor& desc, JsonObject& json, const FieldMask* mask, const JsonConvertParam& param);
+static void JsonToRepeatedField(const JsonObject& json, Message& msg, const FieldDescriptor& desc, const FieldMask* mask, const JsonConvertParam& param);
+static void MapFieldToJson(const Message& msg, const FieldDescriptor& desc, JsonObject& json, const FieldMask* mask, const JsonConvertParam& param);
+static void JsonToMapField(const JsonObject& json, Message& msg, const FieldDescriptor& desc, const FieldMask* mask, const JsonConvertParam& param);
+
+// 字段不在掩码内时返回false, field_mask为该字段对应的子掩码.
+static inline bool FindFieldMask(const FieldMask* mask, const FieldDescriptor& field_desc, const FieldMask*& field_mask)
+{
+    field_mask = nullptr;
+    if (mask == nullptr || mask->IsEmpty()) return true;
+
+    field_mask = mask->FindChild(field_desc.GetNumber());
+    return field_mask != nullptr;
+}
 
 void MessageToJson(const Message& msg, JsonObject& json, const JsonConvertParam& param/* = JsonConvertParam()*/)
+{
+    MessageToJsonImpl(msg, json, param.field_mask, param);
+}
+
+void JsonToMessage(const JsonObject& json, Message& msg, const JsonConvertParam& param/* = JsonConvertParam()*/)
+{
+    JsonToMessageImpl(json, msg, param.field_mask, param);
+}
+
+void MessageToJsonImpl(const Message& msg, JsonObject& json, const FieldMask* mask, const JsonConvertParam& param)
 {
     const mrpc::Descriptor* desc = msg.GetDescriptor();
     assert(desc != nullptr);
 
     for (auto field_desc : desc->GetFields())
     {
+        const FieldMask* field_mask = nullptr;
+        if (!FindFieldMask(mask, *field_desc, field_mask)) continue;
+
         std::string field_name(field_desc->GetName());
         switch (field_desc->GetCppType())
         {
@@ -56,17 +82,17 @@ void MessageToJson(const Message& msg, JsonObject& json, const JsonConvertParam&
                 break;
             case mrpc::CPPTYPE_MESSAGE:
                 json[field_name] = JsonObject::object();
-                MessageToJson(mrpc::Reflection::GetMessage(msg, *field_desc), json[field_name], param);
+                MessageToJsonImpl(mrpc::Reflection::GetMessage(msg, *field_desc), json[field_name], field_mask, param);
                 break;
             case mrpc::CPPTYPE_VECTOR:
             case mrpc::CPPTYPE_LIST:
                 json[field_name] = JsonObject::array();
-                RepeatedFieldToJson(msg, *field_desc, json[field_name], param);
+                RepeatedFieldToJson(msg, *field_desc, json[field_name], field_mask, param);
                 break;
             case mrpc::CPPTYPE_MAP:
             case mrpc::CPPTYPE_UNORDERED_MAP:
                 json[field_name] = JsonObject::object();
-                MapFieldToJson(msg, *field_desc, json[field_name], param);
+                MapFieldToJson(msg, *field_desc, json[field_name], field_mask, param);
                 break;
             default:
                 assert(false);
@@ -75,13 +101,16 @@ void MessageToJson(const Message& msg, JsonObject& json, const JsonConvertParam&
     }
 }
 
-void JsonToMessage(const JsonObject& json, Message& msg, const JsonConvertParam& param/* = JsonConvertParam()*/)
+void JsonToMessageImpl(const JsonObject& json, Message& msg, const FieldMask* mask, const JsonConvertParam& param)
 {
     const mrpc::Descriptor* desc = msg.GetDescriptor();
     assert(desc != nullptr);
 
     for (auto field_desc : desc->GetFields())
     {
+        const FieldMask* field_mask = nullptr;
+        if (!FindFieldMask(mask, *field_desc, field_mask)) continue;
+
         std::string field_name(field_desc->GetName());
         if (!json.contains(field_name)) continue;
 
@@ -134,17 +163,17 @@ void JsonToMessage(const JsonObject& json, Message& msg, const JsonConvertParam&
                 break;
             case mrpc::CPPTYPE_MESSAGE:
                 if (param.skip_type_mismatch && !json[field_name].is_object()) continue;
-                JsonToMessage(json[field_name], mrpc::Reflection::GetMessage(msg, *field_desc), param);
+                JsonToMessageImpl(json[field_name], mrpc::Reflection::GetMessage(msg, *field_desc), field_mask, param);
                 break;
             case mrpc::CPPTYPE_VECTOR:
             case mrpc::CPPTYPE_LIST:
                 if (param.skip_type_mismatch && !json[field_name].is_array()) continue;
-                JsonToRepeatedField(json[field_name], msg, *field_desc, param);
+                JsonToRepeatedField(json[field_name], msg, *field_desc, field_mask, param);
                 break;
             case mrpc::CPPTYPE_MAP:
             case mrpc::CPPTYPE_UNORDERED_MAP:
                 if (param.skip_type_mismatch && !json[field_name].is_object()) continue;
-                JsonToMapField(json[field_name], msg, *field_desc, param);
+                JsonToMapField(json[field_name], msg, *field_desc, field_mask, param);
                 break;
             default:
                 assert(false);
@@ -166,7 +195,7 @@ void JsonStringToMessage(const std::string& str, Message& msg, const JsonConvert
     JsonToMessage(object, msg, param);
 }
 
-void RepeatedFieldToJson(const Message& msg, const FieldDescriptor& desc, JsonObject& json, const JsonConvertParam& param)
+void RepeatedFieldToJson(const Message& msg, const FieldDescriptor& desc, JsonObject& json, const FieldMask* mask, const JsonConvertParam& param)
 {
     const RepeatedFieldDescriptor* field_desc = dynamic_cast<const RepeatedFieldDescriptor*>(&desc);
     assert(field_desc != nullptr);
@@ -213,7 +242,7 @@ void RepeatedFieldToJson(const Message& msg, const FieldDescriptor& desc, JsonOb
             case CPPTYPE_MESSAGE:
             {
                 JsonObject object = JsonObject::object();
-                MessageToJson(Reflection::RepeatedGetMessage(desc, *it), object, param);
+                MessageToJsonImpl(Reflection::RepeatedGetMessage(desc, *it), object, mask, param);
                 json.push_back(object);
                 break;
             }
@@ -226,7 +255,7 @@ void RepeatedFieldToJson(const Message& msg, const FieldDescriptor& desc, JsonOb
     }
 }
 
-void JsonToRepeatedField(const JsonObject& json, Message& msg, const FieldDescriptor& desc, const JsonConvertParam& param)
+void JsonToRepeatedField(const JsonObject& json, Message& msg, const FieldDescriptor& desc, const FieldMask* mask, const JsonConvertParam& param)
 {
     const RepeatedFieldDescriptor* field_desc = dynamic_cast<const RepeatedFieldDescriptor*>(&desc);
     assert(field_desc != nullptr);
@@ -282,7 +311,7 @@ void JsonToRepeatedField(const JsonObject& json, Message& msg, const FieldDescri
                 break;
             case CPPTYPE_MESSAGE:
                 if (param.skip_type_mismatch && !json[i].is_object()) continue;
-                JsonToMessage(json[i], Reflection::RepeatedAddMessage(msg, desc), param);
+                JsonToMessageImpl(json[i], Reflection::RepeatedAddMessage(msg, desc), mask, param);
                 break;
             default:
                 assert(false);
@@ -291,7 +320,7 @@ void JsonToRepeatedField(const JsonObject& json, Message& msg, const FieldDescri
     }
 }
 
-void MapFieldToJson(const Message& msg, const FieldDescriptor& desc, JsonObject& json, const JsonConvertParam& param)
+void MapFieldToJson(const Message& msg, const FieldDescriptor& desc, JsonObject& json, const FieldMask* mask, const JsonConvertParam& param)
 {
     const MapFieldDescriptor* field_desc = dynamic_cast<const MapFieldDescriptor*>(&desc);
     assert(field_desc != nullptr);
@@ -363,7 +392,7 @@ void MapFieldToJson(const Message& msg, const FieldDescriptor& desc, JsonObject&
                 break;
             case CPPTYPE_MESSAGE:
                 json[key_name] = JsonObject::object();
-                MessageToJson(Reflection::MapGetMessageValue(desc, *it), json[key_name], param);
+                MessageToJsonImpl(Reflection::MapGetMessageValue(desc, *it), json[key_name], mask, param);
                 break;
             default:
                 assert(false);
@@ -375,7 +404,8 @@ void MapFieldToJson(const Message& msg, const FieldDescriptor& desc, JsonObject&
 }
 
 template<typename K>
-void JsonToMapFieldImpl(const JsonObject& json, const K& key, Message& msg, const FieldDescriptor& desc, const MapFieldDescriptor* field_desc, const JsonConvertParam& param)
+void JsonToMapFieldImpl(const JsonObject& json, const K& key, Message& msg, const FieldDescriptor& desc, const MapFieldDescriptor* field_desc,
+        const FieldMask* mask, const JsonConvertParam& param)
 {
     switch (field_desc->GetValueCppType())
     {
@@ -426,7 +456,7 @@ void JsonToMapFieldImpl(const JsonObject& json, const K& key, Message& msg, cons
             break;
         case CPPTYPE_MESSAGE:
             if (param.skip_type_mismatch && !json.is_object()) return;
-            JsonToMessage(json, Reflection::MapSetWithMessageValue<K>(msg, desc, key), param);
+            JsonToMessageImpl(json, Reflection::MapSetWithMessageValue<K>(msg, desc, key), mask, param);
             break;
         default:
             assert(false);
@@ -434,7 +464,7 @@ void JsonToMapFieldImpl(const JsonObject& json, const K& key, Message& msg, cons
     }
 }
 
-void JsonToMapField(const JsonObject& json, Message& msg, const FieldDescriptor& desc, const JsonConvertParam& param)
+void JsonToMapField(const JsonObject& json, Message& msg, const FieldDescriptor& desc, const FieldMask* mask, const JsonConvertParam& param)
 {
     const MapFieldDescriptor* field_desc = dynamic_cast<const MapFieldDescriptor*>(&desc);
     assert(field_desc != nullptr);
@@ -444,29 +474,29 @@ void JsonToMapField(const JsonObject& json, Message& msg, const FieldDescriptor&
         switch (field_desc->GetKeyCppType())
         {
             case CPPTYPE_INT32:
-                JsonToMapFieldImpl<int32_t>(value, std::stoi(key_name), msg, desc, field_desc, param);
+                JsonToMapFieldImpl<int32_t>(value, std::stoi(key_name), msg, desc, field_desc, mask, param);
                 break;
             case CPPTYPE_UINT32:
-                JsonToMapFieldImpl<uint32_t>(value, std::stoul(key_name), msg, desc, field_desc, param);
+                JsonToMapFieldImpl<uint32_t>(value, std::stoul(key_name), msg, desc, field_desc, mask, param);
                 break;
             case CPPTYPE_INT64:
-                JsonToMapFieldImpl<int64_t>(value, std::stoll(key_name), msg, desc, field_desc, param);
+                JsonToMapFieldImpl<int64_t>(value, std::stoll(key_name), msg, desc, field_desc, mask, param);
                 break;
             case CPPTYPE_UINT64:
-                JsonToMapFieldImpl<uint64_t>(value, std::stoull(key_name), msg, desc, field_desc, param);
+                JsonToMapFieldImpl<uint64_t>(value, std::stoull(key_name), msg, desc, field_desc, mask, param);
                 break;
             case CPPTYPE_BOOL:
                 if (key_name == "false")
                 {
-                    JsonToMapFieldImpl<bool>(value, false, msg, desc, field_desc, param);
+                    JsonToMapFieldImpl<bool>(value, false, msg, desc, field_desc, mask, param);
                 }
                 else
                 {
-                    JsonToMapFieldImpl<bool>(value, true, msg, desc, field_desc, param);
+                    JsonToMapFieldImpl<bool>(value, true, msg, desc, field_desc, mask, param);
                 }
                 break;
             case CPPTYPE_STRING:
-                JsonToMapFieldImpl<std::string>(value, key_name, msg, desc, field_desc, param);
+                JsonToMapFieldImpl<std::string>(value, key_name, msg, desc, field_desc, mask, param);
                 break;
             default:
                 assert(false);
@@ -7,6 +7,8 @@
 namespace mrpc
 {
 
+class FieldMask;
+
 using JsonObject = nlohmann::ordered_json;
 
 struct JsonConvertParam
@@ -21,6 +23,9 @@ struct JsonConvertParam
     int indent = -1;                        // 缩进空格数(-1=紧凑)
     char indent_char = ' ';                 // 缩进字符(默认空格)
     bool ensure_ascii = true;               // 是否转义非ASCII字符
+
+    // 所有转换函数
+    const FieldMask* field_mask = nullptr;  // 只转换掩码内的字段(nullptr或空掩码=全部字段)
 };
 
 void MessageToJson(const Message& msg, JsonObject& json, const JsonConvertParam& param = JsonConvertParam());
@@ -1,4 +1,6 @@
+#include <mrpc/message/field_mask.h>
 #include <mrpc/message/message.h>
+#include <mrpc/message/reflection_codec.h>
 
 namespace mrpc
 {
@@ -22,9 +24,28 @@ void Message::SerializeToString(std::string& s, bool skip_default /*= true*/) co
     }
 }
 
+void Message::SerializeToString(std::string& s, const FieldMask& mask, bool skip_default /*= true*/) const
+{
+    if (mask.IsEmpty())
+    {
+        SerializeToString(s, skip_default);
+        return;
+    }
+    ReflectionCodec::SerializeToString(*this, &mask, s, skip_default);
+}
+
 bool Message::ParseFromString(std::string_view s)
 {
     return ParseFromBytes(reinterpret_cast<const uint8_t*>(s.data()), reinterpret_cast<const uint8_t*>(s.data() + s.size()));
 }
 
+bool Message::ParseFromString(std::string_view s, const FieldMask& mask)
+{
+    if (mask.IsEmpty())
+    {
+        return ParseFromString(s);
+    }
+    return ReflectionCodec::ParseFromString(*this, s, &mask);
+}
+
 }
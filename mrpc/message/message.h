@@ -9,6 +9,7 @@ namespace mrpc
 
 class EnumDescriptor;
 class Descriptor;
+class FieldMask;
 class Message;
 
 template<bool skip_default>
@@ -43,9 +44,13 @@ public:
 
     // Serialize.
     void SerializeToString(std::string& s, bool skip_default = true) const;
+    // 只序列化掩码内的字段.
+    void SerializeToString(std::string& s, const FieldMask& mask, bool skip_default = true) const;
 
     // Parse.
     bool ParseFromString(std::string_view s);
+    // 掩码之外的字段直接跳过, 不会写入消息.
+    bool ParseFromString(std::string_view s, const FieldMask& mask);
 
 protected:
     mutable size_t cached_size_ = 0;
@@ -5,6 +5,7 @@
 #include <string>
 #include <type_traits>
 
+#include <mrpc/message/field_type.h>
 #include <mrpc/message/message.h>
 
 #if (defined(__BYTE_ORDER__) && defined(__ORDER_LITTLE_ENDIAN__) && \
@@ -25,16 +26,6 @@
 namespace mrpc
 {
 
-enum WireType : int32_t
-{
-    WIRETYPE_VARINT             = 0,
-    WIRETYPE_FIXED64            = 1,
-    WIRETYPE_LENGTH_DELIMITED   = 2,
-    // WIRETYPE_START_GROUP     = 3,
-    // WIRETYPE_END_GROUP       = 4,
-    WIRETYPE_FIXED32            = 5,
-};
-
 //
 // Host endian <---> little endian
 //
@@ -102,24 +93,6 @@ constexpr inline int64_t ZigZagDecode(uint64_t n)
 //
 // type traits
 //
-enum FieldType : int32_t
-{
-    TYPE_VAR_UINT32         = 1,
-    TYPE_VAR_INT32          = 2,
-    TYPE_FIXED_UINT32       = 3,
-    TYPE_FIXED_INT32        = 4,
-    TYPE_ZIGZAG_INT32       = 5,
-    TYPE_VAR_UINT64         = 6,
-    TYPE_VAR_INT64          = 7,
-    TYPE_FIXED_UINT64       = 8,
-    TYPE_FIXED_INT64        = 9,
-    TYPE_ZIGZAG_INT64       = 10,
-    TYPE_FLOAT              = 11,
-    TYPE_DOUBLE             = 12,
-    TYPE_BOOL               = 13,
-    TYPE_STRING             = 14,
-};
-
 template<FieldType field_type>
 struct FieldWireTypeTraits
 {
@@ -1,3 +1,6 @@
+#include <cstring>
+#include <functional>
+#include <string_view>
 #include <mrpc/message/reflection.h>
 
 namespace mrpc
@@ -187,4 +190,50 @@ const Message& Reflection::MapGetMessageValue(const FieldDescriptor& desc, MapFi
     return it.GetValue<Message>();
 }
 
+void Reflection::CopyPodFields(const Message& from, Message& to)
+{
+    const Descriptor* desc = from.GetDescriptor();
+    assert(desc != nullptr && desc == to.GetDescriptor());
+    for (auto& run : desc->GetPodRuns())
+    {
+        memcpy(reinterpret_cast<char*>(&to) + run.offset, reinterpret_cast<const char*>(&from) + run.offset, run.size);
+    }
+}
+
+bool Reflection::PodFieldsEqual(const Message& a, const Message& b)
+{
+    const Descriptor* desc = a.GetDescriptor();
+    assert(desc != nullptr && desc == b.GetDescriptor());
+    for (auto& run : desc->GetPodRuns())
+    {
+        if (memcmp(reinterpret_cast<const char*>(&a) + run.offset, reinterpret_cast<const char*>(&b) + run.offset, run.size) != 0)
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+size_t Reflection::HashPodFields(const Message& msg, size_t seed)
+{
+    const Descriptor* desc = msg.GetDescriptor();
+    assert(desc != nullptr);
+    for (auto& run : desc->GetPodRuns())
+    {
+        size_t h = std::hash<std::string_view>()(std::string_view(reinterpret_cast<const char*>(&msg) + run.offset, run.size));
+        seed ^= h + 0x9e3779b9 + (seed << 6) + (seed >> 2);
+    }
+    return seed;
+}
+
+void Reflection::ClearPodFields(Message& msg)
+{
+    const Descriptor* desc = msg.GetDescriptor();
+    assert(desc != nullptr);
+    for (auto& run : desc->GetPodRuns())
+    {
+        memset(reinterpret_cast<char*>(&msg) + run.offset, 0, run.size);
+    }
+}
+
 }
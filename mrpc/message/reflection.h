@@ -1,6 +1,7 @@
 #pragma once
 
 #include <cassert>
+#include <cstddef>
 #include <memory>
 #include <mrpc/message/descriptor.h>
 
@@ -189,8 +190,38 @@ public:
         return *field_desc->Find<K, Message>(msg, key, true);
     }
 
+    // 以下函数按Descriptor::GetPodRuns()整段处理标量字段, 其余字段见Descriptor::GetNonPodFields().
+    static void CopyPodFields(const Message& from, Message& to);
+    static bool PodFieldsEqual(const Message& a, const Message& b);
+    static size_t HashPodFields(const Message& msg, size_t seed = 0);
+    static void ClearPodFields(Message& msg);
+
     using RepeatedIteratorPtr = std::unique_ptr<RepeatedFieldDescriptor::Iterator>;
     using MapIteratorPtr = std::unique_ptr<MapFieldDescriptor::Iterator>;
+
+    // 在栈上构造的迭代器, 不分配内存.
+    template<typename FieldDescriptorType>
+    class StackIterator
+    {
+    public:
+        using Iterator = typename FieldDescriptorType::Iterator;
+
+        StackIterator(const FieldDescriptorType& desc, const Message& msg) : it_(desc.NewIterator(msg, buffer_)) {}
+        ~StackIterator() { it_->~Iterator(); }
+
+        StackIterator(const StackIterator&) = delete;
+        StackIterator& operator=(const StackIterator&) = delete;
+
+        inline Iterator* operator->() const { return it_; }
+        inline Iterator& operator*() const { return *it_; }
+
+    private:
+        alignas(std::max_align_t) char buffer_[FieldDescriptorType::kIteratorBufferSize];
+        Iterator* it_ = nullptr;
+    };
+
+    using RepeatedStackIterator = StackIterator<RepeatedFieldDescriptor>;
+    using MapStackIterator = StackIterator<MapFieldDescriptor>;
 };
 
 }
@@ -0,0 +1,565 @@
+#include <cassert>
+#include <vector>
+
+#include <mrpc/message/field_mask.h>
+#include <mrpc/message/reflection.h>
+#include <mrpc/message/reflection_codec.h>
+#include <mrpc/message/reflection_internal.h>
+
+namespace mrpc
+{
+
+static inline size_t CalcTagByteSize(int32_t number, WireType wire_type)
+{
+    return CalcByteSize<TYPE_VAR_UINT32>((static_cast<uint32_t>(number) << 3) | wire_type);
+}
+
+static inline void SerializeTag(std::string& s, int32_t number, WireType wire_type)
+{
+    Serialize<TYPE_VAR_UINT32>(s, (static_cast<uint32_t>(number) << 3) | wire_type);
+}
+
+// 与生成代码一样和字段声明的默认值比较, proto2的默认值可以不为0.
+template<FieldType field_type>
+static inline bool IsDefaultValue(const Message& msg, const FieldDescriptor& field, const FieldValueType<field_type>& value)
+{
+    const char* data = reinterpret_cast<const char*>(&msg.GetDescriptor()->GetDefaultInstance()) + field.GetOffset();
+    return value == *reinterpret_cast<const FieldValueType<field_type>*>(data);
+}
+
+// mask为nullptr或没有子节点时处理全部字段.
+template<typename F>
+static inline void ForEachField(const Message& msg, const FieldMask* mask, F&& f)
+{
+    if (mask == nullptr || mask->IsEmpty())
+    {
+        const Descriptor* desc = msg.GetDescriptor();
+        assert(desc != nullptr);
+
+        for (const FieldDescriptor* field : desc->GetFields())
+        {
+            f(*field, nullptr);
+        }
+        return;
+    }
+
+    assert(mask->GetDescriptor() == msg.GetDescriptor());
+    for (const FieldMask& child : mask->GetChildren())
+    {
+        f(*child.GetField(), &child);
+    }
+}
+
+//
+// Encoder
+//
+// 两遍遍历: CalcMessageSize按先序记录每个子消息和packed字段的大小,
+// WriteMessage按同样的顺序读取, 嵌套消息的大小只计算一次.
+class ReflectionEncoder
+{
+public:
+    ReflectionEncoder(bool skip_default, std::vector<uint32_t>& sizes);
+
+    size_t CalcMessageSize(const Message& msg, const FieldMask* mask);
+    void WriteMessage(std::string& s, const Message& msg, const FieldMask* mask);
+
+    inline bool IsFinished() const { return cursor_ == sizes_.size(); }
+
+private:
+    bool skip_default_;
+    std::vector<uint32_t>& sizes_;
+    size_t cursor_ = 0;
+
+    uint32_t CalcNestedMessageSize(const Message& msg, const FieldMask* mask);
+    size_t CalcFieldSize(const Message& msg, const FieldDescriptor& field, const FieldMask* mask);
+    size_t CalcRepeatedFieldSize(const Message& msg, const RepeatedFieldDescriptor& field, const FieldMask* mask);
+    size_t CalcMapFieldSize(const Message& msg, const MapFieldDescriptor& field, const FieldMask* mask);
+
+    void WriteNestedMessage(std::string& s, const Message& msg, uint32_t size, const FieldMask* mask);
+    void WriteField(std::string& s, const Message& msg, const FieldDescriptor& field, const FieldMask* mask);
+    void WriteRepeatedField(std::string& s, const Message& msg, const RepeatedFieldDescriptor& field, const FieldMask* mask);
+    void WriteMapField(std::string& s, const Message& msg, const MapFieldDescriptor& field, const FieldMask* mask);
+};
+
+ReflectionEncoder::ReflectionEncoder(bool skip_default, std::vector<uint32_t>& sizes) :
+    skip_default_(skip_default),
+    sizes_(sizes)
+{
+}
+
+size_t ReflectionEncoder::CalcMessageSize(const Message& msg, const FieldMask* mask)
+{
+    size_t size = 0;
+    ForEachField(msg, mask, [&](const FieldDescriptor& field, const FieldMask* field_mask)
+    {
+        size += CalcFieldSize(msg, field, field_mask);
+    });
+    return size;
+}
+
+uint32_t ReflectionEncoder::CalcNestedMessageSize(const Message& msg, const FieldMask* mask)
+{
+    size_t slot = sizes_.size();
+    sizes_.push_back(0);
+
+    uint32_t size = static_cast<uint32_t>(CalcMessageSize(msg, mask));
+    if (size == 0)
+    {
+        // 空消息不会展开写入, 丢弃其内部记录的大小.
+        sizes_.resize(slot + 1);
+    }
+    sizes_[slot] = size;
+    return size;
+}
+
+size_t ReflectionEncoder::CalcFieldSize(const Message& msg, const FieldDescriptor& field, const FieldMask* mask)
+{
+    switch (field.GetCppType())
+    {
+        case CPPTYPE_MESSAGE:
+        {
+            uint32_t size = CalcNestedMessageSize(Reflection::GetMessage(msg, field), mask);
+            if (size == 0) return 0;
+            return CalcTagByteSize(field.GetNumber(), WIRETYPE_LENGTH_DELIMITED) + CalcByteSize<TYPE_VAR_UINT32>(size) + size;
+        }
+        case CPPTYPE_VECTOR:
+        case CPPTYPE_LIST:
+            return CalcRepeatedFieldSize(msg, static_cast<const RepeatedFieldDescriptor&>(field), mask);
+        case CPPTYPE_MAP:
+        case CPPTYPE_UNORDERED_MAP:
+            return CalcMapFieldSize(msg, static_cast<const MapFieldDescriptor&>(field), mask);
+        default:
+            break;
+    }
+
+    const char* data = reinterpret_cast<const char*>(&msg) + field.GetOffset();
+    return VisitFieldType(field.GetFieldType(), [&]<FieldType field_type>() -> size_t
+    {
+        const FieldValueType<field_type>& value = *reinterpret_cast<const FieldValueType<field_type>*>(data);
+        if (skip_default_ && IsDefaultValue<field_type>(msg, field, value)) return 0;
+        return CalcTagByteSize(field.GetNumber(), field.GetWireType()) + CalcByteSize<field_type>(value);
+    });
+}
+
+size_t ReflectionEncoder::CalcRepeatedFieldSize(const Message& msg, const RepeatedFieldDescriptor& field, const FieldMask* mask)
+{
+    Reflection::RepeatedStackIterator it(field, msg);
+    if (!it->HasNext()) return 0;
+
+    size_t tag_size = CalcTagByteSize(field.GetNumber(), WIRETYPE_LENGTH_DELIMITED);
+    size_t size = 0;
+    if (field.GetValueCppType() == CPPTYPE_MESSAGE)
+    {
+        for (; it->HasNext(); it->Next())
+        {
+            uint32_t msg_size = CalcNestedMessageSize(it->Get<Message>(), mask);
+            size += tag_size + CalcByteSize<TYPE_VAR_UINT32>(msg_size) + msg_size;
+        }
+        return size;
+    }
+
+    if (field.GetValueCppType() == CPPTYPE_STRING)
+    {
+        for (; it->HasNext(); it->Next())
+        {
+            size += tag_size + CalcByteSize<TYPE_STRING>(it->Get<std::string>());
+        }
+        return size;
+    }
+
+    // packed
+    VisitFieldType(field.GetValueFieldType(), [&]<FieldType field_type>()
+    {
+        for (; it->HasNext(); it->Next())
+        {
+            size += CalcByteSize<field_type>(it->Get<FieldValueType<field_type>>());
+        }
+    });
+    sizes_.push_back(static_cast<uint32_t>(size));
+    return tag_size + CalcByteSize<TYPE_VAR_UINT32>(static_cast<uint32_t>(size)) + size;
+}
+
+size_t ReflectionEncoder::CalcMapFieldSize(const Message& msg, const MapFieldDescriptor& field, const FieldMask* mask)
+{
+    Reflection::MapStackIterator it(field, msg);
+    size_t tag_size = CalcTagByteSize(field.GetNumber(), WIRETYPE_LENGTH_DELIMITED);
+    size_t size = 0;
+
+    VisitFieldType(field.GetKeyFieldType(), [&]<FieldType key_field_type>()
+    {
+        if (field.GetValueCppType() == CPPTYPE_MESSAGE)
+        {
+            for (; it->HasNext(); it->Next())
+            {
+                uint32_t msg_size = CalcNestedMessageSize(it->GetValue<Message>(), mask);
+                size_t entry_size = 2 + CalcByteSize<key_field_type>(it->GetKey<FieldValueType<key_field_type>>()) +
+                    CalcByteSize<TYPE_VAR_UINT32>(msg_size) + msg_size;
+                size += tag_size + CalcByteSize<TYPE_VAR_UINT32>(static_cast<uint32_t>(entry_size)) + entry_size;
+            }
+            return;
+        }
+
+        VisitFieldType(field.GetValueFieldType(), [&]<FieldType value_field_type>()
+        {
+            for (; it->HasNext(); it->Next())
+            {
+                size_t entry_size = 2 + CalcByteSize<key_field_type>(it->GetKey<FieldValueType<key_field_type>>()) +
+                    CalcByteSize<value_field_type>(it->GetValue<FieldValueType<value_field_type>>());
+                size += tag_size + CalcByteSize<TYPE_VAR_UINT32>(static_cast<uint32_t>(entry_size)) + entry_size;
+            }
+        });
+    });
+    return size;
+}
+
+void ReflectionEncoder::WriteMessage(std::string& s, const Message& msg, const FieldMask* mask)
+{
+    ForEachField(msg, mask, [&](const FieldDescriptor& field, const FieldMask* field_mask)
+    {
+        WriteField(s, msg, field, field_mask);
+    });
+}
+
+void ReflectionEncoder::WriteNestedMessage(std::string& s, const Message& msg, uint32_t size, const FieldMask* mask)
+{
+    Serialize<TYPE_VAR_UINT32>(s, size);
+    if (size > 0)
+    {
+        WriteMessage(s, msg, mask);
+    }
+}
+
+void ReflectionEncoder::WriteField(std::string& s, const Message& msg, const FieldDescriptor& field, const FieldMask* mask)
+{
+    switch (field.GetCppType())
+    {
+        case CPPTYPE_MESSAGE:
+        {
+            assert(cursor_ < sizes_.size());
+            uint32_t size = sizes_[cursor_++];
+            if (size == 0) return;
+            SerializeTag(s, field.GetNumber(), WIRETYPE_LENGTH_DELIMITED);
+            WriteNestedMessage(s, Reflection::GetMessage(msg, field), size, mask);
+            return;
+        }
+        case CPPTYPE_VECTOR:
+        case CPPTYPE_LIST:
+            WriteRepeatedField(s, msg, static_cast<const RepeatedFieldDescriptor&>(field), mask);
+            return;
+        case CPPTYPE_MAP:
+        case CPPTYPE_UNORDERED_MAP:
+            WriteMapField(s, msg, static_cast<const MapFieldDescriptor&>(field), mask);
+            return;
+        default:
+            break;
+    }
+
+    const char* data = reinterpret_cast<const char*>(&msg) + field.GetOffset();
+    VisitFieldType(field.GetFieldType(), [&]<FieldType field_type>()
+    {
+        const FieldValueType<field_type>& value = *reinterpret_cast<const FieldValueType<field_type>*>(data);
+        if (skip_default_ && IsDefaultValue<field_type>(msg, field, value)) return;
+        SerializeTag(s, field.GetNumber(), field.GetWireType());
+        Serialize<field_type>(s, value);
+    });
+}
+
+void ReflectionEncoder::WriteRepeatedField(std::string& s, const Message& msg, const RepeatedFieldDescriptor& field, const FieldMask* mask)
+{
+    Reflection::RepeatedStackIterator it(field, msg);
+    if (!it->HasNext()) return;
+
+    if (field.GetValueCppType() == CPPTYPE_MESSAGE)
+    {
+        for (; it->HasNext(); it->Next())
+        {
+            assert(cursor_ < sizes_.size());
+            SerializeTag(s, field.GetNumber(), WIRETYPE_LENGTH_DELIMITED);
+            WriteNestedMessage(s, it->Get<Message>(), sizes_[cursor_++], mask);
+        }
+        return;
+    }
+
+    if (field.GetValueCppType() == CPPTYPE_STRING)
+    {
+        for (; it->HasNext(); it->Next())
+        {
+            SerializeTag(s, field.GetNumber(), WIRETYPE_LENGTH_DELIMITED);
+            Serialize<TYPE_STRING>(s, it->Get<std::string>());
+        }
+        return;
+    }
+
+    // packed
+    assert(cursor_ < sizes_.size());
+    SerializeTag(s, field.GetNumber(), WIRETYPE_LENGTH_DELIMITED);
+    Serialize<TYPE_VAR_UINT32>(s, sizes_[cursor_++]);
+    VisitFieldType(field.GetValueFieldType(), [&]<FieldType field_type>()
+    {
+        for (; it->HasNext(); it->Next())
+        {
+            Serialize<field_type>(s, it->Get<FieldValueType<field_type>>());
+        }
+    });
+}
+
+void ReflectionEncoder::WriteMapField(std::string& s, const Message& msg, const MapFieldDescriptor& field, const FieldMask* mask)
+{
+    Reflection::MapStackIterator it(field, msg);
+    const char key_tag = static_cast<char>(0x08 | FieldTypeToWireType(field.GetKeyFieldType()));
+    const char value_tag = static_cast<char>(0x10 | FieldTypeToWireType(field.GetValueFieldType()));
+
+    VisitFieldType(field.GetKeyFieldType(), [&]<FieldType key_field_type>()
+    {
+        if (field.GetValueCppType() == CPPTYPE_MESSAGE)
+        {
+            for (; it->HasNext(); it->Next())
+            {
+                assert(cursor_ < sizes_.size());
+                uint32_t msg_size = sizes_[cursor_++];
+                const FieldValueType<key_field_type>& key = it->GetKey<FieldValueType<key_field_type>>();
+                size_t entry_size = 2 + CalcByteSize<key_field_type>(key) + CalcByteSize<TYPE_VAR_UINT32>(msg_size) + msg_size;
+
+                SerializeTag(s, field.GetNumber(), WIRETYPE_LENGTH_DELIMITED);
+                Serialize<TYPE_VAR_UINT32>(s, static_cast<uint32_t>(entry_size));
+                s.push_back(key_tag);
+                Serialize<key_field_type>(s, key);
+                s.push_back(value_tag);
+                WriteNestedMessage(s, it->GetValue<Message>(), msg_size, mask);
+            }
+            return;
+        }
+
+        VisitFieldType(field.GetValueFieldType(), [&]<FieldType value_field_type>()
+        {
+            for (; it->HasNext(); it->Next())
+            {
+                const FieldValueType<key_field_type>& key = it->GetKey<FieldValueType<key_field_type>>();
+                const FieldValueType<value_field_type>& value = it->GetValue<FieldValueType<value_field_type>>();
+                size_t entry_size = 2 + CalcByteSize<key_field_type>(key) + CalcByteSize<value_field_type>(value);
+
+                SerializeTag(s, field.GetNumber(), WIRETYPE_LENGTH_DELIMITED);
+                Serialize<TYPE_VAR_UINT32>(s, static_cast<uint32_t>(entry_size));
+                s.push_back(key_tag);
+                Serialize<key_field_type>(s, key);
+                s.push_back(value_tag);
+                Serialize<value_field_type>(s, value);
+            }
+        });
+    });
+}
+
+//
+// Decoder
+//
+static bool ParseMessage(Message& msg, const uint8_t*& begin, const uint8_t* const end, const FieldMask* mask);
+
+static bool ParseNestedMessage(Message& msg, const uint8_t*& begin, const uint8_t* const end, const FieldMask* mask)
+{
+    uint32_t size = 0;
+    if (!Parse<TYPE_VAR_UINT32>(size, begin, end)) return false;
+    if (begin + size > end) return false;
+
+    const uint8_t* p = begin;
+    if (!ParseMessage(msg, p, begin + size, mask)) return false;
+
+    begin += size;
+    return true;
+}
+
+static bool ParseRepeatedField(uint32_t type, Message& msg, const RepeatedFieldDescriptor& field, const uint8_t*& begin, const uint8_t* const end,
+        const FieldMask* mask)
+{
+    if (field.GetValueCppType() == CPPTYPE_MESSAGE)
+    {
+        if (type != WIRETYPE_LENGTH_DELIMITED) return false;
+        return ParseNestedMessage(Reflection::RepeatedAddMessage(msg, field), begin, end, mask);
+    }
+
+    if (field.GetValueCppType() == CPPTYPE_STRING)
+    {
+        if (type != WIRETYPE_LENGTH_DELIMITED) return false;
+        return Parse<TYPE_STRING>(field.Add<std::string>(msg), begin, end);
+    }
+
+    return VisitFieldType(field.GetValueFieldType(), [&]<FieldType field_type>() -> bool
+    {
+        if (type == WIRETYPE_LENGTH_DELIMITED)
+        {
+            uint32_t size = 0;
+            if (!Parse<TYPE_VAR_UINT32>(size, begin, end)) return false;
+
+            const uint8_t* const real_end = begin + size;
+            if (real_end > end) return false;
+
+            while (begin < real_end)
+            {
+                FieldValueType<field_type> value;
+                if (!Parse<field_type>(value, begin, real_end)) return false;
+
+                field.Add<FieldValueType<field_type>>(msg) = value;
+            }
+            return true;
+        }
+        else if (type == FieldTypeToWireType(field_type))
+        {
+            FieldValueType<field_type> value;
+            if (!Parse<field_type>(value, begin, end)) return false;
+
+            field.Add<FieldValueType<field_type>>(msg) = value;
+            return true;
+        }
+        return false;
+    });
+}
+
+static bool ParseMapField(uint32_t type, Message& msg, const MapFieldDescriptor& field, const uint8_t*& begin, const uint8_t* const end,
+        const FieldMask* mask)
+{
+    if (type != WIRETYPE_LENGTH_DELIMITED) return false;
+
+    uint32_t size = 0;
+    if (!Parse<TYPE_VAR_UINT32>(size, begin, end)) return false;
+
+    const uint8_t* const real_end = begin + size;
+    if (real_end > end) return false;
+
+    if (begin >= real_end || begin[0] != (0x08 | FieldTypeToWireType(field.GetKeyFieldType()))) return false;
+    begin += 1;
+
+    return VisitFieldType(field.GetKeyFieldType(), [&]<FieldType key_field_type>() -> bool
+    {
+        FieldValueType<key_field_type> key;
+        if (!Parse<key_field_type>(key, begin, real_end)) return false;
+
+        if (begin >= real_end || begin[0] != (0x10 | FieldTypeToWireType(field.GetValueFieldType()))) return false;
+        begin += 1;
+
+        if (field.GetValueCppType() == CPPTYPE_MESSAGE)
+        {
+            Message* value = field.Find<FieldValueType<key_field_type>, Message>(msg, key, true);
+            return ParseNestedMessage(*value, begin, real_end, mask) && begin == real_end;
+        }
+
+        bool result = VisitFieldType(field.GetValueFieldType(), [&]<FieldType value_field_type>() -> bool
+        {
+            FieldValueType<value_field_type>* value =
+                field.Find<FieldValueType<key_field_type>, FieldValueType<value_field_type>>(msg, key, true);
+            return Parse<value_field_type>(*value, begin, real_end);
+        });
+        return result && begin == real_end;
+    });
+}
+
+static bool ParseField(uint32_t type, Message& msg, const FieldDescriptor& field, const uint8_t*& begin, const uint8_t* const end,
+        const FieldMask* mask)
+{
+    switch (field.GetCppType())
+    {
+        case CPPTYPE_MESSAGE:
+            if (type != WIRETYPE_LENGTH_DELIMITED) return false;
+            return ParseNestedMessage(Reflection::GetMessage(msg, field), begin, end, mask);
+        case CPPTYPE_VECTOR:
+        case CPPTYPE_LIST:
+            return ParseRepeatedField(type, msg, static_cast<const RepeatedFieldDescriptor&>(field), begin, end, mask);
+        case CPPTYPE_MAP:
+        case CPPTYPE_UNORDERED_MAP:
+            return ParseMapField(type, msg, static_cast<const MapFieldDescriptor&>(field), begin, end, mask);
+        default:
+            break;
+    }
+
+    if (type != static_cast<uint32_t>(field.GetWireType())) return false;
+
+    char* data = reinterpret_cast<char*>(&msg) + field.GetOffset();
+    return VisitFieldType(field.GetFieldType(), [&]<FieldType field_type>() -> bool
+    {
+        return Parse<field_type>(*reinterpret_cast<FieldValueType<field_type>*>(data), begin, end);
+    });
+}
+
+bool ParseMessage(Message& msg, const uint8_t*& begin, const uint8_t* const end, const FieldMask* mask)
+{
+    const Descriptor* desc = msg.GetDescriptor();
+    assert(desc != nullptr);
+
+    if (mask != nullptr && mask->IsEmpty()) mask = nullptr;
+    assert(mask == nullptr || mask->GetDescriptor() == desc);
+
+    uint32_t number = 0, type = 0;
+    while (begin < end)
+    {
+        if (!ParseTag(number, type, begin, end)) return false;
+
+        // 掩码之外的字段按未知字段跳过, 不会写入消息.
+        const FieldMask* field_mask = nullptr;
+        const FieldDescriptor* field = nullptr;
+        if (mask == nullptr)
+        {
+            field = desc->FindFieldByNumber(static_cast<int32_t>(number));
+        }
+        else if ((field_mask = mask->FindChild(static_cast<int32_t>(number))) != nullptr)
+        {
+            field = field_mask->GetField();
+        }
+
+        if (field == nullptr)
+        {
+            if (!ParseSkipUnknown(type, begin, end)) return false;
+            continue;
+        }
+
+        if (!ParseField(type, msg, *field, begin, end, field_mask)) return false;
+    }
+    return true;
+}
+
+//
+// ReflectionCodec
+//
+static thread_local std::vector<uint32_t> t_sizes;
+
+size_t ReflectionCodec::ByteSize(const Message& msg, bool skip_default/* = true*/)
+{
+    return ByteSize(msg, nullptr, skip_default);
+}
+
+size_t ReflectionCodec::ByteSize(const Message& msg, const FieldMask* mask, bool skip_default/* = true*/)
+{
+    t_sizes.clear();
+    ReflectionEncoder encoder(skip_default, t_sizes);
+    return encoder.CalcMessageSize(msg, mask);
+}
+
+void ReflectionCodec::SerializeToString(const Message& msg, std::string& s, bool skip_default/* = true*/)
+{
+    SerializeToString(msg, nullptr, s, skip_default);
+}
+
+void ReflectionCodec::SerializeToString(const Message& msg, const FieldMask* mask, std::string& s, bool skip_default/* = true*/)
+{
+    t_sizes.clear();
+    ReflectionEncoder encoder(skip_default, t_sizes);
+    size_t size = encoder.CalcMessageSize(msg, mask);
+
+    s.clear();
+    if (s.capacity() < size)
+    {
+        s.reserve(size);
+    }
+    encoder.WriteMessage(s, msg, mask);
+    assert(encoder.IsFinished());
+    assert(s.size() == size);
+}
+
+bool ReflectionCodec::ParseFromString(Message& msg, std::string_view s, const FieldMask* mask/* = nullptr*/)
+{
+    return ParseFromBytes(msg, reinterpret_cast<const uint8_t*>(s.data()), reinterpret_cast<const uint8_t*>(s.data() + s.size()), mask);
+}
+
+bool ReflectionCodec::ParseFromBytes(Message& msg, const uint8_t* begin, const uint8_t* const end, const FieldMask* mask/* = nullptr*/)
+{
+    return ParseMessage(msg, begin, end, mask);
+}
+
+}
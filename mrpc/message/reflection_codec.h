@@ -0,0 +1,30 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+#include <mrpc/message/message.h>
+
+namespace mrpc
+{
+
+class FieldMask;
+
+// 只依赖Descriptor的二进制编解码, 输出与生成代码的SerializeToString一致.
+// 可用于代理, 录制回放等不感知具体消息类型的场景.
+// mask不为空时只处理掩码内的字段, 解析时掩码之外的字段直接跳过.
+class ReflectionCodec
+{
+public:
+    static size_t ByteSize(const Message& msg, bool skip_default = true);
+    static size_t ByteSize(const Message& msg, const FieldMask* mask, bool skip_default = true);
+
+    static void SerializeToString(const Message& msg, std::string& s, bool skip_default = true);
+    static void SerializeToString(const Message& msg, const FieldMask* mask, std::string& s, bool skip_default = true);
+
+    static bool ParseFromString(Message& msg, std::string_view s, const FieldMask* mask = nullptr);
+    static bool ParseFromBytes(Message& msg, const uint8_t* begin, const uint8_t* const end, const FieldMask* mask = nullptr);
+};
+
+}
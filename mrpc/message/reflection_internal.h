@@ -0,0 +1,39 @@
+#pragma once
+
+#include <cassert>
+
+#include <mrpc/message/message_internal.h>
+
+namespace mrpc
+{
+
+template<FieldType field_type>
+using FieldValueType = typename FieldCppTypeTraits<field_type>::ValueType;
+
+// 把运行时的FieldType分发到模板参数, 循环体内不再有类型判断.
+template<typename F>
+inline auto VisitFieldType(FieldType field_type, F&& f) -> decltype(f.template operator()<TYPE_BOOL>())
+{
+    switch (field_type)
+    {
+        case TYPE_VAR_UINT32: return f.template operator()<TYPE_VAR_UINT32>();
+        case TYPE_VAR_INT32: return f.template operator()<TYPE_VAR_INT32>();
+        case TYPE_FIXED_UINT32: return f.template operator()<TYPE_FIXED_UINT32>();
+        case TYPE_FIXED_INT32: return f.template operator()<TYPE_FIXED_INT32>();
+        case TYPE_ZIGZAG_INT32: return f.template operator()<TYPE_ZIGZAG_INT32>();
+        case TYPE_VAR_UINT64: return f.template operator()<TYPE_VAR_UINT64>();
+        case TYPE_VAR_INT64: return f.template operator()<TYPE_VAR_INT64>();
+        case TYPE_FIXED_UINT64: return f.template operator()<TYPE_FIXED_UINT64>();
+        case TYPE_FIXED_INT64: return f.template operator()<TYPE_FIXED_INT64>();
+        case TYPE_ZIGZAG_INT64: return f.template operator()<TYPE_ZIGZAG_INT64>();
+        case TYPE_FLOAT: return f.template operator()<TYPE_FLOAT>();
+        case TYPE_DOUBLE: return f.template operator()<TYPE_DOUBLE>();
+        case TYPE_BOOL: return f.template operator()<TYPE_BOOL>();
+        case TYPE_STRING: return f.template operator()<TYPE_STRING>();
+        default: break;
+    }
+    assert(false && "unknown type");
+    return decltype(f.template operator()<TYPE_BOOL>())();
+}
+
+}
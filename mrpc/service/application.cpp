@@ -6,6 +6,8 @@
 #include <fstream>
 #include <sstream>
 
+#include <mrpc/error_code.mrpc.h>
+#include <mrpc/message/descriptor.h>
 #include <mrpc/message/json.h>
 #include <mrpc/service/application.h>
 #include <mrpc/service/endpoint.h>
@@ -108,10 +110,36 @@ int Application::Initialize()
 {
     int ret = 0;
 
+    DescriptorPool::Freeze();
+
+    if (config_.proxy.io_thread_num == 0)
+    {
+        MRPC_LOG_ERROR("Proxy io_thread_num must be greater than 0.");
+        return ERROR_INITIALIZATION_FAILED;
+    }
+    GlobalProxy::SetIoThreadNum(config_.proxy.io_thread_num);
+
     for (const auto& stub_config : config_.proxy.stub)
     {
-        Endpoint endpoint = Endpoint::ParseFromConfig(stub_config.network);
-        GlobalProxy::RegisterLocalEndpoint(stub_config.name, endpoint);
+        if (stub_config.endpoint.empty())
+        {
+            Endpoint endpoint = Endpoint::ParseFromConfig(stub_config.network);
+            GlobalProxy::RegisterLocalEndpoint(stub_config.name, endpoint);
+        }
+        else
+        {
+            std::vector<Endpoint> endpoints;
+            for (const auto& network_config : stub_config.endpoint)
+            {
+                endpoints.push_back(Endpoint::ParseFromConfig(network_config));
+            }
+            GlobalProxy::RegisterLocalEndpoints(stub_config.name, endpoints, stub_config.balance);
+        }
+
+        for (const auto& hedging_config : stub_config.hedging)
+        {
+            GlobalProxy::RegisterHedgingPolicy(stub_config.name, hedging_config);
+        }
     }
 
     for (const auto& service_config : config_.server.service)
@@ -157,6 +185,8 @@ void Application::MainLoop()
 
     uint32_t loop_interval = config_.common.loop_interval;
     uint64_t next_loop_time = Time::Now() + loop_interval;
+    uint32_t metrics_interval = config_.common.metrics_interval;
+    uint64_t next_metrics_time = Time::Now() + metrics_interval;
     MainThreadVisitor visitor;
     std::chrono::milliseconds timeout(20);
     while (running_)
@@ -171,6 +201,20 @@ void Application::MainLoop()
             }
         }
 
+        if (metrics_interval > 0)
+        {
+            uint64_t now = Time::Now();
+            if (now >= next_metrics_time)
+            {
+                for (const auto& bridge_ptr : bridge_)
+                {
+                    bridge_ptr->LogMetrics();
+                }
+                GlobalProxy::LogMetrics();
+                next_metrics_time = now + metrics_interval;
+            }
+        }
+
         ContextPtrWrapper context_wrapper;
         if (!main_queue_.wait_and_pop(context_wrapper, timeout))
         {
@@ -181,6 +225,18 @@ void Application::MainLoop()
     }
 }
 
+const ServiceMetrics* Application::GetServiceMetrics(const std::string& name) const
+{
+    for (const auto& bridge_ptr : bridge_)
+    {
+        if (bridge_ptr->GetConfig().name == name)
+        {
+            return &bridge_ptr->GetMetrics();
+        }
+    }
+    return nullptr;
+}
+
 void Application::Finalize()
 {
     for (auto& bridge_ptr : bridge_)
@@ -32,6 +32,9 @@ public:
     void MainLoop();
     void Finalize();
 
+    // 按名字查找Service的统计数据, 不存在时返回nullptr.
+    const ServiceMetrics* GetServiceMetrics(const std::string& name) const;
+
 private:
     ApplicationConfig config_;
     std::vector<std::unique_ptr<ServiceBridge>> bridge_;
@@ -0,0 +1,72 @@
+#pragma once
+
+#include <cassert>
+#include <coroutine>
+#include <cstdint>
+#include <memory>
+#include <string>
+
+#include <mrpc/error_code.mrpc.h>
+#include <mrpc/message/field_mask.h>
+#include <mrpc/service/callback.h>
+#include <mrpc/service/context.h>
+#include <mrpc/service/service_stub.h>
+
+namespace mrpc
+{
+
+// 生成代码中Foo_Co的返回值, 在协程(见mrpc/util/task.h)中co_await得到错误码, 成功时rsp为响应.
+// 请求按异步调用发出, 回包由发起调用线程的ContextPtrQueue处理, 协程在该线程中恢复, 不阻塞线程.
+// 只能在worker线程和主线程中使用.
+template<typename T>
+    requires(std::is_base_of_v<Message, T>)
+class CallAwaiter final
+{
+public:
+    CallAwaiter(ServiceStub& stub, uint32_t method_code, std::string&& req_data, T& rsp, const FieldMask& rsp_field_mask) :
+        stub_(stub),
+        method_code_(method_code),
+        req_data_(std::move(req_data)),
+        callback_(std::make_shared<ResumeCallback>(rsp, rsp_field_mask))
+    {
+    }
+
+    bool await_ready() const noexcept { return false; }
+
+    void await_suspend(std::coroutine_handle<> handle)
+    {
+        assert(GetCurrentThreadContextPtrQueue() != nullptr);
+        callback_->handle = handle;
+        stub_.CallMethod(method_code_, std::move(req_data_), callback_->rsp_field_mask.ToString(), callback_);
+    }
+
+    int32_t await_resume() const noexcept { return callback_->ret; }
+
+private:
+    struct ResumeCallback final : public Callback
+    {
+        ResumeCallback(T& rsp, const FieldMask& rsp_field_mask) : rsp(rsp), rsp_field_mask(rsp_field_mask) {}
+
+        void Done(int32_t ret, const std::string& rsp_data) override
+        {
+            if (ret == 0 && !rsp.ParseFromString(rsp_data, rsp_field_mask))
+            {
+                ret = ERROR_INVALID_METHOD_RESPONSE_DATA;
+            }
+            this->ret = ret;
+            handle.resume();
+        }
+
+        T& rsp;
+        FieldMask rsp_field_mask;
+        int32_t ret = 0;
+        std::coroutine_handle<> handle;
+    };
+
+    ServiceStub& stub_;
+    uint32_t method_code_ = 0;
+    std::string req_data_;
+    std::shared_ptr<ResumeCallback> callback_;
+};
+
+}
@@ -1,5 +1,6 @@
 #pragma once
 
+#include <atomic>
 #include <cstdint>
 #include <string>
 #include <memory>
@@ -26,6 +27,7 @@ struct ServiceContext final : public std::enable_shared_from_this<ServiceContext
 {
     // Set by IO thread
     uint64_t conn_id = 0;
+    uint32_t io_index = 0;  // 接收请求的IO线程, 回包由它发送
     uint64_t seq_id = 0;
     std::string host;
     uint32_t port = 0;
@@ -45,19 +47,41 @@ struct ServiceStubContextNotifier
 {
     std::mutex mtx;
     std::condition_variable cv;
+    bool done = false;  // 由IO线程在持有mtx时设置, 防止虚假唤醒
+};
+
+struct ServiceStubContext;
+
+// 主请求和对冲请求共享, 两者可能在不同的IO线程中完成, 只有先完成的一个通知调用方
+struct HedgeState
+{
+    std::atomic<bool> done = false;
+    std::atomic<uint32_t> outstanding = 0;      // 还没有完成的请求数
+    std::shared_ptr<ServiceStubContext> primary;    // 持有调用方的callback或notifier, 完成时释放
 };
 
 struct ServiceStubContext final : public std::enable_shared_from_this<ServiceStubContext>
 {
     // Set by worker thread
     uint64_t stub_id = 0;
+    uint32_t io_index = 0;  // 客户端IO线程
     uint64_t seq_id = 0;
     Endpoint endpoint;
     Protocol protocol;
 
     ServiceContextRequestParam param;
+    std::string rsp_field_mask;
     std::string request;
 
+    std::shared_ptr<EndpointGroup> endpoints;   // 配置了多个地址或对冲时不为空, 由IO线程在完成时反馈给balancer
+    uint32_t endpoint_index = 0;
+    uint64_t start_time = 0;    // 微秒
+
+    HedgingPolicy* hedging = nullptr;   // 方法配置了对冲时不为空, 属于endpoints
+    uint32_t method_code = 0;
+    std::shared_ptr<const std::string> request_data;  // 用于重新打包对冲请求, 接管自调用方
+    std::shared_ptr<HedgeState> hedge;  // Set by IO thread, 已发送对冲请求时不为空
+
     std::unique_ptr<ServiceStubContextNotifier> notifier; // Sync call
     void* queue = nullptr; // Async call (thread_local ContextPtrQueue*)
     std::shared_ptr<Callback> callback;
@@ -1,3 +1,6 @@
+#include <algorithm>
+#include <format>
+
 #include <mrpc/service/endpoint.h>
 #include <mrpc/service/application_config.mrpc.h>
 
@@ -10,8 +13,43 @@ Endpoint Endpoint::ParseFromConfig(const NetworkConfig& config)
     endpoint.protocol = config.protocol;
     endpoint.host = config.host;
     endpoint.port = config.port;
+    endpoint.path = config.path;
     endpoint.timeout = config.timeout;
+    endpoint.io_backend = config.io_backend;
+    endpoint.pool_size = config.pool_size;
+    endpoint.pool_balance = config.pool_balance;
+    endpoint.reconnect_interval = config.reconnect_interval;
+    endpoint.max_reconnect_interval = config.max_reconnect_interval;
+    endpoint.max_send_buffer_bytes = config.max_send_buffer_bytes;
+    endpoint.weight = config.weight;
     return endpoint;
 }
 
+std::string Endpoint::GetAddress() const
+{
+    if (protocol == pipe || protocol == shm)
+    {
+        return std::format("{}://{}", NetworkProtocolConfig_Name(protocol), path);
+    }
+    return std::format("{}://{}:{}", NetworkProtocolConfig_Name(protocol), host, port);
+}
+
+HedgingPolicy::HedgingPolicy(const HedgingConfig& config) :
+    method(config.method),
+    delay(config.delay),
+    percentile(config.percentile),
+    budget(config.budget_percent)
+{
+}
+
+uint64_t HedgingPolicy::GetDelay() const
+{
+    if (delay != 0)
+    {
+        return delay;
+    }
+    uint64_t latency_us = latency.GetPercentile(percentile);
+    return latency_us == 0 ? 0 : std::max<uint64_t>((latency_us + 999) / 1000, 1);
+}
+
 }
@@ -1,21 +1,70 @@
 #pragma once
 
+#include <atomic>
 #include <cstdint>
+#include <map>
+#include <memory>
 #include <string>
+#include <vector>
+
+#include <mrpc/util/latency_histogram.h>
+#include <mrpc/util/load_balancer.h>
+#include <mrpc/util/retry_budget.h>
 
 namespace mrpc
 {
 
 class NetworkConfig;
+class HedgingConfig;
 
 struct Endpoint
 {
     int32_t protocol = 0;
     std::string host;
     uint32_t port = 0;
+    std::string path;
     uint32_t timeout = 0;
+    int32_t io_backend = 0;
+    uint32_t pool_size = 1;
+    int32_t pool_balance = 0;
+    uint32_t reconnect_interval = 0;
+    uint32_t max_reconnect_interval = 0;
+    uint32_t max_send_buffer_bytes = 0;
+    uint32_t weight = 0;
+    uint32_t address_id = 0;    // GetAddress相同的Endpoint编号相同, 由GlobalProxy注册时分配
 
     static Endpoint ParseFromConfig(const NetworkConfig& config);
+
+    // 传输协议和地址相同的Endpoint共享同一个连接池.
+    std::string GetAddress() const;
+};
+
+// 一个方法的对冲策略. 耗时样本和预算由客户端IO线程更新, 统计数据由主线程定期打印.
+struct HedgingPolicy
+{
+    explicit HedgingPolicy(const HedgingConfig& config);
+
+    // 发送对冲请求的延迟(毫秒), 0表示耗时样本不足, 不发送
+    uint64_t GetDelay() const;
+
+    std::string method;
+    uint32_t delay = 0;
+    uint32_t percentile = 0;
+    LatencyHistogram latency;   // 得到后端处理结果的请求的耗时(微秒)
+    RetryBudget budget;
+
+    std::atomic<uint64_t> hedged_requests = 0;  // 发送的对冲请求数
+    std::atomic<uint64_t> hedges_won = 0;       // 对冲请求先成功回包的次数
+    std::atomic<uint64_t> budget_exhausted = 0; // 预算不足没有发送的次数
+};
+
+// 一个ServiceStub配置的多个地址, 由同名的所有ServiceStub共享
+struct EndpointGroup
+{
+    std::vector<Endpoint> endpoints;
+    std::vector<uint32_t> io_indexes;   // 每个地址所在的客户端IO线程
+    std::unique_ptr<LoadBalancer> balancer;
+    std::map<uint32_t, std::unique_ptr<HedgingPolicy>> hedging;   // method_code -> 对冲策略
 };
 
 }
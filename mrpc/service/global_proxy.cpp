@@ -1,49 +1,135 @@
+#include <algorithm>
+#include <cassert>
+#include <functional>
+
+#include <mrpc/service/application_config.mrpc.h>
 #include <mrpc/service/global_proxy.h>
+#include <mrpc/util/hash.h>
 #include <mrpc/util/log.h>
 
 namespace mrpc
 {
 
-std::map<std::string, Endpoint> GlobalProxy::local_name2endpoint_;
+std::map<std::string, std::shared_ptr<EndpointGroup>> GlobalProxy::local_name2endpoints_;
 std::atomic<uint64_t> GlobalProxy::next_stub_id_ = 0;
-NetworkClient GlobalProxy::network_;
-std::thread GlobalProxy::network_thread_;
+std::map<std::string, uint32_t> GlobalProxy::address2id_;
+uint32_t GlobalProxy::io_thread_num_ = 1;
+std::vector<std::unique_ptr<NetworkClient>> GlobalProxy::network_;
+std::vector<std::thread> GlobalProxy::network_thread_;
 
 void GlobalProxy::RegisterLocalEndpoint(const std::string& name, const Endpoint& endpoint)
 {
-    local_name2endpoint_[name] = endpoint;
+    RegisterLocalEndpoints(name, { endpoint }, round_robin);
+}
+
+void GlobalProxy::RegisterLocalEndpoints(const std::string& name, const std::vector<Endpoint>& endpoints, int32_t balance)
+{
+    assert(!endpoints.empty());
+    std::shared_ptr<EndpointGroup> group = std::make_shared<EndpointGroup>();
+    group->endpoints = endpoints;
+    std::vector<std::pair<std::string, uint32_t>> backends;
+    for (auto& endpoint : group->endpoints)
+    {
+        // 地址只在注册时格式化一次, 客户端用编号查找连接池
+        std::string address = endpoint.GetAddress();
+        endpoint.address_id = GetAddressId(address);
+        group->io_indexes.push_back(GetIoIndex(address));
+        backends.emplace_back(std::move(address), endpoint.weight);
+    }
+    // 只有一个地址时不需要选择
+    if (endpoints.size() > 1)
+    {
+        group->balancer = LoadBalancer::Create((LoadBalancePolicy)balance, backends);
+    }
+    local_name2endpoints_[name] = group;
+}
+
+void GlobalProxy::RegisterHedgingPolicy(const std::string& name, const HedgingConfig& config)
+{
+    std::shared_ptr<EndpointGroup> group = FindLocalEndpoints(name);
+    assert(group != nullptr);
+    group->hedging[APHash(config.method)].reset(new HedgingPolicy(config));
+}
+
+void GlobalProxy::SetIoThreadNum(uint32_t io_thread_num)
+{
+    assert(network_.empty());
+    io_thread_num_ = std::max<uint32_t>(io_thread_num, 1);
 }
 
 void GlobalProxy::Start()
 {
-    network_thread_ = std::thread(NetworkThreadFunc, std::ref(network_));
+    for (uint32_t i = 0; i < io_thread_num_; ++i)
+    {
+        network_.emplace_back(new NetworkClient());
+    }
+    for (uint32_t i = 0; i < io_thread_num_; ++i)
+    {
+        network_thread_.emplace_back(NetworkThreadFunc, std::ref(*network_[i]));
+    }
 }
 
 void GlobalProxy::Stop()
 {
-    network_.Stop();
-    network_thread_.join();
+    for (auto& network : network_)
+    {
+        network->Stop();
+    }
+    for (auto& thread : network_thread_)
+    {
+        thread.join();
+    }
+    network_thread_.clear();
 }
 
 void GlobalProxy::SendRequest(const std::shared_ptr<ServiceStubContext>& context)
 {
-    network_.SendRequest(context);
+    assert(context->io_index < network_.size());
+    network_[context->io_index]->SendRequest(context);
+}
+
+void GlobalProxy::SendRequests(std::vector<std::shared_ptr<ServiceStubContext>>& contexts)
+{
+    std::stable_sort(contexts.begin(), contexts.end(), [](const auto& a, const auto& b) { return a->io_index < b->io_index; });
+    for (auto first = contexts.begin(); first != contexts.end(); )
+    {
+        uint32_t io_index = (*first)->io_index;
+        auto last = std::find_if(first, contexts.end(), [io_index](const auto& context) { return context->io_index != io_index; });
+        assert(io_index < network_.size());
+        network_[io_index]->SendRequests(std::span(first, last));
+        first = last;
+    }
 }
 
-const Endpoint* GlobalProxy::FindLocalEndpoint(const std::string& name)
+void GlobalProxy::LogMetrics()
 {
-    auto it = local_name2endpoint_.find(name);
-    if (it != local_name2endpoint_.end())
+    for (const auto& [name, group] : local_name2endpoints_)
     {
-        return &it->second;
+        for (const auto& [method_code, policy] : group->hedging)
+        {
+            MRPC_LOG_INFO("Service stub {}.{} hedging metrics, delay {} ms, samples {}, hedged requests {}, hedges won {}, budget exhausted {}",
+                    name, policy->method, policy->GetDelay(), policy->latency.GetSampleNum(),
+                    policy->hedged_requests.load(), policy->hedges_won.load(), policy->budget_exhausted.load());
+        }
+    }
+}
+
+std::shared_ptr<EndpointGroup> GlobalProxy::FindLocalEndpoints(const std::string& name)
+{
+    auto it = local_name2endpoints_.find(name);
+    if (it != local_name2endpoints_.end())
+    {
+        return it->second;
     }
     return nullptr;
 }
 
-void GlobalProxy::InitServiceStub(const std::shared_ptr<ServiceStub>& stub, const Endpoint& endpoint)
+void GlobalProxy::InitServiceStub(const std::shared_ptr<ServiceStub>& stub, const std::shared_ptr<EndpointGroup>& group)
 {
     stub->stub_id_ = ++next_stub_id_;
-    stub->endpoint_ = endpoint;
+    stub->endpoint_ = group->endpoints[0];
+    stub->io_index_ = group->io_indexes[0];
+    stub->endpoints_ = group;
     const Protocol* protocol = GlobalFindProtocol("mrpc");//TODO
     if (protocol != nullptr)
     {
@@ -51,6 +137,18 @@ void GlobalProxy::InitServiceStub(const std::shared_ptr<ServiceStub>& stub, cons
     }
 }
 
+uint32_t GlobalProxy::GetIoIndex(const std::string& address)
+{
+    // 同一地址的请求总是交给同一个IO线程, 共享其中的连接池
+    return std::hash<std::string>()(address) % io_thread_num_;
+}
+
+uint32_t GlobalProxy::GetAddressId(const std::string& address)
+{
+    auto it = address2id_.try_emplace(address, address2id_.size() + 1).first;
+    return it->second;
+}
+
 void GlobalProxy::NetworkThreadFunc(NetworkClient& network)
 {
     MRPC_LOG_INFO("Thread start");//, id {}", std::this_thread::get_id());
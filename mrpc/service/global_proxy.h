@@ -12,20 +12,17 @@
 namespace mrpc
 {
 
-template<typename T>
-    requires(std::is_base_of_v<ServiceStub, T>)
-class ServiceProxy
-{
-public:
-    void SendRequest(const std::shared_ptr<ServiceStubContext>& context);
-private:
-    std::vector<std::shared_ptr<T>> stubs_;
-};
-
 class GlobalProxy
 {
 public:
+    // 必须在Start, FindServiceStub和RegisterLocalEndpoint之前调用.
+    static void SetIoThreadNum(uint32_t io_thread_num);
+
     static void RegisterLocalEndpoint(const std::string& name, const Endpoint& endpoint);
+    // 多个地址时每个请求由balance(LoadBalanceConfig)选择地址
+    static void RegisterLocalEndpoints(const std::string& name, const std::vector<Endpoint>& endpoints, int32_t balance);
+    // 必须在RegisterLocalEndpoint(s)之后, FindServiceStub之前调用
+    static void RegisterHedgingPolicy(const std::string& name, const HedgingConfig& config);
 
     static void Start();
     static void Stop();
@@ -35,18 +32,28 @@ public:
     static std::shared_ptr<T> FindServiceStub(const std::string& name);
 
     static void SendRequest(const std::shared_ptr<ServiceStubContext>& context);
+    // 按IO线程分组, 每个IO线程只入队和唤醒一次. 会改变contexts中的顺序.
+    static void SendRequests(std::vector<std::shared_ptr<ServiceStubContext>>& contexts);
+
+    // 打印对冲请求的统计数据
+    static void LogMetrics();
 
 private:
-    static const Endpoint* FindLocalEndpoint(const std::string& name);
-    static void InitServiceStub(const std::shared_ptr<ServiceStub>& stub, const Endpoint& endpoint);
+    static std::shared_ptr<EndpointGroup> FindLocalEndpoints(const std::string& name);
+    static void InitServiceStub(const std::shared_ptr<ServiceStub>& stub, const std::shared_ptr<EndpointGroup>& group);
+    static uint32_t GetIoIndex(const std::string& address);
+    static uint32_t GetAddressId(const std::string& address);
 
     static void NetworkThreadFunc(NetworkClient& network);
 
-    static std::map<std::string, Endpoint> local_name2endpoint_;
+    static std::map<std::string, std::shared_ptr<EndpointGroup>> local_name2endpoints_;
     static std::atomic<uint64_t> next_stub_id_;
+    static std::map<std::string, uint32_t> address2id_;
 
-    static NetworkClient network_;
-    static std::thread network_thread_;
+    // 每个IO线程一个NetworkClient, 请求按地址的哈希值分配
+    static uint32_t io_thread_num_;
+    static std::vector<std::unique_ptr<NetworkClient>> network_;
+    static std::vector<std::thread> network_thread_;
 };
 
 
@@ -54,14 +61,14 @@ template<typename T>
     requires(std::is_base_of_v<ServiceStub, T>)
 std::shared_ptr<T> GlobalProxy::FindServiceStub(const std::string& name)
 {
-    const Endpoint* endpoint = FindLocalEndpoint(name);
-    if (endpoint == nullptr)
+    std::shared_ptr<EndpointGroup> group = FindLocalEndpoints(name);
+    if (group == nullptr)
     {
         return nullptr;
     }
 
     std::shared_ptr<T> stub = std::make_shared<T>();
-    InitServiceStub(stub, *endpoint);
+    InitServiceStub(stub, group);
     return stub;
 }
 
@@ -1,14 +1,34 @@
 #include <cassert>
+#include <cerrno>
 #include <cstring>
+#include <algorithm>
 #include <atomic>
+#include <format>
+#include <map>
 #include <unordered_map>
+#include <unordered_set>
+#include <linux/io_uring.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
 #include <uv.h>
 
 #include <mrpc/error_code.mrpc.h>
+#include <mrpc/service/global_proxy.h>
 #include <mrpc/service/network_client.h>
 #include <mrpc/service/application_config.mrpc.h>
+#include <mrpc/service/service_stub.h>
+#include <mrpc/util/backoff.h>
+#include <mrpc/util/buffer_pool.h>
+#include <mrpc/util/datagram.h>
+#include <mrpc/util/input_buffer.h>
+#include <mrpc/util/io_uring.h>
 #include <mrpc/util/log.h>
-#include <mrpc/util/thread_safe_queue.h>
+#include <mrpc/util/mpsc_queue.h>
+#include <mrpc/util/sendmsg_buffer.h>
+#include <mrpc/util/shm_channel.h>
+#include <mrpc/util/time.h>
+#include <mrpc/util/timer_wheel.h>
 
 namespace mrpc
 {
@@ -19,25 +39,86 @@ struct write_req_t
     uv_buf_t buf;
 };
 
-static void GetSelfTcpAddrName(uv_tcp_t* handle, std::string& host, uint32_t& port)
+// TCP和Unix domain socket(pipe)共用同一套读写流程, 只有初始化和地址不同
+union StreamHandle
 {
-    struct sockaddr_storage rawname;
-    int namelen = sizeof(rawname);
-    if (uv_tcp_getsockname(handle, (struct sockaddr*)&rawname, &namelen) != 0)
-    {
-        return;
-    }
+    uv_tcp_t tcp;
+    uv_pipe_t pipe;
+    uv_poll_t poll;     // 客户端的shm连接直接监视控制socket
+    uv_udp_t udp;       // 没有连接, 每个数据报一个包
+};
+
+// sendmmsg发不出去(发送缓冲区满)的数据报交给uv_udp_send排队.
+struct DatagramSendReq
+{
+    uv_udp_send_t req;
+    Datagram datagram;
+    uint64_t seq_id = 0;    // 客户端的请求, 发送失败时立即失败; 0表示不需要回包
+};
+
+// recvmmsg一次最多接收的数据报个数, 接收缓冲区按最大数据报切分
+static constexpr size_t kDatagramRecvBatch = 16;
+static constexpr size_t kDatagramRecvBufferSize = kDatagramRecvBatch * 64 * 1024;
+
+// shm连接的数据走共享内存环, 对端写入数据或腾出空间时poll可读.
+// 连接关闭时由poll的关闭回调释放.
+struct ShmConnection
+{
+    void* conn = nullptr;
+    uv_poll_t poll;
+    ShmChannel channel;
+};
+
+static constexpr uint32_t kUringEntries = 256;
+static constexpr uint16_t kRecvBufferGroup = 0;
+static constexpr uint32_t kRecvBufferNum = 64;
+static constexpr uint32_t kRecvBufferSize = 64 * 1024;     // 与BufferPool的默认块大小一致
+static constexpr uint32_t kMaxCqeBatch = 256;
 
-    char ip[INET6_ADDRSTRLEN];
-    if (rawname.ss_family == AF_INET)
+// user_data的高8位为操作类型, 低56位为连接id
+enum UringClientOp : uint64_t
+{
+    kOpRecv = 1,
+    kOpSend = 2,
+};
+
+static constexpr uint64_t kOpShift = 56;
+static constexpr uint64_t kConnIdMask = (1ULL << kOpShift) - 1;
+
+static inline uint64_t MakeUserData(UringClientOp op, uint64_t conn_id)
+{
+    return ((uint64_t)op << kOpShift) | (conn_id & kConnIdMask);
+}
+
+// io_uring连接仍由libuv建立和关闭, 建立之后用multishot recv接收,
+// 同一轮事件循环的请求合并为一个sendmsg. 提交给内核的recv和sendmsg都完成之后才能释放连接.
+struct UringConnection
+{
+    int fd = -1;
+    SendmsgBuffer write_buffer;     // 待发送和正在发送的请求
+    uint32_t pending_ops = 0;
+    bool recv_armed = false;
+    bool queued = false;    // 已经加入uring_conns_
+    bool closed = false;    // libuv已经关闭, 等待pending_ops为0
+};
+
+static void OnCloseShm(uv_handle_t* handle)
+{
+    delete (ShmConnection*)uv_handle_get_data(handle);
+}
+
+static void GetAddrName(const struct sockaddr* addr, std::string& host, uint32_t& port)
+{
+    char ip[INET6_ADDRSTRLEN] = { 0 };
+    if (addr->sa_family == AF_INET)
     {
-        struct sockaddr_in* addr_v4 = (struct sockaddr_in*)&rawname;
+        const struct sockaddr_in* addr_v4 = (const struct sockaddr_in*)addr;
         uv_ip4_name(addr_v4, ip, sizeof(ip));
         port = ntohs(addr_v4->sin_port);
     }
-    else if (rawname.ss_family == AF_INET6)
+    else if (addr->sa_family == AF_INET6)
     {
-        struct sockaddr_in6* addr_v6 = (struct sockaddr_in6*)&rawname;
+        const struct sockaddr_in6* addr_v6 = (const struct sockaddr_in6*)addr;
         uv_ip6_name(addr_v6, ip, sizeof(ip));
         port = ntohs(addr_v6->sin6_port);
     }
@@ -45,59 +126,170 @@ static void GetSelfTcpAddrName(uv_tcp_t* handle, std::string& host, uint32_t& po
     host = ip;
 }
 
-struct NetworkClientTcpConnection
+static void GetSelfTcpAddrName(uv_tcp_t* handle, std::string& host, uint32_t& port)
+{
+    struct sockaddr_storage rawname;
+    int namelen = sizeof(rawname);
+    if (uv_tcp_getsockname(handle, (struct sockaddr*)&rawname, &namelen) != 0)
+    {
+        return;
+    }
+
+    GetAddrName((const struct sockaddr*)&rawname, host, port);
+}
+
+struct ConnectionPool;
+
+struct NetworkClientConnection
 {
-    NetworkClientTcpConnection();
-    ~NetworkClientTcpConnection() = default;
+    NetworkClientConnection();
+    ~NetworkClientConnection() = default;
 
-    uint64_t stub_id = 0;
+    uint64_t conn_id = 0;
     std::string self_host;
     uint32_t self_port = 0;
     std::string peer_host;
     uint32_t peer_port = 0;
     Protocol protocol;
+    bool connected = false;     // 连接建立之前的请求缓存在send_buffer中
     bool close = false;
-    std::string buffer;
+    InputBuffer buffer;
     std::vector<std::string> send_buffer;
+    size_t send_buffer_bytes = 0;
+    size_t max_send_buffer_bytes = 0;   // 0表示不限制
+
+    // 所属的连接池
+    ConnectionPool* pool = nullptr;
+    size_t slot = 0;
+    std::unordered_set<uint64_t> pending_seq_ids;   // 等待回包的请求, 连接断开时立即失败
+
+    // 非空时为shm连接, 收到服务端发来的共享内存段之前以及环满时, 请求缓存在send_buffer中
+    ShmConnection* shm = nullptr;
+    bool shm_ready = false;
+    int control_fd = -1;
+
+    // UDP连接的请求, 每轮事件循环用sendmmsg一次发送
+    std::vector<Datagram> datagrams;
+    std::vector<uint64_t> datagram_seq_ids;    // 与datagrams一一对应, 0表示不需要回包
+
+    // 非空时为io_uring连接, 在连接建立之后根据io_backend创建
+    int32_t io_backend = 0;
+    std::unique_ptr<UringConnection> uring;
 
     // uv fields
     uv_connect_t connect_handle;
-    uv_tcp_t handle;
+    StreamHandle handle;
 
     void FlushBuffer();
+    void FlushShm();
 
-    void Write(const std::string& packet);
+    // send_buffer超过上限时返回false, 请求没有发送
+    bool Write(const std::string& packet);
+    bool WriteShm(const std::string& packet);
+    bool CanBuffer(size_t length) const;
     static void OnWrite(uv_write_t* req, int status);
 
     void Close(uv_close_cb cb);
 };
 
-NetworkClientTcpConnection::NetworkClientTcpConnection()
+// 同一地址的连接池, 由所有ServiceStub共享. slots中为空或者已关闭的位置在选中时重新连接.
+// 建立连接失败后熔断: retry_time之前不建立新连接, 请求只能使用池中其它的连接, 没有时直接失败;
+// 到期后只建立一个试探连接, 成功后恢复, 失败则按指数退避延长等待时间.
+struct ConnectionPool
+{
+    std::vector<NetworkClientConnection*> slots;
+    size_t next_slot = 0;
+    Backoff backoff;
+    uint64_t retry_time = 0;
+};
+
+NetworkClientConnection::NetworkClientConnection()
 {
     uv_handle_set_data((uv_handle_t*)&handle, this);
 }
 
-void NetworkClientTcpConnection::FlushBuffer()
+void NetworkClientConnection::FlushBuffer()
 {
-    for (auto& packet : send_buffer)
+    std::vector<std::string> packets;
+    packets.swap(send_buffer);
+    send_buffer_bytes = 0;
+    for (auto& packet : packets)
     {
         Write(packet);
     }
-    send_buffer.clear();
 }
 
-void NetworkClientTcpConnection::Write(const std::string& packet)
+void NetworkClientConnection::FlushShm()
+{
+    size_t index = 0;
+    for (; index < send_buffer.size(); ++index)
+    {
+        std::string& packet = send_buffer[index];
+        size_t written = shm->channel.Write(packet.data(), packet.length());
+        send_buffer_bytes -= written;
+        if (written < packet.length())
+        {
+            packet.erase(0, written);
+            break;
+        }
+    }
+    send_buffer.erase(send_buffer.begin(), send_buffer.begin() + index);
+}
+
+bool NetworkClientConnection::CanBuffer(size_t length) const
+{
+    return max_send_buffer_bytes == 0 || send_buffer_bytes + length <= max_send_buffer_bytes;
+}
+
+bool NetworkClientConnection::WriteShm(const std::string& packet)
+{
+    size_t written = 0;
+    if (shm_ready && send_buffer.empty())
+    {
+        written = shm->channel.Write(packet.data(), packet.length());
+    }
+    if (written < packet.length())
+    {
+        // 已经写入一部分的请求必须写完
+        if (written == 0 && !CanBuffer(packet.length()))
+        {
+            return false;
+        }
+        send_buffer.push_back(packet.substr(written));
+        send_buffer_bytes += packet.length() - written;
+    }
+    MRPC_LOG_DEBUG("Send request, conn id {}, data length {}", conn_id, packet.length());
+    return true;
+}
+
+bool NetworkClientConnection::Write(const std::string& packet)
 {
+    if (shm != nullptr)
+    {
+        return WriteShm(packet);
+    }
+    if (!connected)
+    {
+        if (!CanBuffer(packet.length()))
+        {
+            return false;
+        }
+        send_buffer.push_back(packet);
+        send_buffer_bytes += packet.length();
+        return true;
+    }
+
     size_t length = packet.length();
     write_req_t* write_req = (write_req_t*)malloc(sizeof(write_req_t));
     write_req->buf = uv_buf_init((char*)malloc(length), length);
     memcpy(write_req->buf.base, packet.c_str(), length);
     int ret = uv_write((uv_write_t*)write_req, (uv_stream_t*)&handle, &write_req->buf, 1, OnWrite);
     assert(ret == 0);
-    MRPC_LOG_DEBUG("Send request, stub id {}, data length {}", stub_id, length);
+    MRPC_LOG_DEBUG("Send request, conn id {}, data length {}", conn_id, length);
+    return true;
 }
 
-void NetworkClientTcpConnection::OnWrite(uv_write_t* req, int status)
+void NetworkClientConnection::OnWrite(uv_write_t* req, int status)
 {
     if (status)
     {
@@ -109,46 +301,130 @@ void NetworkClientTcpConnection::OnWrite(uv_write_t* req, int status)
     free(write_req);
 }
 
-void NetworkClientTcpConnection::Close(uv_close_cb cb)
+void NetworkClientConnection::Close(uv_close_cb cb)
 {
     close = true;
+    if (shm_ready)
+    {
+        uv_close((uv_handle_t*)&shm->poll, OnCloseShm);
+    }
+    else
+    {
+        delete shm;
+    }
+    shm = nullptr;
+    shm_ready = false;
     uv_close((uv_handle_t*)&handle, cb);
 }
 
+// 对冲延迟通常只有几毫秒到几十毫秒, 使用更细的时间粒度
+static constexpr uint64_t kHedgeTick = 1;
+static constexpr size_t kHedgeSlotNum = 1024;
+
+// 请求没有得到后端的处理结果
+static bool IsTransportFailure(int32_t ret)
+{
+    return ret == ERROR_TIMEOUT || ret == ERROR_CONNECTION_CLOSED || ret == ERROR_SERVICE_UNAVAILABLE
+        || ret == ERROR_SEND_BUFFER_FULL || ret == ERROR_SERVICE_OVERLOADED;
+}
+
+// 等待回包的请求
+struct PendingRequest
+{
+    std::shared_ptr<ServiceStubContext> context;
+    uint64_t conn_id = 0;   // 发送请求的连接
+};
+
 class NetworkClientImpl
 {
 public:
     NetworkClientImpl();
     ~NetworkClientImpl();
 
-    int Connect(uint64_t stub_id, const Protocol& protocol, const Endpoint& endpoint);
-    int ConnectToTcpAddr(uint64_t stub_id, const Protocol& protocol, const std::string& host, uint32_t port);
+    // 失败时返回nullptr
+    NetworkClientConnection* Connect(const Protocol& protocol, const Endpoint& endpoint);
+    NetworkClientConnection* ConnectToTcpAddr(const Protocol& protocol, const std::string& host, uint32_t port);
+    NetworkClientConnection* ConnectToPipe(const Protocol& protocol, const std::string& path);
+    NetworkClientConnection* ConnectToShm(const Protocol& protocol, const std::string& path);
+    NetworkClientConnection* ConnectToUdpAddr(const Protocol& protocol, const std::string& host, uint32_t port);
 
     void Start();
     void Stop();
 
     void SendRequest(const std::shared_ptr<ServiceStubContext>& context);
+    void SendRequests(std::span<const std::shared_ptr<ServiceStubContext>> contexts);
 
 private:
-    static void OnTcpConnect(uv_connect_t* req, int status);
-    static void OnCloseTcpConnection(uv_handle_t *handle);
+    static void OnConnect(uv_connect_t* req, int status);
+    static void OnCloseConnection(uv_handle_t *handle);
     static void OnAllocBuffer(uv_handle_t* handle, size_t suggested_size, uv_buf_t* buf);
     static void OnRead(uv_stream_t* handle, ssize_t nread, const uv_buf_t* buf);
     static void OnRequestWrite(uv_async_t* handle);
     static void OnWrite(uv_write_t *req, int status);
+    static void OnShmControl(uv_poll_t* handle, int status, int events);
+    static void OnShmEvent(uv_poll_t* handle, int status, int events);
+    static void OnAllocDatagram(uv_handle_t* handle, size_t suggested_size, uv_buf_t* buf);
+    static void OnReadDatagram(uv_udp_t* handle, ssize_t nread, const uv_buf_t* buf, const struct sockaddr* addr, unsigned flags);
+    static void OnSendDatagram(uv_udp_send_t* req, int status);
+    static void OnUringEvent(uv_poll_t* handle, int status, int events);
+    static void OnTimer(uv_timer_t* handle);
+    static void OnHedgeTimer(uv_timer_t* handle);
+    static void CompleteRequest(const std::shared_ptr<ServiceStubContext>& context, int32_t ret, std::string&& response_payload);
+    static std::shared_ptr<ServiceStubContext> CompleteHedgedRequest(const std::shared_ptr<ServiceStubContext>& context, int32_t ret);
+    static bool SendHedgeRequest(const std::shared_ptr<ServiceStubContext>& context);
+    static void FailRequest(const std::shared_ptr<ServiceStubContext>& context, int32_t ret);
+    static void ReportToBalancer(const ServiceStubContext& context, int32_t ret);
+
+    NetworkClientConnection* SelectConnection(const std::shared_ptr<ServiceStubContext>& context);
+    void OnConnected(NetworkClientConnection* conn);
+    void CloseConnection(NetworkClientConnection* conn);
+    void AddPendingRequest(NetworkClientConnection* conn, const std::shared_ptr<ServiceStubContext>& context);
+    void HandleResponses(NetworkClientConnection* conn, const char*& begin, const char* end);
+    void CheckTimeout(uint64_t now);
+    void CheckHedge(uint64_t now);
+    void FailPendingRequest(uint64_t seq_id, int32_t ret);
+    bool QueueDatagram(NetworkClientConnection* conn, const std::shared_ptr<ServiceStubContext>& context);
+    void FlushDatagrams();
+
+    bool InitUring();
+    bool StartUring(NetworkClientConnection* conn);
+    bool ArmRecv(NetworkClientConnection* conn);
+    void HandleCqe(const struct io_uring_cqe* cqe);
+    void OnUringRecv(NetworkClientConnection* conn, int res, uint32_t flags);
+    void OnUringSend(NetworkClientConnection* conn, int res);
+    bool QueueUringWrite(NetworkClientConnection* conn, std::string&& packet);
+    void FlushUringWrite(NetworkClientConnection* conn);
+    void SubmitSend(NetworkClientConnection* conn);
+    void FlushUring();
 
     std::atomic<bool> running_ = false;
-    std::unordered_map<uint64_t, std::unique_ptr<NetworkClientTcpConnection>> id2conn_;
-    std::unordered_map<uint64_t, std::shared_ptr<ServiceStubContext>> id2context_;
-    ThreadSafeQueue<std::shared_ptr<ServiceStubContext>> queue_;
+    std::unordered_map<uint64_t, std::unique_ptr<NetworkClientConnection>> id2conn_;
+    std::map<std::pair<uint32_t, const void*>, ConnectionPool> address2pool_;  // 地址编号(见Endpoint::address_id)和协议 -> 连接池
+    std::unordered_map<uint64_t, PendingRequest> id2context_;
+    TimerWheel timer_wheel_;    // 每个等待回包的请求一个定时器, 在endpoint.timeout到期
+    TimerWheel hedge_wheel_;    // 配置了对冲的请求一个定时器, 到期时还没有回包则发送对冲请求
+    std::vector<uint64_t> expired_seq_ids_;
+    MpscQueue<std::shared_ptr<ServiceStubContext>> queue_;  // 各线程提交的请求
+    BufferPool read_buffer_pool_;
+    std::vector<NetworkClientConnection*> datagram_conns_;     // datagrams非空的连接
+    std::unique_ptr<char[]> datagram_buffer_;
+    std::unique_ptr<IoUring> ring_;     // 第一个io_uring连接建立时创建
+    bool uring_unsupported_ = false;
+    std::vector<NetworkClientConnection*> uring_conns_;     // 本轮有新请求的io_uring连接
+    uint64_t next_conn_id_ = 0;
 
     // uv fields
     uv_loop_t loop_;
     uv_async_t async_;
+    uv_timer_t timer_;          // 时间轮非空时运行
+    uv_timer_t hedge_timer_;    // 对冲时间轮非空时运行
+    uv_poll_t ring_poll_;       // io_uring有完成事件时可读
 
 };
 
-NetworkClientImpl::NetworkClientImpl()
+NetworkClientImpl::NetworkClientImpl() :
+    timer_wheel_(0),    // 首次Advance时追上当前时间
+    hedge_wheel_(0, kHedgeTick, kHedgeSlotNum)
 {
     int ret = uv_loop_init(&loop_);
     assert(ret == 0);
@@ -156,6 +432,12 @@ NetworkClientImpl::NetworkClientImpl()
 
     ret = uv_async_init(&loop_, &async_, OnRequestWrite);
     assert(ret == 0);
+
+    ret = uv_timer_init(&loop_, &timer_);
+    assert(ret == 0);
+
+    ret = uv_timer_init(&loop_, &hedge_timer_);
+    assert(ret == 0);
 }
 
 NetworkClientImpl::~NetworkClientImpl()
@@ -167,222 +449,1229 @@ NetworkClientImpl::~NetworkClientImpl()
     */
 }
 
-int NetworkClientImpl::Connect(uint64_t stub_id, const Protocol& protocol, const Endpoint& endpoint)
+NetworkClientConnection* NetworkClientImpl::Connect(const Protocol& protocol, const Endpoint& endpoint)
 {
     switch (endpoint.protocol)
     {
         case tcp:
-            return ConnectToTcpAddr(stub_id, protocol, endpoint.host, endpoint.port);
+            return ConnectToTcpAddr(protocol, endpoint.host, endpoint.port);
+            break;
+        case pipe:
+            return ConnectToPipe(protocol, endpoint.path);
+            break;
+        case udp:
+            return ConnectToUdpAddr(protocol, endpoint.host, endpoint.port);
+            break;
+        case shm:
+            return ConnectToShm(protocol, endpoint.path);
             break;
         default:
             break;
     }
 
-    MRPC_LOG_ERROR("Invalid protocol, stub id {}", stub_id);
-    return ERROR_INITIALIZATION_FAILED;
+    MRPC_LOG_ERROR("Invalid protocol {}", endpoint.protocol);
+    return nullptr;
 }
 
-int NetworkClientImpl::ConnectToTcpAddr(uint64_t stub_id, const Protocol& protocol, const std::string& host, uint32_t port)
+NetworkClientConnection* NetworkClientImpl::ConnectToTcpAddr(const Protocol& protocol, const std::string& host, uint32_t port)
 {
     int ret = 0;
-    NetworkClientTcpConnection* conn = new NetworkClientTcpConnection();
-    conn->stub_id = stub_id;
+    NetworkClientConnection* conn = new NetworkClientConnection();
+    conn->conn_id = ++next_conn_id_;
     conn->peer_host = host;
     conn->peer_port = port;
     conn->protocol = protocol;
 
-    ret = uv_tcp_init(&loop_, &conn->handle);
+    ret = uv_tcp_init(&loop_, &conn->handle.tcp);
     assert(ret == 0);
-    ret = uv_tcp_nodelay(&conn->handle, 1);
+    ret = uv_tcp_nodelay(&conn->handle.tcp, 1);
     assert(ret == 0);
 
     struct sockaddr_in addr_v4;
     struct sockaddr_in6 addr_v6;
     if (uv_ip4_addr(host.c_str(), port, &addr_v4) == 0)
     {
-        ret = uv_tcp_connect(&conn->connect_handle, &conn->handle, (const struct sockaddr*)&addr_v4, OnTcpConnect);
+        ret = uv_tcp_connect(&conn->connect_handle, &conn->handle.tcp, (const struct sockaddr*)&addr_v4, OnConnect);
         assert(ret == 0);
     }
     else if (uv_ip6_addr(host.c_str(), port, &addr_v6) == 0)
     {
-        ret = uv_tcp_connect(&conn->connect_handle, &conn->handle, (const struct sockaddr*)&addr_v6, OnTcpConnect);
+        ret = uv_tcp_connect(&conn->connect_handle, &conn->handle.tcp, (const struct sockaddr*)&addr_v6, OnConnect);
         assert(ret == 0);
     }
     else
     {
         MRPC_LOG_ERROR("Invalid address {}:{}", host, port);
         delete conn;
-        return ERROR_INITIALIZATION_FAILED;
+        return nullptr;
+    }
+
+    id2conn_.emplace(conn->conn_id, conn);
+    MRPC_LOG_DEBUG("Connecting to address {}:{} success, conn id {}...", host, port, conn->conn_id);
+    return conn;
+}
+
+NetworkClientConnection* NetworkClientImpl::ConnectToPipe(const Protocol& protocol, const std::string& path)
+{
+    if (path.empty())
+    {
+        MRPC_LOG_ERROR("Pipe path is empty");
+        return nullptr;
+    }
+
+    NetworkClientConnection* conn = new NetworkClientConnection();
+    conn->conn_id = ++next_conn_id_;
+    conn->peer_host = path;
+    conn->protocol = protocol;
+
+    int ret = uv_pipe_init(&loop_, &conn->handle.pipe, 0);
+    assert(ret == 0);
+    uv_pipe_connect(&conn->connect_handle, &conn->handle.pipe, path.c_str(), OnConnect);
+
+    id2conn_.emplace(conn->conn_id, conn);
+    MRPC_LOG_DEBUG("Connecting to pipe {} success, conn id {}...", path, conn->conn_id);
+    return conn;
+}
+
+NetworkClientConnection* NetworkClientImpl::ConnectToUdpAddr(const Protocol& protocol, const std::string& host, uint32_t port)
+{
+    struct sockaddr_storage addr;
+    if (uv_ip4_addr(host.c_str(), port, (struct sockaddr_in*)&addr) != 0
+            && uv_ip6_addr(host.c_str(), port, (struct sockaddr_in6*)&addr) != 0)
+    {
+        MRPC_LOG_ERROR("Invalid address {}:{}", host, port);
+        return nullptr;
+    }
+
+    NetworkClientConnection* conn = new NetworkClientConnection();
+    conn->conn_id = ++next_conn_id_;
+    conn->peer_host = host;
+    conn->peer_port = port;
+    conn->protocol = protocol;
+
+    // 连接后的socket只接收服务端的数据报, 发送时不用再指定地址
+    int ret = uv_udp_init_ex(&loop_, &conn->handle.udp, AF_UNSPEC | UV_UDP_RECVMMSG);
+    assert(ret == 0);
+    id2conn_.emplace(conn->conn_id, conn);
+    ret = uv_udp_connect(&conn->handle.udp, (const struct sockaddr*)&addr);
+    if (ret == 0)
+    {
+        ret = uv_udp_recv_start(&conn->handle.udp, OnAllocDatagram, OnReadDatagram);
+    }
+    if (ret != 0)
+    {
+        MRPC_LOG_ERROR("Connect to udp address {}:{} error, {}", host, port, uv_strerror(ret));
+        // 由关闭回调从id2conn_中删除
+        CloseConnection(conn);
+        return nullptr;
+    }
+
+    conn->connected = true;
+    struct sockaddr_storage rawname;
+    int namelen = sizeof(rawname);
+    if (uv_udp_getsockname(&conn->handle.udp, (struct sockaddr*)&rawname, &namelen) == 0)
+    {
+        GetAddrName((const struct sockaddr*)&rawname, conn->self_host, conn->self_port);
+    }
+
+    MRPC_LOG_DEBUG("New connection, conn id {}, self addr {}:{}, peer udp addr {}:{}", conn->conn_id, conn->self_host, conn->self_port, conn->peer_host, conn->peer_port);
+    return conn;
+}
+
+NetworkClientConnection* NetworkClientImpl::ConnectToShm(const Protocol& protocol, const std::string& path)
+{
+    struct sockaddr_un addr;
+    memset(&addr, 0, sizeof(addr));
+    if (path.empty() || path.length() >= sizeof(addr.sun_path))
+    {
+        MRPC_LOG_ERROR("Invalid shm path {}", path);
+        return nullptr;
     }
+    addr.sun_family = AF_UNIX;
+    memcpy(addr.sun_path, path.c_str(), path.length());
+
+    // 本机的Unix domain socket连接立即完成, 之后等待服务端发来共享内存段
+    int fd = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (fd < 0 || connect(fd, (const struct sockaddr*)&addr, sizeof(addr)) != 0)
+    {
+        MRPC_LOG_ERROR("Connect to shm {} error, {}", path, strerror(errno));
+        if (fd >= 0) close(fd);
+        return nullptr;
+    }
+
+    NetworkClientConnection* conn = new NetworkClientConnection();
+    conn->conn_id = ++next_conn_id_;
+    conn->peer_host = path;
+    conn->protocol = protocol;
+    conn->control_fd = fd;
+    conn->shm = new ShmConnection();
+    conn->shm->conn = conn;
+
+    int ret = uv_poll_init(&loop_, &conn->handle.poll, fd);
+    assert(ret == 0);
+    ret = uv_poll_start(&conn->handle.poll, UV_READABLE, OnShmControl);
+    assert(ret == 0);
 
-    id2conn_.emplace(stub_id, conn);
-    MRPC_LOG_DEBUG("Connecting to address {}:{} success...", host, port);
-    return 0;
+    id2conn_.emplace(conn->conn_id, conn);
+    MRPC_LOG_DEBUG("Connecting to shm {} success, conn id {}...", path, conn->conn_id);
+    return conn;
 }
 
-void NetworkClientImpl::OnTcpConnect(uv_connect_t* req, int status)
+void NetworkClientImpl::OnConnect(uv_connect_t* req, int status)
 {
     uv_stream_t* connection = req->handle;
-    NetworkClientTcpConnection* conn = (NetworkClientTcpConnection*)uv_handle_get_data((uv_handle_t*)connection);
+    NetworkClientImpl* client = (NetworkClientImpl*)uv_loop_get_data(uv_handle_get_loop((uv_handle_t*)connection));
+    NetworkClientConnection* conn = (NetworkClientConnection*)uv_handle_get_data((uv_handle_t*)connection);
     if (status < 0)
     {
-        conn->Close(OnCloseTcpConnection);
-        MRPC_LOG_ERROR("New connection for stub {} error, {}", conn->stub_id, uv_strerror(status));
+        client->CloseConnection(conn);
+        MRPC_LOG_ERROR("New connection {} to {}:{} error, {}", conn->conn_id, conn->peer_host, conn->peer_port, uv_strerror(status));
         return;
     }
 
-    GetSelfTcpAddrName(&conn->handle, conn->self_host, conn->self_port);
-    MRPC_LOG_DEBUG("New connection, stub id {}, self addr {}:{}, peer addr {}:{}", conn->stub_id, conn->self_host, conn->self_port, conn->peer_host, conn->peer_port);
+    if (uv_handle_get_type((uv_handle_t*)connection) == UV_TCP)
+    {
+        GetSelfTcpAddrName(&conn->handle.tcp, conn->self_host, conn->self_port);
+    }
+    MRPC_LOG_DEBUG("New connection, conn id {}, self addr {}:{}, peer addr {}:{}", conn->conn_id, conn->self_host, conn->self_port, conn->peer_host, conn->peer_port);
+
+    if (conn->io_backend == io_uring && uv_handle_get_type((uv_handle_t*)connection) == UV_TCP && client->StartUring(conn))
+    {
+        client->OnConnected(conn);
+        conn->send_buffer_bytes = 0;
+        // 缓存的请求不超过同一个上限, 都能加入io_uring的发送队列
+        for (auto& packet : conn->send_buffer)
+        {
+            client->QueueUringWrite(conn, std::move(packet));
+        }
+        conn->send_buffer.clear();
+        client->FlushUring();
+        return;
+    }
 
     int ret = uv_read_start((uv_stream_t*)&conn->handle, OnAllocBuffer, OnRead);
     assert(ret == 0);
 
+    client->OnConnected(conn);
     conn->FlushBuffer();
 }
 
-void NetworkClientImpl::OnCloseTcpConnection(uv_handle_t* handle)
+void NetworkClientImpl::OnConnected(NetworkClientConnection* conn)
+{
+    conn->connected = true;
+    if (conn->pool != nullptr)
+    {
+        conn->pool->backoff.Reset();
+        conn->pool->retry_time = 0;
+    }
+}
+
+void NetworkClientImpl::CloseConnection(NetworkClientConnection* conn)
+{
+    if (conn->close)
+    {
+        return;
+    }
+
+    // 没有建立成功的连接计入熔断
+    if (!conn->connected && conn->pool != nullptr)
+    {
+        uint32_t delay = conn->pool->backoff.Fail();
+        conn->pool->retry_time = uv_now(&loop_) + delay;
+        MRPC_LOG_WARN("Connect to {}:{} failed {} times, retry after {} ms", conn->peer_host, conn->peer_port, conn->pool->backoff.GetFailures(), delay);
+    }
+
+    // 已发送和缓存的请求都不会再有回包
+    for (uint64_t seq_id : conn->pending_seq_ids)
+    {
+        auto it = id2context_.find(seq_id);
+        if (it == id2context_.end())
+        {
+            continue;
+        }
+        std::shared_ptr<ServiceStubContext> context = std::move(it->second.context);
+        id2context_.erase(it);
+        FailRequest(context, ERROR_CONNECTION_CLOSED);
+    }
+    conn->pending_seq_ids.clear();
+
+    if (conn->uring != nullptr)
+    {
+        // shutdown使未完成的recv和sendmsg尽快结束, libuv关闭fd之后内核中的操作仍然持有socket
+        shutdown(conn->uring->fd, SHUT_RDWR);
+    }
+    conn->Close(OnCloseConnection);
+}
+
+void NetworkClientImpl::OnCloseConnection(uv_handle_t* handle)
 {
     NetworkClientImpl* client = (NetworkClientImpl*)uv_loop_get_data(uv_handle_get_loop(handle));
-    NetworkClientTcpConnection* conn = (NetworkClientTcpConnection*)uv_handle_get_data(handle);
-    MRPC_LOG_DEBUG("Close connection, stub id {}, self addr {}:{}, peer addr {}:{}", conn->stub_id, conn->self_host, conn->self_port, conn->peer_host, conn->peer_port);
-    client->id2conn_.erase(conn->stub_id);
+    NetworkClientConnection* conn = (NetworkClientConnection*)uv_handle_get_data(handle);
+    MRPC_LOG_DEBUG("Close connection, conn id {}, self addr {}:{}, peer addr {}:{}", conn->conn_id, conn->self_host, conn->self_port, conn->peer_host, conn->peer_port);
+    if (conn->control_fd >= 0)
+    {
+        close(conn->control_fd);
+    }
+    // 关闭期间位置可能已经被新连接占用
+    if (conn->pool != nullptr && conn->pool->slots[conn->slot] == conn)
+    {
+        conn->pool->slots[conn->slot] = nullptr;
+    }
+    if (conn->uring != nullptr && conn->uring->pending_ops > 0)
+    {
+        // 由HandleCqe在最后一个操作完成时释放
+        conn->uring->closed = true;
+        return;
+    }
+    client->id2conn_.erase(conn->conn_id);
 }
 
 void NetworkClientImpl::OnAllocBuffer(uv_handle_t* handle, size_t suggested_size, uv_buf_t* buf)
 {
-    (void)handle;
-    buf->base = (char*)malloc(suggested_size);
-    buf->len = suggested_size;
+    (void)suggested_size;
+    NetworkClientImpl* client = (NetworkClientImpl*)uv_loop_get_data(uv_handle_get_loop(handle));
+    NetworkClientConnection* conn = (NetworkClientConnection*)uv_handle_get_data(handle);
+    if (conn->buffer.Empty())
+    {
+        buf->base = client->read_buffer_pool_.Allocate();
+        buf->len = client->read_buffer_pool_.GetBlockSize();
+    }
+    else
+    {
+        // 有残留数据时直接读到输入缓冲区的尾部, 省去一次拷贝
+        conn->buffer.EnsureWritable(client->read_buffer_pool_.GetBlockSize());
+        buf->base = conn->buffer.GetWritePtr();
+        buf->len = conn->buffer.GetWritableSize();
+    }
 }
 
-void NetworkClientImpl::OnRead(uv_stream_t* handle, ssize_t nread, const uv_buf_t* buf)
+NetworkClientConnection* NetworkClientImpl::SelectConnection(const std::shared_ptr<ServiceStubContext>& context)
 {
-    NetworkClientImpl* client = (NetworkClientImpl*)uv_loop_get_data(uv_handle_get_loop((uv_handle_t*)handle));
-    NetworkClientTcpConnection* conn = (NetworkClientTcpConnection*)uv_handle_get_data((uv_handle_t*)handle);
-    if (nread > 0)
+    const Endpoint& endpoint = context->endpoint;
+    // 协议不同的ServiceStub不能共用连接
+    ConnectionPool& pool = address2pool_[{ endpoint.address_id, (const void*)context->protocol.handle_response }];
+    if (pool.slots.empty())
     {
-        conn->buffer.append(buf->base, nread);
-        MRPC_LOG_TRACE("Received {} bytes", nread);
+        pool.slots.resize(std::max<uint32_t>(endpoint.pool_size, 1));
+        pool.backoff = Backoff(endpoint.reconnect_interval, endpoint.max_reconnect_interval);
+    }
 
-        const char* begin = conn->buffer.c_str();
-        const char* end = conn->buffer.c_str() + conn->buffer.size();
-        while (begin < end)
+    size_t slot = 0;
+    if (endpoint.pool_balance == least_pending)
+    {
+        // 已有的连接都有未回包的请求时才建立新连接
+        size_t empty_slot = pool.slots.size();
+        size_t best_slot = pool.slots.size();
+        for (size_t i = 0; i < pool.slots.size(); ++i)
         {
-            bool has_error = false;
-            uint64_t seq_id = 0;
-            int32_t ret_value = 0;
-            std::string response_payload;
-            if (conn->protocol.handle_response(begin, end - begin, has_error, seq_id, ret_value, response_payload))
-            {
-                std::shared_ptr<ServiceStubContext> context;
-                auto it = client->id2context_.find(seq_id);
-                if (it != client->id2context_.end())
-                {
-                    context = it->second;
-                    client->id2context_.erase(it);
-                }
-
-                if (!context)
-                {
-                    continue;
-                }
-
-                context->ret = ret_value;
-                context->response_payload = std::move(response_payload);
-                if (context->queue != nullptr)
-                {
-                    ((ContextPtrQueue*)context->queue)->push(context);
-                }
-                else if (context->notifier)
-                {
-                    context->notifier->cv.notify_one();
-                }
-            }
-            else if (has_error)
+            NetworkClientConnection* conn = pool.slots[i];
+            if (conn == nullptr || conn->close)
             {
-                conn->Close(OnCloseTcpConnection);
-                break;
+                empty_slot = std::min(empty_slot, i);
             }
-            else
+            else if (best_slot == pool.slots.size() || conn->pending_seq_ids.size() < pool.slots[best_slot]->pending_seq_ids.size())
             {
-                break;
+                best_slot = i;
             }
         }
+        bool busy = best_slot == pool.slots.size() || !pool.slots[best_slot]->pending_seq_ids.empty();
+        slot = busy && empty_slot < pool.slots.size() ? empty_slot : best_slot;
+    }
+    else
+    {
+        slot = pool.next_slot++ % pool.slots.size();
+    }
+
+    NetworkClientConnection* conn = pool.slots[slot];
+    if (conn != nullptr && !conn->close)
+    {
+        return conn;
+    }
 
-        if (begin < end)
+    uint64_t now = uv_now(&loop_);
+    if (now < pool.retry_time)
+    {
+        // 熔断期间只能使用已有的连接
+        for (NetworkClientConnection* other : pool.slots)
         {
-            if (begin != conn->buffer.c_str())
+            if (other != nullptr && !other->close)
             {
-                conn->buffer.assign(begin, end - begin);
+                return other;
             }
         }
-        else
-        {
-            conn->buffer.clear();
-        }
+        return nullptr;
     }
-    else if (nread < 0)
+
+    conn = Connect(context->protocol, endpoint);
+    if (conn == nullptr)
     {
-        if (nread != UV_EOF)
+        uint32_t delay = pool.backoff.Fail();
+        pool.retry_time = now + delay;
+        return nullptr;
+    }
+    conn->max_send_buffer_bytes = endpoint.max_send_buffer_bytes;
+    conn->io_backend = endpoint.io_backend;
+    conn->pool = &pool;
+    conn->slot = slot;
+    pool.slots[slot] = conn;
+    if (pool.backoff.GetFailures() > 0)
+    {
+        // 试探连接有结果之前不再建立其它连接
+        pool.retry_time = UINT64_MAX;
+    }
+    return conn;
+}
+
+void NetworkClientImpl::AddPendingRequest(NetworkClientConnection* conn, const std::shared_ptr<ServiceStubContext>& context)
+{
+    id2context_[context->seq_id] = { context, conn->conn_id };
+    conn->pending_seq_ids.insert(context->seq_id);
+
+    // 对冲请求本身不再对冲
+    if (context->hedging != nullptr && context->hedge == nullptr)
+    {
+        uint64_t delay = context->hedging->GetDelay();
+        if (delay != 0 && (context->endpoint.timeout == 0 || delay < context->endpoint.timeout))
         {
-            MRPC_LOG_ERROR("Read error, {}", uv_err_name(nread));
+            hedge_wheel_.Add(context->seq_id, uv_now(&loop_) + delay);
+            if (!uv_is_active((uv_handle_t*)&hedge_timer_))
+            {
+                int ret = uv_timer_start(&hedge_timer_, OnHedgeTimer, kHedgeTick, kHedgeTick);
+                assert(ret == 0);
+            }
         }
-        conn->Close(OnCloseTcpConnection);
     }
 
-    free(buf->base);
+    if (context->endpoint.timeout == 0)
+    {
+        return;
+    }
+
+    timer_wheel_.Add(context->seq_id, uv_now(&loop_) + context->endpoint.timeout);
+    if (!uv_is_active((uv_handle_t*)&timer_))
+    {
+        uint64_t tick = timer_wheel_.GetTick();
+        int ret = uv_timer_start(&timer_, OnTimer, tick, tick);
+        assert(ret == 0);
+    }
 }
 
-void NetworkClientImpl::OnRequestWrite(uv_async_t* handle)
+void NetworkClientImpl::CompleteRequest(const std::shared_ptr<ServiceStubContext>& context, int32_t ret, std::string&& response_payload)
 {
-    NetworkClientImpl* client = (NetworkClientImpl*)uv_loop_get_data(uv_handle_get_loop((uv_handle_t*)handle));
-    std::shared_ptr<ServiceStubContext> context;
-    while (client->queue_.try_pop(context))
+    if (context->endpoints != nullptr && context->endpoints->balancer != nullptr)
     {
-        if (context->param.need_response)
-        {
-            client->id2context_[context->seq_id] = context;
-        }
+        ReportToBalancer(*context, ret);
+    }
 
-        NetworkClientTcpConnection* conn = nullptr;
-        auto it = client->id2conn_.find(context->stub_id);
-        if (it != client->id2conn_.end())
-        {
-            conn = it->second.get();
-        }
-        if (conn != nullptr && conn->close)
+    std::shared_ptr<ServiceStubContext> target = context;
+    if (context->hedging != nullptr)
+    {
+        target = CompleteHedgedRequest(context, ret);
+        if (target == nullptr)
         {
-            MRPC_LOG_DEBUG("Discard request, stub id {}, data length {}", context->stub_id, context->request.length());
-            continue;
+            return;
         }
+    }
 
-        if (conn == nullptr)
-        {
-            int ret = client->Connect(context->stub_id, context->protocol, context->endpoint);
-            if (ret != 0)
+    target->ret = ret;
+    target->response_payload = std::move(response_payload);
+    if (target->queue != nullptr)
+    {
+        ((ContextPtrQueue*)target->queue)->push(target);
+    }
+    else if (target->notifier)
+    {
+        std::lock_guard<std::mutex> lock(target->notifier->mtx);
+        target->notifier->done = true;
+        target->notifier->cv.notify_one();
+    }
+}
+
+// 返回需要通知调用方的context(总是主请求), 不需要通知时返回nullptr
+std::shared_ptr<ServiceStubContext> NetworkClientImpl::CompleteHedgedRequest(const std::shared_ptr<ServiceStubContext>& context, int32_t ret)
+{
+    HedgingPolicy& policy = *context->hedging;
+    bool failed = IsTransportFailure(ret);
+    if (!failed)
+    {
+        policy.latency.Add(std::max<uint64_t>(Time::NowMicros() - context->start_time, 1));
+    }
+
+    // 主请求没有到达后端时不等待延迟, 立即向另一个地址重试
+    if (failed && ret != ERROR_TIMEOUT && context->hedge == nullptr && context->endpoints->balancer != nullptr)
+    {
+        SendHedgeRequest(context);
+    }
+    if (context->hedge == nullptr)
+    {
+        return context;
+    }
+
+    // 另一个请求还没有完成时, 失败的请求不通知调用方
+    HedgeState& hedge = *context->hedge;
+    if (hedge.outstanding.fetch_sub(1) > 1 && failed)
+    {
+        return nullptr;
+    }
+    // 后完成的请求直接丢弃
+    if (hedge.done.exchange(true))
+    {
+        return nullptr;
+    }
+
+    std::shared_ptr<ServiceStubContext> primary = std::move(hedge.primary);
+    if (primary != context && !failed)
+    {
+        ++policy.hedges_won;
+    }
+    return primary;
+}
+
+bool NetworkClientImpl::SendHedgeRequest(const std::shared_ptr<ServiceStubContext>& context)
+{
+    HedgingPolicy& policy = *context->hedging;
+    if (!policy.budget.TryAcquire())
+    {
+        ++policy.budget_exhausted;
+        return false;
+    }
+
+    std::shared_ptr<ServiceStubContext> hedge_context = ServiceStub::PackHedgeRequest(*context);
+    // primary与context之间的循环引用在完成时解除
+    std::shared_ptr<HedgeState> hedge = std::make_shared<HedgeState>();
+    hedge->outstanding = 2;
+    hedge->primary = context;
+    context->hedge = hedge;
+    hedge_context->hedge = hedge;
+    ++policy.hedged_requests;
+
+    MRPC_LOG_DEBUG("Send hedge request, stub id {}, seq id {}, hedge seq id {}", context->stub_id, context->seq_id, hedge_context->seq_id);
+    GlobalProxy::SendRequest(hedge_context);
+    return true;
+}
+
+void NetworkClientImpl::ReportToBalancer(const ServiceStubContext& context, int32_t ret)
+{
+    // 客户端直接失败的请求没有到达后端, 不计入耗时
+    bool local_failure = ret == ERROR_SERVICE_UNAVAILABLE || ret == ERROR_SEND_BUFFER_FULL;
+    bool success = !IsTransportFailure(ret);
+    uint64_t latency = local_failure ? 0 : std::max<uint64_t>(Time::NowMicros() - context.start_time, 1);
+    context.endpoints->balancer->OnRequestDone(context.endpoint_index, success, latency);
+}
+
+void NetworkClientImpl::FailRequest(const std::shared_ptr<ServiceStubContext>& context, int32_t ret)
+{
+    if (!context->param.need_response)
+    {
+        return;
+    }
+    CompleteRequest(context, ret, std::string());
+}
+
+void NetworkClientImpl::OnTimer(uv_timer_t* handle)
+{
+    NetworkClientImpl* client = (NetworkClientImpl*)uv_loop_get_data(uv_handle_get_loop((uv_handle_t*)handle));
+    client->CheckTimeout(uv_now(&client->loop_));
+}
+
+void NetworkClientImpl::CheckTimeout(uint64_t now)
+{
+    expired_seq_ids_.clear();
+    timer_wheel_.Advance(now, expired_seq_ids_);
+    for (uint64_t seq_id : expired_seq_ids_)
+    {
+        // 已经收到回包的请求不在id2context_中
+        auto it = id2context_.find(seq_id);
+        if (it == id2context_.end())
+        {
+            continue;
+        }
+
+        PendingRequest request = std::move(it->second);
+        id2context_.erase(it);
+        auto conn_it = id2conn_.find(request.conn_id);
+        if (conn_it != id2conn_.end())
+        {
+            conn_it->second->pending_seq_ids.erase(seq_id);
+        }
+
+        MRPC_LOG_DEBUG("Request timeout, stub id {}, seq id {}, conn id {}", request.context->stub_id, seq_id, request.conn_id);
+        CompleteRequest(request.context, ERROR_TIMEOUT, std::string());
+    }
+
+    if (timer_wheel_.Empty())
+    {
+        uv_timer_stop(&timer_);
+    }
+}
+
+void NetworkClientImpl::OnHedgeTimer(uv_timer_t* handle)
+{
+    NetworkClientImpl* client = (NetworkClientImpl*)uv_loop_get_data(uv_handle_get_loop((uv_handle_t*)handle));
+    client->CheckHedge(uv_now(&client->loop_));
+}
+
+void NetworkClientImpl::CheckHedge(uint64_t now)
+{
+    expired_seq_ids_.clear();
+    hedge_wheel_.Advance(now, expired_seq_ids_);
+    for (uint64_t seq_id : expired_seq_ids_)
+    {
+        // 已经完成的请求不在id2context_中, 原请求不取消, 两者先回包的一个有效
+        auto it = id2context_.find(seq_id);
+        if (it != id2context_.end() && it->second.context->hedge == nullptr)
+        {
+            SendHedgeRequest(it->second.context);
+        }
+    }
+
+    if (hedge_wheel_.Empty())
+    {
+        uv_timer_stop(&hedge_timer_);
+    }
+}
+
+void NetworkClientImpl::HandleResponses(NetworkClientConnection* conn, const char*& begin, const char* end)
+{
+    while (begin < end)
+    {
+        bool has_error = false;
+        uint64_t seq_id = 0;
+        int32_t ret_value = 0;
+        std::string response_payload;
+        if (conn->protocol.handle_response(begin, end - begin, has_error, seq_id, ret_value, response_payload))
+        {
+            // 已经超时的请求直接丢弃回包
+            auto it = id2context_.find(seq_id);
+            if (it == id2context_.end())
             {
-                MRPC_LOG_DEBUG("Discard request, stub id {}, data length {}", context->stub_id, context->request.length());
                 continue;
             }
 
-            auto it = client->id2conn_.find(context->stub_id);
-            if (it != client->id2conn_.end())
+            std::shared_ptr<ServiceStubContext> context = std::move(it->second.context);
+            id2context_.erase(it);
+            conn->pending_seq_ids.erase(seq_id);
+
+            CompleteRequest(context, ret_value, std::move(response_payload));
+        }
+        else if (has_error)
+        {
+            CloseConnection(conn);
+            return;
+        }
+        else
+        {
+            return;
+        }
+    }
+}
+
+void NetworkClientImpl::OnRead(uv_stream_t* handle, ssize_t nread, const uv_buf_t* buf)
+{
+    NetworkClientImpl* client = (NetworkClientImpl*)uv_loop_get_data(uv_handle_get_loop((uv_handle_t*)handle));
+    NetworkClientConnection* conn = (NetworkClientConnection*)uv_handle_get_data((uv_handle_t*)handle);
+    bool in_buffer = buf->base != nullptr && buf->base == conn->buffer.GetWritePtr();
+    if (nread > 0)
+    {
+        MRPC_LOG_TRACE("Received {} bytes", nread);
+
+        if (in_buffer)
+        {
+            conn->buffer.Commit(nread);
+
+            const char* begin = conn->buffer.GetReadPtr();
+            const char* end = begin + conn->buffer.GetReadableSize();
+            client->HandleResponses(conn, begin, end);
+            conn->buffer.Consume(begin - conn->buffer.GetReadPtr());
+        }
+        else
+        {
+            // 没有残留数据时直接在读缓冲区上解析, 只保存不完整的尾部
+            const char* begin = buf->base;
+            const char* end = buf->base + nread;
+            client->HandleResponses(conn, begin, end);
+            if (begin < end && !conn->close)
+            {
+                conn->buffer.Append(begin, end - begin);
+            }
+        }
+
+        if (!conn->close)
+        {
+            ReserveFrame(conn->protocol, conn->buffer);
+        }
+    }
+    else if (nread < 0)
+    {
+        if (nread != UV_EOF)
+        {
+            MRPC_LOG_ERROR("Read error, {}", uv_err_name(nread));
+        }
+        client->CloseConnection(conn);
+    }
+
+    if (!in_buffer)
+    {
+        client->read_buffer_pool_.Free(buf->base);
+    }
+}
+
+void NetworkClientImpl::OnShmControl(uv_poll_t* handle, int status, int events)
+{
+    (void)events;
+    NetworkClientImpl* client = (NetworkClientImpl*)uv_loop_get_data(uv_handle_get_loop((uv_handle_t*)handle));
+    NetworkClientConnection* conn = (NetworkClientConnection*)uv_handle_get_data((uv_handle_t*)handle);
+    if (status < 0)
+    {
+        MRPC_LOG_ERROR("Poll shm control socket error, conn id {}, {}", conn->conn_id, uv_strerror(status));
+        client->CloseConnection(conn);
+        return;
+    }
+
+    if (!conn->shm_ready)
+    {
+        ShmConnection* shm = conn->shm;
+        int ret = shm->channel.ReceiveFrom(conn->control_fd);
+        if (ret == EAGAIN)
+        {
+            return;
+        }
+        else if (ret != 0)
+        {
+            MRPC_LOG_ERROR("New connection {} to shm {} error, {}", conn->conn_id, conn->peer_host, strerror(ret));
+            client->CloseConnection(conn);
+            return;
+        }
+
+        ret = uv_poll_init(&client->loop_, &shm->poll, shm->channel.GetEventFd());
+        assert(ret == 0);
+        uv_handle_set_data((uv_handle_t*)&shm->poll, shm);
+        ret = uv_poll_start(&shm->poll, UV_READABLE, OnShmEvent);
+        assert(ret == 0);
+        conn->shm_ready = true;
+        client->OnConnected(conn);
+        MRPC_LOG_DEBUG("New connection, conn id {}, shm {}, ring size {}", conn->conn_id, conn->peer_host, shm->channel.GetRingSize());
+
+        conn->FlushShm();
+        return;
+    }
+
+    // 连接建立后控制socket上只会有对端关闭
+    char data = 0;
+    ssize_t nread = recv(conn->control_fd, &data, sizeof(data), 0);
+    if (nread < 0 && (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR))
+    {
+        return;
+    }
+    MRPC_LOG_DEBUG("Shm connection closed, conn id {}, peer {}", conn->conn_id, conn->peer_host);
+    client->CloseConnection(conn);
+}
+
+void NetworkClientImpl::OnShmEvent(uv_poll_t* handle, int status, int events)
+{
+    (void)events;
+    NetworkClientImpl* client = (NetworkClientImpl*)uv_loop_get_data(uv_handle_get_loop((uv_handle_t*)handle));
+    ShmConnection* shm = (ShmConnection*)uv_handle_get_data((uv_handle_t*)handle);
+    NetworkClientConnection* conn = (NetworkClientConnection*)shm->conn;
+    if (status < 0)
+    {
+        MRPC_LOG_ERROR("Poll shm event error, conn id {}, {}", conn->conn_id, uv_strerror(status));
+        client->CloseConnection(conn);
+        return;
+    }
+
+    shm->channel.ClearEvent();
+    size_t nread = shm->channel.Read(conn->buffer);
+    if (nread > 0)
+    {
+        MRPC_LOG_TRACE("Received {} bytes", nread);
+
+        const char* begin = conn->buffer.GetReadPtr();
+        const char* end = begin + conn->buffer.GetReadableSize();
+        client->HandleResponses(conn, begin, end);
+        if (conn->close)
+        {
+            return;
+        }
+        conn->buffer.Consume(begin - conn->buffer.GetReadPtr());
+        ReserveFrame(conn->protocol, conn->buffer);
+    }
+
+    // 服务端可能腾出了空间
+    conn->FlushShm();
+}
+
+void NetworkClientImpl::OnAllocDatagram(uv_handle_t* handle, size_t suggested_size, uv_buf_t* buf)
+{
+    (void)suggested_size;
+    NetworkClientImpl* client = (NetworkClientImpl*)uv_loop_get_data(uv_handle_get_loop(handle));
+    // 解析时会拷贝出回包数据, 接收缓冲区可以一直复用
+    if (!client->datagram_buffer_)
+    {
+        client->datagram_buffer_.reset(new char[kDatagramRecvBufferSize]);
+    }
+    buf->base = client->datagram_buffer_.get();
+    buf->len = kDatagramRecvBufferSize;
+}
+
+void NetworkClientImpl::OnReadDatagram(uv_udp_t* handle, ssize_t nread, const uv_buf_t* buf, const struct sockaddr* addr, unsigned flags)
+{
+    (void)flags;
+    NetworkClientImpl* client = (NetworkClientImpl*)uv_loop_get_data(uv_handle_get_loop((uv_handle_t*)handle));
+    NetworkClientConnection* conn = (NetworkClientConnection*)uv_handle_get_data((uv_handle_t*)handle);
+    if (nread < 0)
+    {
+        // 比如服务端没有启动时收到的ICMP端口不可达, 请求由调用方超时处理
+        MRPC_LOG_DEBUG("Receive datagram error, conn id {}, {}", conn->conn_id, uv_err_name(nread));
+        return;
+    }
+    // nread为0且addr为空时表示没有数据或者recvmmsg的缓冲区可以释放
+    if (addr == nullptr)
+    {
+        return;
+    }
+
+    MRPC_LOG_TRACE("Received datagram {} bytes", nread);
+    const char* begin = buf->base;
+    client->HandleResponses(conn, begin, buf->base + nread);
+}
+
+// 已经加入等待表的请求发送失败, 不等待超时
+void NetworkClientImpl::FailPendingRequest(uint64_t seq_id, int32_t ret)
+{
+    auto it = id2context_.find(seq_id);
+    if (it == id2context_.end())
+    {
+        return;
+    }
+
+    PendingRequest request = std::move(it->second);
+    id2context_.erase(it);
+    auto conn_it = id2conn_.find(request.conn_id);
+    if (conn_it != id2conn_.end())
+    {
+        conn_it->second->pending_seq_ids.erase(seq_id);
+    }
+    FailRequest(request.context, ret);
+}
+
+bool NetworkClientImpl::QueueDatagram(NetworkClientConnection* conn, const std::shared_ptr<ServiceStubContext>& context)
+{
+    if (context->request.length() > kMaxDatagramSize)
+    {
+        MRPC_LOG_ERROR("Discard request, conn id {}, data length {} exceeds max datagram size", conn->conn_id, context->request.length());
+        return false;
+    }
+
+    if (conn->datagrams.empty())
+    {
+        datagram_conns_.push_back(conn);
+    }
+    conn->datagrams.emplace_back().data = std::move(context->request);
+    conn->datagram_seq_ids.push_back(context->param.need_response ? context->seq_id : 0);
+    return true;
+}
+
+void NetworkClientImpl::FlushDatagrams()
+{
+    for (NetworkClientConnection* conn : datagram_conns_)
+    {
+        std::vector<Datagram>& datagrams = conn->datagrams;
+        uv_os_fd_t fd = -1;
+        uv_fileno((const uv_handle_t*)&conn->handle, &fd);
+        size_t index = 0;
+        while (index < datagrams.size())
+        {
+            int ret = SendDatagrams(fd, datagrams.data() + index, datagrams.size() - index);
+            if (ret > 0)
             {
-                conn = it->second.get();
+                index += ret;
             }
-            if (conn == nullptr)
+            else if (ret == -EAGAIN || ret == -EWOULDBLOCK)
             {
-                MRPC_LOG_DEBUG("Discard request, stub id {}, data length {}", context->stub_id, context->request.length());
-                continue;
+                break;
             }
+            else
+            {
+                MRPC_LOG_DEBUG("Send datagram error, conn id {}, {}", conn->conn_id, strerror(-ret));
+                FailPendingRequest(conn->datagram_seq_ids[index], ERROR_SERVICE_UNAVAILABLE);
+                ++index;
+            }
+        }
+        MRPC_LOG_DEBUG("Send requests, conn id {}, datagram num {}", conn->conn_id, index);
 
-            conn->send_buffer.push_back(std::move(context->request));
+        // 发送缓冲区满时剩下的交给libuv, 等socket可写后再发送
+        for (; index < datagrams.size(); ++index)
+        {
+            DatagramSendReq* send_req = new DatagramSendReq();
+            send_req->datagram = std::move(datagrams[index]);
+            send_req->seq_id = conn->datagram_seq_ids[index];
+            uv_buf_t buf = uv_buf_init(send_req->datagram.data.data(), send_req->datagram.data.length());
+            uv_req_set_data((uv_req_t*)&send_req->req, send_req);
+            int ret = uv_udp_send(&send_req->req, &conn->handle.udp, &buf, 1, nullptr, OnSendDatagram);
+            if (ret != 0)
+            {
+                MRPC_LOG_DEBUG("Send datagram error, conn id {}, {}", conn->conn_id, uv_strerror(ret));
+                FailPendingRequest(send_req->seq_id, ERROR_SERVICE_UNAVAILABLE);
+                delete send_req;
+            }
         }
-        else
+        datagrams.clear();
+        conn->datagram_seq_ids.clear();
+    }
+    datagram_conns_.clear();
+}
+
+void NetworkClientImpl::OnSendDatagram(uv_udp_send_t* req, int status)
+{
+    DatagramSendReq* send_req = (DatagramSendReq*)uv_req_get_data((uv_req_t*)req);
+    if (status)
+    {
+        MRPC_LOG_DEBUG("Send datagram error, {}", uv_strerror(status));
+        NetworkClientImpl* client = (NetworkClientImpl*)uv_loop_get_data(uv_handle_get_loop((uv_handle_t*)req->handle));
+        client->FailPendingRequest(send_req->seq_id, ERROR_SERVICE_UNAVAILABLE);
+    }
+    delete send_req;
+}
+
+bool NetworkClientImpl::InitUring()
+{
+    if (ring_ != nullptr)
+    {
+        return true;
+    }
+    if (uring_unsupported_)
+    {
+        return false;
+    }
+
+    if (!IoUring::IsSupported())
+    {
+        MRPC_LOG_WARN("io_uring is not supported by the kernel, use libuv");
+        uring_unsupported_ = true;
+        return false;
+    }
+
+    std::unique_ptr<IoUring> ring(new IoUring());
+    int ret = ring->Initialize(kUringEntries);
+    if (ret == 0)
+    {
+        ret = ring->RegisterBufferRing(kRecvBufferGroup, kRecvBufferNum, kRecvBufferSize);
+    }
+    if (ret != 0)
+    {
+        MRPC_LOG_WARN("Initialize io_uring error, {}, use libuv", strerror(-ret));
+        uring_unsupported_ = true;
+        return false;
+    }
+
+    // 完成事件由libuv的事件循环监视, 不单独阻塞等待
+    ret = uv_poll_init(&loop_, &ring_poll_, ring->GetFd());
+    assert(ret == 0);
+    ret = uv_poll_start(&ring_poll_, UV_READABLE, OnUringEvent);
+    assert(ret == 0);
+    ring_ = std::move(ring);
+    return true;
+}
+
+bool NetworkClientImpl::StartUring(NetworkClientConnection* conn)
+{
+    uv_os_fd_t fd = -1;
+    if (!InitUring() || uv_fileno((const uv_handle_t*)&conn->handle, &fd) != 0)
+    {
+        return false;
+    }
+
+    conn->uring.reset(new UringConnection());
+    conn->uring->fd = fd;
+    if (!ArmRecv(conn))
+    {
+        conn->uring.reset();
+        return false;
+    }
+    MRPC_LOG_DEBUG("Use io_uring, conn id {}", conn->conn_id);
+    return true;
+}
+
+bool NetworkClientImpl::ArmRecv(NetworkClientConnection* conn)
+{
+    struct io_uring_sqe* sqe = ring_->GetSqe();
+    if (sqe == nullptr)
+    {
+        MRPC_LOG_ERROR("Submission queue is full, conn id {}", conn->conn_id);
+        return false;
+    }
+
+    // len为0, 每次由内核从buffer ring中取一个缓冲区
+    sqe->opcode = IORING_OP_RECV;
+    sqe->fd = conn->uring->fd;
+    sqe->ioprio = IORING_RECV_MULTISHOT;
+    sqe->flags = IOSQE_BUFFER_SELECT;
+    sqe->buf_group = ring_->GetBufferGroupId();
+    sqe->user_data = MakeUserData(kOpRecv, conn->conn_id);
+    conn->uring->recv_armed = true;
+    ++conn->uring->pending_ops;
+    return true;
+}
+
+void NetworkClientImpl::OnUringEvent(uv_poll_t* handle, int status, int events)
+{
+    (void)events;
+    NetworkClientImpl* client = (NetworkClientImpl*)uv_loop_get_data(uv_handle_get_loop((uv_handle_t*)handle));
+    if (status < 0)
+    {
+        MRPC_LOG_ERROR("Poll io_uring error, {}", uv_strerror(status));
+        return;
+    }
+
+    struct io_uring_cqe* cqes[kMaxCqeBatch];
+    uint32_t num = 0;
+    while ((num = client->ring_->PeekCqes(cqes, kMaxCqeBatch)) > 0)
+    {
+        for (uint32_t i = 0; i < num; ++i)
         {
-            conn->Write(context->request);
+            client->HandleCqe(cqes[i]);
         }
+        client->ring_->AdvanceCq(num);
     }
+
+    // 处理完成事件时重新提交的recv和sendmsg
+    client->FlushUring();
+}
+
+void NetworkClientImpl::HandleCqe(const struct io_uring_cqe* cqe)
+{
+    UringClientOp op = (UringClientOp)(cqe->user_data >> kOpShift);
+    uint64_t conn_id = cqe->user_data & kConnIdMask;
+    auto it = id2conn_.find(conn_id);
+    assert(it != id2conn_.end());
+    NetworkClientConnection* conn = it->second.get();
+    if (op == kOpRecv)
+    {
+        OnUringRecv(conn, cqe->res, cqe->flags);
+    }
+    else if (op == kOpSend)
+    {
+        OnUringSend(conn, cqe->res);
+    }
+
+    if (conn->uring->closed && conn->uring->pending_ops == 0)
+    {
+        id2conn_.erase(it);
+    }
+}
+
+void NetworkClientImpl::OnUringRecv(NetworkClientConnection* conn, int res, uint32_t flags)
+{
+    bool more = (flags & IORING_CQE_F_MORE) != 0;
+    if (res > 0)
+    {
+        assert(flags & IORING_CQE_F_BUFFER);
+        uint16_t buffer_id = flags >> IORING_CQE_BUFFER_SHIFT;
+        const char* data = ring_->GetBuffer(buffer_id);
+        MRPC_LOG_TRACE("Received {} bytes", res);
+
+        if (!conn->close)
+        {
+            if (conn->buffer.Empty())
+            {
+                // 直接在provided buffer上解析, 只保存不完整的尾部
+                const char* begin = data;
+                const char* end = data + res;
+                HandleResponses(conn, begin, end);
+                if (begin < end && !conn->close)
+                {
+                    conn->buffer.Append(begin, end - begin);
+                }
+            }
+            else
+            {
+                conn->buffer.Append(data, res);
+                const char* begin = conn->buffer.GetReadPtr();
+                const char* end = begin + conn->buffer.GetReadableSize();
+                HandleResponses(conn, begin, end);
+                conn->buffer.Consume(begin - conn->buffer.GetReadPtr());
+            }
+
+            if (!conn->close)
+            {
+                ReserveFrame(conn->protocol, conn->buffer);
+            }
+        }
+        ring_->RecycleBuffer(buffer_id);
+    }
+    else if (res == 0)
+    {
+        CloseConnection(conn);
+    }
+    else if (res != -ENOBUFS && res != -ECANCELED)
+    {
+        MRPC_LOG_ERROR("Read error, conn id {}, {}", conn->conn_id, strerror(-res));
+        CloseConnection(conn);
+    }
+
+    if (more)
+    {
+        return;
+    }
+
+    // multishot recv结束: 连接关闭, 缓冲区用完(-ENOBUFS)或者内核要求重新提交
+    conn->uring->recv_armed = false;
+    --conn->uring->pending_ops;
+    if (!conn->close && !ArmRecv(conn))
+    {
+        CloseConnection(conn);
+    }
+}
+
+void NetworkClientImpl::OnUringSend(NetworkClientConnection* conn, int res)
+{
+    UringConnection* uring = conn->uring.get();
+    --uring->pending_ops;
+    if (conn->close)
+    {
+        return;
+    }
+
+    if (res < 0)
+    {
+        MRPC_LOG_ERROR("Write error, conn id {}, {}", conn->conn_id, strerror(-res));
+        CloseConnection(conn);
+        return;
+    }
+
+    // 部分发送时从未发送的位置继续
+    if (uring->write_buffer.Advance(res))
+    {
+        SubmitSend(conn);
+        return;
+    }
+    FlushUringWrite(conn);
+}
+
+bool NetworkClientImpl::QueueUringWrite(NetworkClientConnection* conn, std::string&& packet)
+{
+    UringConnection* uring = conn->uring.get();
+    // 对端不读取时未发送的请求和连接建立之前的缓存一样受max_send_buffer_bytes限制
+    if (conn->max_send_buffer_bytes != 0 && uring->write_buffer.GetBytes() + packet.length() > conn->max_send_buffer_bytes)
+    {
+        return false;
+    }
+    if (!uring->queued)
+    {
+        uring->queued = true;
+        uring_conns_.push_back(conn);
+    }
+    MRPC_LOG_DEBUG("Send request, conn id {}, data length {}", conn->conn_id, packet.length());
+    uring->write_buffer.Append(std::move(packet));
+    return true;
+}
+
+void NetworkClientImpl::FlushUringWrite(NetworkClientConnection* conn)
+{
+    // 上一个sendmsg完成之后再发送, 保证请求顺序
+    if (conn->uring->write_buffer.Prepare())
+    {
+        SubmitSend(conn);
+    }
+}
+
+void NetworkClientImpl::SubmitSend(NetworkClientConnection* conn)
+{
+    struct io_uring_sqe* sqe = ring_->GetSqe();
+    if (sqe == nullptr)
+    {
+        MRPC_LOG_ERROR("Submission queue is full, conn id {}", conn->conn_id);
+        CloseConnection(conn);
+        return;
+    }
+
+    UringConnection* uring = conn->uring.get();
+    sqe->opcode = IORING_OP_SENDMSG;
+    sqe->fd = uring->fd;
+    sqe->addr = (uint64_t)(uintptr_t)uring->write_buffer.GetMsg();
+    sqe->len = 1;
+    sqe->msg_flags = MSG_NOSIGNAL;
+    sqe->user_data = MakeUserData(kOpSend, conn->conn_id);
+    ++uring->pending_ops;
+}
+
+void NetworkClientImpl::FlushUring()
+{
+    if (ring_ == nullptr)
+    {
+        return;
+    }
+
+    for (NetworkClientConnection* conn : uring_conns_)
+    {
+        conn->uring->queued = false;
+        if (!conn->close)
+        {
+            FlushUringWrite(conn);
+        }
+    }
+    uring_conns_.clear();
+
+    int ret = ring_->Submit();
+    if (ret < 0)
+    {
+        MRPC_LOG_ERROR("Submit io_uring error, {}", strerror(-ret));
+    }
+}
+
+void NetworkClientImpl::OnRequestWrite(uv_async_t* handle)
+{
+    NetworkClientImpl* client = (NetworkClientImpl*)uv_loop_get_data(uv_handle_get_loop((uv_handle_t*)handle));
+    if (!client->running_)
+    {
+        uv_stop(&client->loop_);
+        return;
+    }
+
+    std::shared_ptr<ServiceStubContext> context;
+    while (client->queue_.TryPop(context))
+    {
+        NetworkClientConnection* conn = client->SelectConnection(context);
+        if (conn == nullptr)
+        {
+            MRPC_LOG_DEBUG("Discard request, stub id {}, data length {}", context->stub_id, context->request.length());
+            FailRequest(context, ERROR_SERVICE_UNAVAILABLE);
+            continue;
+        }
+
+        if (uv_handle_get_type((uv_handle_t*)&conn->handle) == UV_UDP)
+        {
+            if (!client->QueueDatagram(conn, context))
+            {
+                FailRequest(context, ERROR_INVALID_METHOD_REQUEST_DATA);
+                continue;
+            }
+        }
+        else if (conn->uring != nullptr)
+        {
+            if (!client->QueueUringWrite(conn, std::move(context->request)))
+            {
+                MRPC_LOG_DEBUG("Send buffer full, conn id {}, buffered {} bytes", conn->conn_id, conn->uring->write_buffer.GetBytes());
+                FailRequest(context, ERROR_SEND_BUFFER_FULL);
+                continue;
+            }
+        }
+        else if (!conn->Write(context->request))
+        {
+            MRPC_LOG_DEBUG("Send buffer full, conn id {}, buffered {} bytes", conn->conn_id, conn->send_buffer_bytes);
+            FailRequest(context, ERROR_SEND_BUFFER_FULL);
+            continue;
+        }
+
+        if (context->param.need_response)
+        {
+            client->AddPendingRequest(conn, context);
+        }
+    }
+
+    client->FlushDatagrams();
+    client->FlushUring();
 }
 
 void NetworkClientImpl::Start()
@@ -396,15 +1685,29 @@ void NetworkClientImpl::Start()
 
 void NetworkClientImpl::Stop()
 {
+    // uv_stop不是线程安全的, 由事件循环线程在OnRequestWrite中调用
     running_ = false;
-    uv_stop(&loop_);
+    int ret = uv_async_send(&async_);
+    assert(ret == 0);
 }
 
 void NetworkClientImpl::SendRequest(const std::shared_ptr<ServiceStubContext>& context)
 {
-    queue_.push(context);
-    int ret = uv_async_send(&async_);
-    assert(ret == 0);
+    // 只有队列从空变为非空时唤醒, 同一批请求只需要一次uv_async_send
+    if (queue_.Push(context))
+    {
+        int ret = uv_async_send(&async_);
+        assert(ret == 0);
+    }
+}
+
+void NetworkClientImpl::SendRequests(std::span<const std::shared_ptr<ServiceStubContext>> contexts)
+{
+    if (queue_.PushBatch(contexts.begin(), contexts.end()))
+    {
+        int ret = uv_async_send(&async_);
+        assert(ret == 0);
+    }
 }
 
 NetworkClient::NetworkClient() : impl_(new NetworkClientImpl())
@@ -431,4 +1734,9 @@ void NetworkClient::SendRequest(const std::shared_ptr<ServiceStubContext>& conte
     impl_->SendRequest(context);
 }
 
+void NetworkClient::SendRequests(std::span<const std::shared_ptr<ServiceStubContext>> contexts)
+{
+    impl_->SendRequests(contexts);
+}
+
 }
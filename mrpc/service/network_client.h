@@ -1,6 +1,7 @@
 #pragma once
 
 #include <memory>
+#include <span>
 
 #include <mrpc/service/context.h>
 #include <mrpc/util/noncopyable.h>
@@ -20,6 +21,7 @@ public:
     void Stop();
 
     void SendRequest(const std::shared_ptr<ServiceStubContext>& context);
+    void SendRequests(std::span<const std::shared_ptr<ServiceStubContext>> contexts);
 
 private:
     NetworkClientImpl* impl_;
@@ -1,44 +1,85 @@
+#include <algorithm>
 #include <cassert>
+#include <cerrno>
 #include <cstring>
 #include <atomic>
 #include <unordered_map>
+#include <unistd.h>
 #include <uv.h>
 
 #include <mrpc/error_code.mrpc.h>
 #include <mrpc/service/network_service.h>
+#include <mrpc/service/network_service_uring.h>
 #include <mrpc/service/service_bridge.h>
 #include <mrpc/service/application_config.mrpc.h>
+#include <mrpc/service/service_metrics.h>
+#include <mrpc/util/buffer_pool.h>
+#include <mrpc/util/datagram.h>
+#include <mrpc/util/input_buffer.h>
+#include <mrpc/util/io_uring.h>
 #include <mrpc/util/log.h>
-#include <mrpc/util/thread_safe_queue.h>
+#include <mrpc/util/mpsc_queue.h>
+#include <mrpc/util/shm_channel.h>
+#include <mrpc/util/timer_wheel.h>
 
 namespace mrpc
 {
 
-struct write_req_t
+// 一次uv_write发送的多个回包, 数据从ServiceContext中move过来, 不再拷贝.
+struct WriteBatch
 {
     uv_write_t req;
-    uv_buf_t buf;
+    size_t size = 0;    // 尚未写出的字节数
+    std::vector<std::string> data;
+    std::vector<uv_buf_t> bufs;
 };
 
-static void GetPeerTcpAddrName(uv_tcp_t* handle, std::string& host, uint32_t& port)
+// TCP和Unix domain socket(pipe)共用同一套读写流程, 只有初始化和地址不同
+union StreamHandle
 {
-    struct sockaddr_storage rawname;
-    int namelen = sizeof(rawname);
-    if (uv_tcp_getpeername(handle, (struct sockaddr*)&rawname, &namelen) != 0)
-    {
-        return;
-    }
+    uv_tcp_t tcp;
+    uv_pipe_t pipe;
+    uv_poll_t poll;     // 客户端的shm连接直接监视控制socket
+    uv_udp_t udp;       // 没有连接, 每个数据报一个包
+};
+
+// sendmmsg发不出去(发送缓冲区满)的数据报交给uv_udp_send排队.
+struct DatagramSendReq
+{
+    uv_udp_send_t req;
+    Datagram datagram;
+};
+
+// recvmmsg一次最多接收的数据报个数, 接收缓冲区按最大数据报切分
+static constexpr size_t kDatagramRecvBatch = 16;
+static constexpr size_t kDatagramRecvBufferSize = kDatagramRecvBatch * 64 * 1024;
+
+// shm连接的数据走共享内存环, 对端写入数据或腾出空间时poll可读.
+// 连接关闭时由poll的关闭回调释放.
+struct ShmConnection
+{
+    void* conn = nullptr;
+    uv_poll_t poll;
+    ShmChannel channel;
+};
+
+static void OnCloseShm(uv_handle_t* handle)
+{
+    delete (ShmConnection*)uv_handle_get_data(handle);
+}
 
-    char ip[INET6_ADDRSTRLEN];
-    if (rawname.ss_family == AF_INET)
+static void GetAddrName(const struct sockaddr* addr, std::string& host, uint32_t& port)
+{
+    char ip[INET6_ADDRSTRLEN] = { 0 };
+    if (addr->sa_family == AF_INET)
     {
-        struct sockaddr_in* addr_v4 = (struct sockaddr_in*)&rawname;
+        const struct sockaddr_in* addr_v4 = (const struct sockaddr_in*)addr;
         uv_ip4_name(addr_v4, ip, sizeof(ip));
         port = ntohs(addr_v4->sin_port);
     }
-    else if (rawname.ss_family == AF_INET6)
+    else if (addr->sa_family == AF_INET6)
     {
-        struct sockaddr_in6* addr_v6 = (struct sockaddr_in6*)&rawname;
+        const struct sockaddr_in6* addr_v6 = (const struct sockaddr_in6*)addr;
         uv_ip6_name(addr_v6, ip, sizeof(ip));
         port = ntohs(addr_v6->sin6_port);
     }
@@ -46,45 +87,109 @@ static void GetPeerTcpAddrName(uv_tcp_t* handle, std::string& host, uint32_t& po
     host = ip;
 }
 
-struct NetworkServiceTcpConnection
+static void GetPeerTcpAddrName(uv_tcp_t* handle, std::string& host, uint32_t& port)
+{
+    struct sockaddr_storage rawname;
+    int namelen = sizeof(rawname);
+    if (uv_tcp_getpeername(handle, (struct sockaddr*)&rawname, &namelen) != 0)
+    {
+        return;
+    }
+
+    GetAddrName((const struct sockaddr*)&rawname, host, port);
+}
+
+static socklen_t GetAddrLength(const struct sockaddr* addr)
+{
+    return addr->sa_family == AF_INET6 ? sizeof(struct sockaddr_in6) : sizeof(struct sockaddr_in);
+}
+
+// 每个IO线程各自监听同一地址, 由内核把新连接(或数据报)分配到各个线程
+static int BindReusePortSocket(const struct sockaddr* addr, int type)
+{
+#ifdef SO_REUSEPORT
+    int on = 1;
+    int fd = socket(addr->sa_family, type, 0);
+    if (fd < 0
+            || setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &on, sizeof(on)) != 0
+            || setsockopt(fd, SOL_SOCKET, SO_REUSEPORT, &on, sizeof(on)) != 0
+            || bind(fd, addr, GetAddrLength(addr)) != 0)
+    {
+        MRPC_LOG_ERROR("Bind reuse port socket error, {}", strerror(errno));
+        if (fd >= 0) close(fd);
+        return -1;
+    }
+    return fd;
+#else
+    (void)addr;
+    (void)type;
+    MRPC_LOG_ERROR("SO_REUSEPORT is not supported, io_thread_num must be 1");
+    return -1;
+#endif
+}
+
+struct NetworkServiceConnection
 {
-    NetworkServiceTcpConnection();
-    ~NetworkServiceTcpConnection() = default;
+    NetworkServiceConnection();
+    ~NetworkServiceConnection() = default;
 
     uint64_t conn_id = 0;
     std::string host;
     uint32_t port = 0;
     Protocol protocol;
     bool close = false;
-    std::string buffer;
+    InputBuffer buffer;
+    std::vector<std::string> write_buffer;  // 本轮待发送的回包
+
+    // 背压
+    uint32_t pending_requests = 0;      // 已交给worker线程但还没有回包的请求
+    size_t pending_write_bytes = 0;     // write_buffer和uv_write中尚未写出的字节
+    bool read_paused = false;
+
+    // 超时, 取自uv_now
+    uint64_t last_active_time = 0;      // 最近一次收到数据的时间
+    uint64_t read_start_time = 0;       // 开始接收当前不完整的包的时间
+
+    // 非空时为shm连接, handle只作为控制socket, 关闭时表示对端断开
+    ShmConnection* shm = nullptr;
+    size_t write_offset = 0;            // write_buffer中第一个回包已经写入环的字节
 
     // uv fields
-    uv_tcp_t handle;
+    StreamHandle handle;
 
     void Close(uv_close_cb cb);
 };
 
-NetworkServiceTcpConnection::NetworkServiceTcpConnection()
+NetworkServiceConnection::NetworkServiceConnection()
 {
     uv_handle_set_data((uv_handle_t*)&handle, this);
 }
 
-void NetworkServiceTcpConnection::Close(uv_close_cb cb)
+void NetworkServiceConnection::Close(uv_close_cb cb)
 {
     close = true;
+    if (shm != nullptr)
+    {
+        uv_close((uv_handle_t*)&shm->poll, OnCloseShm);
+        shm = nullptr;
+    }
     uv_close((uv_handle_t*)&handle, cb);
 }
 
-class NetworkServiceImpl
+class NetworkServiceImpl;
+
+// 一个IO线程对应一个NetworkServiceLoop, 各自拥有独立的uv_loop_t、监听socket和连接.
+class NetworkServiceLoop
 {
 public:
-    NetworkServiceImpl();
-    ~NetworkServiceImpl();
-
-    void SetBridge(ServiceBridge* bridge);
-    void SetAllProtocol(const std::vector<Protocol>& all_protocol);
+    NetworkServiceLoop(NetworkServiceImpl& service, uint32_t index);
+    ~NetworkServiceLoop();
 
-    int BindTcpAddr(const std::string& host, uint32_t port, uint32_t backlog);
+    int BindTcpAddr(const struct sockaddr* addr, uint32_t backlog, bool reuse_port);
+    int BindUdpAddr(const struct sockaddr* addr, bool reuse_port);
+    // shared_fd为-1时绑定path, 否则在另一个IO线程已绑定的socket上监听.
+    int BindPipe(const std::string& path, uint32_t backlog, uv_os_fd_t shared_fd);
+    uv_os_fd_t GetServerFd() const;
 
     void Start();
     void Stop();
@@ -92,31 +197,108 @@ public:
     void SendResponse(const std::shared_ptr<ServiceContext>& context);
 
 private:
-    static void OnNewTcpConnection(uv_stream_t* server, int status);
-    static void OnCloseTcpConnection(uv_handle_t *handle);
+    static void OnNewConnection(uv_stream_t* server, int status);
+    static void OnCloseConnection(uv_handle_t *handle);
+    static void OnCloseRejectedConnection(uv_handle_t *handle);
     static void OnAllocBuffer(uv_handle_t* handle, size_t suggested_size, uv_buf_t* buf);
     static void OnRead(uv_stream_t* handle, ssize_t nread, const uv_buf_t* buf);
     static void OnRequestWrite(uv_async_t* handle);
     static void OnWrite(uv_write_t *req, int status);
-
+    static void OnTimer(uv_timer_t* handle);
+    static void OnShmEvent(uv_poll_t* handle, int status, int events);
+    static void OnAllocDatagram(uv_handle_t* handle, size_t suggested_size, uv_buf_t* buf);
+    static void OnReadDatagram(uv_udp_t* handle, ssize_t nread, const uv_buf_t* buf, const struct sockaddr* addr, unsigned flags);
+    static void OnSendDatagram(uv_udp_send_t* req, int status);
+
+    bool OpenShm(NetworkServiceConnection* conn);
+    void ParseRequests(NetworkServiceConnection* conn, const char*& begin, const char* end);
+    void QueueWrite(NetworkServiceConnection* conn, std::string&& data);
+    void OnReceived(NetworkServiceConnection* conn, bool parsed);
+    void FlushWrite(NetworkServiceConnection* conn);
+    void FlushShmWrite(NetworkServiceConnection* conn);
+    void FlushAllWrites();
+    void WriteDone(NetworkServiceConnection* conn, size_t size);
+    void UpdateReading(NetworkServiceConnection* conn);
+    bool HasTimeout() const;
+    uint64_t GetExpireTime(NetworkServiceConnection* conn, uint64_t now, bool& idle) const;
+    void CheckTimeout(uint64_t now);
+    void DispatchMessage(NetworkServiceConnection* conn, const std::shared_ptr<ServiceContext>& context);
+    void DispatchDatagram(const std::shared_ptr<ServiceContext>& context, const struct sockaddr* addr);
+    void QueueDatagram(const struct sockaddr_storage& addr, const std::shared_ptr<ServiceContext>& context);
+    void FlushDatagrams();
+
+    NetworkServiceImpl& service_;
+    uint32_t index_ = 0;
     std::atomic<bool> running_ = false;
-    std::string host_;
-    uint32_t port_ = 0;
-    ServiceBridge* bridge_ = nullptr;
-    std::vector<Protocol> all_protocol_;
-    std::unordered_map<uint64_t, std::unique_ptr<NetworkServiceTcpConnection>> id2conn_;
-    ThreadSafeQueue<std::shared_ptr<ServiceContext>> queue_;
-
-    static inline uint64_t next_conn_id_ = 0;
+    std::unordered_map<uint64_t, std::unique_ptr<NetworkServiceConnection>> id2conn_;
+    MpscQueue<std::shared_ptr<ServiceContext>> queue_;      // worker线程提交的回包
+    BufferPool read_buffer_pool_;
+    std::vector<NetworkServiceConnection*> write_conns_;    // write_buffer非空的连接
+    ServiceMetrics& metrics_;
+    TimerWheel timer_wheel_;    // 每个连接最多一个定时器, 到期时检查空闲和读超时
+    std::vector<uint64_t> expired_conn_ids_;
+
+    // UDP
+    std::unordered_map<uint64_t, struct sockaddr_storage> datagram_peers_;  // 交给worker线程的请求id -> 对端地址
+    std::vector<Datagram> datagrams_;   // 本轮待发送的回包, 用sendmmsg一次发送
+    std::unique_ptr<char[]> datagram_buffer_;
 
     // uv fields
     uv_loop_t loop_;
-    uv_tcp_t tcp_server_;
+    uv_handle_type server_type_ = UV_TCP;
+    StreamHandle server_;
     uv_async_t async_;
+    uv_timer_t timer_;
+};
+
+class NetworkServiceImpl
+{
+public:
+    NetworkServiceImpl() = default;
+    ~NetworkServiceImpl() = default;
+
+    void SetBridge(ServiceBridge* bridge);
+    void SetAllProtocol(const std::vector<Protocol>& all_protocol);
+    void SetIoThreadNum(uint32_t io_thread_num);
+    void SetConnectionLimit(uint32_t max_pending_requests, uint32_t max_write_queue_bytes);
+    void SetConnectionTimeout(uint32_t max_connections, uint32_t read_timeout, uint32_t idle_timeout);
+
+    int BindTcpAddr(const std::string& host, uint32_t port, uint32_t backlog);
+    int BindPipe(const std::string& path, uint32_t backlog);
+    int BindUdpAddr(const std::string& host, uint32_t port);
+    int BindShm(const std::string& path, uint32_t backlog, uint32_t ring_size);
+
+    void Start(uint32_t io_index);
+    void Stop();
+
+    void SendResponse(const std::shared_ptr<ServiceContext>& context);
 
+private:
+    std::string host_;
+    uint32_t port_ = 0;
+    ServiceBridge* bridge_ = nullptr;
+    std::vector<Protocol> all_protocol_;
+    uint32_t io_thread_num_ = 1;
+    uint32_t max_pending_requests_ = 0;
+    uint32_t max_write_queue_bytes_ = 0;
+    uint32_t max_connections_ = 0;
+    uint32_t read_timeout_ = 0;
+    uint32_t idle_timeout_ = 0;
+    uint32_t shm_ring_size_ = 0;            // 大于0时新连接为shm连接
+    std::atomic<uint32_t> conn_num_ = 0;    // 所有IO线程的连接数
+    std::vector<std::unique_ptr<NetworkServiceLoop>> loops_;
+
+    // 所有IO线程(以及所有Service)共享, 保证连接id全局唯一
+    static inline std::atomic<uint64_t> next_conn_id_ = 0;
+
+    friend class NetworkServiceLoop;
 };
 
-NetworkServiceImpl::NetworkServiceImpl()
+NetworkServiceLoop::NetworkServiceLoop(NetworkServiceImpl& service, uint32_t index) :
+    service_(service),
+    index_(index),
+    metrics_(service.bridge_->GetMetrics()),
+    timer_wheel_(0)     // 首次Advance时追上当前时间
 {
     int ret = uv_loop_init(&loop_);
     assert(ret == 0);
@@ -124,66 +306,138 @@ NetworkServiceImpl::NetworkServiceImpl()
 
     ret = uv_async_init(&loop_, &async_, OnRequestWrite);
     assert(ret == 0);
+
+    ret = uv_timer_init(&loop_, &timer_);
+    assert(ret == 0);
 }
 
-NetworkServiceImpl::~NetworkServiceImpl()
+NetworkServiceLoop::~NetworkServiceLoop()
 {
     int ret = uv_loop_close(&loop_);
     assert(ret == 0);
 }
 
-void NetworkServiceImpl::SetBridge(ServiceBridge* bridge)
+int NetworkServiceLoop::BindTcpAddr(const struct sockaddr* addr, uint32_t backlog, bool reuse_port)
 {
-    bridge_ = bridge;
-}
+    int ret = 0;
 
-void NetworkServiceImpl::SetAllProtocol(const std::vector<Protocol>& all_protocol)
-{
-    all_protocol_ = all_protocol;
+    ret = uv_tcp_init(&loop_, &server_.tcp);
+    assert(ret == 0);
+
+    if (reuse_port)
+    {
+        int fd = BindReusePortSocket(addr, SOCK_STREAM);
+        if (fd < 0)
+        {
+            return ERROR_INITIALIZATION_FAILED;
+        }
+
+        ret = uv_tcp_open(&server_.tcp, fd);
+        assert(ret == 0);
+    }
+    else
+    {
+        ret = uv_tcp_bind(&server_.tcp, addr, 0);
+        assert(ret == 0);
+    }
+
+    ret = uv_tcp_nodelay(&server_.tcp, 1);
+    assert(ret == 0);
+
+    ret = uv_listen((uv_stream_t*)&server_.tcp, backlog, OnNewConnection);
+    if (ret != 0)
+    {
+        MRPC_LOG_ERROR("Server listen on address {}:{} error, {}", service_.host_, service_.port_, uv_strerror(ret));
+        return ERROR_INITIALIZATION_FAILED;
+    }
+
+    return 0;
 }
 
-int NetworkServiceImpl::BindTcpAddr(const std::string& host, uint32_t port, uint32_t backlog)
+int NetworkServiceLoop::BindUdpAddr(const struct sockaddr* addr, bool reuse_port)
 {
     int ret = 0;
 
-    ret = uv_tcp_init(&loop_, &tcp_server_);
+    // 接收缓冲区大于一个数据报时, libuv用recvmmsg一次接收多个
+    server_type_ = UV_UDP;
+    ret = uv_udp_init_ex(&loop_, &server_.udp, AF_UNSPEC | UV_UDP_RECVMMSG);
     assert(ret == 0);
 
-    struct sockaddr_in addr_v4;
-    struct sockaddr_in6 addr_v6;
-    if (uv_ip4_addr(host.c_str(), port, &addr_v4) == 0)
+    if (reuse_port)
     {
-        ret = uv_tcp_bind(&tcp_server_, (const struct sockaddr*)&addr_v4, 0);
+        int fd = BindReusePortSocket(addr, SOCK_DGRAM);
+        if (fd < 0)
+        {
+            return ERROR_INITIALIZATION_FAILED;
+        }
+
+        ret = uv_udp_open(&server_.udp, fd);
         assert(ret == 0);
     }
-    else if (uv_ip6_addr(host.c_str(), port, &addr_v6) == 0)
+    else
     {
-        ret = uv_tcp_bind(&tcp_server_, (const struct sockaddr*)&addr_v6, 0);
-        assert(ret == 0);
+        ret = uv_udp_bind(&server_.udp, addr, 0);
+        if (ret != 0)
+        {
+            MRPC_LOG_ERROR("Bind udp address {}:{} error, {}", service_.host_, service_.port_, uv_strerror(ret));
+            return ERROR_INITIALIZATION_FAILED;
+        }
     }
-    else
+
+    ret = uv_udp_recv_start(&server_.udp, OnAllocDatagram, OnReadDatagram);
+    if (ret != 0)
     {
-        MRPC_LOG_ERROR("Invalid server address {}:{}", host, port);
+        MRPC_LOG_ERROR("Server receive on udp address {}:{} error, {}", service_.host_, service_.port_, uv_strerror(ret));
         return ERROR_INITIALIZATION_FAILED;
     }
 
-    ret = uv_tcp_nodelay(&tcp_server_, 1);
+    return 0;
+}
+
+int NetworkServiceLoop::BindPipe(const std::string& path, uint32_t backlog, uv_os_fd_t shared_fd)
+{
+    int ret = 0;
+
+    server_type_ = UV_NAMED_PIPE;
+    ret = uv_pipe_init(&loop_, &server_.pipe, 0);
     assert(ret == 0);
 
-    ret = uv_listen((uv_stream_t*)&tcp_server_, backlog, OnNewTcpConnection);
+    if (shared_fd < 0)
+    {
+        // 删除上次进程退出时残留的socket文件
+        unlink(path.c_str());
+        ret = uv_pipe_bind(&server_.pipe, path.c_str());
+    }
+    else
+    {
+        // AF_UNIX不支持SO_REUSEPORT, 各IO线程在同一个socket上监听, 由先被唤醒的线程accept
+        uv_os_fd_t fd = dup(shared_fd);
+        ret = fd < 0 ? uv_translate_sys_error(errno) : uv_pipe_open(&server_.pipe, fd);
+    }
     if (ret != 0)
     {
-        MRPC_LOG_ERROR("Server listen on address {}:{} error, {}", host, port, uv_strerror(ret));
+        MRPC_LOG_ERROR("Bind pipe {} error, {}", path, uv_strerror(ret));
+        return ERROR_INITIALIZATION_FAILED;
+    }
+
+    ret = uv_listen((uv_stream_t*)&server_.pipe, backlog, OnNewConnection);
+    if (ret != 0)
+    {
+        MRPC_LOG_ERROR("Server listen on pipe {} error, {}", path, uv_strerror(ret));
         return ERROR_INITIALIZATION_FAILED;
     }
 
-    host_ = host;
-    port_ = port;
-    MRPC_LOG_INFO("Server listen on address {}:{} success...", host_, port_);
     return 0;
 }
 
-void NetworkServiceImpl::OnNewTcpConnection(uv_stream_t* server, int status)
+uv_os_fd_t NetworkServiceLoop::GetServerFd() const
+{
+    uv_os_fd_t fd = -1;
+    uv_fileno((const uv_handle_t*)&server_, &fd);
+    return fd;
+}
+
+void NetworkServiceLoop::OnNewConnection(uv_stream_t* server, int status)
 {
     if (status < 0)
     {
@@ -191,120 +445,233 @@ void NetworkServiceImpl::OnNewTcpConnection(uv_stream_t* server, int status)
         return;
     }
 
-    NetworkServiceTcpConnection* conn = new NetworkServiceTcpConnection();
-    NetworkServiceImpl* service = (NetworkServiceImpl*)uv_loop_get_data(uv_handle_get_loop((uv_handle_t*)server));
-    int ret = uv_tcp_init(&service->loop_, &conn->handle);
+    NetworkServiceConnection* conn = new NetworkServiceConnection();
+    NetworkServiceLoop* loop = (NetworkServiceLoop*)uv_loop_get_data(uv_handle_get_loop((uv_handle_t*)server));
+    NetworkServiceImpl& service = loop->service_;
+    int ret = loop->server_type_ == UV_TCP ? uv_tcp_init(&loop->loop_, &conn->handle.tcp) : uv_pipe_init(&loop->loop_, &conn->handle.pipe, 0);
     assert(ret == 0);
 
-    if (uv_accept(server, (uv_stream_t*)&conn->handle) == 0)
+    if (uv_accept(server, (uv_stream_t*)&conn->handle) != 0)
     {
-        conn->conn_id = ++next_conn_id_;
-        GetPeerTcpAddrName(&conn->handle, conn->host, conn->port);
-        if (service->all_protocol_.size() == 1)
-        {
-            conn->protocol = service->all_protocol_[0];
-        }
-        service->id2conn_.emplace(conn->conn_id, conn);
-
-        MRPC_LOG_DEBUG("Accept new connection, conn id {}, self addr {}:{}, peer addr {}:{}", conn->conn_id, service->host_, service->port_, conn->host, conn->port);
+        conn->Close(OnCloseRejectedConnection);
+        return;
+    }
 
-        ret = uv_read_start((uv_stream_t*)&conn->handle, OnAllocBuffer, OnRead);
-        assert(ret == 0);
+    if (loop->server_type_ == UV_TCP)
+    {
+        GetPeerTcpAddrName(&conn->handle.tcp, conn->host, conn->port);
     }
     else
     {
-        conn->Close(OnCloseTcpConnection);
+        conn->host = service.host_;
     }
+    uint32_t conn_num = ++service.conn_num_;
+    if (service.max_connections_ > 0 && conn_num > service.max_connections_)
+    {
+        // 先accept再关闭, 避免新连接堆积在backlog中
+        --service.conn_num_;
+        ++loop->metrics_.rejected_connections;
+        MRPC_LOG_DEBUG("Too many connections, reject peer addr {}:{}, max connections {}", conn->host, conn->port, service.max_connections_);
+        conn->Close(OnCloseRejectedConnection);
+        return;
+    }
+    ++loop->metrics_.connections;
+
+    conn->conn_id = ++NetworkServiceImpl::next_conn_id_;
+    if (service.all_protocol_.size() == 1)
+    {
+        conn->protocol = service.all_protocol_[0];
+    }
+    loop->id2conn_.emplace(conn->conn_id, conn);
+
+    MRPC_LOG_DEBUG("Accept new connection, conn id {}, io thread {}, self addr {}:{}, peer addr {}:{}", conn->conn_id, loop->index_, service.host_, service.port_, conn->host, conn->port);
+
+    if (service.shm_ring_size_ > 0 && !loop->OpenShm(conn))
+    {
+        conn->Close(OnCloseConnection);
+        return;
+    }
+
+    if (loop->HasTimeout())
+    {
+        uint64_t now = uv_now(&loop->loop_);
+        bool idle = false;
+        conn->last_active_time = now;
+        loop->timer_wheel_.Add(conn->conn_id, loop->GetExpireTime(conn, now, idle));
+    }
+
+    ret = uv_read_start((uv_stream_t*)&conn->handle, OnAllocBuffer, OnRead);
+    assert(ret == 0);
 }
 
-void NetworkServiceImpl::OnCloseTcpConnection(uv_handle_t* handle)
+void NetworkServiceLoop::OnCloseConnection(uv_handle_t* handle)
 {
-    NetworkServiceImpl* service = (NetworkServiceImpl*)uv_loop_get_data(uv_handle_get_loop(handle));
-    NetworkServiceTcpConnection* conn = (NetworkServiceTcpConnection*)uv_handle_get_data(handle);
-    MRPC_LOG_DEBUG("Close connection, conn id {}, self addr {}:{}, peer addr {}:{}", conn->conn_id, service->host_, service->port_, conn->host, conn->port);
-    service->id2conn_.erase(conn->conn_id);
+    NetworkServiceLoop* loop = (NetworkServiceLoop*)uv_loop_get_data(uv_handle_get_loop(handle));
+    NetworkServiceConnection* conn = (NetworkServiceConnection*)uv_handle_get_data(handle);
+    MRPC_LOG_DEBUG("Close connection, conn id {}, self addr {}:{}, peer addr {}:{}", conn->conn_id, loop->service_.host_, loop->service_.port_, conn->host, conn->port);
+    // 之后到达的回包会被丢弃, 不再计数
+    loop->metrics_.pending_requests -= conn->pending_requests;
+    loop->metrics_.pending_write_bytes -= conn->pending_write_bytes;
+    --loop->metrics_.connections;
+    --loop->service_.conn_num_;
+    loop->id2conn_.erase(conn->conn_id);
 }
 
-void NetworkServiceImpl::OnAllocBuffer(uv_handle_t* handle, size_t suggested_size, uv_buf_t* buf)
+void NetworkServiceLoop::OnCloseRejectedConnection(uv_handle_t* handle)
 {
-    (void)handle;
-    buf->base = (char*)malloc(suggested_size);
-    buf->len = suggested_size;
+    delete (NetworkServiceConnection*)uv_handle_get_data(handle);
 }
 
-void NetworkServiceImpl::OnRead(uv_stream_t* handle, ssize_t nread, const uv_buf_t* buf)
+void NetworkServiceLoop::OnAllocBuffer(uv_handle_t* handle, size_t suggested_size, uv_buf_t* buf)
 {
-    NetworkServiceImpl* service = (NetworkServiceImpl*)uv_loop_get_data(uv_handle_get_loop((uv_handle_t*)handle));
-    NetworkServiceTcpConnection* conn = (NetworkServiceTcpConnection*)uv_handle_get_data((uv_handle_t*)handle);
-    if (nread > 0)
+    (void)suggested_size;
+    NetworkServiceLoop* loop = (NetworkServiceLoop*)uv_loop_get_data(uv_handle_get_loop(handle));
+    NetworkServiceConnection* conn = (NetworkServiceConnection*)uv_handle_get_data(handle);
+    if (conn->buffer.Empty() || conn->shm != nullptr)
     {
-        conn->buffer.append(buf->base, nread);
-        MRPC_LOG_TRACE("Received {} bytes", nread);
+        buf->base = loop->read_buffer_pool_.Allocate();
+        buf->len = loop->read_buffer_pool_.GetBlockSize();
+    }
+    else
+    {
+        // 有残留数据时直接读到输入缓冲区的尾部, 省去一次拷贝
+        conn->buffer.EnsureWritable(loop->read_buffer_pool_.GetBlockSize());
+        buf->base = conn->buffer.GetWritePtr();
+        buf->len = conn->buffer.GetWritableSize();
+    }
+}
+
+bool NetworkServiceLoop::OpenShm(NetworkServiceConnection* conn)
+{
+    // 创建共享内存段和eventfd, 通过刚accept的Unix domain socket发给客户端
+    ShmConnection* shm = new ShmConnection();
+    uv_os_fd_t fd = -1;
+    if (!shm->channel.Create(service_.shm_ring_size_)
+            || uv_fileno((const uv_handle_t*)&conn->handle, &fd) != 0
+            || !shm->channel.SendTo(fd))
+    {
+        MRPC_LOG_ERROR("Open shm channel error, conn id {}, {}", conn->conn_id, strerror(errno));
+        delete shm;
+        return false;
+    }
+
+    shm->conn = conn;
+    int ret = uv_poll_init(&loop_, &shm->poll, shm->channel.GetEventFd());
+    assert(ret == 0);
+    uv_handle_set_data((uv_handle_t*)&shm->poll, shm);
+    ret = uv_poll_start(&shm->poll, UV_READABLE, OnShmEvent);
+    assert(ret == 0);
+    conn->shm = shm;
+    return true;
+}
+
+void NetworkServiceLoop::DispatchMessage(NetworkServiceConnection* conn, const std::shared_ptr<ServiceContext>& context)
+{
+    context->conn_id = conn->conn_id;
+    context->io_index = index_;
+    context->host = conn->host;
+    context->port = conn->port;
+    context->protocol = conn->protocol;
+    if (service_.bridge_->DispatchMessage(context))
+    {
+        ++conn->pending_requests;
+        ++metrics_.pending_requests;
+    }
+    else if (!context->response.empty())
+    {
+        QueueWrite(conn, std::move(context->response));
+    }
+}
 
-        const char* begin = conn->buffer.c_str();
-        const char* end = conn->buffer.c_str() + conn->buffer.size();
-        if (conn->protocol.parse == nullptr)
+void NetworkServiceLoop::ParseRequests(NetworkServiceConnection* conn, const char*& begin, const char* end)
+{
+    if (conn->protocol.parse == nullptr)
+    {
+        bool has_error = false;
+        std::shared_ptr<ServiceContext> context;
+        for (const auto& protocol : service_.all_protocol_)
         {
-            bool has_error = false;
-            std::shared_ptr<ServiceContext> context;
-            for (const auto& protocol : service->all_protocol_)
+            if (protocol.parse(begin, end - begin, false, has_error, context))
+            {
+                conn->protocol = protocol;
+                DispatchMessage(conn, context);
+                break;
+            }
+            else if (has_error)
             {
-                if (protocol.parse(begin, end - begin, false, has_error, context))
-                {
-                    conn->protocol = protocol;
-
-                    context->conn_id = conn->conn_id;
-                    context->host = conn->host;
-                    context->port = conn->port;
-                    context->protocol = conn->protocol;
-                    service->bridge_->DispatchMessage(context);
-                    break;
-                }
-                else if (has_error)
-                {
-                    conn->Close(OnCloseTcpConnection);
-                    break;
-                }
+                conn->Close(OnCloseConnection);
+                return;
             }
         }
+    }
 
-        if (conn->protocol.parse != nullptr)
+    if (conn->protocol.parse != nullptr)
+    {
+        while (begin < end)
         {
-            while (begin < end)
+            bool has_error = false;
+            std::shared_ptr<ServiceContext> context;
+            if (conn->protocol.parse(begin, end - begin, true, has_error, context))
             {
-                bool has_error = false;
-                std::shared_ptr<ServiceContext> context;
-                if (conn->protocol.parse(begin, end - begin, true, has_error, context))
-                {
-                    context->conn_id = conn->conn_id;
-                    context->host = conn->host;
-                    context->port = conn->port;
-                    context->protocol = conn->protocol;
-                    service->bridge_->DispatchMessage(context);
-                }
-                else if (has_error)
-                {
-                    conn->Close(OnCloseTcpConnection);
-                    break;
-                }
-                else
-                {
-                    break;
-                }
+                DispatchMessage(conn, context);
+            }
+            else if (has_error)
+            {
+                conn->Close(OnCloseConnection);
+                return;
+            }
+            else
+            {
+                return;
             }
         }
+    }
+}
+
+void NetworkServiceLoop::OnRead(uv_stream_t* handle, ssize_t nread, const uv_buf_t* buf)
+{
+    NetworkServiceLoop* loop = (NetworkServiceLoop*)uv_loop_get_data(uv_handle_get_loop((uv_handle_t*)handle));
+    NetworkServiceConnection* conn = (NetworkServiceConnection*)uv_handle_get_data((uv_handle_t*)handle);
+    bool in_buffer = buf->base != nullptr && buf->base == conn->buffer.GetWritePtr();
+    if (nread > 0 && conn->shm != nullptr)
+    {
+        MRPC_LOG_DEBUG("Unexpected data on shm control socket, conn id {}", conn->conn_id);
+        conn->Close(OnCloseConnection);
+    }
+    else if (nread > 0)
+    {
+        MRPC_LOG_TRACE("Received {} bytes", nread);
 
-        if (begin < end)
+        bool parsed = false;
+        if (in_buffer)
+        {
+            conn->buffer.Commit(nread);
+
+            const char* begin = conn->buffer.GetReadPtr();
+            const char* end = begin + conn->buffer.GetReadableSize();
+            loop->ParseRequests(conn, begin, end);
+            parsed = begin != conn->buffer.GetReadPtr();
+            conn->buffer.Consume(begin - conn->buffer.GetReadPtr());
+        }
+        else
         {
-            if (begin != conn->buffer.c_str())
+            // 没有残留数据时直接在读缓冲区上解析, 只保存不完整的尾部
+            const char* begin = buf->base;
+            const char* end = buf->base + nread;
+            loop->ParseRequests(conn, begin, end);
+            parsed = begin != buf->base;
+            if (begin < end && !conn->close)
             {
-                conn->buffer.assign(begin, end - begin);
+                conn->buffer.Append(begin, end - begin);
             }
         }
-        else
+
+        if (!conn->close)
         {
-            conn->buffer.clear();
+            loop->OnReceived(conn, parsed);
         }
+        // 过载时的错误回包
+        loop->FlushAllWrites();
     }
     else if (nread < 0)
     {
@@ -312,110 +679,779 @@ void NetworkServiceImpl::OnRead(uv_stream_t* handle, ssize_t nread, const uv_buf
         {
             MRPC_LOG_DEBUG("Read error, {}", uv_err_name(nread));
         }
-        conn->Close(OnCloseTcpConnection);
+        conn->Close(OnCloseConnection);
     }
 
-    free(buf->base);
+    if (!in_buffer)
+    {
+        loop->read_buffer_pool_.Free(buf->base);
+    }
 }
 
-void NetworkServiceImpl::OnRequestWrite(uv_async_t* handle)
+void NetworkServiceLoop::OnShmEvent(uv_poll_t* handle, int status, int events)
 {
-    NetworkServiceImpl* service = (NetworkServiceImpl*)uv_loop_get_data(uv_handle_get_loop((uv_handle_t*)handle));
-    std::shared_ptr<ServiceContext> context;
-    while (service->queue_.try_pop(context))
+    (void)events;
+    NetworkServiceLoop* loop = (NetworkServiceLoop*)uv_loop_get_data(uv_handle_get_loop((uv_handle_t*)handle));
+    ShmConnection* shm = (ShmConnection*)uv_handle_get_data((uv_handle_t*)handle);
+    NetworkServiceConnection* conn = (NetworkServiceConnection*)shm->conn;
+    if (status < 0)
     {
-        NetworkServiceTcpConnection* conn = nullptr;
-        auto it = service->id2conn_.find(context->conn_id);
-        if (it != service->id2conn_.end())
-        {
-            conn = it->second.get();
-        }
-        if (conn == nullptr || conn->close)
-        {
-            MRPC_LOG_DEBUG("Discard response, conn id {}, data length {}", context->conn_id, context->response.length());
-            continue;
-        }
+        MRPC_LOG_DEBUG("Poll shm event error, conn id {}, {}", conn->conn_id, uv_strerror(status));
+        conn->Close(OnCloseConnection);
+        return;
+    }
 
-        if (!context->response.empty())
-        {
-            size_t length = context->response.length();
-            write_req_t* write_req = (write_req_t*)malloc(sizeof(write_req_t));
-            write_req->buf = uv_buf_init((char*)malloc(length), length);
-            memcpy(write_req->buf.base, context->response.c_str(), length);
-            int ret = uv_write((uv_write_t*)write_req, (uv_stream_t*)&conn->handle, &write_req->buf, 1, OnWrite);
-            assert(ret == 0);
-            MRPC_LOG_TRACE("Send response, conn id {}, data length {}", context->conn_id, context->response.length());
-        }
+    shm->channel.ClearEvent();
+    // 暂停读取时数据留在环中, 对端写满后自然阻塞
+    size_t nread = conn->read_paused ? 0 : shm->channel.Read(conn->buffer);
+    if (nread > 0)
+    {
+        MRPC_LOG_TRACE("Received {} bytes", nread);
 
-        if (context->close_connection)
+        const char* begin = conn->buffer.GetReadPtr();
+        const char* end = begin + conn->buffer.GetReadableSize();
+        loop->ParseRequests(conn, begin, end);
+        bool parsed = begin != conn->buffer.GetReadPtr();
+        conn->buffer.Consume(begin - conn->buffer.GetReadPtr());
+        if (!conn->close)
         {
-            conn->Close(OnCloseTcpConnection);
+            loop->OnReceived(conn, parsed);
         }
+    }
 
-        context.reset();
+    // 对端可能腾出了空间
+    if (!conn->close)
+    {
+        loop->FlushWrite(conn);
+        loop->UpdateReading(conn);
     }
+    loop->FlushAllWrites();
 }
 
-void NetworkServiceImpl::OnWrite(uv_write_t* req, int status)
+void NetworkServiceLoop::OnAllocDatagram(uv_handle_t* handle, size_t suggested_size, uv_buf_t* buf)
 {
-    if (status)
+    (void)suggested_size;
+    NetworkServiceLoop* loop = (NetworkServiceLoop*)uv_loop_get_data(uv_handle_get_loop(handle));
+    // 解析时会拷贝出请求数据, 接收缓冲区可以一直复用
+    if (!loop->datagram_buffer_)
     {
-        MRPC_LOG_DEBUG("Write error, {}", uv_strerror(status));
+        loop->datagram_buffer_.reset(new char[kDatagramRecvBufferSize]);
     }
-
-    write_req_t* write_req = (write_req_t*)req;
-    free(write_req->buf.base);
-    free(write_req);
+    buf->base = loop->datagram_buffer_.get();
+    buf->len = kDatagramRecvBufferSize;
 }
 
-void NetworkServiceImpl::Start()
+void NetworkServiceLoop::OnReadDatagram(uv_udp_t* handle, ssize_t nread, const uv_buf_t* buf, const struct sockaddr* addr, unsigned flags)
 {
-    running_ = true;
-    while (running_)
+    (void)flags;
+    NetworkServiceLoop* loop = (NetworkServiceLoop*)uv_loop_get_data(uv_handle_get_loop((uv_handle_t*)handle));
+    if (nread < 0)
     {
-        uv_run(&loop_, UV_RUN_DEFAULT);
+        MRPC_LOG_DEBUG("Receive datagram error, {}", uv_err_name(nread));
+        return;
+    }
+    // nread为0且addr为空时表示没有数据或者recvmmsg的缓冲区可以释放
+    if (addr == nullptr)
+    {
+        return;
+    }
+
+    MRPC_LOG_TRACE("Received datagram {} bytes", nread);
+    bool parsed = false;
+    for (const auto& protocol : loop->service_.all_protocol_)
+    {
+        // 每个数据报只有一个包, 不完整的包直接丢弃
+        const char* begin = buf->base;
+        bool has_error = false;
+        std::shared_ptr<ServiceContext> context;
+        if (protocol.parse(begin, nread, false, has_error, context))
+        {
+            context->protocol = protocol;
+            loop->DispatchDatagram(context, addr);
+            parsed = true;
+            break;
+        }
     }
+    if (!parsed)
+    {
+        MRPC_LOG_DEBUG("Discard invalid datagram, length {}", nread);
+    }
+
+    // 过载时的错误回包
+    loop->FlushDatagrams();
 }
 
-void NetworkServiceImpl::Stop()
+void NetworkServiceLoop::DispatchDatagram(const std::shared_ptr<ServiceContext>& context, const struct sockaddr* addr)
 {
-    running_ = false;
-    uv_stop(&loop_);
+    // 数据报没有连接, 每个请求分配一个id用于找回对端地址
+    context->conn_id = ++NetworkServiceImpl::next_conn_id_;
+    context->io_index = index_;
+    GetAddrName(addr, context->host, context->port);
+
+    struct sockaddr_storage peer;
+    memcpy(&peer, addr, GetAddrLength(addr));
+    if (service_.bridge_->DispatchMessage(context))
+    {
+        datagram_peers_.emplace(context->conn_id, peer);
+        ++metrics_.pending_requests;
+    }
+    else if (!context->response.empty())
+    {
+        QueueDatagram(peer, context);
+    }
 }
 
-void NetworkServiceImpl::SendResponse(const std::shared_ptr<ServiceContext>& context)
+void NetworkServiceLoop::QueueDatagram(const struct sockaddr_storage& addr, const std::shared_ptr<ServiceContext>& context)
+{
+    // 回包过大时改为回复错误码, 客户端不必等到超时
+    if (context->response.length() > kMaxDatagramSize)
+    {
+        MRPC_LOG_ERROR("Discard response, request id {}, data length {} exceeds max datagram size", context->conn_id, context->response.length());
+        context->response.clear();
+        if (context->protocol.respond_error != nullptr)
+        {
+            context->protocol.respond_error(context, ERROR_INVALID_METHOD_RESPONSE_DATA);
+        }
+        if (context->response.empty() || context->response.length() > kMaxDatagramSize)
+        {
+            return;
+        }
+    }
+
+    Datagram& datagram = datagrams_.emplace_back();
+    datagram.addr = addr;
+    datagram.addr_len = GetAddrLength((const struct sockaddr*)&addr);
+    datagram.data = std::move(context->response);
+}
+
+void NetworkServiceLoop::FlushDatagrams()
+{
+    if (datagrams_.empty()) return;
+
+    uv_os_fd_t fd = -1;
+    uv_fileno((const uv_handle_t*)&server_.udp, &fd);
+    size_t index = 0;
+    while (index < datagrams_.size())
+    {
+        int ret = SendDatagrams(fd, datagrams_.data() + index, datagrams_.size() - index);
+        if (ret > 0)
+        {
+            index += ret;
+        }
+        else if (ret == -EAGAIN || ret == -EWOULDBLOCK)
+        {
+            break;
+        }
+        else
+        {
+            // 跳过发送失败的数据报
+            MRPC_LOG_DEBUG("Send datagram error, {}", strerror(-ret));
+            ++index;
+        }
+    }
+
+    // 发送缓冲区满时剩下的交给libuv, 等socket可写后再发送
+    for (; index < datagrams_.size(); ++index)
+    {
+        DatagramSendReq* send_req = new DatagramSendReq();
+        send_req->datagram = std::move(datagrams_[index]);
+        uv_buf_t buf = uv_buf_init(send_req->datagram.data.data(), send_req->datagram.data.length());
+        uv_req_set_data((uv_req_t*)&send_req->req, send_req);
+        int ret = uv_udp_send(&send_req->req, &server_.udp, &buf, 1, (const struct sockaddr*)&send_req->datagram.addr, OnSendDatagram);
+        if (ret != 0)
+        {
+            MRPC_LOG_DEBUG("Send datagram error, {}", uv_strerror(ret));
+            delete send_req;
+        }
+    }
+    datagrams_.clear();
+}
+
+void NetworkServiceLoop::OnSendDatagram(uv_udp_send_t* req, int status)
+{
+    if (status)
+    {
+        MRPC_LOG_DEBUG("Send datagram error, {}", uv_strerror(status));
+    }
+    delete (DatagramSendReq*)uv_req_get_data((uv_req_t*)req);
+}
+
+void NetworkServiceLoop::OnReceived(NetworkServiceConnection* conn, bool parsed)
+{
+    // 每收到一个完整的包, 读超时重新计时
+    uint64_t now = uv_now(&loop_);
+    conn->last_active_time = now;
+    if (conn->buffer.Empty())
+    {
+        conn->read_start_time = 0;
+    }
+    else if (parsed || conn->read_start_time == 0)
+    {
+        conn->read_start_time = now;
+    }
+
+    ReserveFrame(conn->protocol, conn->buffer);
+    UpdateReading(conn);
+}
+
+void NetworkServiceLoop::OnRequestWrite(uv_async_t* handle)
+{
+    NetworkServiceLoop* loop = (NetworkServiceLoop*)uv_loop_get_data(uv_handle_get_loop((uv_handle_t*)handle));
+    if (!loop->running_)
+    {
+        uv_stop(&loop->loop_);
+        return;
+    }
+
+    std::shared_ptr<ServiceContext> context;
+    while (loop->queue_.TryPop(context))
+    {
+        if (loop->server_type_ == UV_UDP)
+        {
+            auto it = loop->datagram_peers_.find(context->conn_id);
+            assert(it != loop->datagram_peers_.end());
+            --loop->metrics_.pending_requests;
+            if (!context->response.empty())
+            {
+                MRPC_LOG_TRACE("Send response, request id {}, data length {}", context->conn_id, context->response.length());
+                loop->QueueDatagram(it->second, context);
+            }
+            loop->datagram_peers_.erase(it);
+            continue;
+        }
+
+        NetworkServiceConnection* conn = nullptr;
+        auto it = loop->id2conn_.find(context->conn_id);
+        if (it != loop->id2conn_.end())
+        {
+            conn = it->second.get();
+        }
+        if (conn == nullptr || conn->close)
+        {
+            MRPC_LOG_DEBUG("Discard response, conn id {}, data length {}", context->conn_id, context->response.length());
+            continue;
+        }
+
+        assert(conn->pending_requests > 0);
+        --conn->pending_requests;
+        --loop->metrics_.pending_requests;
+
+        if (!context->response.empty())
+        {
+            MRPC_LOG_TRACE("Send response, conn id {}, data length {}", context->conn_id, context->response.length());
+            loop->QueueWrite(conn, std::move(context->response));
+        }
+
+        if (context->close_connection)
+        {
+            loop->FlushWrite(conn);
+            conn->Close(OnCloseConnection);
+        }
+        else if (conn->write_buffer.empty())
+        {
+            loop->UpdateReading(conn);
+        }
+
+        context.reset();
+    }
+
+    loop->FlushDatagrams();
+    loop->FlushAllWrites();
+}
+
+void NetworkServiceLoop::QueueWrite(NetworkServiceConnection* conn, std::string&& data)
+{
+    if (conn->write_buffer.empty())
+    {
+        write_conns_.push_back(conn);
+    }
+    conn->pending_write_bytes += data.length();
+    metrics_.pending_write_bytes += data.length();
+    conn->write_buffer.push_back(std::move(data));
+}
+
+void NetworkServiceLoop::FlushAllWrites()
+{
+    // 同一连接的回包合并为一次写
+    for (NetworkServiceConnection* conn : write_conns_)
+    {
+        if (!conn->close)
+        {
+            FlushWrite(conn);
+            UpdateReading(conn);
+        }
+    }
+    write_conns_.clear();
+}
+
+void NetworkServiceLoop::FlushWrite(NetworkServiceConnection* conn)
+{
+    std::vector<std::string>& write_buffer = conn->write_buffer;
+    if (write_buffer.empty()) return;
+
+    if (conn->shm != nullptr)
+    {
+        FlushShmWrite(conn);
+        return;
+    }
+
+    std::vector<uv_buf_t> bufs;
+    bufs.reserve(write_buffer.size());
+    for (auto& data : write_buffer)
+    {
+        bufs.push_back(uv_buf_init(data.data(), data.length()));
+    }
+
+    // 先尝试直接写入socket, 写不完的部分再交给uv_write
+    int written = uv_try_write((uv_stream_t*)&conn->handle, bufs.data(), bufs.size());
+    if (written < 0 && written != UV_EAGAIN)
+    {
+        MRPC_LOG_DEBUG("Write error, conn id {}, {}", conn->conn_id, uv_strerror(written));
+        write_buffer.clear();
+        conn->Close(OnCloseConnection);
+        return;
+    }
+
+    size_t index = 0;
+    size_t offset = written > 0 ? written : 0;
+    WriteDone(conn, offset);
+    while (index < write_buffer.size() && offset >= write_buffer[index].length())
+    {
+        offset -= write_buffer[index].length();
+        ++index;
+    }
+
+    if (index < write_buffer.size())
+    {
+        WriteBatch* batch = new WriteBatch();
+        batch->data.reserve(write_buffer.size() - index);
+        for (size_t i = index; i < write_buffer.size(); ++i)
+        {
+            batch->size += write_buffer[i].length();
+            batch->data.push_back(std::move(write_buffer[i]));
+        }
+        // move之后再取地址, 短字符串的数据在对象内部
+        batch->bufs.reserve(batch->data.size());
+        for (auto& data : batch->data)
+        {
+            batch->bufs.push_back(uv_buf_init(data.data(), data.length()));
+        }
+        batch->bufs[0].base += offset;
+        batch->bufs[0].len -= offset;
+        batch->size -= offset;
+
+        uv_req_set_data((uv_req_t*)&batch->req, batch);
+        int ret = uv_write(&batch->req, (uv_stream_t*)&conn->handle, batch->bufs.data(), batch->bufs.size(), OnWrite);
+        assert(ret == 0);
+    }
+
+    write_buffer.clear();
+}
+
+void NetworkServiceLoop::FlushShmWrite(NetworkServiceConnection* conn)
+{
+    // 环满时剩下的回包留在write_buffer中, 对端读取后在OnShmEvent中继续写
+    std::vector<std::string>& write_buffer = conn->write_buffer;
+    size_t index = 0;
+    while (index < write_buffer.size())
+    {
+        const std::string& data = write_buffer[index];
+        size_t written = conn->shm->channel.Write(data.data() + conn->write_offset, data.length() - conn->write_offset);
+        WriteDone(conn, written);
+        conn->write_offset += written;
+        if (conn->write_offset < data.length())
+        {
+            break;
+        }
+        conn->write_offset = 0;
+        ++index;
+    }
+    write_buffer.erase(write_buffer.begin(), write_buffer.begin() + index);
+}
+
+void NetworkServiceLoop::OnWrite(uv_write_t* req, int status)
+{
+    if (status)
+    {
+        MRPC_LOG_DEBUG("Write error, {}", uv_strerror(status));
+    }
+
+    // 连接关闭时未完成的写请求先于关闭回调返回, 此时连接仍然有效
+    NetworkServiceLoop* loop = (NetworkServiceLoop*)uv_loop_get_data(uv_handle_get_loop((uv_handle_t*)req->handle));
+    NetworkServiceConnection* conn = (NetworkServiceConnection*)uv_handle_get_data((uv_handle_t*)req->handle);
+    WriteBatch* batch = (WriteBatch*)uv_req_get_data((uv_req_t*)req);
+    loop->WriteDone(conn, batch->size);
+    loop->UpdateReading(conn);
+    delete batch;
+}
+
+void NetworkServiceLoop::WriteDone(NetworkServiceConnection* conn, size_t size)
+{
+    assert(conn->pending_write_bytes >= size);
+    conn->pending_write_bytes -= size;
+    metrics_.pending_write_bytes -= size;
+}
+
+void NetworkServiceLoop::UpdateReading(NetworkServiceConnection* conn)
+{
+    if (conn->close) return;
+
+    uint32_t max_pending_requests = service_.max_pending_requests_;
+    uint32_t max_write_queue_bytes = service_.max_write_queue_bytes_;
+    bool request_overflow = max_pending_requests > 0 && conn->pending_requests >= max_pending_requests;
+    bool write_overflow = max_write_queue_bytes > 0 && conn->pending_write_bytes >= max_write_queue_bytes;
+    if (!conn->read_paused)
+    {
+        if (request_overflow || write_overflow)
+        {
+            MRPC_LOG_DEBUG("Pause reading, conn id {}, pending requests {}, pending write bytes {}", conn->conn_id, conn->pending_requests, conn->pending_write_bytes);
+            // shm连接仍然要监视控制socket和eventfd, 只是不再读取环
+            if (conn->shm == nullptr)
+            {
+                int ret = uv_read_stop((uv_stream_t*)&conn->handle);
+                assert(ret == 0);
+            }
+            conn->read_paused = true;
+            ++metrics_.read_pauses;
+            if (write_overflow)
+            {
+                ++metrics_.write_queue_overflows;
+            }
+        }
+    }
+    else if ((max_pending_requests == 0 || conn->pending_requests <= max_pending_requests / 2)
+            && (max_write_queue_bytes == 0 || conn->pending_write_bytes <= max_write_queue_bytes / 2))
+    {
+        MRPC_LOG_DEBUG("Resume reading, conn id {}, pending requests {}, pending write bytes {}", conn->conn_id, conn->pending_requests, conn->pending_write_bytes);
+        if (conn->shm != nullptr)
+        {
+            // 暂停期间环中积压的数据在下一轮事件循环中读取
+            conn->shm->channel.NotifySelf();
+        }
+        else
+        {
+            int ret = uv_read_start((uv_stream_t*)&conn->handle, OnAllocBuffer, OnRead);
+            assert(ret == 0);
+        }
+        conn->read_paused = false;
+        // 暂停期间不计算读超时
+        if (!conn->buffer.Empty())
+        {
+            conn->read_start_time = uv_now(&loop_);
+        }
+    }
+}
+
+bool NetworkServiceLoop::HasTimeout() const
+{
+    return service_.read_timeout_ > 0 || service_.idle_timeout_ > 0;
+}
+
+uint64_t NetworkServiceLoop::GetExpireTime(NetworkServiceConnection* conn, uint64_t now, bool& idle) const
+{
+    uint32_t read_timeout = service_.read_timeout_;
+    uint32_t idle_timeout = service_.idle_timeout_;
+
+    // 都不适用时过一段时间再检查
+    uint32_t check_interval = read_timeout == 0 ? idle_timeout : (idle_timeout == 0 ? read_timeout : std::min(read_timeout, idle_timeout));
+    uint64_t expire_time = now + check_interval;
+    if (read_timeout > 0 && !conn->read_paused && conn->read_start_time > 0)
+    {
+        expire_time = std::min(expire_time, conn->read_start_time + read_timeout);
+    }
+    // 还有请求没回包时不算空闲
+    if (idle_timeout > 0 && conn->pending_requests == 0 && conn->pending_write_bytes == 0
+            && conn->last_active_time + idle_timeout <= expire_time)
+    {
+        expire_time = conn->last_active_time + idle_timeout;
+        idle = true;
+    }
+    return expire_time;
+}
+
+void NetworkServiceLoop::OnTimer(uv_timer_t* handle)
+{
+    NetworkServiceLoop* loop = (NetworkServiceLoop*)uv_loop_get_data(uv_handle_get_loop((uv_handle_t*)handle));
+    loop->CheckTimeout(uv_now(&loop->loop_));
+}
+
+void NetworkServiceLoop::CheckTimeout(uint64_t now)
+{
+    expired_conn_ids_.clear();
+    timer_wheel_.Advance(now, expired_conn_ids_);
+    for (uint64_t conn_id : expired_conn_ids_)
+    {
+        auto it = id2conn_.find(conn_id);
+        if (it == id2conn_.end() || it->second->close)
+        {
+            continue;
+        }
+
+        NetworkServiceConnection* conn = it->second.get();
+        bool idle = false;
+        uint64_t expire_time = GetExpireTime(conn, now, idle);
+        if (expire_time > now)
+        {
+            timer_wheel_.Add(conn_id, expire_time);
+            continue;
+        }
+
+        if (idle)
+        {
+            ++metrics_.idle_timeouts;
+            MRPC_LOG_DEBUG("Idle timeout, conn id {}, peer addr {}:{}", conn->conn_id, conn->host, conn->port);
+        }
+        else
+        {
+            ++metrics_.read_timeouts;
+            MRPC_LOG_DEBUG("Read timeout, conn id {}, peer addr {}:{}, buffered {} bytes", conn->conn_id, conn->host, conn->port, conn->buffer.GetReadableSize());
+        }
+        conn->Close(OnCloseConnection);
+    }
+}
+
+void NetworkServiceLoop::Start()
+{
+    if (HasTimeout())
+    {
+        uint64_t tick = timer_wheel_.GetTick();
+        int ret = uv_timer_start(&timer_, OnTimer, tick, tick);
+        assert(ret == 0);
+    }
+
+    running_ = true;
+    while (running_)
+    {
+        uv_run(&loop_, UV_RUN_DEFAULT);
+    }
+}
+
+void NetworkServiceLoop::Stop()
 {
-    queue_.push(context);
+    // uv_stop不是线程安全的, 由事件循环线程在OnRequestWrite中调用
+    running_ = false;
     int ret = uv_async_send(&async_);
     assert(ret == 0);
 }
 
-NetworkService::NetworkService() : impl_(new NetworkServiceImpl())
+void NetworkServiceLoop::SendResponse(const std::shared_ptr<ServiceContext>& context)
+{
+    if (queue_.Push(context))
+    {
+        int ret = uv_async_send(&async_);
+        assert(ret == 0);
+    }
+}
+
+void NetworkServiceImpl::SetBridge(ServiceBridge* bridge)
+{
+    bridge_ = bridge;
+}
+
+void NetworkServiceImpl::SetAllProtocol(const std::vector<Protocol>& all_protocol)
+{
+    all_protocol_ = all_protocol;
+}
+
+void NetworkServiceImpl::SetIoThreadNum(uint32_t io_thread_num)
+{
+    assert(loops_.empty());
+    io_thread_num_ = io_thread_num;
+}
+
+void NetworkServiceImpl::SetConnectionLimit(uint32_t max_pending_requests, uint32_t max_write_queue_bytes)
+{
+    max_pending_requests_ = max_pending_requests;
+    max_write_queue_bytes_ = max_write_queue_bytes;
+}
+
+void NetworkServiceImpl::SetConnectionTimeout(uint32_t max_connections, uint32_t read_timeout, uint32_t idle_timeout)
+{
+    max_connections_ = max_connections;
+    read_timeout_ = read_timeout;
+    idle_timeout_ = idle_timeout;
+}
+
+int NetworkServiceImpl::BindTcpAddr(const std::string& host, uint32_t port, uint32_t backlog)
+{
+    struct sockaddr_storage addr;
+    if (uv_ip4_addr(host.c_str(), port, (struct sockaddr_in*)&addr) != 0
+            && uv_ip6_addr(host.c_str(), port, (struct sockaddr_in6*)&addr) != 0)
+    {
+        MRPC_LOG_ERROR("Invalid server address {}:{}", host, port);
+        return ERROR_INITIALIZATION_FAILED;
+    }
+
+    host_ = host;
+    port_ = port;
+    for (uint32_t i = 0; i < io_thread_num_; ++i)
+    {
+        NetworkServiceLoop* loop = new NetworkServiceLoop(*this, i);
+        loops_.emplace_back(loop);
+
+        int ret = loop->BindTcpAddr((const struct sockaddr*)&addr, backlog, io_thread_num_ > 1);
+        if (ret != 0)
+        {
+            return ret;
+        }
+    }
+
+    MRPC_LOG_INFO("Server listen on address {}:{} success, io thread num {}...", host_, port_, io_thread_num_);
+    return 0;
+}
+
+int NetworkServiceImpl::BindUdpAddr(const std::string& host, uint32_t port)
+{
+    struct sockaddr_storage addr;
+    if (uv_ip4_addr(host.c_str(), port, (struct sockaddr_in*)&addr) != 0
+            && uv_ip6_addr(host.c_str(), port, (struct sockaddr_in6*)&addr) != 0)
+    {
+        MRPC_LOG_ERROR("Invalid server address {}:{}", host, port);
+        return ERROR_INITIALIZATION_FAILED;
+    }
+
+    host_ = host;
+    port_ = port;
+    for (uint32_t i = 0; i < io_thread_num_; ++i)
+    {
+        NetworkServiceLoop* loop = new NetworkServiceLoop(*this, i);
+        loops_.emplace_back(loop);
+
+        int ret = loop->BindUdpAddr((const struct sockaddr*)&addr, io_thread_num_ > 1);
+        if (ret != 0)
+        {
+            return ret;
+        }
+    }
+
+    MRPC_LOG_INFO("Server receive on udp address {}:{} success, io thread num {}...", host_, port_, io_thread_num_);
+    return 0;
+}
+
+int NetworkServiceImpl::BindPipe(const std::string& path, uint32_t backlog)
+{
+    if (path.empty())
+    {
+        MRPC_LOG_ERROR("Pipe path is empty");
+        return ERROR_INITIALIZATION_FAILED;
+    }
+
+    host_ = path;
+    port_ = 0;
+    for (uint32_t i = 0; i < io_thread_num_; ++i)
+    {
+        NetworkServiceLoop* loop = new NetworkServiceLoop(*this, i);
+        loops_.emplace_back(loop);
+
+        int ret = loop->BindPipe(path, backlog, i == 0 ? -1 : loops_[0]->GetServerFd());
+        if (ret != 0)
+        {
+            return ret;
+        }
+    }
+
+    MRPC_LOG_INFO("Server listen on pipe {} success, io thread num {}...", host_, io_thread_num_);
+    return 0;
+}
+
+int NetworkServiceImpl::BindShm(const std::string& path, uint32_t backlog, uint32_t ring_size)
+{
+    // 用Unix domain socket建立连接和检测断开, 数据走共享内存
+    shm_ring_size_ = std::max<uint32_t>(ring_size, 1);
+    return BindPipe(path, backlog);
+}
+
+void NetworkServiceImpl::Start(uint32_t io_index)
+{
+    assert(io_index < loops_.size());
+    loops_[io_index]->Start();
+}
+
+void NetworkServiceImpl::Stop()
+{
+    for (auto& loop : loops_)
+    {
+        loop->Stop();
+    }
+}
+
+void NetworkServiceImpl::SendResponse(const std::shared_ptr<ServiceContext>& context)
+{
+    // 回包必须由接收请求的IO线程发送
+    assert(context->io_index < loops_.size());
+    loops_[context->io_index]->SendResponse(context);
+}
+
+NetworkService::NetworkService() : impl_(new NetworkServiceImpl()), uring_(new NetworkServiceUring())
 {
 }
 
 NetworkService::~NetworkService()
 {
+    delete uring_;
     delete impl_;
 }
 
 void NetworkService::SetBridge(ServiceBridge* bridge)
 {
     impl_->SetBridge(bridge);
+    uring_->SetBridge(bridge);
 }
 
 void NetworkService::SetAllProtocol(const std::vector<Protocol>& all_protocol)
 {
     impl_->SetAllProtocol(all_protocol);
+    uring_->SetAllProtocol(all_protocol);
+}
+
+void NetworkService::SetIoThreadNum(uint32_t io_thread_num)
+{
+    impl_->SetIoThreadNum(io_thread_num);
+    uring_->SetIoThreadNum(io_thread_num);
+}
+
+void NetworkService::SetConnectionLimit(uint32_t max_pending_requests, uint32_t max_write_queue_bytes)
+{
+    impl_->SetConnectionLimit(max_pending_requests, max_write_queue_bytes);
+    uring_->SetConnectionLimit(max_pending_requests, max_write_queue_bytes);
 }
 
 int NetworkService::Bind(const NetworkConfig& config)
 {
+    impl_->SetConnectionTimeout(config.max_connections, config.timeout, config.idle_timeout);
+    uring_->SetConnectionTimeout(config.max_connections, config.timeout, config.idle_timeout);
+
+    if (config.io_backend == io_uring)
+    {
+        if (config.protocol != tcp)
+        {
+            MRPC_LOG_WARN("io_uring backend only supports tcp, use libuv for protocol {}", NetworkProtocolConfig_Name(config.protocol));
+        }
+        else if (!IoUring::IsSupported())
+        {
+            MRPC_LOG_WARN("io_uring is not supported by the kernel, use libuv");
+        }
+        else
+        {
+            use_uring_ = true;
+            return uring_->BindTcpAddr(config.host, config.port, config.tcp_backlog);
+        }
+    }
+
     switch (config.protocol)
     {
         case tcp:
             return impl_->BindTcpAddr(config.host, config.port, config.tcp_backlog);
             break;
+        case udp:
+            return impl_->BindUdpAddr(config.host, config.port);
+            break;
+        case pipe:
+            return impl_->BindPipe(config.path, config.tcp_backlog);
+            break;
+        case shm:
+            return impl_->BindShm(config.path, config.tcp_backlog, config.shm_ring_size);
+            break;
         default:
             break;
     }
@@ -424,19 +1460,40 @@ int NetworkService::Bind(const NetworkConfig& config)
     return ERROR_INITIALIZATION_FAILED;
 }
 
-void NetworkService::Start()
+void NetworkService::Start(uint32_t io_index)
 {
-    impl_->Start();
+    if (use_uring_)
+    {
+        uring_->Start(io_index);
+    }
+    else
+    {
+        impl_->Start(io_index);
+    }
 }
 
 void NetworkService::Stop()
 {
-    impl_->Stop();
+    if (use_uring_)
+    {
+        uring_->Stop();
+    }
+    else
+    {
+        impl_->Stop();
+    }
 }
 
 void NetworkService::SendResponse(const std::shared_ptr<ServiceContext>& context)
 {
-    impl_->SendResponse(context);
+    if (use_uring_)
+    {
+        uring_->SendResponse(context);
+    }
+    else
+    {
+        impl_->SendResponse(context);
+    }
 }
 
 }
@@ -13,6 +13,7 @@ namespace mrpc
 class NetworkConfig;
 class ServiceBridge;
 class NetworkServiceImpl;
+class NetworkServiceUring;
 
 class NetworkService : private NonCopyable
 {
@@ -22,16 +23,23 @@ public:
 
     void SetBridge(ServiceBridge* bridge);
     void SetAllProtocol(const std::vector<Protocol>& all_protocol);
+    // 必须在Bind之前调用, 大于1时每个IO线程通过SO_REUSEPORT各自监听同一地址.
+    void SetIoThreadNum(uint32_t io_thread_num);
+    // 连接上未回包的请求数或待发送的字节数达到上限时暂停读取该连接, 降到一半以下时恢复. 0表示不限制.
+    void SetConnectionLimit(uint32_t max_pending_requests, uint32_t max_write_queue_bytes);
 
     int Bind(const NetworkConfig& config);
 
-    void Start();
+    // 运行第io_index个IO线程的事件循环, 阻塞直到Stop.
+    void Start(uint32_t io_index);
     void Stop();
 
     void SendResponse(const std::shared_ptr<ServiceContext>& context);
 
 private:
     NetworkServiceImpl* impl_;
+    NetworkServiceUring* uring_;
+    bool use_uring_ = false;    // Bind时根据io_backend选择
 };
 
 }
@@ -0,0 +1,969 @@
+#include <algorithm>
+#include <arpa/inet.h>
+#include <cassert>
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <linux/io_uring.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <unordered_map>
+#include <unistd.h>
+
+#include <mrpc/error_code.mrpc.h>
+#include <mrpc/service/network_service_uring.h>
+#include <mrpc/service/service_bridge.h>
+#include <mrpc/service/service_metrics.h>
+#include <mrpc/util/input_buffer.h>
+#include <mrpc/util/io_uring.h>
+#include <mrpc/util/log.h>
+#include <mrpc/util/mpsc_queue.h>
+#include <mrpc/util/sendmsg_buffer.h>
+#include <mrpc/util/timer_wheel.h>
+
+namespace mrpc
+{
+
+static constexpr uint32_t kUringEntries = 1024;
+static constexpr uint16_t kRecvBufferGroup = 0;
+static constexpr uint32_t kRecvBufferNum = 128;
+static constexpr uint32_t kRecvBufferSize = 64 * 1024;     // 与BufferPool的默认块大小一致
+static constexpr uint32_t kMaxCqeBatch = 256;
+
+// user_data的高8位为操作类型, 低56位为连接id
+enum UringOp : uint64_t
+{
+    kOpAccept = 1,
+    kOpRecv = 2,
+    kOpSend = 3,
+    kOpWakeup = 4,
+    kOpCancel = 5,
+};
+
+static constexpr uint64_t kOpShift = 56;
+static constexpr uint64_t kConnIdMask = (1ULL << kOpShift) - 1;
+
+static inline uint64_t MakeUserData(UringOp op, uint64_t conn_id)
+{
+    return ((uint64_t)op << kOpShift) | (conn_id & kConnIdMask);
+}
+
+// 与uv_now一样取单调时钟的毫秒数
+static uint64_t GetMonotonicTime()
+{
+    auto now = std::chrono::steady_clock::now().time_since_epoch();
+    return std::chrono::duration_cast<std::chrono::milliseconds>(now).count();
+}
+
+static void GetPeerAddrName(int fd, std::string& host, uint32_t& port)
+{
+    struct sockaddr_storage addr;
+    socklen_t addr_len = sizeof(addr);
+    if (getpeername(fd, (struct sockaddr*)&addr, &addr_len) != 0)
+    {
+        return;
+    }
+
+    char ip[INET6_ADDRSTRLEN] = { 0 };
+    if (addr.ss_family == AF_INET)
+    {
+        const struct sockaddr_in* addr_v4 = (const struct sockaddr_in*)&addr;
+        inet_ntop(AF_INET, &addr_v4->sin_addr, ip, sizeof(ip));
+        port = ntohs(addr_v4->sin_port);
+    }
+    else if (addr.ss_family == AF_INET6)
+    {
+        const struct sockaddr_in6* addr_v6 = (const struct sockaddr_in6*)&addr;
+        inet_ntop(AF_INET6, &addr_v6->sin6_addr, ip, sizeof(ip));
+        port = ntohs(addr_v6->sin6_port);
+    }
+    host = ip;
+}
+
+struct NetworkServiceUringConnection
+{
+    uint64_t conn_id = 0;
+    int fd = -1;
+    std::string host;
+    uint32_t port = 0;
+    Protocol protocol;
+    bool close = false;
+    bool close_after_send = false;          // 回包发送完之后关闭
+    InputBuffer buffer;
+    SendmsgBuffer write_buffer;     // 待发送和正在发送的回包
+
+    // 提交给内核但还没有最终完成的recv和sendmsg, 为0之后才能释放连接
+    uint32_t pending_ops = 0;
+    bool recv_armed = false;
+    bool recv_canceling = false;
+
+    // 背压
+    uint32_t pending_requests = 0;
+    size_t pending_write_bytes = 0;
+    bool read_paused = false;
+
+    // 超时
+    uint64_t last_active_time = 0;
+    uint64_t read_start_time = 0;
+};
+
+// 一个IO线程对应一个NetworkServiceUringLoop, 各自拥有独立的io_uring、监听socket和连接.
+class NetworkServiceUringLoop
+{
+public:
+    NetworkServiceUringLoop(NetworkServiceUring& service, uint32_t index);
+    ~NetworkServiceUringLoop();
+
+    int BindTcpAddr(const struct sockaddr* addr, socklen_t addr_len, uint32_t backlog, bool reuse_port);
+
+    void Start();
+    void Stop();
+
+    void SendResponse(const std::shared_ptr<ServiceContext>& context);
+
+private:
+    void ArmAccept();
+    void ArmRecv(NetworkServiceUringConnection* conn);
+    void ArmWakeup();
+    void CancelRecv(NetworkServiceUringConnection* conn);
+
+    void HandleCqe(const struct io_uring_cqe* cqe);
+    void OnAccept(int res, bool more);
+    void OnRecv(NetworkServiceUringConnection* conn, int res, uint32_t flags);
+    void OnSend(NetworkServiceUringConnection* conn, int res);
+    void OnWakeup();
+
+    void Close(NetworkServiceUringConnection* conn);
+    void FinishClose();
+    void ParseRequests(NetworkServiceUringConnection* conn, const char*& begin, const char* end);
+    void DispatchMessage(NetworkServiceUringConnection* conn, const std::shared_ptr<ServiceContext>& context);
+    void OnReceived(NetworkServiceUringConnection* conn, bool parsed);
+    void QueueWrite(NetworkServiceUringConnection* conn, std::string&& data);
+    void FlushWrite(NetworkServiceUringConnection* conn);
+    void SubmitSend(NetworkServiceUringConnection* conn);
+    void FlushAllWrites();
+    void WriteDone(NetworkServiceUringConnection* conn, size_t size);
+    void UpdateReading(NetworkServiceUringConnection* conn);
+    bool HasTimeout() const;
+    uint64_t GetExpireTime(NetworkServiceUringConnection* conn, uint64_t now, bool& idle) const;
+    void CheckTimeout(uint64_t now);
+
+    NetworkServiceUring& service_;
+    uint32_t index_ = 0;
+    std::atomic<bool> running_ = false;
+    std::unordered_map<uint64_t, std::unique_ptr<NetworkServiceUringConnection>> id2conn_;
+    MpscQueue<std::shared_ptr<ServiceContext>> queue_;      // worker线程提交的回包
+    std::vector<NetworkServiceUringConnection*> write_conns_;   // write_buffer非空的连接
+    std::vector<NetworkServiceUringConnection*> close_conns_;   // 等待未完成的操作结束后释放
+    ServiceMetrics& metrics_;
+    TimerWheel timer_wheel_;
+    std::vector<uint64_t> expired_conn_ids_;
+
+    int server_fd_ = -1;
+    bool accept_armed_ = false;
+
+    // worker线程在回包队列从空变为非空时写eventfd唤醒IO线程
+    int wakeup_fd_ = -1;
+    uint64_t wakeup_value_ = 0;
+
+    // 最后声明, 最先析构, 先取消内核中引用连接内存的操作
+    IoUring ring_;
+};
+
+NetworkServiceUringLoop::NetworkServiceUringLoop(NetworkServiceUring& service, uint32_t index) :
+    service_(service),
+    index_(index),
+    metrics_(service.bridge_->GetMetrics()),
+    timer_wheel_(0)
+{
+}
+
+NetworkServiceUringLoop::~NetworkServiceUringLoop()
+{
+    for (auto& it : id2conn_)
+    {
+        close(it.second->fd);
+    }
+    if (server_fd_ >= 0) close(server_fd_);
+    if (wakeup_fd_ >= 0) close(wakeup_fd_);
+}
+
+int NetworkServiceUringLoop::BindTcpAddr(const struct sockaddr* addr, socklen_t addr_len, uint32_t backlog, bool reuse_port)
+{
+    int ret = ring_.Initialize(kUringEntries);
+    if (ret == 0)
+    {
+        ret = ring_.RegisterBufferRing(kRecvBufferGroup, kRecvBufferNum, kRecvBufferSize);
+    }
+    if (ret != 0)
+    {
+        MRPC_LOG_ERROR("Initialize io_uring error, {}", strerror(-ret));
+        return ERROR_INITIALIZATION_FAILED;
+    }
+
+    wakeup_fd_ = eventfd(0, EFD_CLOEXEC);
+    if (wakeup_fd_ < 0)
+    {
+        MRPC_LOG_ERROR("Create eventfd error, {}", strerror(errno));
+        return ERROR_INITIALIZATION_FAILED;
+    }
+
+    // 每个IO线程各自监听同一地址, 由内核把新连接分配到各个线程
+    int on = 1;
+    server_fd_ = socket(addr->sa_family, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (server_fd_ < 0
+            || setsockopt(server_fd_, SOL_SOCKET, SO_REUSEADDR, &on, sizeof(on)) != 0
+            || (reuse_port && setsockopt(server_fd_, SOL_SOCKET, SO_REUSEPORT, &on, sizeof(on)) != 0)
+            || setsockopt(server_fd_, IPPROTO_TCP, TCP_NODELAY, &on, sizeof(on)) != 0
+            || bind(server_fd_, addr, addr_len) != 0
+            || listen(server_fd_, backlog) != 0)
+    {
+        MRPC_LOG_ERROR("Server listen on address {}:{} error, {}", service_.host_, service_.port_, strerror(errno));
+        return ERROR_INITIALIZATION_FAILED;
+    }
+
+    return 0;
+}
+
+void NetworkServiceUringLoop::ArmAccept()
+{
+    struct io_uring_sqe* sqe = ring_.GetSqe();
+    if (sqe == nullptr) return;
+
+    sqe->opcode = IORING_OP_ACCEPT;
+    sqe->fd = server_fd_;
+    sqe->ioprio = IORING_ACCEPT_MULTISHOT;
+    sqe->accept_flags = SOCK_CLOEXEC;
+    sqe->user_data = MakeUserData(kOpAccept, 0);
+    accept_armed_ = true;
+}
+
+void NetworkServiceUringLoop::ArmRecv(NetworkServiceUringConnection* conn)
+{
+    struct io_uring_sqe* sqe = ring_.GetSqe();
+    if (sqe == nullptr)
+    {
+        MRPC_LOG_ERROR("Submission queue is full, conn id {}", conn->conn_id);
+        Close(conn);
+        return;
+    }
+
+    // len为0, 每次由内核从buffer ring中取一个缓冲区
+    sqe->opcode = IORING_OP_RECV;
+    sqe->fd = conn->fd;
+    sqe->ioprio = IORING_RECV_MULTISHOT;
+    sqe->flags = IOSQE_BUFFER_SELECT;
+    sqe->buf_group = ring_.GetBufferGroupId();
+    sqe->user_data = MakeUserData(kOpRecv, conn->conn_id);
+    conn->recv_armed = true;
+    ++conn->pending_ops;
+}
+
+void NetworkServiceUringLoop::ArmWakeup()
+{
+    struct io_uring_sqe* sqe = ring_.GetSqe();
+    assert(sqe != nullptr);
+    sqe->opcode = IORING_OP_READ;
+    sqe->fd = wakeup_fd_;
+    sqe->addr = (uint64_t)(uintptr_t)&wakeup_value_;
+    sqe->len = sizeof(wakeup_value_);
+    sqe->user_data = MakeUserData(kOpWakeup, 0);
+}
+
+void NetworkServiceUringLoop::CancelRecv(NetworkServiceUringConnection* conn)
+{
+    if (!conn->recv_armed || conn->recv_canceling) return;
+
+    struct io_uring_sqe* sqe = ring_.GetSqe();
+    if (sqe == nullptr) return;
+
+    sqe->opcode = IORING_OP_ASYNC_CANCEL;
+    sqe->fd = -1;
+    sqe->addr = MakeUserData(kOpRecv, conn->conn_id);
+    sqe->user_data = MakeUserData(kOpCancel, conn->conn_id);
+    conn->recv_canceling = true;
+}
+
+void NetworkServiceUringLoop::HandleCqe(const struct io_uring_cqe* cqe)
+{
+    UringOp op = (UringOp)(cqe->user_data >> kOpShift);
+    uint64_t conn_id = cqe->user_data & kConnIdMask;
+    switch (op)
+    {
+        case kOpAccept:
+            OnAccept(cqe->res, (cqe->flags & IORING_CQE_F_MORE) != 0);
+            return;
+        case kOpWakeup:
+            OnWakeup();
+            return;
+        case kOpCancel:
+            return;
+        default:
+            break;
+    }
+
+    auto it = id2conn_.find(conn_id);
+    assert(it != id2conn_.end());
+    NetworkServiceUringConnection* conn = it->second.get();
+    if (op == kOpRecv)
+    {
+        OnRecv(conn, cqe->res, cqe->flags);
+    }
+    else if (op == kOpSend)
+    {
+        OnSend(conn, cqe->res);
+    }
+}
+
+void NetworkServiceUringLoop::OnAccept(int res, bool more)
+{
+    if (!more)
+    {
+        accept_armed_ = false;
+    }
+    if (res < 0)
+    {
+        MRPC_LOG_DEBUG("New connection error, {}", strerror(-res));
+        return;
+    }
+
+    NetworkServiceUringConnection* conn = new NetworkServiceUringConnection();
+    conn->fd = res;
+    GetPeerAddrName(conn->fd, conn->host, conn->port);
+
+    uint32_t conn_num = ++service_.conn_num_;
+    if (service_.max_connections_ > 0 && conn_num > service_.max_connections_)
+    {
+        --service_.conn_num_;
+        ++metrics_.rejected_connections;
+        MRPC_LOG_DEBUG("Too many connections, reject peer addr {}:{}, max connections {}", conn->host, conn->port, service_.max_connections_);
+        close(conn->fd);
+        delete conn;
+        return;
+    }
+    ++metrics_.connections;
+
+    int on = 1;
+    setsockopt(conn->fd, IPPROTO_TCP, TCP_NODELAY, &on, sizeof(on));
+
+    conn->conn_id = ++NetworkServiceUring::next_conn_id_;
+    if (service_.all_protocol_.size() == 1)
+    {
+        conn->protocol = service_.all_protocol_[0];
+    }
+    id2conn_.emplace(conn->conn_id, conn);
+
+    MRPC_LOG_DEBUG("Accept new connection, conn id {}, io thread {}, self addr {}:{}, peer addr {}:{}", conn->conn_id, index_, service_.host_, service_.port_, conn->host, conn->port);
+
+    if (HasTimeout())
+    {
+        uint64_t now = GetMonotonicTime();
+        bool idle = false;
+        conn->last_active_time = now;
+        timer_wheel_.Add(conn->conn_id, GetExpireTime(conn, now, idle));
+    }
+
+    ArmRecv(conn);
+}
+
+void NetworkServiceUringLoop::OnRecv(NetworkServiceUringConnection* conn, int res, uint32_t flags)
+{
+    bool more = (flags & IORING_CQE_F_MORE) != 0;
+    if (res > 0)
+    {
+        assert(flags & IORING_CQE_F_BUFFER);
+        uint16_t buffer_id = flags >> IORING_CQE_BUFFER_SHIFT;
+        const char* data = ring_.GetBuffer(buffer_id);
+        MRPC_LOG_TRACE("Received {} bytes", res);
+
+        // 连接关闭或取消之前已经收到的数据照常处理
+        if (!conn->close)
+        {
+            bool parsed = false;
+            if (conn->buffer.Empty())
+            {
+                // 直接在provided buffer上解析, 只保存不完整的尾部
+                const char* begin = data;
+                const char* end = data + res;
+                ParseRequests(conn, begin, end);
+                parsed = begin != data;
+                if (begin < end && !conn->close)
+                {
+                    conn->buffer.Append(begin, end - begin);
+                }
+            }
+            else
+            {
+                conn->buffer.Append(data, res);
+                const char* begin = conn->buffer.GetReadPtr();
+                const char* end = begin + conn->buffer.GetReadableSize();
+                ParseRequests(conn, begin, end);
+                parsed = begin != conn->buffer.GetReadPtr();
+                conn->buffer.Consume(begin - conn->buffer.GetReadPtr());
+            }
+
+            if (!conn->close)
+            {
+                OnReceived(conn, parsed);
+            }
+        }
+        ring_.RecycleBuffer(buffer_id);
+    }
+    else if (res == 0)
+    {
+        Close(conn);
+    }
+    else if (res != -ENOBUFS && res != -ECANCELED)
+    {
+        MRPC_LOG_DEBUG("Read error, conn id {}, {}", conn->conn_id, strerror(-res));
+        Close(conn);
+    }
+
+    if (more) return;
+
+    // multishot recv结束: 被取消, 缓冲区用完(-ENOBUFS)或者内核要求重新提交
+    conn->recv_armed = false;
+    conn->recv_canceling = false;
+    --conn->pending_ops;
+    if (!conn->close && !conn->read_paused)
+    {
+        if (res == -ENOBUFS)
+        {
+            MRPC_LOG_DEBUG("Recv buffer ring is exhausted, conn id {}", conn->conn_id);
+        }
+        ArmRecv(conn);
+    }
+}
+
+void NetworkServiceUringLoop::OnSend(NetworkServiceUringConnection* conn, int res)
+{
+    --conn->pending_ops;
+    if (conn->close) return;
+
+    if (res < 0)
+    {
+        MRPC_LOG_DEBUG("Write error, conn id {}, {}", conn->conn_id, strerror(-res));
+        WriteDone(conn, conn->pending_write_bytes);
+        conn->write_buffer.Clear();
+        Close(conn);
+        return;
+    }
+
+    // 部分发送时从未发送的位置继续
+    size_t written = res;
+    WriteDone(conn, written);
+    if (conn->write_buffer.Advance(written))
+    {
+        SubmitSend(conn);
+        return;
+    }
+
+    FlushWrite(conn);
+    if (conn->close_after_send && !conn->write_buffer.IsSending())
+    {
+        Close(conn);
+        return;
+    }
+    UpdateReading(conn);
+}
+
+void NetworkServiceUringLoop::OnWakeup()
+{
+    if (running_)
+    {
+        ArmWakeup();
+    }
+
+    std::shared_ptr<ServiceContext> context;
+    while (queue_.TryPop(context))
+    {
+        NetworkServiceUringConnection* conn = nullptr;
+        auto it = id2conn_.find(context->conn_id);
+        if (it != id2conn_.end())
+        {
+            conn = it->second.get();
+        }
+        if (conn == nullptr || conn->close)
+        {
+            MRPC_LOG_DEBUG("Discard response, conn id {}, data length {}", context->conn_id, context->response.length());
+            continue;
+        }
+
+        assert(conn->pending_requests > 0);
+        --conn->pending_requests;
+        --metrics_.pending_requests;
+
+        if (!context->response.empty())
+        {
+            MRPC_LOG_TRACE("Send response, conn id {}, data length {}", context->conn_id, context->response.length());
+            QueueWrite(conn, std::move(context->response));
+        }
+
+        if (context->close_connection)
+        {
+            // shutdown会中断正在发送的sendmsg, 等回包都发送完再关闭
+            FlushWrite(conn);
+            if (!conn->write_buffer.IsSending())
+            {
+                Close(conn);
+            }
+            else
+            {
+                conn->close_after_send = true;
+                CancelRecv(conn);
+                conn->read_paused = true;
+            }
+        }
+        else if (!conn->write_buffer.HasPending())
+        {
+            UpdateReading(conn);
+        }
+
+        context.reset();
+    }
+}
+
+void NetworkServiceUringLoop::Close(NetworkServiceUringConnection* conn)
+{
+    if (conn->close) return;
+
+    // shutdown使未完成的recv和sendmsg尽快结束, 都结束之后在FinishClose中释放
+    conn->close = true;
+    shutdown(conn->fd, SHUT_RDWR);
+    CancelRecv(conn);
+    close_conns_.push_back(conn);
+}
+
+void NetworkServiceUringLoop::FinishClose()
+{
+    size_t remain = 0;
+    for (NetworkServiceUringConnection* conn : close_conns_)
+    {
+        if (conn->pending_ops > 0)
+        {
+            close_conns_[remain++] = conn;
+            continue;
+        }
+
+        MRPC_LOG_DEBUG("Close connection, conn id {}, self addr {}:{}, peer addr {}:{}", conn->conn_id, service_.host_, service_.port_, conn->host, conn->port);
+        metrics_.pending_requests -= conn->pending_requests;
+        metrics_.pending_write_bytes -= conn->pending_write_bytes;
+        --metrics_.connections;
+        --service_.conn_num_;
+        close(conn->fd);
+        id2conn_.erase(conn->conn_id);
+    }
+    close_conns_.resize(remain);
+}
+
+void NetworkServiceUringLoop::DispatchMessage(NetworkServiceUringConnection* conn, const std::shared_ptr<ServiceContext>& context)
+{
+    context->conn_id = conn->conn_id;
+    context->io_index = index_;
+    context->host = conn->host;
+    context->port = conn->port;
+    context->protocol = conn->protocol;
+    if (service_.bridge_->DispatchMessage(context))
+    {
+        ++conn->pending_requests;
+        ++metrics_.pending_requests;
+    }
+    else if (!context->response.empty())
+    {
+        QueueWrite(conn, std::move(context->response));
+    }
+}
+
+void NetworkServiceUringLoop::ParseRequests(NetworkServiceUringConnection* conn, const char*& begin, const char* end)
+{
+    if (conn->protocol.parse == nullptr)
+    {
+        bool has_error = false;
+        std::shared_ptr<ServiceContext> context;
+        for (const auto& protocol : service_.all_protocol_)
+        {
+            if (protocol.parse(begin, end - begin, false, has_error, context))
+            {
+                conn->protocol = protocol;
+                DispatchMessage(conn, context);
+                break;
+            }
+            else if (has_error)
+            {
+                Close(conn);
+                return;
+            }
+        }
+    }
+
+    if (conn->protocol.parse != nullptr)
+    {
+        while (begin < end)
+        {
+            bool has_error = false;
+            std::shared_ptr<ServiceContext> context;
+            if (conn->protocol.parse(begin, end - begin, true, has_error, context))
+            {
+                DispatchMessage(conn, context);
+            }
+            else if (has_error)
+            {
+                Close(conn);
+                return;
+            }
+            else
+            {
+                return;
+            }
+        }
+    }
+}
+
+void NetworkServiceUringLoop::OnReceived(NetworkServiceUringConnection* conn, bool parsed)
+{
+    uint64_t now = GetMonotonicTime();
+    conn->last_active_time = now;
+    if (conn->buffer.Empty())
+    {
+        conn->read_start_time = 0;
+    }
+    else if (parsed || conn->read_start_time == 0)
+    {
+        conn->read_start_time = now;
+    }
+
+    ReserveFrame(conn->protocol, conn->buffer);
+    UpdateReading(conn);
+}
+
+void NetworkServiceUringLoop::QueueWrite(NetworkServiceUringConnection* conn, std::string&& data)
+{
+    if (!conn->write_buffer.HasPending())
+    {
+        write_conns_.push_back(conn);
+    }
+    conn->pending_write_bytes += data.length();
+    metrics_.pending_write_bytes += data.length();
+    conn->write_buffer.Append(std::move(data));
+}
+
+void NetworkServiceUringLoop::FlushAllWrites()
+{
+    // 同一连接的回包合并为一个sendmsg, 所有连接的sendmsg在下一次Submit时一起提交
+    for (NetworkServiceUringConnection* conn : write_conns_)
+    {
+        if (!conn->close)
+        {
+            FlushWrite(conn);
+            UpdateReading(conn);
+        }
+    }
+    write_conns_.clear();
+}
+
+void NetworkServiceUringLoop::FlushWrite(NetworkServiceUringConnection* conn)
+{
+    // 上一个sendmsg完成之后再发送, 保证回包顺序
+    if (conn->write_buffer.Prepare())
+    {
+        SubmitSend(conn);
+    }
+}
+
+void NetworkServiceUringLoop::SubmitSend(NetworkServiceUringConnection* conn)
+{
+    struct io_uring_sqe* sqe = ring_.GetSqe();
+    if (sqe == nullptr)
+    {
+        MRPC_LOG_ERROR("Submission queue is full, conn id {}", conn->conn_id);
+        Close(conn);
+        return;
+    }
+
+    sqe->opcode = IORING_OP_SENDMSG;
+    sqe->fd = conn->fd;
+    sqe->addr = (uint64_t)(uintptr_t)conn->write_buffer.GetMsg();
+    sqe->len = 1;
+    sqe->msg_flags = MSG_NOSIGNAL;
+    sqe->user_data = MakeUserData(kOpSend, conn->conn_id);
+    ++conn->pending_ops;
+}
+
+void NetworkServiceUringLoop::WriteDone(NetworkServiceUringConnection* conn, size_t size)
+{
+    assert(conn->pending_write_bytes >= size);
+    conn->pending_write_bytes -= size;
+    metrics_.pending_write_bytes -= size;
+}
+
+void NetworkServiceUringLoop::UpdateReading(NetworkServiceUringConnection* conn)
+{
+    if (conn->close) return;
+
+    uint32_t max_pending_requests = service_.max_pending_requests_;
+    uint32_t max_write_queue_bytes = service_.max_write_queue_bytes_;
+    bool request_overflow = max_pending_requests > 0 && conn->pending_requests >= max_pending_requests;
+    bool write_overflow = max_write_queue_bytes > 0 && conn->pending_write_bytes >= max_write_queue_bytes;
+    if (!conn->read_paused)
+    {
+        if (request_overflow || write_overflow)
+        {
+            MRPC_LOG_DEBUG("Pause reading, conn id {}, pending requests {}, pending write bytes {}", conn->conn_id, conn->pending_requests, conn->pending_write_bytes);
+            // 取消multishot recv, 取消完成之前收到的数据照常处理
+            CancelRecv(conn);
+            conn->read_paused = true;
+            ++metrics_.read_pauses;
+            if (write_overflow)
+            {
+                ++metrics_.write_queue_overflows;
+            }
+        }
+    }
+    else if ((max_pending_requests == 0 || conn->pending_requests <= max_pending_requests / 2)
+            && (max_write_queue_bytes == 0 || conn->pending_write_bytes <= max_write_queue_bytes / 2))
+    {
+        MRPC_LOG_DEBUG("Resume reading, conn id {}, pending requests {}, pending write bytes {}", conn->conn_id, conn->pending_requests, conn->pending_write_bytes);
+        conn->read_paused = false;
+        // 取消还没完成时在OnRecv中重新提交
+        if (!conn->recv_armed)
+        {
+            ArmRecv(conn);
+        }
+        if (!conn->buffer.Empty())
+        {
+            conn->read_start_time = GetMonotonicTime();
+        }
+    }
+}
+
+bool NetworkServiceUringLoop::HasTimeout() const
+{
+    return service_.read_timeout_ > 0 || service_.idle_timeout_ > 0;
+}
+
+uint64_t NetworkServiceUringLoop::GetExpireTime(NetworkServiceUringConnection* conn, uint64_t now, bool& idle) const
+{
+    uint32_t read_timeout = service_.read_timeout_;
+    uint32_t idle_timeout = service_.idle_timeout_;
+
+    uint32_t check_interval = read_timeout == 0 ? idle_timeout : (idle_timeout == 0 ? read_timeout : std::min(read_timeout, idle_timeout));
+    uint64_t expire_time = now + check_interval;
+    if (read_timeout > 0 && !conn->read_paused && conn->read_start_time > 0)
+    {
+        expire_time = std::min(expire_time, conn->read_start_time + read_timeout);
+    }
+    if (idle_timeout > 0 && conn->pending_requests == 0 && conn->pending_write_bytes == 0
+            && conn->last_active_time + idle_timeout <= expire_time)
+    {
+        expire_time = conn->last_active_time + idle_timeout;
+        idle = true;
+    }
+    return expire_time;
+}
+
+void NetworkServiceUringLoop::CheckTimeout(uint64_t now)
+{
+    expired_conn_ids_.clear();
+    timer_wheel_.Advance(now, expired_conn_ids_);
+    for (uint64_t conn_id : expired_conn_ids_)
+    {
+        auto it = id2conn_.find(conn_id);
+        if (it == id2conn_.end() || it->second->close)
+        {
+            continue;
+        }
+
+        NetworkServiceUringConnection* conn = it->second.get();
+        bool idle = false;
+        uint64_t expire_time = GetExpireTime(conn, now, idle);
+        if (expire_time > now)
+        {
+            timer_wheel_.Add(conn_id, expire_time);
+            continue;
+        }
+
+        if (idle)
+        {
+            ++metrics_.idle_timeouts;
+            MRPC_LOG_DEBUG("Idle timeout, conn id {}, peer addr {}:{}", conn->conn_id, conn->host, conn->port);
+        }
+        else
+        {
+            ++metrics_.read_timeouts;
+            MRPC_LOG_DEBUG("Read timeout, conn id {}, peer addr {}:{}, buffered {} bytes", conn->conn_id, conn->host, conn->port, conn->buffer.GetReadableSize());
+        }
+        Close(conn);
+    }
+}
+
+void NetworkServiceUringLoop::Start()
+{
+    running_ = true;
+    ArmAccept();
+    ArmWakeup();
+
+    int64_t timeout = HasTimeout() ? (int64_t)timer_wheel_.GetTick() : -1;
+    uint64_t next_check_time = GetMonotonicTime() + timer_wheel_.GetTick();
+    struct io_uring_cqe* cqes[kMaxCqeBatch];
+    while (running_)
+    {
+        int ret = ring_.Submit(1, timeout);
+        if (ret < 0 && ret != -ETIME && ret != -EINTR && ret != -EBUSY)
+        {
+            MRPC_LOG_ERROR("Submit io_uring error, {}", strerror(-ret));
+            break;
+        }
+
+        uint32_t num = 0;
+        while ((num = ring_.PeekCqes(cqes, kMaxCqeBatch)) > 0)
+        {
+            for (uint32_t i = 0; i < num; ++i)
+            {
+                HandleCqe(cqes[i]);
+            }
+            ring_.AdvanceCq(num);
+        }
+
+        // 积压太多连接时accept可能结束, 重新提交
+        if (!accept_armed_)
+        {
+            ArmAccept();
+        }
+        FlushAllWrites();
+        if (timeout >= 0)
+        {
+            uint64_t now = GetMonotonicTime();
+            if (now >= next_check_time)
+            {
+                CheckTimeout(now);
+                next_check_time = now + timer_wheel_.GetTick();
+            }
+        }
+        FinishClose();
+    }
+}
+
+void NetworkServiceUringLoop::Stop()
+{
+    running_ = false;
+    uint64_t value = 1;
+    ssize_t ret = write(wakeup_fd_, &value, sizeof(value));
+    assert(ret == sizeof(value));
+    (void)ret;
+}
+
+void NetworkServiceUringLoop::SendResponse(const std::shared_ptr<ServiceContext>& context)
+{
+    // 取空队列之后入队的回包一定会再次唤醒
+    if (queue_.Push(context))
+    {
+        uint64_t value = 1;
+        ssize_t ret = write(wakeup_fd_, &value, sizeof(value));
+        assert(ret == sizeof(value));
+        (void)ret;
+    }
+}
+
+NetworkServiceUring::NetworkServiceUring()
+{
+}
+
+NetworkServiceUring::~NetworkServiceUring()
+{
+}
+
+void NetworkServiceUring::SetBridge(ServiceBridge* bridge)
+{
+    bridge_ = bridge;
+}
+
+void NetworkServiceUring::SetAllProtocol(const std::vector<Protocol>& all_protocol)
+{
+    all_protocol_ = all_protocol;
+}
+
+void NetworkServiceUring::SetIoThreadNum(uint32_t io_thread_num)
+{
+    assert(loops_.empty());
+    io_thread_num_ = io_thread_num;
+}
+
+void NetworkServiceUring::SetConnectionLimit(uint32_t max_pending_requests, uint32_t max_write_queue_bytes)
+{
+    max_pending_requests_ = max_pending_requests;
+    max_write_queue_bytes_ = max_write_queue_bytes;
+}
+
+void NetworkServiceUring::SetConnectionTimeout(uint32_t max_connections, uint32_t read_timeout, uint32_t idle_timeout)
+{
+    max_connections_ = max_connections;
+    read_timeout_ = read_timeout;
+    idle_timeout_ = idle_timeout;
+}
+
+int NetworkServiceUring::BindTcpAddr(const std::string& host, uint32_t port, uint32_t backlog)
+{
+    struct sockaddr_storage addr;
+    memset(&addr, 0, sizeof(addr));
+    socklen_t addr_len = 0;
+    struct sockaddr_in* addr_v4 = (struct sockaddr_in*)&addr;
+    struct sockaddr_in6* addr_v6 = (struct sockaddr_in6*)&addr;
+    if (inet_pton(AF_INET, host.c_str(), &addr_v4->sin_addr) == 1)
+    {
+        addr_v4->sin_family = AF_INET;
+        addr_v4->sin_port = htons(port);
+        addr_len = sizeof(struct sockaddr_in);
+    }
+    else if (inet_pton(AF_INET6, host.c_str(), &addr_v6->sin6_addr) == 1)
+    {
+        addr_v6->sin6_family = AF_INET6;
+        addr_v6->sin6_port = htons(port);
+        addr_len = sizeof(struct sockaddr_in6);
+    }
+    else
+    {
+        MRPC_LOG_ERROR("Invalid server address {}:{}", host, port);
+        return ERROR_INITIALIZATION_FAILED;
+    }
+
+    host_ = host;
+    port_ = port;
+    for (uint32_t i = 0; i < io_thread_num_; ++i)
+    {
+        NetworkServiceUringLoop* loop = new NetworkServiceUringLoop(*this, i);
+        loops_.emplace_back(loop);
+
+        int ret = loop->BindTcpAddr((const struct sockaddr*)&addr, addr_len, backlog, io_thread_num_ > 1);
+        if (ret != 0)
+        {
+            return ret;
+        }
+    }
+
+    MRPC_LOG_INFO("Server listen on address {}:{} success, io thread num {}, io backend io_uring...", host_, port_, io_thread_num_);
+    return 0;
+}
+
+void NetworkServiceUring::Start(uint32_t io_index)
+{
+    assert(io_index < loops_.size());
+    loops_[io_index]->Start();
+}
+
+void NetworkServiceUring::Stop()
+{
+    for (auto& loop : loops_)
+    {
+        loop->Stop();
+    }
+}
+
+void NetworkServiceUring::SendResponse(const std::shared_ptr<ServiceContext>& context)
+{
+    assert(context->io_index < loops_.size());
+    loops_[context->io_index]->SendResponse(context);
+}
+
+}
@@ -0,0 +1,58 @@
+#pragma once
+
+#include <atomic>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <mrpc/service/context.h>
+#include <mrpc/service/protocol.h>
+#include <mrpc/util/noncopyable.h>
+
+namespace mrpc
+{
+
+class ServiceBridge;
+class NetworkServiceUringLoop;
+
+// 基于io_uring的TCP服务端(仅Linux), 接口与libuv实现的NetworkServiceImpl一致, 由NetworkService根据io_backend选择.
+// multishot accept/recv, 接收缓冲区由内核从provided buffer ring中选择, 每轮事件循环的回包合并为一次提交.
+class NetworkServiceUring final : private NonCopyable
+{
+public:
+    NetworkServiceUring();
+    ~NetworkServiceUring();
+
+    void SetBridge(ServiceBridge* bridge);
+    void SetAllProtocol(const std::vector<Protocol>& all_protocol);
+    void SetIoThreadNum(uint32_t io_thread_num);
+    void SetConnectionLimit(uint32_t max_pending_requests, uint32_t max_write_queue_bytes);
+    void SetConnectionTimeout(uint32_t max_connections, uint32_t read_timeout, uint32_t idle_timeout);
+
+    int BindTcpAddr(const std::string& host, uint32_t port, uint32_t backlog);
+
+    void Start(uint32_t io_index);
+    void Stop();
+
+    void SendResponse(const std::shared_ptr<ServiceContext>& context);
+
+private:
+    std::string host_;
+    uint32_t port_ = 0;
+    ServiceBridge* bridge_ = nullptr;
+    std::vector<Protocol> all_protocol_;
+    uint32_t io_thread_num_ = 1;
+    uint32_t max_pending_requests_ = 0;
+    uint32_t max_write_queue_bytes_ = 0;
+    uint32_t max_connections_ = 0;
+    uint32_t read_timeout_ = 0;
+    uint32_t idle_timeout_ = 0;
+    std::atomic<uint32_t> conn_num_ = 0;    // 所有IO线程的连接数
+    std::vector<std::unique_ptr<NetworkServiceUringLoop>> loops_;
+
+    static inline std::atomic<uint64_t> next_conn_id_ = 0;
+
+    friend class NetworkServiceUringLoop;
+};
+
+}
@@ -0,0 +1,208 @@
+#pragma once
+
+#include <cassert>
+#include <coroutine>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <mrpc/error_code.mrpc.h>
+#include <mrpc/message/field_mask.h>
+#include <mrpc/service/callback.h>
+#include <mrpc/service/context.h>
+#include <mrpc/service/global_proxy.h>
+#include <mrpc/service/service_stub.h>
+#include <mrpc/util/noncopyable.h>
+
+namespace mrpc
+{
+
+template<typename T>
+struct ParallelCallResult
+{
+    int32_t ret = ERROR_TIMEOUT;    // 提前完成时还没有回包的调用为ERROR_TIMEOUT
+    T rsp;
+};
+
+// ParallelCall完成时调用一次, 在发起调用的线程中执行
+template<typename T>
+class ParallelCallback
+{
+public:
+    ParallelCallback() = default;
+    virtual ~ParallelCallback() = default;
+
+    virtual void Done(std::vector<ParallelCallResult<T>>& results, size_t success_num) = 0;
+};
+
+// 并行调用多个服务(或同一服务的多个分片), 响应类型相同.
+// 请求由生成代码的Foo_Parallel添加, Start或co_await时按IO线程分组一次性提交;
+// 结果按添加顺序存放在预先分配的数组中, 所有调用共用一个回调对象, 全部完成(或满足quorum)时只通知一次.
+// 只能在worker线程和主线程中使用.
+template<typename T>
+    requires(std::is_base_of_v<Message, T>)
+class ParallelCall final : private NonCopyable
+{
+public:
+    using Result = ParallelCallResult<T>;
+
+    explicit ParallelCall(size_t call_num = 0) : state_(std::make_shared<State>())
+    {
+        state_->slots.reserve(call_num);
+        contexts_.reserve(call_num);
+    }
+
+    // 成功的调用数达到quorum时提前完成, 不可能达到时也立即完成; 0表示等待所有调用
+    void SetQuorum(size_t quorum) { state_->quorum = quorum; }
+    // 每个调用的超时(毫秒), 只能比stub配置的超时更短; 0表示使用stub的配置
+    void SetTimeout(uint32_t timeout) { timeout_ = timeout; }
+
+    // 由生成代码调用, 只能在Start之前调用
+    void Add(ServiceStub& stub, uint32_t method_code, std::string&& req_data, const FieldMask& rsp_field_mask)
+    {
+        assert(!started_);
+        contexts_.push_back(stub.PackRequest(method_code, std::move(req_data), rsp_field_mask.ToString()));
+        state_->slots.emplace_back(state_.get(), state_->slots.size(), rsp_field_mask);
+    }
+
+    void Start(const std::shared_ptr<ParallelCallback<T>>& cb)
+    {
+        state_->callback = cb;
+        Submit();
+    }
+
+    // 在协程中co_await, 结果为成功的调用数
+    auto operator co_await() & noexcept
+    {
+        struct Awaiter
+        {
+            ParallelCall& call;
+
+            bool await_ready() const noexcept { return false; }
+
+            bool await_suspend(std::coroutine_handle<> handle)
+            {
+                // 回包总是由当前线程的队列稍后处理, 提交之后再记录handle也不会错过
+                call.Submit();
+                if (call.state_->finished)
+                {
+                    return false;
+                }
+                call.state_->handle = handle;
+                return true;
+            }
+
+            size_t await_resume() const noexcept { return call.state_->success_num; }
+        };
+        return Awaiter{ *this };
+    }
+
+    inline std::vector<Result>& GetResults() { return state_->results; }
+    inline size_t GetSuccessNum() const { return state_->success_num; }
+
+private:
+    struct State;
+
+    struct Slot final : public Callback
+    {
+        Slot(State* state, size_t index, const FieldMask& rsp_field_mask) :
+            state(state), index(index), rsp_field_mask(rsp_field_mask) {}
+
+        void Done(int32_t ret, const std::string& rsp_data) override { state->Done(*this, ret, rsp_data); }
+
+        State* state = nullptr;
+        size_t index = 0;
+        FieldMask rsp_field_mask;
+    };
+
+    // 所有调用的callback都是共享State所有权的别名指针, 指向各自的Slot
+    struct State
+    {
+        void Done(const Slot& slot, int32_t ret, const std::string& rsp_data)
+        {
+            if (finished)
+            {
+                return;
+            }
+
+            Result& result = results[slot.index];
+            if (ret == 0 && !result.rsp.ParseFromString(rsp_data, slot.rsp_field_mask))
+            {
+                ret = ERROR_INVALID_METHOD_RESPONSE_DATA;
+            }
+            result.ret = ret;
+            ++done_num;
+            if (ret == 0)
+            {
+                ++success_num;
+            }
+
+            size_t call_num = results.size();
+            if (done_num == call_num
+                    || (quorum != 0 && (success_num >= quorum || success_num + (call_num - done_num) < quorum)))
+            {
+                Finish();
+            }
+        }
+
+        void Finish()
+        {
+            finished = true;
+            if (callback)
+            {
+                std::shared_ptr<ParallelCallback<T>> cb = std::move(callback);
+                cb->Done(results, success_num);
+            }
+            if (handle)
+            {
+                std::exchange(handle, nullptr).resume();
+            }
+        }
+
+        std::vector<Slot> slots;
+        std::vector<Result> results;
+        size_t quorum = 0;
+        size_t done_num = 0;
+        size_t success_num = 0;
+        bool finished = false;
+
+        std::shared_ptr<ParallelCallback<T>> callback;
+        std::coroutine_handle<> handle;
+    };
+
+    void Submit()
+    {
+        assert(!started_);
+        assert(GetCurrentThreadContextPtrQueue() != nullptr);
+        started_ = true;
+
+        state_->results.resize(state_->slots.size());
+        if (contexts_.empty())
+        {
+            state_->Finish();
+            return;
+        }
+
+        for (size_t i = 0; i < contexts_.size(); ++i)
+        {
+            auto& context = contexts_[i];
+            context->queue = GetCurrentThreadContextPtrQueue();
+            context->callback = CallbackPtr(state_, &state_->slots[i]);
+            if (timeout_ != 0 && (context->endpoint.timeout == 0 || timeout_ < context->endpoint.timeout))
+            {
+                context->endpoint.timeout = timeout_;
+            }
+        }
+        GlobalProxy::SendRequests(contexts_);
+        contexts_.clear();
+    }
+
+    std::shared_ptr<State> state_;
+    std::vector<std::shared_ptr<ServiceStubContext>> contexts_;
+    uint32_t timeout_ = 0;
+    bool started_ = false;
+};
+
+}
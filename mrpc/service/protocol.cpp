@@ -9,6 +9,7 @@
 #include <mrpc/service/protocol.h>
 #include <mrpc/service/protocol.mrpc.h>
 #include <mrpc/service/service.h>
+#include <mrpc/util/input_buffer.h>
 #include <mrpc/util/log.h>
 
 namespace mrpc
@@ -69,6 +70,16 @@ static inline bool MrpcProtocolUnpackHeader(const char* ptr, size_t size, bool s
     return true;
 }
 
+static size_t MrpcProtocolGetFrameLength(const char* ptr, size_t size)
+{
+    const MrpcProtocolLayout* layout = (const MrpcProtocolLayout*)ptr;
+    if (size < sizeof(*layout) || memcmp(layout->magic, MRPC_PROTOCOL_MAGIC, sizeof(layout->magic)) != 0)
+    {
+        return 0;
+    }
+    return sizeof(*layout) + LETOH(layout->length);
+}
+
 static bool MrpcProtocolParse(const char*& ptr, size_t size, bool strict, bool& has_error, std::shared_ptr<ServiceContext>& context)
 {
     uint64_t seq_id = 0;
@@ -97,6 +108,20 @@ static bool MrpcProtocolParse(const char*& ptr, size_t size, bool strict, bool&
     return true;
 }
 
+static void MrpcProtocolPackResponse(const std::shared_ptr<ServiceContext>& context, int32_t ret, std::string&& rsp_data)
+{
+    if (context->param.need_response && context->send_response)
+    {
+        MrpcMethodResponse rsp;
+        rsp.ret = ret;
+        rsp.rsp_data = std::move(rsp_data);
+
+        std::string response_payload;
+        rsp.SerializeToString(response_payload);
+        MrpcProtocolPackHeader(context->seq_id, response_payload, context->response);
+    }
+}
+
 static void MrpcProtocolHandleRequest(Service& service, const std::shared_ptr<ServiceContext>& context)
 {
     MrpcMethodRequest req;
@@ -112,7 +137,7 @@ static void MrpcProtocolHandleRequest(Service& service, const std::shared_ptr<Se
 
         try
         {
-            ret = service.CallMethod(req.method_code, req.req_data, rsp_data);
+            ret = service.CallMethod(req.method_code, req.req_data, req.rsp_field_mask, rsp_data);
         }
         catch (const std::exception& e)
         {
@@ -126,11 +151,45 @@ static void MrpcProtocolHandleRequest(Service& service, const std::shared_ptr<Se
         }
     } while (0);
 
-    if (context->param.need_response && context->send_response)
+    MrpcProtocolPackResponse(context, ret, std::move(rsp_data));
+}
+
+static Task<> MrpcProtocolHandleRequestCo(Service& service, std::shared_ptr<ServiceContext> context)
+{
+    MrpcMethodRequest req;
+    int32_t ret = 0;
+    std::string rsp_data;
+    if (!req.ParseFromString(context->request_payload))
+    {
+        ret = ERROR_INVALID_SERVICE_REQUEST_DATA;
+    }
+    else
+    {
+        try
+        {
+            ret = co_await service.CallMethodCo(req.method_code, req.req_data, req.rsp_field_mask, rsp_data);
+        }
+        catch (const std::exception& e)
+        {
+            ret = ERROR_EXCEPTION;
+            MRPC_LOG_ERROR("Catch exception {}", e.what());
+        }
+        catch (...)
+        {
+            ret = ERROR_EXCEPTION;
+            MRPC_LOG_ERROR("Catch unknown exception.");
+        }
+    }
+
+    MrpcProtocolPackResponse(context, ret, std::move(rsp_data));
+}
+
+static void MrpcProtocolRespondError(const std::shared_ptr<ServiceContext>& context, int32_t ret)
+{
+    if (context->param.need_response)
     {
         MrpcMethodResponse rsp;
         rsp.ret = ret;
-        rsp.rsp_data = std::move(rsp_data);
 
         std::string response_payload;
         rsp.SerializeToString(response_payload);
@@ -143,6 +202,7 @@ static void MrpcProtocolPack(uint32_t method_code, const std::string& req_data,
     MrpcMethodRequest req;
     req.method_code = method_code;
     req.req_data = req_data;
+    req.rsp_field_mask = context->rsp_field_mask;
 
     MrpcRequestPayload req_payload;
     req_payload.param.has_thread_hash_code = context->param.has_thread_hash_code;
@@ -178,6 +238,8 @@ static bool MrpcProtocolHandleResponse(const char*& ptr, size_t size, bool& has_
     return true;
 }
 
+static constexpr size_t kMaxReserveFrameLength = 16 * 1024 * 1024;  // 超过此长度的包不提前预留
+
 static std::mutex g_mutex;
 static std::map<std::string, Protocol> g_name2protocol =
 {
@@ -185,8 +247,11 @@ static std::map<std::string, Protocol> g_name2protocol =
         { 
             .parse = MrpcProtocolParse, 
             .handle_request = MrpcProtocolHandleRequest, 
+            .handle_request_co = MrpcProtocolHandleRequestCo,
+            .respond_error = MrpcProtocolRespondError,
             .pack = MrpcProtocolPack,
             .handle_response = MrpcProtocolHandleResponse,
+            .get_frame_length = MrpcProtocolGetFrameLength,
         }
     },
 };
@@ -209,4 +274,15 @@ const Protocol* GlobalFindProtocol(const std::string& name)
     return nullptr;
 }
 
+void ReserveFrame(const Protocol& protocol, InputBuffer& buffer)
+{
+    if (protocol.get_frame_length == nullptr || buffer.Empty()) return;
+
+    size_t frame_length = protocol.get_frame_length(buffer.GetReadPtr(), buffer.GetReadableSize());
+    if (frame_length > buffer.GetReadableSize() && frame_length <= kMaxReserveFrameLength)
+    {
+        buffer.Reserve(frame_length);
+    }
+}
+
 }
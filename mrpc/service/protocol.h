@@ -5,10 +5,12 @@
 #include <string>
 
 #include <mrpc/message/message.h>
+#include <mrpc/util/task.h>
 
 namespace mrpc
 {
 
+class InputBuffer;
 class Service;
 class ServiceContext;
 class ServiceStubContext;
@@ -21,6 +23,14 @@ struct Protocol
     // Server, worker thread
     using RequestHandler = void (*)(Service& service, const std::shared_ptr<ServiceContext>& context);
 
+    // Server, worker thread, optional
+    // 协程服务的请求, 协程结束时回包已写入context->response. 没有时协程服务按普通服务调用.
+    using CoroutineRequestHandler = Task<> (*)(Service& service, std::shared_ptr<ServiceContext> context);
+
+    // Server, IO thread, optional
+    // 请求没有交给worker线程处理(比如过载)时, 直接生成错误回包写入context->response.
+    using ErrorResponder = void (*)(const std::shared_ptr<ServiceContext>& context, int32_t ret);
+
     // Client, worker thread
     using Packer = void(*)(uint32_t method_code, const std::string& req_data, std::shared_ptr<ServiceStubContext>& context);
     using Serializer = void(*)(const std::string& method_name, const Message& req, Message& rsp);
@@ -28,11 +38,18 @@ struct Protocol
     // Client, IO thread
     using ResponseHandler = bool (*)(const char*& ptr, size_t size, bool& has_error, uint64_t& seq_id, int32_t& ret, std::string& response_payload);
 
+    // Server & Client, IO thread, optional
+    // 包头完整时返回整个包的长度, 否则返回0. 用于提前为不完整的包预留输入缓冲区.
+    using FrameLengthGetter = size_t (*)(const char* ptr, size_t size);
+
     Parser parse = nullptr;
     RequestHandler handle_request = nullptr;
+    CoroutineRequestHandler handle_request_co = nullptr;
+    ErrorResponder respond_error = nullptr;
     Packer pack = nullptr;
     Serializer serialize = nullptr;
     ResponseHandler handle_response = nullptr;
+    FrameLengthGetter get_frame_length = nullptr;
 
     bool IsServer() const { return parse != nullptr && handle_request != nullptr; }
     bool IsClient() const { return (pack != nullptr || serialize != nullptr) && handle_response != nullptr; }
@@ -41,4 +58,7 @@ struct Protocol
 void GlobalRegisterProtocol(const std::string& name, const Protocol& protocol);
 const Protocol* GlobalFindProtocol(const std::string& name);
 
+// 输入缓冲区中有不完整的包时, 按包头声明的长度一次性预留空间, 避免接收大包时反复扩容.
+void ReserveFrame(const Protocol& protocol, InputBuffer& buffer);
+
 }
@@ -5,6 +5,7 @@
 #include <memory>
 
 #include <mrpc/util/noncopyable.h>
+#include <mrpc/util/task.h>
 
 namespace mrpc
 {
@@ -23,8 +24,22 @@ public:
     virtual const Descriptor* GetResponseDescriptor(const std::string& method_name) const = 0;
     virtual int32_t CallMethod(const std::string& method_name, const Message& req, Message& rsp) = 0;
 
-    // name hash based protocol
-    virtual int32_t CallMethod(uint32_t method_code, const std::string& req_data, std::string& rsp_data) = 0;
+    // name hash based protocol, rsp_field_mask为空时序列化全部字段
+    virtual int32_t CallMethod(uint32_t method_code, const std::string& req_data, const std::string& rsp_field_mask, std::string& rsp_data) = 0;
+
+    // 协程服务(proto中设置option (mrpc.coroutine) = true)的处理函数可以挂起, 只能通过以下接口调用.
+    // 普通服务默认直接调用CallMethod.
+    virtual bool IsCoroutine() const { return false; }
+
+    virtual Task<int32_t> CallMethodCo(const std::string& method_name, const Message& req, Message& rsp)
+    {
+        co_return CallMethod(method_name, req, rsp);
+    }
+
+    virtual Task<int32_t> CallMethodCo(uint32_t method_code, const std::string& req_data, const std::string& rsp_field_mask, std::string& rsp_data)
+    {
+        co_return CallMethod(method_code, req_data, rsp_field_mask, rsp_data);
+    }
 };
 
 }
@@ -32,6 +32,14 @@ int ServiceBridge::Initialize(const ServiceFactory& factory, const ServiceConfig
     }
     network_.SetAllProtocol(all_protocol);
 
+    if (config_.io_thread_num == 0)
+    {
+        MRPC_LOG_ERROR("Service {} io_thread_num must be greater than 0.", config_.name);
+        return ERROR_INITIALIZATION_FAILED;
+    }
+    network_.SetIoThreadNum(config_.io_thread_num);
+    network_.SetConnectionLimit(config_.max_pending_requests, config_.max_write_queue_bytes);
+
     ret = network_.Bind(config_.network);
     if (ret != 0)
     {
@@ -61,7 +69,10 @@ void ServiceBridge::Start()
     {
         service_thread_.emplace_back(ServiceThreadFunc, std::ref(running_), std::ref(network_), std::ref(*service_[i]), std::ref(*service_queues_[i]));
     }
-    network_thread_ = std::thread(NetworkThreadFunc, std::ref(network_));
+    for (uint32_t i = 0; i < config_.io_thread_num; ++i)
+    {
+        network_thread_.emplace_back(NetworkThreadFunc, std::ref(network_), i);
+    }
 }
 
 void ServiceBridge::Stop()
@@ -69,7 +80,10 @@ void ServiceBridge::Stop()
     running_ = false;
     network_.Stop();
 
-    network_thread_.join();
+    for (uint32_t i = 0; i < config_.io_thread_num; ++i)
+    {
+        network_thread_[i].join();
+    }
     for (uint32_t i = 0; i < config_.thread_num; ++i)
     {
         service_thread_[i].join();
@@ -80,7 +94,24 @@ void ServiceBridge::Finalize()
 {
 }
 
-void ServiceBridge::DispatchMessage(const std::shared_ptr<ServiceContext>& context)
+void ServiceBridge::LogMetrics() const
+{
+    size_t queued = 0;
+    for (const auto& queue : service_queues_)
+    {
+        queued += queue->size();
+    }
+
+    MRPC_LOG_INFO("Service {} metrics, queued {}, rejected {}, dropped {}, pending requests {}, pending write bytes {}, read pauses {}, write queue overflows {}, "
+            "connections {}, rejected connections {}, idle timeouts {}, read timeouts {}",
+            config_.name, queued, metrics_.rejected_requests.load(), metrics_.dropped_requests.load(),
+            metrics_.pending_requests.load(), metrics_.pending_write_bytes.load(),
+            metrics_.read_pauses.load(), metrics_.write_queue_overflows.load(),
+            metrics_.connections.load(), metrics_.rejected_connections.load(),
+            metrics_.idle_timeouts.load(), metrics_.read_timeouts.load());
+}
+
+bool ServiceBridge::DispatchMessage(const std::shared_ptr<ServiceContext>& context)
 {
     size_t index = 0;
     if (context->param.has_thread_hash_code)
@@ -92,14 +123,36 @@ void ServiceBridge::DispatchMessage(const std::shared_ptr<ServiceContext>& conte
         index = context->conn_id % config_.thread_num;
     }
 
-    service_queues_[index]->push(context);
+    if (config_.max_queue_size == 0)
+    {
+        service_queues_[index]->push(context);
+        return true;
+    }
+    if (service_queues_[index]->try_push(context, config_.max_queue_size))
+    {
+        return true;
+    }
+
+    if (config_.overflow_policy == drop)
+    {
+        ++metrics_.dropped_requests;
+    }
+    else
+    {
+        ++metrics_.rejected_requests;
+        if (context->protocol.respond_error != nullptr)
+        {
+            context->protocol.respond_error(context, ERROR_SERVICE_OVERLOADED);
+        }
+    }
+    return false;
 }
 
-void ServiceBridge::NetworkThreadFunc(NetworkService& network)
+void ServiceBridge::NetworkThreadFunc(NetworkService& network, uint32_t io_index)
 {
     MRPC_LOG_INFO("Thread start");//, id {}", std::this_thread::get_id());
 
-    network.Start();
+    network.Start(io_index);
 }
 
 struct ServiceThreadVisitor
@@ -113,13 +166,34 @@ struct ServiceThreadVisitor
     Service& service;
 };
 
+static void FinishRequest(NetworkService& network, const std::shared_ptr<ServiceContext>& context)
+{
+    if (!context->param.need_response || !context->send_response)
+    {
+        context->response.clear();
+    }
+    // 没有回包时也交还给IO线程, 用于统计连接上未回包的请求数
+    network.SendResponse(context);
+}
+
+// 挂起期间由协程帧持有context, 协程结束后回包
+static Task<> HandleRequestCo(NetworkService& network, Service& service, std::shared_ptr<ServiceContext> context)
+{
+    co_await context->protocol.handle_request_co(service, context);
+    FinishRequest(network, context);
+}
+
 void ServiceThreadVisitor::operator()(const std::shared_ptr<ServiceContext>& context)
 {
-    context->protocol.handle_request(service, context);
-    if ((context->param.need_response && context->send_response) || context->close_connection)
+    if (service.IsCoroutine() && context->protocol.handle_request_co != nullptr)
     {
-        network.SendResponse(context);
+        // 第一次挂起时返回, 继续处理队列中的其它请求和回包
+        Spawn(HandleRequestCo(network, service, context));
+        return;
     }
+
+    context->protocol.handle_request(service, context);
+    FinishRequest(network, context);
 }
 
 void ServiceThreadVisitor::operator()(const std::shared_ptr<ServiceStubContext>& context)
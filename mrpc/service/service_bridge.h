@@ -9,6 +9,7 @@
 #include <mrpc/service/network_service.h>
 #include <mrpc/service/service.h>
 #include <mrpc/service/service_factory.h>
+#include <mrpc/service/service_metrics.h>
 #include <mrpc/util/noncopyable.h>
 #include <mrpc/util/thread_safe_queue.h>
 
@@ -26,18 +27,24 @@ public:
     void Stop();
     void Finalize();
 
+    const ServiceConfig& GetConfig() const { return config_; }
+    ServiceMetrics& GetMetrics() { return metrics_; }
+    const ServiceMetrics& GetMetrics() const { return metrics_; }
+    void LogMetrics() const;
 
-    void DispatchMessage(const std::shared_ptr<ServiceContext>& context);
+    // 返回false表示worker线程队列已满, 请求没有被处理. 此时context->response非空则需要直接回包.
+    bool DispatchMessage(const std::shared_ptr<ServiceContext>& context);
 
 private:
-    static void NetworkThreadFunc(NetworkService& network);
+    static void NetworkThreadFunc(NetworkService& network, uint32_t io_index);
     static void ServiceThreadFunc(std::atomic<bool>& running, NetworkService& network, Service& service, ContextPtrQueue& queue);
 
     ServiceConfig config_;
     std::atomic<bool> running_ = false;
+    ServiceMetrics metrics_;
 
     NetworkService network_;
-    std::thread network_thread_;
+    std::vector<std::thread> network_thread_;
 
     std::vector<std::unique_ptr<Service>> service_;
     std::vector<std::unique_ptr<ContextPtrQueue>> service_queues_;
@@ -0,0 +1,29 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+
+namespace mrpc
+{
+
+// 单个Service的统计数据, IO线程和worker线程并发更新.
+struct ServiceMetrics
+{
+    // worker线程队列已满
+    std::atomic<uint64_t> rejected_requests = 0;    // 回复了ERROR_SERVICE_OVERLOADED
+    std::atomic<uint64_t> dropped_requests = 0;     // 直接丢弃
+
+    // 连接
+    std::atomic<int64_t> connections = 0;
+    std::atomic<uint64_t> rejected_connections = 0;     // 超过max_connections被关闭
+    std::atomic<uint64_t> idle_timeouts = 0;            // 空闲超时被关闭
+    std::atomic<uint64_t> read_timeouts = 0;            // 不完整的包超时被关闭
+
+    // 连接背压
+    std::atomic<uint64_t> read_pauses = 0;              // 暂停读取的次数
+    std::atomic<uint64_t> write_queue_overflows = 0;    // 其中因待发送字节数超限而暂停的次数
+    std::atomic<int64_t> pending_requests = 0;          // 所有连接上未回包的请求数
+    std::atomic<int64_t> pending_write_bytes = 0;       // 所有连接上待发送的字节数
+};
+
+}
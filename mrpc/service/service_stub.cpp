@@ -4,25 +4,33 @@
 #include <mrpc/service/context.h>
 #include <mrpc/service/service_stub.h>
 #include <mrpc/service/global_proxy.h>
+#include <mrpc/util/time.h>
 
 namespace mrpc
 {
 
 static std::atomic<uint64_t> g_next_seq_id = 0;
 
-int32_t ServiceStub::CallMethod(uint32_t method_code, const std::string& req_data, std::string& rsp_data)
+int32_t ServiceStub::CallMethod(uint32_t method_code, std::string req_data, const std::string& rsp_field_mask, std::string& rsp_data)
 {
     std::shared_ptr<ServiceStubContext> context = std::make_shared<ServiceStubContext>();
-    InitContext(context);
-    protocol_.pack(method_code, req_data, context);
+    InitContext(context, method_code, true);
+    context->rsp_field_mask = rsp_field_mask;
+    PackContext(context, method_code, std::move(req_data));
 
-    std::chrono::milliseconds timeout(endpoint_.timeout);
+    std::chrono::milliseconds timeout(context->endpoint.timeout);
     context->notifier = std::unique_ptr<ServiceStubContextNotifier>(new ServiceStubContextNotifier());
     {
         // WARNING: Pay attention to the calling sequence!!!
         std::unique_lock<std::mutex> lock(context->notifier->mtx);
         GlobalProxy::SendRequest(context);
-        if (context->notifier->cv.wait_for(lock, timeout) == std::cv_status::timeout)
+        // IO线程在超时后同样会以ERROR_TIMEOUT完成请求并清理, 这里只是兜底
+        auto done = [&context] { return context->notifier->done; };
+        if (context->endpoint.timeout == 0)
+        {
+            context->notifier->cv.wait(lock, done);
+        }
+        else if (!context->notifier->cv.wait_for(lock, timeout, done))
         {
             return ERROR_TIMEOUT;
         }
@@ -36,15 +44,12 @@ int32_t ServiceStub::CallMethod(uint32_t method_code, const std::string& req_dat
     return 0;
 }
 
-void ServiceStub::CallMethod(uint32_t method_code, const std::string& req_data, const CallbackPtr& cb)
+void ServiceStub::CallMethod(uint32_t method_code, std::string req_data, const std::string& rsp_field_mask, const CallbackPtr& cb)
 {
     std::shared_ptr<ServiceStubContext> context = std::make_shared<ServiceStubContext>();
-    InitContext(context);
-    if (!cb)
-    {
-        context->param.need_response = false;
-    }
-    protocol_.pack(method_code, req_data, context);
+    InitContext(context, method_code, cb != nullptr);
+    context->rsp_field_mask = rsp_field_mask;
+    PackContext(context, method_code, std::move(req_data));
 
     if (cb)
     {
@@ -54,13 +59,112 @@ void ServiceStub::CallMethod(uint32_t method_code, const std::string& req_data,
     GlobalProxy::SendRequest(context);
 }
 
-void ServiceStub::InitContext(const std::shared_ptr<ServiceStubContext>& context)
+std::shared_ptr<ServiceStubContext> ServiceStub::PackRequest(uint32_t method_code, std::string req_data, const std::string& rsp_field_mask)
+{
+    std::shared_ptr<ServiceStubContext> context = std::make_shared<ServiceStubContext>();
+    InitContext(context, method_code, true);
+    context->rsp_field_mask = rsp_field_mask;
+    PackContext(context, method_code, std::move(req_data));
+    return context;
+}
+
+std::shared_ptr<ServiceStubContext> ServiceStub::PackHedgeRequest(const ServiceStubContext& primary)
+{
+    std::shared_ptr<ServiceStubContext> context = std::make_shared<ServiceStubContext>();
+    context->stub_id = primary.stub_id;
+    context->seq_id = ++g_next_seq_id;
+    context->protocol = primary.protocol;
+    context->param = primary.param;
+    context->rsp_field_mask = primary.rsp_field_mask;
+    context->io_index = primary.io_index;
+    context->endpoint = primary.endpoint;
+    context->endpoints = primary.endpoints;
+    context->hedging = primary.hedging;
+    context->method_code = primary.method_code;
+    context->start_time = Time::NowMicros();
+
+    LoadBalancer* balancer = primary.endpoints->balancer.get();
+    if (balancer != nullptr)
+    {
+        uint32_t index = balancer->SelectOther(primary.endpoint_index);
+        balancer->OnRequestStart(index);
+        context->endpoint_index = index;
+        context->io_index = primary.endpoints->io_indexes[index];
+        context->endpoint = primary.endpoints->endpoints[index];
+    }
+
+    uint32_t timeout = primary.endpoint.timeout;
+    if (timeout != 0)
+    {
+        uint64_t elapsed = (context->start_time - primary.start_time) / 1000;
+        context->endpoint.timeout = elapsed < timeout ? timeout - (uint32_t)elapsed : 1;
+    }
+    else
+    {
+        context->endpoint.timeout = 0;
+    }
+
+    context->protocol.pack(primary.method_code, *primary.request_data, context);
+    return context;
+}
+
+void ServiceStub::InitContext(const std::shared_ptr<ServiceStubContext>& context, uint32_t method_code, bool need_response)
 {
     context->stub_id = stub_id_;
     context->seq_id = ++g_next_seq_id;
-    context->endpoint = endpoint_;
     context->protocol = protocol_;
-    //TODO param;
+    context->param = param_;
+    context->param.need_response = need_response;
+    context->io_index = io_index_;
+    context->endpoint = endpoint_;
+
+    if (endpoints_ == nullptr)
+    {
+        return;
+    }
+
+    if (endpoints_->balancer != nullptr)
+    {
+        LoadBalancer& balancer = *endpoints_->balancer;
+        uint32_t index = balancer.Select(param_.has_thread_hash_code, param_.thread_hash_code);
+        context->io_index = endpoints_->io_indexes[index];
+        context->endpoint = endpoints_->endpoints[index];
+        // 不需要回包的请求没有完成的时机, 不参与统计
+        if (need_response)
+        {
+            balancer.OnRequestStart(index);
+            context->endpoints = endpoints_;
+            context->endpoint_index = index;
+            context->start_time = Time::NowMicros();
+        }
+    }
+
+    // 不需要回包的请求无法判断是否需要对冲
+    if (!need_response)
+    {
+        return;
+    }
+    auto it = endpoints_->hedging.find(method_code);
+    if (it == endpoints_->hedging.end())
+    {
+        return;
+    }
+    HedgingPolicy* hedging = it->second.get();
+    hedging->budget.OnRequest();
+    context->endpoints = endpoints_;
+    context->hedging = hedging;
+    context->method_code = method_code;
+    context->start_time = Time::NowMicros();
+}
+
+void ServiceStub::PackContext(std::shared_ptr<ServiceStubContext>& context, uint32_t method_code, std::string&& req_data)
+{
+    protocol_.pack(method_code, req_data, context);
+    // 对冲请求在IO线程中重新打包, 与原请求共享同一份请求数据
+    if (context->hedging != nullptr)
+    {
+        context->request_data = std::make_shared<const std::string>(std::move(req_data));
+    }
 }
 
 }
@@ -22,15 +22,31 @@ public:
     virtual ~ServiceStub() = default;
 
     void SetProtocol(const Protocol& protocol) { protocol_ = protocol; }
+    // 服务端按thread_hash_code选择worker线程, 配置了多个地址时consistent_hash也按它选择地址
+    void SetThreadHashCode(uint32_t thread_hash_code)
+    {
+        param_.has_thread_hash_code = true;
+        param_.thread_hash_code = thread_hash_code;
+    }
 
-    int32_t CallMethod(uint32_t method_code, const std::string& req_data, std::string& rsp_data);
-    void CallMethod(uint32_t method_code, const std::string& req_data, const CallbackPtr& cb);
+    // 配置了对冲的方法直接接管req_data, 调用方传入右值可以避免拷贝
+    int32_t CallMethod(uint32_t method_code, std::string req_data, const std::string& rsp_field_mask, std::string& rsp_data);
+    void CallMethod(uint32_t method_code, std::string req_data, const std::string& rsp_field_mask, const CallbackPtr& cb);
+
+    // 只打包不发送, 调用方设置queue和callback后通过GlobalProxy::SendRequests批量发送
+    std::shared_ptr<ServiceStubContext> PackRequest(uint32_t method_code, std::string req_data, const std::string& rsp_field_mask);
+
+    // 由客户端IO线程调用, 为配置了对冲的请求打包一个新seq_id的副本, 尽量选择另一个地址, 截止时间与原请求相同
+    static std::shared_ptr<ServiceStubContext> PackHedgeRequest(const ServiceStubContext& primary);
 
 private:
-    void InitContext(const std::shared_ptr<ServiceStubContext>& context);
+    void InitContext(const std::shared_ptr<ServiceStubContext>& context, uint32_t method_code, bool need_response);
+    void PackContext(std::shared_ptr<ServiceStubContext>& context, uint32_t method_code, std::string&& req_data);
 
     uint64_t stub_id_ = 0;
+    uint32_t io_index_ = 0;
     Endpoint endpoint_;
+    std::shared_ptr<EndpointGroup> endpoints_;  // 配置了多个地址时, 每个请求由其中的balancer重新选择地址
     Protocol protocol_;
     ServiceContextRequestParam param_;
 
@@ -0,0 +1,29 @@
+#include <algorithm>
+
+#include <mrpc/util/backoff.h>
+
+namespace mrpc
+{
+
+Backoff::Backoff(uint32_t initial/* = 0*/, uint32_t max/* = 0*/) :
+    initial_(initial),
+    max_(std::max(initial, max)),
+    random_(std::random_device()())
+{
+}
+
+uint32_t Backoff::Fail()
+{
+    ++failures_;
+    if (initial_ == 0)
+    {
+        return 0;
+    }
+
+    // 超过32次之后必然已经到达上限, 避免移位溢出
+    uint32_t shift = std::min<uint32_t>(failures_ - 1, 32);
+    uint64_t delay = std::min<uint64_t>((uint64_t)initial_ << shift, max_);
+    return (uint32_t)(delay / 2 + random_() % (delay - delay / 2 + 1));
+}
+
+}
@@ -0,0 +1,31 @@
+#pragma once
+
+#include <cstdint>
+#include <random>
+
+namespace mrpc
+{
+
+// 带随机抖动的指数退避: 连续第n次失败后等待min(max, initial * 2^(n-1))的[1/2, 1]倍,
+// 抖动避免大量客户端在同一时刻重连. initial为0时不等待.
+// 非线程安全.
+class Backoff final
+{
+public:
+    Backoff(uint32_t initial = 0, uint32_t max = 0);
+    ~Backoff() = default;
+
+    inline uint32_t GetFailures() const { return failures_; }
+    inline void Reset() { failures_ = 0; }
+
+    // 记录一次失败, 返回下一次重试之前的等待时间.
+    uint32_t Fail();
+
+private:
+    uint32_t initial_ = 0;
+    uint32_t max_ = 0;
+    uint32_t failures_ = 0;
+    std::minstd_rand random_;
+};
+
+}
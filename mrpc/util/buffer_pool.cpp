@@ -0,0 +1,45 @@
+#include <mrpc/util/buffer_pool.h>
+
+namespace mrpc
+{
+
+BufferPool::BufferPool(size_t block_size/* = kDefaultBlockSize*/, size_t max_free_blocks/* = kDefaultMaxFreeBlocks*/) :
+    block_size_(block_size),
+    max_free_blocks_(max_free_blocks)
+{
+    free_blocks_.reserve(max_free_blocks_);
+}
+
+BufferPool::~BufferPool()
+{
+    for (char* block : free_blocks_)
+    {
+        delete[] block;
+    }
+}
+
+char* BufferPool::Allocate()
+{
+    if (free_blocks_.empty())
+    {
+        return new char[block_size_];
+    }
+
+    char* block = free_blocks_.back();
+    free_blocks_.pop_back();
+    return block;
+}
+
+void BufferPool::Free(char* block)
+{
+    if (block == nullptr) return;
+
+    if (free_blocks_.size() >= max_free_blocks_)
+    {
+        delete[] block;
+        return;
+    }
+    free_blocks_.push_back(block);
+}
+
+}
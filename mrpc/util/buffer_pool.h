@@ -0,0 +1,35 @@
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+#include <mrpc/util/noncopyable.h>
+
+namespace mrpc
+{
+
+// 固定大小内存块的缓存池, 用于IO线程的读缓冲区, 避免每次读都malloc/free.
+// 非线程安全, 每个事件循环各持有一个.
+class BufferPool final : private NonCopyable
+{
+public:
+    static constexpr size_t kDefaultBlockSize = 64 * 1024;
+    static constexpr size_t kDefaultMaxFreeBlocks = 16;
+
+    explicit BufferPool(size_t block_size = kDefaultBlockSize, size_t max_free_blocks = kDefaultMaxFreeBlocks);
+    ~BufferPool();
+
+    inline size_t GetBlockSize() const { return block_size_; }
+    inline size_t GetFreeBlockNum() const { return free_blocks_.size(); }
+
+    char* Allocate();
+    // 缓存的空闲块超过max_free_blocks时直接释放.
+    void Free(char* block);
+
+private:
+    size_t block_size_ = 0;
+    size_t max_free_blocks_ = 0;
+    std::vector<char*> free_blocks_;
+};
+
+}
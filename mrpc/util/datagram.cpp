@@ -0,0 +1,74 @@
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <sys/uio.h>
+
+#include <mrpc/util/datagram.h>
+
+namespace mrpc
+{
+
+static constexpr size_t kMaxDatagramBatch = 64;
+
+int SendDatagrams(int fd, const Datagram* datagrams, size_t count)
+{
+    count = std::min(count, kMaxDatagramBatch);
+    if (count == 0)
+    {
+        return 0;
+    }
+
+#ifdef __linux__
+    struct mmsghdr msgs[kMaxDatagramBatch];
+    struct iovec iovs[kMaxDatagramBatch];
+    memset(msgs, 0, sizeof(struct mmsghdr) * count);
+    for (size_t i = 0; i < count; ++i)
+    {
+        const Datagram& datagram = datagrams[i];
+        iovs[i].iov_base = (void*)datagram.data.data();
+        iovs[i].iov_len = datagram.data.length();
+        msgs[i].msg_hdr.msg_iov = &iovs[i];
+        msgs[i].msg_hdr.msg_iovlen = 1;
+        if (datagram.addr_len > 0)
+        {
+            msgs[i].msg_hdr.msg_name = (void*)&datagram.addr;
+            msgs[i].msg_hdr.msg_namelen = datagram.addr_len;
+        }
+    }
+
+    int ret = 0;
+    do
+    {
+        ret = sendmmsg(fd, msgs, count, MSG_DONTWAIT);
+    } while (ret < 0 && errno == EINTR);
+    return ret < 0 ? -errno : ret;
+#else
+    for (size_t i = 0; i < count; ++i)
+    {
+        const Datagram& datagram = datagrams[i];
+        struct iovec iov = { (void*)datagram.data.data(), datagram.data.length() };
+        struct msghdr msg;
+        memset(&msg, 0, sizeof(msg));
+        msg.msg_iov = &iov;
+        msg.msg_iovlen = 1;
+        if (datagram.addr_len > 0)
+        {
+            msg.msg_name = (void*)&datagram.addr;
+            msg.msg_namelen = datagram.addr_len;
+        }
+
+        ssize_t ret = 0;
+        do
+        {
+            ret = sendmsg(fd, &msg, MSG_DONTWAIT);
+        } while (ret < 0 && errno == EINTR);
+        if (ret < 0)
+        {
+            return i > 0 ? (int)i : -errno;
+        }
+    }
+    return (int)count;
+#endif
+}
+
+}
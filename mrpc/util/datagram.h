@@ -0,0 +1,24 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include <sys/socket.h>
+
+namespace mrpc
+{
+
+// UDP数据报的最大负载(IPv4).
+static constexpr size_t kMaxDatagramSize = 65507;
+
+struct Datagram
+{
+    struct sockaddr_storage addr;
+    socklen_t addr_len = 0;     // 0表示发给已连接socket的对端
+    std::string data;
+};
+
+// 用sendmmsg一次系统调用发送多个数据报(不支持时逐个sendmsg), 不阻塞.
+// 返回发送出去的个数; 第一个就发送失败时返回-errno, 发送缓冲区满时为-EAGAIN.
+int SendDatagrams(int fd, const Datagram* datagrams, size_t count);
+
+}
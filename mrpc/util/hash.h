@@ -0,0 +1,27 @@
+#pragma once
+
+#include <cstdint>
+#include <string_view>
+
+namespace mrpc
+{
+
+// 服务名和方法名的哈希值, 生成代码(protoc插件)和运行时使用同一个实现.
+inline uint32_t APHash(std::string_view str)
+{
+    uint32_t hash = 0;
+    for (size_t i = 0; i < str.length(); i++)
+    {
+        if ((i & 1) == 0)
+        {
+            hash ^= ((hash << 7) ^ str[i] ^ (hash >> 3));
+        }
+        else
+        {
+            hash ^= (~((hash << 11) ^ str[i] ^ (hash >> 5)));
+        }
+    }
+    return hash;
+}
+
+}
@@ -0,0 +1,79 @@
+#include <algorithm>
+#include <cassert>
+#include <cstring>
+
+#include <mrpc/util/input_buffer.h>
+
+namespace mrpc
+{
+
+void InputBuffer::EnsureWritable(size_t size)
+{
+    if (GetWritableSize() >= size) return;
+
+    size_t readable = GetReadableSize();
+    if (read_pos_ + GetWritableSize() >= size && readable <= capacity_ / 2)
+    {
+        // 整理后空间足够, 且未读数据不超过一半
+        memmove(data_.get(), data_.get() + read_pos_, readable);
+    }
+    else
+    {
+        size_t capacity = std::max({ capacity_ * 2, readable + size, kMinCapacity });
+        std::unique_ptr<char[]> data(new char[capacity]);
+        if (readable > 0)
+        {
+            memcpy(data.get(), data_.get() + read_pos_, readable);
+        }
+        data_ = std::move(data);
+        capacity_ = capacity;
+    }
+
+    read_pos_ = 0;
+    write_pos_ = readable;
+}
+
+void InputBuffer::Reserve(size_t size)
+{
+    size_t readable = GetReadableSize();
+    if (size > readable)
+    {
+        EnsureWritable(size - readable);
+    }
+}
+
+void InputBuffer::Commit(size_t size)
+{
+    assert(size <= GetWritableSize());
+    write_pos_ += size;
+}
+
+void InputBuffer::Append(const char* data, size_t size)
+{
+    EnsureWritable(size);
+    memcpy(data_.get() + write_pos_, data, size);
+    write_pos_ += size;
+}
+
+void InputBuffer::Consume(size_t size)
+{
+    assert(size <= GetReadableSize());
+    read_pos_ += size;
+    if (read_pos_ == write_pos_)
+    {
+        Clear();
+    }
+}
+
+void InputBuffer::Clear()
+{
+    read_pos_ = 0;
+    write_pos_ = 0;
+    if (capacity_ > kMaxIdleCapacity)
+    {
+        data_.reset();
+        capacity_ = 0;
+    }
+}
+
+}
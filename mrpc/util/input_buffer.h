@@ -0,0 +1,48 @@
+#pragma once
+
+#include <cstddef>
+#include <memory>
+
+#include <mrpc/util/noncopyable.h>
+
+namespace mrpc
+{
+
+// 连接的输入缓冲区, 读写游标分离, 消费数据只移动读游标.
+// 只有可写空间不足时才整理(把未读数据移到头部)或扩容, 且只拷贝未读的数据.
+// 非线程安全.
+class InputBuffer final : private NonCopyable
+{
+public:
+    static constexpr size_t kMinCapacity = 4 * 1024;
+    static constexpr size_t kMaxIdleCapacity = 1024 * 1024;  // 数据消费完后超过此容量则释放内存
+
+    InputBuffer() = default;
+    ~InputBuffer() = default;
+
+    inline const char* GetReadPtr() const { return data_.get() + read_pos_; }
+    inline size_t GetReadableSize() const { return write_pos_ - read_pos_; }
+    inline bool Empty() const { return read_pos_ == write_pos_; }
+
+    inline char* GetWritePtr() { return data_.get() + write_pos_; }
+    inline size_t GetWritableSize() const { return capacity_ - write_pos_; }
+    inline size_t GetCapacity() const { return capacity_; }
+
+    // 保证至少有size字节的可写空间.
+    void EnsureWritable(size_t size);
+    // 保证可读与可写空间之和至少为size字节, 已知完整帧长时一次性预留.
+    void Reserve(size_t size);
+    // 在GetWritePtr()处写入size字节后调用.
+    void Commit(size_t size);
+    void Append(const char* data, size_t size);
+    void Consume(size_t size);
+    void Clear();
+
+private:
+    std::unique_ptr<char[]> data_;
+    size_t capacity_ = 0;
+    size_t read_pos_ = 0;
+    size_t write_pos_ = 0;
+};
+
+}
@@ -0,0 +1,275 @@
+#include <atomic>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <sys/utsname.h>
+#include <unistd.h>
+
+#include <mrpc/util/io_uring.h>
+
+namespace mrpc
+{
+
+// 与内核共享的游标
+static inline uint32_t LoadAcquire(const uint32_t* ptr)
+{
+    return std::atomic_ref<const uint32_t>(*ptr).load(std::memory_order_acquire);
+}
+
+static inline void StoreRelease(uint32_t* ptr, uint32_t value)
+{
+    std::atomic_ref<uint32_t>(*ptr).store(value, std::memory_order_release);
+}
+
+static int IoUringSetup(uint32_t entries, struct io_uring_params* params)
+{
+    return (int)syscall(__NR_io_uring_setup, entries, params);
+}
+
+static int IoUringEnter(int ring_fd, uint32_t to_submit, uint32_t min_complete, uint32_t flags, const void* arg, size_t arg_size)
+{
+    return (int)syscall(__NR_io_uring_enter, ring_fd, to_submit, min_complete, flags, arg, arg_size);
+}
+
+static int IoUringRegister(int ring_fd, uint32_t opcode, const void* arg, uint32_t nr_args)
+{
+    return (int)syscall(__NR_io_uring_register, ring_fd, opcode, arg, nr_args);
+}
+
+IoUring::~IoUring()
+{
+    if (buffer_ring_ != nullptr)
+    {
+        struct io_uring_buf_reg reg;
+        memset(&reg, 0, sizeof(reg));
+        reg.bgid = buffer_group_id_;
+        IoUringRegister(ring_fd_, IORING_UNREGISTER_PBUF_RING, &reg, 1);
+        munmap(buffer_ring_, buffer_ring_size_);
+    }
+    if (sqes_ != nullptr) munmap(sqes_, sqes_size_);
+    if (cq_ptr_ != nullptr) munmap(cq_ptr_, cq_size_);
+    if (sq_ptr_ != nullptr) munmap(sq_ptr_, sq_size_);
+    if (ring_fd_ >= 0) close(ring_fd_);
+}
+
+bool IoUring::IsSupported()
+{
+    // multishot recv需要6.0以上的内核
+    struct utsname name;
+    int major = 0;
+    int minor = 0;
+    if (uname(&name) != 0 || sscanf(name.release, "%d.%d", &major, &minor) != 2 || major < 6)
+    {
+        return false;
+    }
+
+    IoUring ring;
+    return ring.Initialize(4) == 0 && ring.RegisterBufferRing(0, 1, 64) == 0;
+}
+
+int IoUring::Initialize(uint32_t entries)
+{
+    struct io_uring_params params;
+    memset(&params, 0, sizeof(params));
+    // 完成队列加大, 避免multishot recv的完成事件溢出.
+    // 不用SINGLE_ISSUER, 服务端在主线程创建、在IO线程提交
+    params.flags = IORING_SETUP_CQSIZE | IORING_SETUP_COOP_TASKRUN;
+    params.cq_entries = entries * 4;
+    ring_fd_ = IoUringSetup(entries, &params);
+    if (ring_fd_ < 0 && errno == EINVAL)
+    {
+        // 5.19之前的内核不支持COOP_TASKRUN
+        params.flags = IORING_SETUP_CQSIZE;
+        ring_fd_ = IoUringSetup(entries, &params);
+    }
+    if (ring_fd_ < 0)
+    {
+        return -errno;
+    }
+
+    sq_size_ = params.sq_off.array + params.sq_entries * sizeof(uint32_t);
+    cq_size_ = params.cq_off.cqes + params.cq_entries * sizeof(struct io_uring_cqe);
+    bool single_mmap = (params.features & IORING_FEAT_SINGLE_MMAP) != 0;
+    if (single_mmap && cq_size_ > sq_size_)
+    {
+        sq_size_ = cq_size_;
+    }
+
+    sq_ptr_ = mmap(nullptr, sq_size_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring_fd_, IORING_OFF_SQ_RING);
+    if (sq_ptr_ == MAP_FAILED)
+    {
+        sq_ptr_ = nullptr;
+        return -errno;
+    }
+
+    void* cq_ptr = sq_ptr_;
+    if (!single_mmap)
+    {
+        cq_ptr_ = mmap(nullptr, cq_size_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring_fd_, IORING_OFF_CQ_RING);
+        if (cq_ptr_ == MAP_FAILED)
+        {
+            cq_ptr_ = nullptr;
+            return -errno;
+        }
+        cq_ptr = cq_ptr_;
+    }
+
+    sqes_size_ = params.sq_entries * sizeof(struct io_uring_sqe);
+    void* sqes = mmap(nullptr, sqes_size_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring_fd_, IORING_OFF_SQES);
+    if (sqes == MAP_FAILED)
+    {
+        return -errno;
+    }
+    sqes_ = (struct io_uring_sqe*)sqes;
+
+    char* sq = (char*)sq_ptr_;
+    sq_head_ = (uint32_t*)(sq + params.sq_off.head);
+    sq_tail_ = (uint32_t*)(sq + params.sq_off.tail);
+    sq_mask_ = *(uint32_t*)(sq + params.sq_off.ring_mask);
+    sq_entries_ = *(uint32_t*)(sq + params.sq_off.ring_entries);
+    sq_array_ = (uint32_t*)(sq + params.sq_off.array);
+
+    char* cq = (char*)cq_ptr;
+    cq_head_ = (uint32_t*)(cq + params.cq_off.head);
+    cq_tail_ = (uint32_t*)(cq + params.cq_off.tail);
+    cq_mask_ = *(uint32_t*)(cq + params.cq_off.ring_mask);
+    cqes_ = (struct io_uring_cqe*)(cq + params.cq_off.cqes);
+    return 0;
+}
+
+int IoUring::RegisterBufferRing(uint16_t group_id, uint32_t buffer_num, uint32_t buffer_size)
+{
+    if (buffer_num == 0 || (buffer_num & (buffer_num - 1)) != 0 || buffer_num > 32768 || buffer_ring_ != nullptr)
+    {
+        return -EINVAL;
+    }
+
+    buffer_ring_size_ = buffer_num * sizeof(struct io_uring_buf);
+    void* ring = mmap(nullptr, buffer_ring_size_, PROT_READ | PROT_WRITE, MAP_ANONYMOUS | MAP_PRIVATE, -1, 0);
+    if (ring == MAP_FAILED)
+    {
+        return -errno;
+    }
+
+    struct io_uring_buf_reg reg;
+    memset(&reg, 0, sizeof(reg));
+    reg.ring_addr = (uint64_t)(uintptr_t)ring;
+    reg.ring_entries = buffer_num;
+    reg.bgid = group_id;
+    if (IoUringRegister(ring_fd_, IORING_REGISTER_PBUF_RING, &reg, 1) != 0)
+    {
+        int error = errno;
+        munmap(ring, buffer_ring_size_);
+        return -error;
+    }
+
+    buffer_ring_ = (struct io_uring_buf_ring*)ring;
+    buffer_group_id_ = group_id;
+    buffer_num_ = buffer_num;
+    buffer_size_ = buffer_size;
+    buffers_.resize((size_t)buffer_num * buffer_size);
+    for (uint32_t i = 0; i < buffer_num; ++i)
+    {
+        RecycleBuffer(i);
+    }
+    return 0;
+}
+
+char* IoUring::GetBuffer(uint16_t buffer_id)
+{
+    return buffers_.data() + (size_t)buffer_id * buffer_size_;
+}
+
+void IoUring::RecycleBuffer(uint16_t buffer_id)
+{
+    // 内核头文件的__DECLARE_FLEX_ARRAY在C++下会让bufs偏移8字节, 直接按数组访问
+    struct io_uring_buf* buf = (struct io_uring_buf*)buffer_ring_ + (buffer_tail_ & (buffer_num_ - 1));
+    buf->addr = (uint64_t)(uintptr_t)GetBuffer(buffer_id);
+    buf->len = buffer_size_;
+    buf->bid = buffer_id;
+    ++buffer_tail_;
+    PublishBuffers();
+}
+
+void IoUring::PublishBuffers()
+{
+    // tail与第一个缓冲区的resv字段重叠
+    uint16_t* tail = &((struct io_uring_buf*)buffer_ring_)->resv;
+    std::atomic_ref<uint16_t>(*tail).store(buffer_tail_, std::memory_order_release);
+}
+
+struct io_uring_sqe* IoUring::GetSqe()
+{
+    if (sqe_tail_ - LoadAcquire(sq_head_) >= sq_entries_)
+    {
+        Submit();
+        if (sqe_tail_ - LoadAcquire(sq_head_) >= sq_entries_)
+        {
+            return nullptr;
+        }
+    }
+
+    struct io_uring_sqe* sqe = &sqes_[sqe_tail_ & sq_mask_];
+    ++sqe_tail_;
+    memset(sqe, 0, sizeof(*sqe));
+    return sqe;
+}
+
+void IoUring::FlushSq()
+{
+    uint32_t tail = *sq_tail_;
+    while (sqe_head_ != sqe_tail_)
+    {
+        sq_array_[tail & sq_mask_] = sqe_head_ & sq_mask_;
+        ++tail;
+        ++sqe_head_;
+    }
+    StoreRelease(sq_tail_, tail);
+}
+
+int IoUring::Submit(uint32_t wait_nr/* = 0*/, int64_t timeout_ms/* = -1*/)
+{
+    uint32_t to_submit = sqe_tail_ - sqe_head_;
+    FlushSq();
+
+    uint32_t flags = wait_nr > 0 ? IORING_ENTER_GETEVENTS : 0;
+    struct __kernel_timespec ts;
+    struct io_uring_getevents_arg arg;
+    const void* enter_arg = nullptr;
+    size_t enter_arg_size = 0;
+    if (wait_nr > 0 && timeout_ms >= 0)
+    {
+        ts.tv_sec = timeout_ms / 1000;
+        ts.tv_nsec = (timeout_ms % 1000) * 1000000;
+        memset(&arg, 0, sizeof(arg));
+        arg.ts = (uint64_t)(uintptr_t)&ts;
+        flags |= IORING_ENTER_EXT_ARG;
+        enter_arg = &arg;
+        enter_arg_size = sizeof(arg);
+    }
+
+    int ret = IoUringEnter(ring_fd_, to_submit, wait_nr, flags, enter_arg, enter_arg_size);
+    return ret < 0 ? -errno : ret;
+}
+
+uint32_t IoUring::PeekCqes(struct io_uring_cqe** cqes, uint32_t max_num)
+{
+    uint32_t head = *cq_head_;
+    uint32_t tail = LoadAcquire(cq_tail_);
+    uint32_t num = 0;
+    for (; head != tail && num < max_num; ++head, ++num)
+    {
+        cqes[num] = &cqes_[head & cq_mask_];
+    }
+    return num;
+}
+
+void IoUring::AdvanceCq(uint32_t num)
+{
+    StoreRelease(cq_head_, *cq_head_ + num);
+}
+
+}
@@ -0,0 +1,88 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include <mrpc/util/noncopyable.h>
+
+struct io_uring_sqe;
+struct io_uring_cqe;
+struct io_uring_buf_ring;
+
+namespace mrpc
+{
+
+// io_uring的最小封装, 直接使用系统调用, 不依赖liburing(仅Linux).
+// 包括提交队列、完成队列和一组provided buffer ring(由内核在recv时选择缓冲区).
+// 非线程安全, 只能由一个线程使用.
+class IoUring final : private NonCopyable
+{
+public:
+    IoUring() = default;
+    ~IoUring();
+
+    // 内核是否支持本类用到的全部特性(multishot accept/recv和provided buffer ring).
+    static bool IsSupported();
+
+    // 成功返回0, 失败返回-errno.
+    int Initialize(uint32_t entries);
+    // 注册buffer_num(2的幂)个buffer_size字节的缓冲区, 编号为group_id.
+    int RegisterBufferRing(uint16_t group_id, uint32_t buffer_num, uint32_t buffer_size);
+
+    // 返回已清零的sqe, 提交队列满时先提交已有的sqe.
+    struct io_uring_sqe* GetSqe();
+    // 提交所有sqe, wait_nr大于0时等待至少wait_nr个完成事件, 最多等待timeout_ms毫秒(小于0不限时).
+    // 返回提交的sqe个数, 失败返回-errno(超时为-ETIME, 被信号打断为-EINTR).
+    int Submit(uint32_t wait_nr = 0, int64_t timeout_ms = -1);
+
+    // 取出当前所有的完成事件, 处理完之后调用AdvanceCq.
+    uint32_t PeekCqes(struct io_uring_cqe** cqes, uint32_t max_num);
+    void AdvanceCq(uint32_t num);
+
+    // 有完成事件时可读, 可以交给其它事件循环监视.
+    inline int GetFd() const { return ring_fd_; }
+    inline uint16_t GetBufferGroupId() const { return buffer_group_id_; }
+    inline uint32_t GetBufferSize() const { return buffer_size_; }
+    char* GetBuffer(uint16_t buffer_id);
+    // 把用完的缓冲区还给内核.
+    void RecycleBuffer(uint16_t buffer_id);
+
+private:
+    void FlushSq();
+    void PublishBuffers();
+
+    int ring_fd_ = -1;
+
+    // 提交队列
+    void* sq_ptr_ = nullptr;
+    size_t sq_size_ = 0;
+    uint32_t* sq_head_ = nullptr;
+    uint32_t* sq_tail_ = nullptr;
+    uint32_t sq_mask_ = 0;
+    uint32_t sq_entries_ = 0;
+    uint32_t* sq_array_ = nullptr;
+    struct io_uring_sqe* sqes_ = nullptr;
+    size_t sqes_size_ = 0;
+    uint32_t sqe_head_ = 0;     // 已经放入sq_array_
+    uint32_t sqe_tail_ = 0;     // 已经分配给调用方
+
+    // 完成队列, 与提交队列共享一次mmap时cq_ptr_为空
+    void* cq_ptr_ = nullptr;
+    size_t cq_size_ = 0;
+    uint32_t* cq_head_ = nullptr;
+    uint32_t* cq_tail_ = nullptr;
+    uint32_t cq_mask_ = 0;
+    struct io_uring_cqe* cqes_ = nullptr;
+
+    // provided buffer ring
+    struct io_uring_buf_ring* buffer_ring_ = nullptr;
+    size_t buffer_ring_size_ = 0;
+    uint16_t buffer_group_id_ = 0;
+    uint32_t buffer_num_ = 0;
+    uint32_t buffer_size_ = 0;
+    uint16_t buffer_tail_ = 0;
+    std::vector<char> buffers_;
+};
+
+}
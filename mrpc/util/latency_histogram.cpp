@@ -0,0 +1,87 @@
+#include <algorithm>
+#include <bit>
+
+#include <mrpc/util/latency_histogram.h>
+
+namespace mrpc
+{
+
+void LatencyHistogram::Add(uint64_t latency)
+{
+    buckets_[GetBucketIndex(latency)].fetch_add(1, std::memory_order_relaxed);
+    if (total_.fetch_add(1, std::memory_order_relaxed) + 1 >= kMaxSamples)
+    {
+        Decay();
+    }
+}
+
+uint64_t LatencyHistogram::GetPercentile(uint32_t percentile) const
+{
+    uint64_t total = 0;
+    uint32_t counts[kBucketNum];
+    for (uint32_t i = 0; i < kBucketNum; ++i)
+    {
+        counts[i] = buckets_[i].load(std::memory_order_relaxed);
+        total += counts[i];
+    }
+    if (total < kMinSamples)
+    {
+        return 0;
+    }
+
+    uint64_t rank = (total * std::min<uint32_t>(percentile, 100) + 99) / 100;
+    uint64_t count = 0;
+    for (uint32_t i = 0; i < kBucketNum; ++i)
+    {
+        count += counts[i];
+        if (count >= rank && count > 0)
+        {
+            return GetBucketUpperBound(i);
+        }
+    }
+    return GetBucketUpperBound(kBucketNum - 1);
+}
+
+// 0~3各占一个桶, 之后每个区间[2^e, 2^(e+1))按次高两位分成4个桶
+uint32_t LatencyHistogram::GetBucketIndex(uint64_t latency)
+{
+    latency = std::min<uint64_t>(latency, UINT32_MAX);
+    if (latency < 4)
+    {
+        return (uint32_t)latency;
+    }
+    uint32_t exponent = std::bit_width(latency) - 1;
+    uint32_t sub = (latency >> (exponent - 2)) & 3;
+    return (exponent - 1) * 4 + sub;
+}
+
+uint64_t LatencyHistogram::GetBucketUpperBound(uint32_t index)
+{
+    if (index < 4)
+    {
+        return index;
+    }
+    uint32_t exponent = index / 4 + 1;
+    uint64_t width = 1ull << (exponent - 2);
+    return (4 + index % 4) * width + width - 1;
+}
+
+void LatencyHistogram::Decay()
+{
+    if (decaying_.exchange(true, std::memory_order_acquire))
+    {
+        return;
+    }
+
+    uint32_t total = 0;
+    for (auto& bucket : buckets_)
+    {
+        uint32_t count = bucket.load(std::memory_order_relaxed) / 2;
+        bucket.store(count, std::memory_order_relaxed);
+        total += count;
+    }
+    total_.store(total, std::memory_order_relaxed);
+    decaying_.store(false, std::memory_order_release);
+}
+
+}
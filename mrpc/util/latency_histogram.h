@@ -0,0 +1,41 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+
+#include <mrpc/util/noncopyable.h>
+
+namespace mrpc
+{
+
+// 耗时(微秒)的对数分桶直方图, 每个2的幂区间分4个桶, 相对误差不超过25%.
+// 样本数达到上限时所有桶减半, 使分位数跟随最近的耗时变化.
+// Add可以在多个线程中并发调用, 减半期间允许丢失个别样本.
+class LatencyHistogram final : private NonCopyable
+{
+public:
+    static constexpr uint32_t kBucketNum = 128;
+    static constexpr uint32_t kMinSamples = 32;     // 样本数不足时GetPercentile返回0
+    static constexpr uint32_t kMaxSamples = 8192;
+
+    LatencyHistogram() = default;
+    ~LatencyHistogram() = default;
+
+    void Add(uint64_t latency);
+    // percentile取值(0, 100], 返回所在桶的上界
+    uint64_t GetPercentile(uint32_t percentile) const;
+
+    inline uint32_t GetSampleNum() const { return total_.load(std::memory_order_relaxed); }
+
+private:
+    static uint32_t GetBucketIndex(uint64_t latency);
+    static uint64_t GetBucketUpperBound(uint32_t index);
+
+    void Decay();
+
+    std::atomic<uint32_t> buckets_[kBucketNum] = {};
+    std::atomic<uint32_t> total_ = 0;
+    std::atomic<bool> decaying_ = false;
+};
+
+}
@@ -0,0 +1,288 @@
+#include <algorithm>
+#include <cassert>
+#include <random>
+
+#include <mrpc/util/load_balancer.h>
+
+namespace mrpc
+{
+
+static std::minstd_rand& GetThreadRandom()
+{
+    thread_local std::minstd_rand random(std::random_device{}());
+    return random;
+}
+
+// 打散相近的输入: thread_hash_code往往是连续的小整数, 虚拟节点名也只差最后几个字符
+static uint32_t MixHashCode(uint32_t hash)
+{
+    hash ^= hash >> 16;
+    hash *= 0x85ebca6bu;
+    hash ^= hash >> 13;
+    hash *= 0xc2b2ae35u;
+    hash ^= hash >> 16;
+    return hash;
+}
+
+// FNV-1a, 各进程中结果相同, 同一个key在所有客户端上映射到哈希环的同一位置
+static uint32_t HashString(std::string_view str)
+{
+    uint32_t hash = 2166136261u;
+    for (char c : str)
+    {
+        hash ^= (uint8_t)c;
+        hash *= 16777619u;
+    }
+    return MixHashCode(hash);
+}
+
+class RoundRobinLoadBalancer final : public LoadBalancer
+{
+public:
+    using LoadBalancer::LoadBalancer;
+
+    uint32_t Select(bool has_hash_code, uint32_t hash_code) override
+    {
+        (void)has_hash_code;
+        (void)hash_code;
+        return NextRoundRobin();
+    }
+};
+
+// 按权重随机, 失败率高的后端权重降低
+class WeightedLoadBalancer final : public LoadBalancer
+{
+public:
+    using LoadBalancer::LoadBalancer;
+
+    uint32_t Select(bool has_hash_code, uint32_t hash_code) override
+    {
+        (void)has_hash_code;
+        (void)hash_code;
+        uint64_t total = 0;
+        for (uint32_t i = 0; i < backends_.size(); ++i)
+        {
+            total += GetEffectiveWeight(i);
+        }
+
+        uint64_t point = GetThreadRandom()() % total;
+        for (uint32_t i = 0; i < backends_.size(); ++i)
+        {
+            uint64_t weight = GetEffectiveWeight(i);
+            if (point < weight)
+            {
+                return i;
+            }
+            point -= weight;
+        }
+        // 并发更新失败率时两次计算的权重可能不同
+        return (uint32_t)backends_.size() - 1;
+    }
+
+private:
+    uint64_t GetEffectiveWeight(uint32_t index) const
+    {
+        return std::max<uint64_t>((uint64_t)backends_[index].weight * GetHealth(index) / kErrorRateScale, 1);
+    }
+};
+
+// 未完成请求最少, 从轮询位置开始查找, 相同时不总是选中第一个
+class LeastPendingLoadBalancer final : public LoadBalancer
+{
+public:
+    using LoadBalancer::LoadBalancer;
+
+    uint32_t Select(bool has_hash_code, uint32_t hash_code) override
+    {
+        (void)has_hash_code;
+        (void)hash_code;
+        uint32_t start = NextRoundRobin();
+        uint32_t best = start;
+        uint64_t best_cost = GetCost(start);
+        for (uint32_t i = 1; i < backends_.size(); ++i)
+        {
+            uint32_t index = (start + i) % backends_.size();
+            uint64_t cost = GetCost(index);
+            if (cost < best_cost)
+            {
+                best = index;
+                best_cost = cost;
+            }
+        }
+        return best;
+    }
+
+private:
+    uint64_t GetCost(uint32_t index) const
+    {
+        uint64_t pending = backends_[index].pending.load(std::memory_order_relaxed);
+        return (pending + 1) * kErrorRateScale / GetHealth(index);
+    }
+};
+
+// 随机取两个后端, 选择(未完成请求数 * 平均耗时)较小的一个
+class PowerOfTwoChoicesLoadBalancer final : public LoadBalancer
+{
+public:
+    using LoadBalancer::LoadBalancer;
+
+    uint32_t Select(bool has_hash_code, uint32_t hash_code) override
+    {
+        (void)has_hash_code;
+        (void)hash_code;
+        uint32_t size = (uint32_t)backends_.size();
+        if (size == 1)
+        {
+            return 0;
+        }
+
+        std::minstd_rand& random = GetThreadRandom();
+        uint32_t a = random() % size;
+        uint32_t b = (a + 1 + random() % (size - 1)) % size;
+        return GetCost(a) <= GetCost(b) ? a : b;
+    }
+
+private:
+    uint64_t GetCost(uint32_t index) const
+    {
+        // 还没有耗时样本的后端按最快处理, 尽快得到样本
+        uint64_t pending = backends_[index].pending.load(std::memory_order_relaxed);
+        uint64_t latency = backends_[index].latency.load(std::memory_order_relaxed);
+        return (pending + 1) * (latency + 1) * kErrorRateScale / GetHealth(index);
+    }
+};
+
+// 按thread_hash_code在哈希环上查找, 每个后端按权重放置虚拟节点; 增删后端时只有少量key改变映射.
+// 选中的后端失败率过半时顺着哈希环使用下一个后端.
+class ConsistentHashLoadBalancer final : public LoadBalancer
+{
+public:
+    explicit ConsistentHashLoadBalancer(const std::vector<std::pair<std::string, uint32_t>>& backends) : LoadBalancer(backends)
+    {
+        for (uint32_t i = 0; i < backends_.size(); ++i)
+        {
+            uint32_t replicas = std::min<uint32_t>(backends_[i].weight, kMaxReplicas);
+            for (uint32_t r = 0; r < replicas; ++r)
+            {
+                ring_.emplace_back(HashString(backends_[i].key + "#" + std::to_string(r)), i);
+            }
+        }
+        std::sort(ring_.begin(), ring_.end());
+    }
+
+    uint32_t Select(bool has_hash_code, uint32_t hash_code) override
+    {
+        if (!has_hash_code)
+        {
+            return NextRoundRobin();
+        }
+
+        auto it = std::lower_bound(ring_.begin(), ring_.end(), std::make_pair(MixHashCode(hash_code), 0u));
+        size_t pos = (it - ring_.begin()) % ring_.size();
+        for (size_t i = 0; i < ring_.size(); ++i)
+        {
+            uint32_t index = ring_[(pos + i) % ring_.size()].second;
+            if (backends_[index].error_rate.load(std::memory_order_relaxed) <= kErrorRateScale / 2)
+            {
+                return index;
+            }
+        }
+        return ring_[pos].second;
+    }
+
+private:
+    static constexpr uint32_t kMaxReplicas = 1000;
+
+    std::vector<std::pair<uint32_t, uint32_t>> ring_;   // (哈希值, 后端下标)
+};
+
+std::unique_ptr<LoadBalancer> LoadBalancer::Create(LoadBalancePolicy policy, const std::vector<std::pair<std::string, uint32_t>>& backends)
+{
+    assert(!backends.empty());
+    switch (policy)
+    {
+    case LB_LEAST_PENDING:
+        return std::unique_ptr<LoadBalancer>(new LeastPendingLoadBalancer(backends));
+    case LB_WEIGHTED:
+        return std::unique_ptr<LoadBalancer>(new WeightedLoadBalancer(backends));
+    case LB_POWER_OF_TWO_CHOICES:
+        return std::unique_ptr<LoadBalancer>(new PowerOfTwoChoicesLoadBalancer(backends));
+    case LB_CONSISTENT_HASH:
+        return std::unique_ptr<LoadBalancer>(new ConsistentHashLoadBalancer(backends));
+    default:
+        return std::unique_ptr<LoadBalancer>(new RoundRobinLoadBalancer(backends));
+    }
+}
+
+LoadBalancer::LoadBalancer(const std::vector<std::pair<std::string, uint32_t>>& backends) : backends_(backends.size())
+{
+    for (size_t i = 0; i < backends.size(); ++i)
+    {
+        backends_[i].key = backends[i].first;
+        backends_[i].weight = std::max<uint32_t>(backends[i].second, 1);
+    }
+}
+
+uint32_t LoadBalancer::SelectOther(uint32_t index) const
+{
+    uint32_t size = (uint32_t)backends_.size();
+    uint32_t best = index;
+    uint64_t best_cost = UINT64_MAX;
+    for (uint32_t i = 1; i < size; ++i)
+    {
+        uint32_t other = (index + i) % size;
+        uint64_t pending = backends_[other].pending.load(std::memory_order_relaxed);
+        uint64_t cost = (pending + 1) * kErrorRateScale / GetHealth(other);
+        if (cost < best_cost)
+        {
+            best = other;
+            best_cost = cost;
+        }
+    }
+    return best;
+}
+
+void LoadBalancer::OnRequestStart(uint32_t index)
+{
+    backends_[index].pending.fetch_add(1, std::memory_order_relaxed);
+}
+
+void LoadBalancer::OnRequestDone(uint32_t index, bool success, uint64_t latency)
+{
+    Backend& backend = backends_[index];
+    backend.pending.fetch_sub(1, std::memory_order_relaxed);
+
+    // 权重为1/8的指数移动平均
+    if (latency > 0)
+    {
+        int64_t sample = (int64_t)std::min<uint64_t>(latency, UINT32_MAX);
+        int64_t average = backend.latency.load(std::memory_order_relaxed);
+        average = average == 0 ? sample : average + (sample - average) / 8;
+        backend.latency.store((uint32_t)std::max<int64_t>(average, 1), std::memory_order_relaxed);
+    }
+
+    uint32_t target = success ? 0 : kErrorRateScale;
+    uint32_t error_rate = backend.error_rate.load(std::memory_order_relaxed);
+    if (target > error_rate)
+    {
+        error_rate += (target - error_rate + 7) / 8;
+    }
+    else
+    {
+        error_rate -= (error_rate - target + 7) / 8;
+    }
+    backend.error_rate.store(error_rate, std::memory_order_relaxed);
+}
+
+uint32_t LoadBalancer::GetHealth(uint32_t index) const
+{
+    uint32_t error_rate = backends_[index].error_rate.load(std::memory_order_relaxed);
+    return std::max(kErrorRateScale - std::min(error_rate, kErrorRateScale), kErrorRateScale / 16);
+}
+
+uint32_t LoadBalancer::NextRoundRobin()
+{
+    return next_.fetch_add(1, std::memory_order_relaxed) % backends_.size();
+}
+
+}
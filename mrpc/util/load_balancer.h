@@ -0,0 +1,71 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <mrpc/util/noncopyable.h>
+
+namespace mrpc
+{
+
+// 取值与application_config.proto中的LoadBalanceConfig相同
+enum LoadBalancePolicy : int32_t
+{
+    LB_ROUND_ROBIN = 1,
+    LB_LEAST_PENDING = 2,
+    LB_WEIGHTED = 3,
+    LB_POWER_OF_TWO_CHOICES = 4,
+    LB_CONSISTENT_HASH = 5,
+};
+
+// 在同一服务的多个后端(地址)之间选择.
+// Select在发起调用的线程中调用, OnRequestStart/OnRequestDone的反馈一般来自客户端IO线程,
+// 统计数据都是原子变量, 并发更新时允许丢失个别样本.
+class LoadBalancer : private NonCopyable
+{
+public:
+    struct Backend
+    {
+        std::string key;                        // 一致性哈希的节点名, 一般为地址
+        uint32_t weight = 1;
+        std::atomic<uint32_t> pending = 0;      // 已选中还没有完成的请求数
+        std::atomic<uint32_t> latency = 0;      // 耗时(微秒)的指数移动平均, 0表示还没有样本
+        std::atomic<uint32_t> error_rate = 0;   // 失败率的指数移动平均, 满值为kErrorRateScale
+    };
+
+    static constexpr uint32_t kErrorRateScale = 1024;
+
+    // backends为(key, weight), weight为0时按1处理. 不认识的policy按轮询处理.
+    static std::unique_ptr<LoadBalancer> Create(LoadBalancePolicy policy, const std::vector<std::pair<std::string, uint32_t>>& backends);
+
+    explicit LoadBalancer(const std::vector<std::pair<std::string, uint32_t>>& backends);
+    virtual ~LoadBalancer() = default;
+
+    // 返回后端的下标. hash_code只用于一致性哈希, 没有时退化为轮询.
+    virtual uint32_t Select(bool has_hash_code, uint32_t hash_code) = 0;
+
+    // 对冲和重试使用, 选择index之外未完成请求最少且健康的后端, 不影响Select的轮询位置.
+    // 只有一个后端时返回index.
+    uint32_t SelectOther(uint32_t index) const;
+
+    void OnRequestStart(uint32_t index);
+    // success表示后端正常处理了请求(业务错误也算成功), latency为0时不记录耗时.
+    void OnRequestDone(uint32_t index, bool success, uint64_t latency);
+
+    inline size_t GetBackendNum() const { return backends_.size(); }
+    inline const Backend& GetBackend(uint32_t index) const { return backends_[index]; }
+
+protected:
+    // 失败率越高越小, 最小为kErrorRateScale / 16, 保证失败的后端仍有少量请求用于探测恢复
+    uint32_t GetHealth(uint32_t index) const;
+    uint32_t NextRoundRobin();
+
+    std::vector<Backend> backends_;
+    std::atomic<uint32_t> next_ = 0;
+};
+
+}
@@ -0,0 +1,114 @@
+#pragma once
+
+#include <atomic>
+#include <utility>
+
+#include <mrpc/util/noncopyable.h>
+
+namespace mrpc
+{
+
+// 无锁的多生产者单消费者队列, 用于worker线程向IO线程提交请求和回包.
+// 生产者用CAS压入一个栈, 消费者一次取走整个栈并反转为入队顺序, 生产者之间只竞争一个原子指针.
+// Push返回true表示队列从空变为非空, 只有这时才需要唤醒消费者, 同一批元素只唤醒一次;
+// 因此消费者被唤醒后必须一直TryPop到返回false.
+template<typename T>
+class MpscQueue final : private NonCopyable
+{
+public:
+    MpscQueue() = default;
+
+    ~MpscQueue()
+    {
+        DeleteList(head_.load(std::memory_order_acquire));
+        DeleteList(batch_);
+    }
+
+    // 任意线程调用.
+    bool Push(T value)
+    {
+        Node* node = new Node{ std::move(value), nullptr };
+        Node* head = head_.load(std::memory_order_relaxed);
+        do
+        {
+            node->next = head;
+        } while (!head_.compare_exchange_weak(head, node, std::memory_order_release, std::memory_order_relaxed));
+        return head == nullptr;
+    }
+
+    // 任意线程调用. 先在本地串成链表再一次CAS压入, 出队顺序与[first, last)相同, 返回值同Push.
+    template<typename Iterator>
+    bool PushBatch(Iterator first, Iterator last)
+    {
+        if (first == last)
+        {
+            return false;
+        }
+
+        Node* top = nullptr;
+        Node* bottom = nullptr;
+        for (; first != last; ++first)
+        {
+            top = new Node{ *first, top };
+            if (bottom == nullptr)
+            {
+                bottom = top;
+            }
+        }
+
+        Node* head = head_.load(std::memory_order_relaxed);
+        do
+        {
+            bottom->next = head;
+        } while (!head_.compare_exchange_weak(head, top, std::memory_order_release, std::memory_order_relaxed));
+        return head == nullptr;
+    }
+
+    // 只能由消费者线程调用, 按入队顺序取出.
+    bool TryPop(T& value)
+    {
+        if (batch_ == nullptr)
+        {
+            Node* node = head_.exchange(nullptr, std::memory_order_acquire);
+            while (node != nullptr)
+            {
+                Node* next = node->next;
+                node->next = batch_;
+                batch_ = node;
+                node = next;
+            }
+            if (batch_ == nullptr)
+            {
+                return false;
+            }
+        }
+
+        Node* node = batch_;
+        batch_ = node->next;
+        value = std::move(node->value);
+        delete node;
+        return true;
+    }
+
+private:
+    struct Node
+    {
+        T value;
+        Node* next = nullptr;
+    };
+
+    static void DeleteList(Node* node)
+    {
+        while (node != nullptr)
+        {
+            Node* next = node->next;
+            delete node;
+            node = next;
+        }
+    }
+
+    std::atomic<Node*> head_ = nullptr;     // 生产者压入的栈, 最新的在前
+    Node* batch_ = nullptr;                 // 消费者已经取出的一批, 按入队顺序
+};
+
+}
@@ -0,0 +1,37 @@
+#include <algorithm>
+
+#include <mrpc/util/retry_budget.h>
+
+namespace mrpc
+{
+
+RetryBudget::RetryBudget(uint32_t ratio, uint32_t max_tokens) :
+    ratio_(std::min<uint32_t>(ratio, kTokenCost)),
+    max_balance_(std::max<uint32_t>(max_tokens, 1) * kTokenCost),
+    balance_(max_balance_)
+{
+}
+
+void RetryBudget::OnRequest()
+{
+    uint32_t balance = balance_.load(std::memory_order_relaxed);
+    while (balance < max_balance_
+            && !balance_.compare_exchange_weak(balance, std::min(balance + ratio_, max_balance_), std::memory_order_relaxed))
+    {
+    }
+}
+
+bool RetryBudget::TryAcquire()
+{
+    uint32_t balance = balance_.load(std::memory_order_relaxed);
+    while (balance >= kTokenCost)
+    {
+        if (balance_.compare_exchange_weak(balance, balance - kTokenCost, std::memory_order_relaxed))
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+}
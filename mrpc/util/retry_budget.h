@@ -0,0 +1,36 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+
+#include <mrpc/util/noncopyable.h>
+
+namespace mrpc
+{
+
+// 重试(对冲)预算的令牌桶: 每个请求存入ratio%个令牌, 每次重试消耗一个令牌,
+// 重试数不超过请求数的ratio%, 后端整体变慢或故障时不会因重试放大流量.
+// 令牌最多积累max_tokens个, 初始为满.
+class RetryBudget final : private NonCopyable
+{
+public:
+    static constexpr uint32_t kDefaultMaxTokens = 10;
+
+    explicit RetryBudget(uint32_t ratio, uint32_t max_tokens = kDefaultMaxTokens);
+    ~RetryBudget() = default;
+
+    void OnRequest();
+    bool TryAcquire();
+
+    // 单位为1/100个令牌
+    inline uint32_t GetBalance() const { return balance_.load(std::memory_order_relaxed); }
+
+private:
+    static constexpr uint32_t kTokenCost = 100;
+
+    const uint32_t ratio_;
+    const uint32_t max_balance_;
+    std::atomic<uint32_t> balance_;
+};
+
+}
@@ -0,0 +1,74 @@
+#include <algorithm>
+#include <climits>
+#include <cstring>
+
+#include <mrpc/util/sendmsg_buffer.h>
+
+namespace mrpc
+{
+
+void SendmsgBuffer::Append(std::string&& data)
+{
+    bytes_ += data.length();
+    pending_.push_back(std::move(data));
+}
+
+bool SendmsgBuffer::Prepare()
+{
+    if (pending_.empty() || !sending_.empty())
+    {
+        return false;
+    }
+
+    sending_.swap(pending_);
+    iovs_.reserve(sending_.size());
+    for (auto& data : sending_)
+    {
+        iovs_.push_back({ data.data(), data.length() });
+    }
+    iov_index_ = 0;
+    UpdateMsg();
+    return true;
+}
+
+bool SendmsgBuffer::Advance(size_t written)
+{
+    bytes_ -= written;
+    while (iov_index_ < iovs_.size() && written >= iovs_[iov_index_].iov_len)
+    {
+        written -= iovs_[iov_index_].iov_len;
+        ++iov_index_;
+    }
+    if (iov_index_ < iovs_.size())
+    {
+        struct iovec& iov = iovs_[iov_index_];
+        iov.iov_base = (char*)iov.iov_base + written;
+        iov.iov_len -= written;
+        UpdateMsg();
+        return true;
+    }
+
+    sending_.clear();
+    iovs_.clear();
+    iov_index_ = 0;
+    return false;
+}
+
+void SendmsgBuffer::Clear()
+{
+    pending_.clear();
+    sending_.clear();
+    bytes_ = 0;
+    iovs_.clear();
+    iov_index_ = 0;
+}
+
+void SendmsgBuffer::UpdateMsg()
+{
+    // 一次最多IOV_MAX个iovec, 剩下的在Advance之后继续发送
+    memset(&msg_, 0, sizeof(msg_));
+    msg_.msg_iov = iovs_.data() + iov_index_;
+    msg_.msg_iovlen = std::min<size_t>(iovs_.size() - iov_index_, IOV_MAX);
+}
+
+}
@@ -0,0 +1,48 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include <vector>
+#include <sys/socket.h>
+#include <sys/uio.h>
+
+#include <mrpc/util/noncopyable.h>
+
+namespace mrpc
+{
+
+// 一个连接通过异步sendmsg(io_uring)发送的数据.
+// 同一时刻只有一个sendmsg, 发送期间追加的数据合并到下一个sendmsg中, 保证顺序;
+// sendmsg只发送了一部分时从未发送的位置继续.
+class SendmsgBuffer final : private NonCopyable
+{
+public:
+    SendmsgBuffer() = default;
+
+    void Append(std::string&& data);
+
+    // 没有正在发送的数据时, 把追加的数据全部转为正在发送. 返回true时需要用GetMsg提交sendmsg.
+    bool Prepare();
+    // sendmsg发送了written字节. 返回true时还有未发送的部分, 需要再次用GetMsg提交sendmsg.
+    bool Advance(size_t written);
+    // sendmsg的参数, 在sendmsg完成之前不能调用Prepare, Advance和Clear.
+    struct msghdr* GetMsg() { return &msg_; }
+    void Clear();
+
+    inline bool IsSending() const { return !sending_.empty(); }
+    inline bool HasPending() const { return !pending_.empty(); }
+    // 追加之后还没有发送出去的字节数
+    inline size_t GetBytes() const { return bytes_; }
+
+private:
+    void UpdateMsg();
+
+    std::vector<std::string> pending_;  // 等待上一个sendmsg完成
+    std::vector<std::string> sending_;
+    std::vector<struct iovec> iovs_;
+    size_t iov_index_ = 0;
+    size_t bytes_ = 0;
+    struct msghdr msg_;
+};
+
+}
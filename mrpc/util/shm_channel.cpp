@@ -0,0 +1,319 @@
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <cstring>
+#include <new>
+#include <fcntl.h>
+#include <sys/eventfd.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <mrpc/util/input_buffer.h>
+#include <mrpc/util/shm_channel.h>
+
+namespace mrpc
+{
+
+// 生产者和消费者的游标分别独占一个cache line, 避免伪共享.
+// 游标单调递增, 对环大小取模得到偏移.
+struct ShmRingHeader
+{
+    alignas(64) std::atomic<uint64_t> write_pos;
+    std::atomic<uint32_t> writer_waiting;   // 写满后等待对端腾出空间
+    alignas(64) std::atomic<uint64_t> read_pos;
+    std::atomic<uint32_t> reader_waiting;   // 读空后等待对端写入数据
+};
+
+struct ShmSegmentHeader
+{
+    uint32_t magic;
+    uint32_t version;
+    uint64_t ring_size;
+};
+
+static_assert(std::atomic<uint64_t>::is_always_lock_free && std::atomic<uint32_t>::is_always_lock_free,
+        "Atomics in shared memory must be lock free");
+
+static constexpr uint32_t kShmMagic = 0x4d52504d;  // "MRPM"
+static constexpr uint32_t kShmVersion = 1;
+static constexpr size_t kShmFdNum = 3;              // 共享内存段, 服务端eventfd, 客户端eventfd
+
+// 段头和两个环头放在第一页, 之后依次是客户端到服务端、服务端到客户端的环
+static constexpr size_t kShmHeaderSize = 4096;
+static constexpr size_t kShmRingHeaderOffset = 64;
+static_assert(kShmRingHeaderOffset + 2 * sizeof(ShmRingHeader) <= kShmHeaderSize);
+
+static ShmRingHeader* GetRingHeader(void* segment, size_t index)
+{
+    return (ShmRingHeader*)((char*)segment + kShmRingHeaderOffset) + index;
+}
+
+static char* GetRingData(void* segment, size_t ring_size, size_t index)
+{
+    return (char*)segment + kShmHeaderSize + ring_size * index;
+}
+
+ShmChannel::~ShmChannel()
+{
+    if (segment_ != nullptr) munmap(segment_, segment_size_);
+    if (mem_fd_ >= 0) close(mem_fd_);
+    if (event_fd_ >= 0) close(event_fd_);
+    if (peer_event_fd_ >= 0) close(peer_event_fd_);
+}
+
+bool ShmChannel::Create(size_t ring_size)
+{
+    size_t size = kShmHeaderSize;
+    while (size < ring_size)
+    {
+        size <<= 1;
+    }
+
+    int mem_fd = memfd_create("mrpc_shm", MFD_CLOEXEC);
+    if (mem_fd < 0)
+    {
+        return false;
+    }
+    mem_fd_ = mem_fd;
+    if (ftruncate(mem_fd, kShmHeaderSize + 2 * size) != 0 || !Map(mem_fd, kShmHeaderSize + 2 * size))
+    {
+        return false;
+    }
+
+    // ftruncate出的内存已经清零, 只需要初始化非零字段
+    ShmSegmentHeader* header = (ShmSegmentHeader*)segment_;
+    header->magic = kShmMagic;
+    header->version = kShmVersion;
+    header->ring_size = size;
+    ring_size_ = size;
+    for (size_t i = 0; i < 2; ++i)
+    {
+        new (GetRingHeader(segment_, i)) ShmRingHeader();
+        GetRingHeader(segment_, i)->reader_waiting = 1;
+    }
+
+    in_ = GetRingHeader(segment_, 0);
+    out_ = GetRingHeader(segment_, 1);
+    in_data_ = GetRingData(segment_, size, 0);
+    out_data_ = GetRingData(segment_, size, 1);
+
+    event_fd_ = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    peer_event_fd_ = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    return event_fd_ >= 0 && peer_event_fd_ >= 0;
+}
+
+bool ShmChannel::SendTo(int socket_fd) const
+{
+    int fds[kShmFdNum] = { mem_fd_, event_fd_, peer_event_fd_ };
+    char data = 0;
+    struct iovec iov = { &data, sizeof(data) };
+    alignas(struct cmsghdr) char control[CMSG_SPACE(sizeof(fds))];
+    memset(control, 0, sizeof(control));
+
+    struct msghdr msg;
+    memset(&msg, 0, sizeof(msg));
+    msg.msg_iov = &iov;
+    msg.msg_iovlen = 1;
+    msg.msg_control = control;
+    msg.msg_controllen = sizeof(control);
+
+    struct cmsghdr* cmsg = CMSG_FIRSTHDR(&msg);
+    cmsg->cmsg_level = SOL_SOCKET;
+    cmsg->cmsg_type = SCM_RIGHTS;
+    cmsg->cmsg_len = CMSG_LEN(sizeof(fds));
+    memcpy(CMSG_DATA(cmsg), fds, sizeof(fds));
+
+    ssize_t ret = 0;
+    do
+    {
+        ret = sendmsg(socket_fd, &msg, MSG_NOSIGNAL);
+    } while (ret < 0 && errno == EINTR);
+    return ret == sizeof(data);
+}
+
+int ShmChannel::ReceiveFrom(int socket_fd)
+{
+    char data = 0;
+    struct iovec iov = { &data, sizeof(data) };
+    alignas(struct cmsghdr) char control[CMSG_SPACE(sizeof(int) * kShmFdNum)];
+
+    struct msghdr msg;
+    memset(&msg, 0, sizeof(msg));
+    msg.msg_iov = &iov;
+    msg.msg_iovlen = 1;
+    msg.msg_control = control;
+    msg.msg_controllen = sizeof(control);
+
+    ssize_t ret = 0;
+    do
+    {
+        ret = recvmsg(socket_fd, &msg, MSG_CMSG_CLOEXEC);
+    } while (ret < 0 && errno == EINTR);
+    if (ret < 0)
+    {
+        return errno == EWOULDBLOCK ? EAGAIN : errno;
+    }
+    else if (ret == 0)
+    {
+        return ECONNRESET;
+    }
+
+    int fds[kShmFdNum] = { -1, -1, -1 };
+    struct cmsghdr* cmsg = CMSG_FIRSTHDR(&msg);
+    if (cmsg != nullptr && cmsg->cmsg_level == SOL_SOCKET && cmsg->cmsg_type == SCM_RIGHTS)
+    {
+        size_t fd_num = (cmsg->cmsg_len - CMSG_LEN(0)) / sizeof(int);
+        memcpy(fds, CMSG_DATA(cmsg), sizeof(int) * std::min(fd_num, kShmFdNum));
+    }
+
+    // 客户端等待服务端的peer_event_fd_, 服务端等待event_fd_, 收到的顺序与SendTo一致
+    mem_fd_ = fds[0];
+    peer_event_fd_ = fds[1];
+    event_fd_ = fds[2];
+    if (mem_fd_ < 0 || peer_event_fd_ < 0 || event_fd_ < 0 || (msg.msg_flags & MSG_CTRUNC) != 0)
+    {
+        return EPROTO;
+    }
+
+    struct stat st;
+    if (fstat(mem_fd_, &st) != 0)
+    {
+        return errno;
+    }
+    if (st.st_size < (off_t)kShmHeaderSize || !Map(mem_fd_, st.st_size))
+    {
+        return EPROTO;
+    }
+
+    const ShmSegmentHeader* header = (const ShmSegmentHeader*)segment_;
+    if (header->magic != kShmMagic || header->version != kShmVersion
+            || header->ring_size == 0 || kShmHeaderSize + 2 * header->ring_size != segment_size_)
+    {
+        return EPROTO;
+    }
+
+    ring_size_ = header->ring_size;
+    in_ = GetRingHeader(segment_, 1);
+    out_ = GetRingHeader(segment_, 0);
+    in_data_ = GetRingData(segment_, ring_size_, 1);
+    out_data_ = GetRingData(segment_, ring_size_, 0);
+    return 0;
+}
+
+bool ShmChannel::Map(int mem_fd, size_t segment_size)
+{
+    void* segment = mmap(nullptr, segment_size, PROT_READ | PROT_WRITE, MAP_SHARED, mem_fd, 0);
+    if (segment == MAP_FAILED)
+    {
+        return false;
+    }
+
+    segment_ = segment;
+    segment_size_ = segment_size;
+    return true;
+}
+
+void ShmChannel::ClearEvent()
+{
+    uint64_t value = 0;
+    while (read(event_fd_, &value, sizeof(value)) < 0 && errno == EINTR);
+}
+
+void ShmChannel::NotifySelf()
+{
+    Notify(event_fd_);
+}
+
+void ShmChannel::Notify(int event_fd)
+{
+    uint64_t value = 1;
+    while (write(event_fd, &value, sizeof(value)) < 0 && errno == EINTR);
+}
+
+size_t ShmChannel::Write(const char* data, size_t size)
+{
+    size_t written = 0;
+    uint64_t write_pos = out_->write_pos.load(std::memory_order_relaxed);
+    while (written < size)
+    {
+        uint64_t read_pos = out_->read_pos.load(std::memory_order_acquire);
+        size_t free_size = ring_size_ - (write_pos - read_pos);
+        if (free_size == 0)
+        {
+            // 先声明等待再检查一次, 避免对端在两步之间读完数据而漏掉唤醒
+            out_->writer_waiting.store(1, std::memory_order_seq_cst);
+            if (out_->read_pos.load(std::memory_order_seq_cst) == read_pos)
+            {
+                break;
+            }
+            out_->writer_waiting.store(0, std::memory_order_relaxed);
+            continue;
+        }
+
+        size_t length = std::min(free_size, size - written);
+        size_t offset = write_pos & (ring_size_ - 1);
+        size_t first = std::min(length, ring_size_ - offset);
+        memcpy(out_data_ + offset, data + written, first);
+        memcpy(out_data_, data + written + first, length - first);
+        write_pos += length;
+        written += length;
+        out_->write_pos.store(write_pos, std::memory_order_seq_cst);
+    }
+
+    if (written > 0 && out_->reader_waiting.load(std::memory_order_seq_cst) != 0
+            && out_->reader_waiting.exchange(0, std::memory_order_seq_cst) != 0)
+    {
+        Notify(peer_event_fd_);
+    }
+    return written;
+}
+
+size_t ShmChannel::Read(InputBuffer& buffer)
+{
+    size_t total = 0;
+    uint64_t read_pos = in_->read_pos.load(std::memory_order_relaxed);
+    while (true)
+    {
+        uint64_t write_pos = in_->write_pos.load(std::memory_order_acquire);
+        size_t length = write_pos - read_pos;
+        if (length == 0)
+        {
+            // 同Write, 先声明等待再检查一次
+            in_->reader_waiting.store(1, std::memory_order_seq_cst);
+            if (in_->write_pos.load(std::memory_order_seq_cst) == read_pos)
+            {
+                break;
+            }
+            in_->reader_waiting.store(0, std::memory_order_relaxed);
+            continue;
+        }
+
+        buffer.EnsureWritable(length);
+        size_t offset = read_pos & (ring_size_ - 1);
+        size_t first = std::min(length, ring_size_ - offset);
+        memcpy(buffer.GetWritePtr(), in_data_ + offset, first);
+        memcpy(buffer.GetWritePtr() + first, in_data_, length - first);
+        buffer.Commit(length);
+        read_pos += length;
+        total += length;
+        in_->read_pos.store(read_pos, std::memory_order_seq_cst);
+
+        if (in_->writer_waiting.load(std::memory_order_seq_cst) != 0
+                && in_->writer_waiting.exchange(0, std::memory_order_seq_cst) != 0)
+        {
+            Notify(peer_event_fd_);
+        }
+
+        if (total >= ring_size_)
+        {
+            // 对端持续写入时分批处理, 剩下的数据留到下一轮事件循环
+            NotifySelf();
+            break;
+        }
+    }
+    return total;
+}
+
+}
@@ -0,0 +1,63 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#include <mrpc/util/noncopyable.h>
+
+namespace mrpc
+{
+
+class InputBuffer;
+struct ShmRingHeader;
+
+// 同一台机器上两个进程之间的共享内存通道(仅支持Linux).
+// 共享内存段(memfd)中有两个单生产者单消费者的字节环, 分别对应两个方向, 每端各有一个eventfd用于唤醒.
+// 服务端Create后通过Unix domain socket把共享内存段和eventfd发给客户端, 客户端ReceiveFrom后映射同一段内存.
+// 写入方只在读取方表示要等待时才写eventfd, 连续的多个包只需要唤醒一次.
+// 每个对象只能由一个线程使用.
+class ShmChannel final : private NonCopyable
+{
+public:
+    static constexpr size_t kDefaultRingSize = 1024 * 1024;
+
+    ShmChannel() = default;
+    ~ShmChannel();
+
+    // 服务端创建共享内存段和eventfd, ring_size向上取整到2的幂且不小于页大小.
+    bool Create(size_t ring_size);
+    // 服务端通过已连接的Unix domain socket把共享内存段和eventfd发给客户端.
+    bool SendTo(int socket_fd) const;
+    // 客户端接收并映射共享内存段, 成功返回0, 数据还没到达时返回EAGAIN, 失败返回errno.
+    int ReceiveFrom(int socket_fd);
+
+    inline bool IsOpen() const { return segment_ != nullptr; }
+    inline size_t GetRingSize() const { return ring_size_; }
+    // 对端写入数据或者腾出写空间时可读.
+    inline int GetEventFd() const { return event_fd_; }
+    void ClearEvent();
+    // 让本端的eventfd可读, 在下一轮事件循环中重新处理.
+    void NotifySelf();
+
+    // 尽可能多地写入, 返回写入的字节数. 写不完时, 对端腾出空间后会唤醒本端.
+    size_t Write(const char* data, size_t size);
+    // 读出所有数据追加到buffer, 返回读出的字节数. 返回后对端再写入数据时会唤醒本端.
+    size_t Read(InputBuffer& buffer);
+
+private:
+    bool Map(int mem_fd, size_t segment_size);
+    void Notify(int event_fd);
+
+    void* segment_ = nullptr;
+    size_t segment_size_ = 0;
+    size_t ring_size_ = 0;
+    int mem_fd_ = -1;
+    int event_fd_ = -1;         // 本端等待
+    int peer_event_fd_ = -1;    // 对端等待
+    ShmRingHeader* in_ = nullptr;
+    ShmRingHeader* out_ = nullptr;
+    char* in_data_ = nullptr;
+    char* out_data_ = nullptr;
+};
+
+}
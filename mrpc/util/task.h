@@ -0,0 +1,184 @@
+#pragma once
+
+#include <coroutine>
+#include <exception>
+#include <optional>
+#include <utility>
+
+#include <mrpc/util/noncopyable.h>
+
+namespace mrpc
+{
+
+// C++20协程的返回类型. 创建后不立即执行, 由co_await或Spawn启动;
+// 协程结束时直接切换回等待它的协程(对称转移), 多层co_await不会增加调用栈.
+// 协程在哪个线程恢复由它等待的对象决定, 比如CallAwaiter总在发起调用的线程恢复.
+template<typename T = void>
+class Task;
+
+namespace detail
+{
+
+template<typename T>
+class TaskPromiseBase
+{
+public:
+    struct FinalAwaiter
+    {
+        bool await_ready() const noexcept { return false; }
+
+        template<typename Promise>
+        std::coroutine_handle<> await_suspend(std::coroutine_handle<Promise> handle) noexcept
+        {
+            std::coroutine_handle<> continuation = handle.promise().continuation_;
+            if (continuation)
+            {
+                return continuation;
+            }
+            return std::noop_coroutine();
+        }
+
+        void await_resume() const noexcept {}
+    };
+
+    std::suspend_always initial_suspend() const noexcept { return {}; }
+    FinalAwaiter final_suspend() const noexcept { return {}; }
+    void unhandled_exception() { exception_ = std::current_exception(); }
+
+    void SetContinuation(std::coroutine_handle<> continuation) { continuation_ = continuation; }
+
+protected:
+    void RethrowIfException()
+    {
+        if (exception_)
+        {
+            std::rethrow_exception(exception_);
+        }
+    }
+
+    std::coroutine_handle<> continuation_;
+    std::exception_ptr exception_;
+};
+
+template<typename T>
+class TaskPromise final : public TaskPromiseBase<T>
+{
+public:
+    Task<T> get_return_object();
+
+    template<typename U>
+    void return_value(U&& value) { value_.emplace(std::forward<U>(value)); }
+
+    T GetResult()
+    {
+        this->RethrowIfException();
+        return std::move(*value_);
+    }
+
+private:
+    std::optional<T> value_;
+};
+
+template<>
+class TaskPromise<void> final : public TaskPromiseBase<void>
+{
+public:
+    Task<void> get_return_object();
+
+    void return_void() {}
+
+    void GetResult() { RethrowIfException(); }
+};
+
+}
+
+template<typename T>
+class Task final : private NonCopyable
+{
+public:
+    using promise_type = detail::TaskPromise<T>;
+
+    explicit Task(std::coroutine_handle<promise_type> handle) : handle_(handle) {}
+    Task(Task&& other) noexcept : handle_(std::exchange(other.handle_, nullptr)) {}
+
+    Task& operator=(Task&& other) noexcept
+    {
+        if (this != &other)
+        {
+            if (handle_) handle_.destroy();
+            handle_ = std::exchange(other.handle_, nullptr);
+        }
+        return *this;
+    }
+
+    ~Task()
+    {
+        if (handle_) handle_.destroy();
+    }
+
+    inline bool Done() const { return !handle_ || handle_.done(); }
+
+    auto operator co_await() && noexcept
+    {
+        struct Awaiter
+        {
+            std::coroutine_handle<promise_type> handle;
+
+            bool await_ready() const noexcept { return handle.done(); }
+
+            std::coroutine_handle<> await_suspend(std::coroutine_handle<> continuation) noexcept
+            {
+                handle.promise().SetContinuation(continuation);
+                return handle;
+            }
+
+            T await_resume() { return handle.promise().GetResult(); }
+        };
+        return Awaiter{ handle_ };
+    }
+
+private:
+    std::coroutine_handle<promise_type> handle_;
+};
+
+namespace detail
+{
+
+template<typename T>
+Task<T> TaskPromise<T>::get_return_object()
+{
+    return Task<T>(std::coroutine_handle<TaskPromise<T>>::from_promise(*this));
+}
+
+inline Task<void> TaskPromise<void>::get_return_object()
+{
+    return Task<void>(std::coroutine_handle<TaskPromise<void>>::from_promise(*this));
+}
+
+// 没有人等待的协程, 结束时自动释放
+struct DetachedTask
+{
+    struct promise_type
+    {
+        DetachedTask get_return_object() const noexcept { return {}; }
+        std::suspend_never initial_suspend() const noexcept { return {}; }
+        std::suspend_never final_suspend() const noexcept { return {}; }
+        void return_void() const noexcept {}
+        void unhandled_exception() const noexcept { std::terminate(); }
+    };
+};
+
+inline DetachedTask RunDetached(Task<void> task)
+{
+    co_await std::move(task);
+}
+
+}
+
+// 在当前线程启动协程, 第一次挂起时返回, 协程结束后自动释放. 协程中抛出的异常会终止进程.
+inline void Spawn(Task<void> task)
+{
+    detail::RunDetached(std::move(task));
+}
+
+}
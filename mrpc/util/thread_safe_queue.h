@@ -35,6 +35,31 @@ public:
         cv_.notify_one();
     }
 
+    // 队列长度达到max_size时不入队, 返回false.
+    bool try_push(const T& value, size_t max_size)
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (queue_.size() >= max_size)
+        {
+            return false;
+        }
+        queue_.push(value);
+        cv_.notify_one();
+        return true;
+    }
+
+    bool try_push(T&& value, size_t max_size)
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (queue_.size() >= max_size)
+        {
+            return false;
+        }
+        queue_.push(std::move(value));
+        cv_.notify_one();
+        return true;
+    }
+
     bool try_pop(T& value)
     {
         std::lock_guard<std::mutex> lock(mutex_);
@@ -12,4 +12,11 @@ uint64_t Time::Now()
     return milliseconds.count();
 }
 
+uint64_t Time::NowMicros()
+{
+    auto now = std::chrono::steady_clock::now();
+    auto microseconds = std::chrono::duration_cast<std::chrono::microseconds>(now.time_since_epoch());
+    return microseconds.count();
+}
+
 }
@@ -9,6 +9,7 @@ class Time
 {
 public:
     static uint64_t Now(); // Milliseconds
+    static uint64_t NowMicros(); // Microseconds, 单调时钟, 用于计算耗时
 };
 
 }
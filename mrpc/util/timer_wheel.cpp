@@ -0,0 +1,52 @@
+#include <algorithm>
+#include <cassert>
+
+#include <mrpc/util/timer_wheel.h>
+
+namespace mrpc
+{
+
+TimerWheel::TimerWheel(uint64_t now, uint64_t tick/* = kDefaultTick*/, size_t slot_num/* = kDefaultSlotNum*/) :
+    tick_(tick),
+    current_tick_(now / tick),
+    slots_(slot_num)
+{
+    assert(tick > 0 && slot_num > 0);
+}
+
+void TimerWheel::Add(uint64_t id, uint64_t expire_time)
+{
+    uint64_t expire_tick = std::max(expire_time / tick_, current_tick_ + 1);
+    slots_[expire_tick % slots_.size()].push_back({ id, expire_tick });
+    ++size_;
+}
+
+void TimerWheel::Advance(uint64_t now, std::vector<uint64_t>& expired)
+{
+    uint64_t target_tick = now / tick_;
+    if (target_tick <= current_tick_) return;
+
+    // 跨度超过一圈时每个槽只需要检查一次
+    uint64_t steps = std::min<uint64_t>(target_tick - current_tick_, slots_.size());
+    for (uint64_t i = 1; i <= steps; ++i)
+    {
+        std::vector<Entry>& slot = slots_[(current_tick_ + i) % slots_.size()];
+        for (size_t j = 0; j < slot.size();)
+        {
+            if (slot[j].expire_tick <= target_tick)
+            {
+                expired.push_back(slot[j].id);
+                slot[j] = slot.back();
+                slot.pop_back();
+                --size_;
+            }
+            else
+            {
+                ++j;
+            }
+        }
+    }
+    current_tick_ = target_tick;
+}
+
+}
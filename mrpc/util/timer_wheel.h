@@ -0,0 +1,47 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include <mrpc/util/noncopyable.h>
+
+namespace mrpc
+{
+
+// 哈希时间轮, 每个槽对应一个tick, 超出一圈的定时器留在槽中等待后续轮次.
+// 不支持删除, 定时器到期后由调用方根据id判断是否仍然有效, 需要时重新Add.
+// 非线程安全.
+class TimerWheel final : private NonCopyable
+{
+public:
+    static constexpr uint64_t kDefaultTick = 100;
+    static constexpr size_t kDefaultSlotNum = 512;
+
+    // tick为时间粒度, now为当前时间, 单位与Add/Advance的时间一致(通常为毫秒).
+    explicit TimerWheel(uint64_t now, uint64_t tick = kDefaultTick, size_t slot_num = kDefaultSlotNum);
+    ~TimerWheel() = default;
+
+    inline uint64_t GetTick() const { return tick_; }
+    inline size_t Size() const { return size_; }
+    inline bool Empty() const { return size_ == 0; }
+
+    // 已经过期的定时器在下一次Advance时到期.
+    void Add(uint64_t id, uint64_t expire_time);
+    // 推进到now, 到期定时器的id追加到expired.
+    void Advance(uint64_t now, std::vector<uint64_t>& expired);
+
+private:
+    struct Entry
+    {
+        uint64_t id = 0;
+        uint64_t expire_tick = 0;
+    };
+
+    uint64_t tick_ = 0;
+    uint64_t current_tick_ = 0;
+    size_t size_ = 0;
+    std::vector<std::vector<Entry>> slots_;
+};
+
+}
@@ -28,6 +28,21 @@ bool CppClass::Parse(const google::protobuf::Descriptor* desc, std::string* erro
         }
     }
 
+    // pod runs
+    for (size_t i = 0; i < fields_.size(); ++i)
+    {
+        if (!fields_[i].pod_) continue;
+
+        if (!pod_runs_.empty() && pod_runs_.back().second + 1 == i)
+        {
+            pod_runs_.back().second = i;
+        }
+        else
+        {
+            pod_runs_.emplace_back(i, i);
+        }
+    }
+
     return true;
 }
 
@@ -112,6 +127,15 @@ void CppClass::OutputToSourceFile(google::protobuf::io::Printer& printer,
     {
         field.OutputDescriptorInitializerList(printer, vars);
     }
+    printer.Print("    },\n"
+            "    {\n");
+    for (auto& [first, last] : pod_runs_)
+    {
+        vars["first_field_name"] = fields_[first].field_name_;
+        vars["last_field_name"] = fields_[last].field_name_;
+        printer.Print(vars, "        { mrpc::OffsetOf($class_name$, $first_field_name$), "
+                "mrpc::OffsetOf($class_name$, $last_field_name$) + sizeof($class_name$::$last_field_name$) - mrpc::OffsetOf($class_name$, $first_field_name$) },\n");
+    }
     printer.Print("    }\n"
             "};\n"
             "};\n"
@@ -146,9 +170,23 @@ void CppClass::OutputToSourceFile(google::protobuf::io::Printer& printer,
     // method Clear
     printer.Print(vars, "void $namespace$::$class_name$::Clear()\n"
             "{\n");
-    for (auto& field : fields_)
+    auto run = pod_runs_.begin();
+    for (size_t i = 0; i < fields_.size(); ++i)
     {
-        field.OutputClearMethod(printer, vars);
+        // 多个相邻的标量字段合并为一次memset
+        if (run != pod_runs_.end() && run->first == i && run->second > i)
+        {
+            vars["first_field_name"] = fields_[run->first].field_name_;
+            vars["last_field_name"] = fields_[run->second].field_name_;
+            printer.Print(vars, "    memset(&$first_field_name$, 0, "
+                    "reinterpret_cast<char*>(&$last_field_name$) + sizeof($last_field_name$) - reinterpret_cast<char*>(&$first_field_name$));\n");
+            i = run->second;
+            ++run;
+            continue;
+        }
+        if (run != pod_runs_.end() && run->second == i) ++run;
+
+        fields_[i].OutputClearMethod(printer, vars);
     }
     printer.Print("}\n"
             "\n");
@@ -37,4 +37,5 @@ private:
     std::string proto_name_;
     std::string proto_full_name_;
     std::vector<CppField> fields_;
+    std::vector<std::pair<size_t, size_t>> pod_runs_;   // 相邻的默认值为0的标量字段, [first, last]
 };
@@ -93,6 +93,7 @@ static const std::map<int, std::string_view> kPbTypeToTemplateType =
     { google::protobuf::FieldDescriptor::TYPE_SFIXED64, "mrpc::TYPE_FIXED_INT64" },
     { google::protobuf::FieldDescriptor::TYPE_SINT32, "mrpc::TYPE_ZIGZAG_INT32" },
     { google::protobuf::FieldDescriptor::TYPE_SINT64, "mrpc::TYPE_ZIGZAG_INT64" },
+    { google::protobuf::FieldDescriptor::TYPE_MESSAGE, "mrpc::TYPE_MESSAGE" },
 };
 
 static std::string_view CppTypeToEnumName(mrpc::CppType cpp_type)
@@ -115,6 +116,17 @@ static std::string_view CppTypeToName(mrpc::CppType cpp_type)
     return "";
 }
 
+static std::string_view PbTypeToTemplateType(int proto_type)
+{
+    auto it = kPbTypeToTemplateType.find(proto_type);
+    if (it != kPbTypeToTemplateType.end())
+    {
+        return it->second;
+    }
+    assert(false && "unknown type");
+    return "";
+}
+
 static std::string_view CppTypeDefault(mrpc::CppType cpp_type)
 {
     auto it = kCppTypeDefault.find(cpp_type);
@@ -281,6 +293,36 @@ bool CppField::Parse(const google::protobuf::FieldDescriptor* desc, std::string*
             break;
     }
 
+    switch (cpp_type_)
+    {
+        case mrpc::CPPTYPE_INT32:
+            pod_ = desc->default_value_int32() == 0;
+            break;
+        case mrpc::CPPTYPE_UINT32:
+            pod_ = desc->default_value_uint32() == 0;
+            break;
+        case mrpc::CPPTYPE_INT64:
+            pod_ = desc->default_value_int64() == 0;
+            break;
+        case mrpc::CPPTYPE_UINT64:
+            pod_ = desc->default_value_uint64() == 0;
+            break;
+        case mrpc::CPPTYPE_FLOAT:
+            pod_ = !desc->has_default_value();
+            break;
+        case mrpc::CPPTYPE_DOUBLE:
+            pod_ = !desc->has_default_value();
+            break;
+        case mrpc::CPPTYPE_BOOL:
+            pod_ = !desc->default_value_bool();
+            break;
+        case mrpc::CPPTYPE_ENUM:
+            pod_ = desc->default_value_enum()->number() == 0;
+            break;
+        default:
+            break;
+    }
+
     return true;
 }
 
@@ -979,11 +1021,13 @@ void CppField::OutputDescriptorWrapperMember(google::protobuf::io::Printer& prin
 {
     vars["field_name"] = field_name_;
     vars["field_name_length"] = std::to_string(field_name_.length());
+    vars["tag_number"] = std::to_string(tag_number_);
     vars["cpp_type_name"] = CppTypeToEnumName(cpp_type_);
 
     if (IsSequenceContainerType(cpp_type_))
     {
         vars["field_sub_type_1"] = CppTypeToEnumName(cpp_sub_type_1_);
+        vars["template_type"] = PbTypeToTemplateType(proto_sub_type_1_);
         vars["container_sub_type_1"] = CppTypeToName(cpp_sub_type_1_);
 
         if (cpp_type_ == mrpc::CPPTYPE_VECTOR)
@@ -998,22 +1042,24 @@ void CppField::OutputDescriptorWrapperMember(google::protobuf::io::Printer& prin
         if (cpp_sub_type_1_ == mrpc::CPPTYPE_ENUM)
         {
             vars["field_type"] = field_type_name_;
-            printer.Print(vars, "static mrpc::$container_impl_type$FieldDescriptorImpl<$container_sub_type_1$> $field_name$_field_desc = { std::string_view(\"$field_name$\", $field_name_length$), $cpp_type_name$, mrpc::OffsetOf($class_name$, $field_name$), $field_sub_type_1$, $field_type$_GetDescriptor() };\n");
+            printer.Print(vars, "static mrpc::$container_impl_type$FieldDescriptorImpl<$container_sub_type_1$> $field_name$_field_desc = { std::string_view(\"$field_name$\", $field_name_length$), $tag_number$, $cpp_type_name$, mrpc::OffsetOf($class_name$, $field_name$), $field_sub_type_1$, $template_type$, $field_type$_GetDescriptor() };\n");
         }
         else if (cpp_sub_type_1_ == mrpc::CPPTYPE_MESSAGE)
         {
             vars["field_type"] = field_type_name_;
-            printer.Print(vars, "static mrpc::$container_impl_type$FieldDescriptorImpl<$field_type$> $field_name$_field_desc = { std::string_view(\"$field_name$\", $field_name_length$), $cpp_type_name$, mrpc::OffsetOf($class_name$, $field_name$), $field_sub_type_1$, $field_type$::GetClassDescriptor() };\n");
+            printer.Print(vars, "static mrpc::$container_impl_type$FieldDescriptorImpl<$field_type$> $field_name$_field_desc = { std::string_view(\"$field_name$\", $field_name_length$), $tag_number$, $cpp_type_name$, mrpc::OffsetOf($class_name$, $field_name$), $field_sub_type_1$, $template_type$, $field_type$::GetClassDescriptor() };\n");
         }
         else
         {
-            printer.Print(vars, "static mrpc::$container_impl_type$FieldDescriptorImpl<$container_sub_type_1$> $field_name$_field_desc = { std::string_view(\"$field_name$\", $field_name_length$), $cpp_type_name$, mrpc::OffsetOf($class_name$, $field_name$), $field_sub_type_1$ };\n");
+            printer.Print(vars, "static mrpc::$container_impl_type$FieldDescriptorImpl<$container_sub_type_1$> $field_name$_field_desc = { std::string_view(\"$field_name$\", $field_name_length$), $tag_number$, $cpp_type_name$, mrpc::OffsetOf($class_name$, $field_name$), $field_sub_type_1$, $template_type$ };\n");
         }
     }
     else if (IsAssociativeContainerType(cpp_type_))
     {
         vars["field_sub_type_1"] = CppTypeToEnumName(cpp_sub_type_1_);
         vars["field_sub_type_2"] = CppTypeToEnumName(cpp_sub_type_2_);
+        vars["template_type_key"] = PbTypeToTemplateType(proto_sub_type_1_);
+        vars["template_type_value"] = PbTypeToTemplateType(proto_sub_type_2_);
         vars["container_sub_type_1"] = CppTypeToName(cpp_sub_type_1_);
         vars["container_sub_type_2"] = CppTypeToName(cpp_sub_type_2_);
 
@@ -1029,16 +1075,16 @@ void CppField::OutputDescriptorWrapperMember(google::protobuf::io::Printer& prin
         if (cpp_sub_type_2_ == mrpc::CPPTYPE_ENUM)
         {
             vars["field_type"] = field_type_name_;
-            printer.Print(vars, "static mrpc::$container_impl_type$FieldDescriptorImpl<$container_sub_type_1$, $container_sub_type_2$> $field_name$_field_desc = { std::string_view(\"$field_name$\", $field_name_length$), $cpp_type_name$, mrpc::OffsetOf($class_name$, $field_name$), $field_sub_type_1$, $field_sub_type_2$, $field_type$_GetDescriptor() };\n");
+            printer.Print(vars, "static mrpc::$container_impl_type$FieldDescriptorImpl<$container_sub_type_1$, $container_sub_type_2$> $field_name$_field_desc = { std::string_view(\"$field_name$\", $field_name_length$), $tag_number$, $cpp_type_name$, mrpc::OffsetOf($class_name$, $field_name$), $field_sub_type_1$, $template_type_key$, $field_sub_type_2$, $template_type_value$, $field_type$_GetDescriptor() };\n");
         }
         else if (cpp_sub_type_2_ == mrpc::CPPTYPE_MESSAGE)
         {
             vars["field_type"] = field_type_name_;
-            printer.Print(vars, "static mrpc::$container_impl_type$FieldDescriptorImpl<$container_sub_type_1$, $field_type$> $field_name$_field_desc = { std::string_view(\"$field_name$\", $field_name_length$), $cpp_type_name$, mrpc::OffsetOf($class_name$, $field_name$), $field_sub_type_1$, $field_sub_type_2$, $field_type$::GetClassDescriptor() };\n");
+            printer.Print(vars, "static mrpc::$container_impl_type$FieldDescriptorImpl<$container_sub_type_1$, $field_type$> $field_name$_field_desc = { std::string_view(\"$field_name$\", $field_name_length$), $tag_number$, $cpp_type_name$, mrpc::OffsetOf($class_name$, $field_name$), $field_sub_type_1$, $template_type_key$, $field_sub_type_2$, $template_type_value$, $field_type$::GetClassDescriptor() };\n");
         }
         else
         {
-            printer.Print(vars, "static mrpc::$container_impl_type$FieldDescriptorImpl<$container_sub_type_1$, $container_sub_type_2$> $field_name$_field_desc = { std::string_view(\"$field_name$\", $field_name_length$), $cpp_type_name$, mrpc::OffsetOf($class_name$, $field_name$), $field_sub_type_1$, $field_sub_type_2$ };\n");
+            printer.Print(vars, "static mrpc::$container_impl_type$FieldDescriptorImpl<$container_sub_type_1$, $container_sub_type_2$> $field_name$_field_desc = { std::string_view(\"$field_name$\", $field_name_length$), $tag_number$, $cpp_type_name$, mrpc::OffsetOf($class_name$, $field_name$), $field_sub_type_1$, $template_type_key$, $field_sub_type_2$, $template_type_value$ };\n");
         }
     }
     else
@@ -1046,16 +1092,17 @@ void CppField::OutputDescriptorWrapperMember(google::protobuf::io::Printer& prin
         if (cpp_type_ == mrpc::CPPTYPE_ENUM)
         {
             vars["field_type"] = field_type_name_;
-            printer.Print(vars, "static mrpc::EnumFieldDescriptor $field_name$_field_desc = { std::string_view(\"$field_name$\", $field_name_length$), $cpp_type_name$, mrpc::OffsetOf($class_name$, $field_name$), $field_type$_GetDescriptor() };\n");
+            printer.Print(vars, "static mrpc::EnumFieldDescriptor $field_name$_field_desc = { std::string_view(\"$field_name$\", $field_name_length$), $tag_number$, $cpp_type_name$, mrpc::OffsetOf($class_name$, $field_name$), $field_type$_GetDescriptor() };\n");
         }
         else if (cpp_type_ == mrpc::CPPTYPE_MESSAGE)
         {
             vars["field_type"] = field_type_name_;
-            printer.Print(vars, "static mrpc::MessageFieldDescriptor $field_name$_field_desc = { std::string_view(\"$field_name$\", $field_name_length$), $cpp_type_name$, mrpc::OffsetOf($class_name$, $field_name$), $field_type$::GetClassDescriptor() };\n");
+            printer.Print(vars, "static mrpc::MessageFieldDescriptor $field_name$_field_desc = { std::string_view(\"$field_name$\", $field_name_length$), $tag_number$, $cpp_type_name$, mrpc::OffsetOf($class_name$, $field_name$), $field_type$::GetClassDescriptor() };\n");
         }
         else
         {
-            printer.Print(vars, "static mrpc::FieldDescriptor $field_name$_field_desc = { std::string_view(\"$field_name$\", $field_name_length$), $cpp_type_name$, mrpc::OffsetOf($class_name$, $field_name$) };\n");
+            vars["template_type"] = PbTypeToTemplateType(proto_type_);
+            printer.Print(vars, "static mrpc::FieldDescriptor $field_name$_field_desc = { std::string_view(\"$field_name$\", $field_name_length$), $tag_number$, $cpp_type_name$, $template_type$, mrpc::OffsetOf($class_name$, $field_name$) };\n");
         }
     }
 }
@@ -65,6 +65,7 @@ private:
     mrpc::CppType cpp_sub_type_2_ = mrpc::CPPTYPE_UNKNOWN;
     std::string field_type_name_;
     std::string field_default_;
+    bool pod_ = false;  // 默认值为0的标量字段, 相邻的可以合并为PodRun
 
     static bool IsNamedType(mrpc::CppType cpp_type);
     static bool IsContainerType(mrpc::CppType cpp_type);
@@ -124,6 +124,9 @@ void CppFile::OutputToHeaderFile(google::protobuf::compiler::GeneratorContext* c
     printer.Print("#include <mrpc/message/message.h>\n");
     if (!service_.empty())
     {
+        printer.Print("#include <mrpc/message/field_mask.h>\n");
+        printer.Print("#include <mrpc/service/call_awaiter.h>\n");
+        printer.Print("#include <mrpc/service/parallel_call.h>\n");
         printer.Print("#include <mrpc/service/service.h>\n");
         printer.Print("#include <mrpc/service/service_stub.h>\n");
     }
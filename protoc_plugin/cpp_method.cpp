@@ -42,7 +42,7 @@ void CppMethod::OutputInterfaceMethodDefinition(google::protobuf::io::Printer& p
     vars["method_name"] = method_name_;
     vars["input_type_name"] = input_type_same_namespace_ ? input_type_name_ : input_type_full_name_;
     vars["output_type_name"] = output_type_same_namespace_ ? output_type_name_ : output_type_full_name_;
-    printer.Print(vars, "    virtual int32_t $method_name$(const $input_type_name$& req, $output_type_name$& rsp) = 0;\n");
+    printer.Print(vars, "    virtual $handler_return_type$ $method_name$(const $input_type_name$& req, $output_type_name$& rsp) = 0;\n");
 }
 
 void CppMethod::OutputStubSyncMethodDefinition(google::protobuf::io::Printer& printer,
@@ -51,7 +51,7 @@ void CppMethod::OutputStubSyncMethodDefinition(google::protobuf::io::Printer& pr
     vars["method_name"] = method_name_;
     vars["input_type_name"] = input_type_same_namespace_ ? input_type_name_ : input_type_full_name_;
     vars["output_type_name"] = output_type_same_namespace_ ? output_type_name_ : output_type_full_name_;
-    printer.Print(vars, "    int32_t $method_name$(const $input_type_name$& req, $output_type_name$& rsp);\n");
+    printer.Print(vars, "    int32_t $method_name$(const $input_type_name$& req, $output_type_name$& rsp, const mrpc::FieldMask& rsp_field_mask = mrpc::FieldMask());\n");
 }
 
 void CppMethod::OutputStubAsyncMethodDefinition(google::protobuf::io::Printer& printer,
@@ -60,7 +60,48 @@ void CppMethod::OutputStubAsyncMethodDefinition(google::protobuf::io::Printer& p
     vars["method_name"] = method_name_;
     vars["input_type_name"] = input_type_same_namespace_ ? input_type_name_ : input_type_full_name_;
     vars["output_type_name"] = output_type_same_namespace_ ? output_type_name_ : output_type_full_name_;
-    printer.Print(vars, "    void $method_name$_Async(const $input_type_name$& req, const std::shared_ptr<mrpc::AsyncCallback<$output_type_name$>>& cb);\n");
+    printer.Print(vars, "    void $method_name$_Async(const $input_type_name$& req, const std::shared_ptr<mrpc::AsyncCallback<$output_type_name$>>& cb,\n"
+            "            const mrpc::FieldMask& rsp_field_mask = mrpc::FieldMask());\n");
+}
+
+void CppMethod::OutputStubCoroutineMethodDefinition(google::protobuf::io::Printer& printer,
+        std::map<std::string, std::string>& vars) const
+{
+    vars["method_name"] = method_name_;
+    vars["input_type_name"] = input_type_same_namespace_ ? input_type_name_ : input_type_full_name_;
+    vars["output_type_name"] = output_type_same_namespace_ ? output_type_name_ : output_type_full_name_;
+    printer.Print(vars, "    mrpc::CallAwaiter<$output_type_name$> $method_name$_Co(const $input_type_name$& req, $output_type_name$& rsp,\n"
+            "            const mrpc::FieldMask& rsp_field_mask = mrpc::FieldMask());\n");
+}
+
+void CppMethod::OutputStubParallelMethodDefinition(google::protobuf::io::Printer& printer,
+        std::map<std::string, std::string>& vars) const
+{
+    vars["method_name"] = method_name_;
+    vars["input_type_name"] = input_type_same_namespace_ ? input_type_name_ : input_type_full_name_;
+    vars["output_type_name"] = output_type_same_namespace_ ? output_type_name_ : output_type_full_name_;
+    printer.Print(vars, "    void $method_name$_Parallel(mrpc::ParallelCall<$output_type_name$>& call, const $input_type_name$& req,\n"
+            "            const mrpc::FieldMask& rsp_field_mask = mrpc::FieldMask());\n");
+}
+
+void CppMethod::OutputInterfaceGetRequestDescriptorImplementation(google::protobuf::io::Printer& printer,
+        std::map<std::string, std::string>& vars) const
+{
+    vars["input_type_name"] = input_type_full_name_;
+    printer.Print(vars,
+            "        case $method_index$:\n"
+            "            return $input_type_name$::GetClassDescriptor();\n"
+            );
+}
+
+void CppMethod::OutputInterfaceGetResponseDescriptorImplementation(google::protobuf::io::Printer& printer,
+        std::map<std::string, std::string>& vars) const
+{
+    vars["output_type_name"] = output_type_full_name_;
+    printer.Print(vars,
+            "        case $method_index$:\n"
+            "            return $output_type_name$::GetClassDescriptor();\n"
+            );
 }
 
 void CppMethod::OutputInterfaceNameBasedCallMethodImplementation(google::protobuf::io::Printer& printer,
@@ -71,7 +112,7 @@ void CppMethod::OutputInterfaceNameBasedCallMethodImplementation(google::protobu
     vars["output_type_name"] = output_type_full_name_;
     printer.Print(vars,
             "        case $method_index$:\n"
-            "            return $method_name$(dynamic_cast<const $input_type_name$&>(req), dynamic_cast<$output_type_name$&>(rsp));\n"
+            "            $return$ $await$$method_name$(dynamic_cast<const $input_type_name$&>(req), dynamic_cast<$output_type_name$&>(rsp));\n"
             "            break;\n"
             );
 }
@@ -88,18 +129,24 @@ void CppMethod::OutputInterfaceMrpcInternalCallMethodImplementation(google::prot
             "            $input_type_name$ req;\n"
             "            if (!req.ParseFromString(req_data))\n"
             "            {\n"
-            "                return mrpc::ERROR_INVALID_METHOD_REQUEST_DATA;\n"
+            "                $return$ mrpc::ERROR_INVALID_METHOD_REQUEST_DATA;\n"
             "            }\n"
             "\n"
             "            $output_type_name$ rsp;\n"
-            "            ret = $method_name$(req, rsp);\n"
+            "            mrpc::FieldMask rsp_mask;\n"
+            "            if (!rsp_field_mask.empty() && !rsp_mask.ParseFromString(rsp.GetDescriptor(), rsp_field_mask))\n"
+            "            {\n"
+            "                $return$ mrpc::ERROR_INVALID_METHOD_FIELD_MASK;\n"
+            "            }\n"
+            "\n"
+            "            ret = $await$$method_name$(req, rsp);\n"
             "            if (ret != 0)\n"
             "            {\n"
-            "                return ret;\n"
+            "                $return$ ret;\n"
             "            }\n"
             "\n"
-            "            rsp.SerializeToString(rsp_data);\n"
-            "            return 0;\n"
+            "            rsp.SerializeToString(rsp_data, rsp_mask);\n"
+            "            $return$ 0;\n"
             "            break;\n"
             "        }\n"
             );
@@ -114,16 +161,16 @@ void CppMethod::OutputStubSyncMethodImplementation(google::protobuf::io::Printer
     vars["method_name_hash"] = std::to_string(method_name_hash_);
     vars["input_type_name"] = input_type_full_name_;
     vars["output_type_name"] = output_type_full_name_;
-    printer.Print(vars, "int32_t $namespace$::$service_name$Stub::$method_name$(const $input_type_name$& req, $output_type_name$& rsp)\n"
+    printer.Print(vars, "int32_t $namespace$::$service_name$Stub::$method_name$(const $input_type_name$& req, $output_type_name$& rsp, const mrpc::FieldMask& rsp_field_mask)\n"
             "{\n"
             "    std::string req_data, rsp_data;\n"
             "    req.SerializeToString(req_data);\n"
-            "    int32_t ret = CallMethod($method_name_hash$u, req_data, rsp_data);\n"
+            "    int32_t ret = CallMethod($method_name_hash$u, std::move(req_data), rsp_field_mask.ToString(), rsp_data);\n"
             "    if (ret != 0)\n"
             "    {\n"
             "        return ret;\n"
             "    }\n"
-            "    if (!rsp.ParseFromString(rsp_data))\n"
+            "    if (!rsp.ParseFromString(rsp_data, rsp_field_mask))\n"
             "    {\n"
             "        return mrpc::ERROR_INVALID_METHOD_RESPONSE_DATA;\n"
             "    }\n"
@@ -140,11 +187,50 @@ void CppMethod::OutputStubAsyncMethodImplementation(google::protobuf::io::Printe
     vars["method_name"] = method_name_;
     vars["input_type_name"] = input_type_full_name_;
     vars["output_type_name"] = output_type_full_name_;
-    printer.Print(vars, "void $namespace$::$service_name$Stub::$method_name$_Async(const $input_type_name$& req, const std::shared_ptr<mrpc::AsyncCallback<$output_type_name$>>& cb)\n"
+    printer.Print(vars, "void $namespace$::$service_name$Stub::$method_name$_Async(const $input_type_name$& req, const std::shared_ptr<mrpc::AsyncCallback<$output_type_name$>>& cb,\n"
+            "        const mrpc::FieldMask& rsp_field_mask)\n"
+            "{\n"
+            "    std::string req_data;\n"
+            "    req.SerializeToString(req_data);\n"
+            "    CallMethod($method_name_hash$u, std::move(req_data), rsp_field_mask.ToString(), cb);\n"
+            "}\n"
+            "\n");
+}
+
+void CppMethod::OutputStubCoroutineMethodImplementation(google::protobuf::io::Printer& printer,
+        std::map<std::string, std::string>& vars) const
+{
+    vars["namespace"] = namespace_;
+    vars["service_name"] = service_name_;
+    vars["method_name"] = method_name_;
+    vars["method_name_hash"] = std::to_string(method_name_hash_);
+    vars["input_type_name"] = input_type_full_name_;
+    vars["output_type_name"] = output_type_full_name_;
+    printer.Print(vars, "mrpc::CallAwaiter<$output_type_name$> $namespace$::$service_name$Stub::$method_name$_Co(const $input_type_name$& req, $output_type_name$& rsp,\n"
+            "        const mrpc::FieldMask& rsp_field_mask)\n"
+            "{\n"
+            "    std::string req_data;\n"
+            "    req.SerializeToString(req_data);\n"
+            "    return mrpc::CallAwaiter<$output_type_name$>(*this, $method_name_hash$u, std::move(req_data), rsp, rsp_field_mask);\n"
+            "}\n"
+            "\n");
+}
+
+void CppMethod::OutputStubParallelMethodImplementation(google::protobuf::io::Printer& printer,
+        std::map<std::string, std::string>& vars) const
+{
+    vars["namespace"] = namespace_;
+    vars["service_name"] = service_name_;
+    vars["method_name"] = method_name_;
+    vars["method_name_hash"] = std::to_string(method_name_hash_);
+    vars["input_type_name"] = input_type_full_name_;
+    vars["output_type_name"] = output_type_full_name_;
+    printer.Print(vars, "void $namespace$::$service_name$Stub::$method_name$_Parallel(mrpc::ParallelCall<$output_type_name$>& call, const $input_type_name$& req,\n"
+            "        const mrpc::FieldMask& rsp_field_mask)\n"
             "{\n"
             "    std::string req_data;\n"
             "    req.SerializeToString(req_data);\n"
-            "    CallMethod($method_name_hash$u, req_data, cb);\n"
+            "    call.Add(*this, $method_name_hash$u, std::move(req_data), rsp_field_mask);\n"
             "}\n"
             "\n");
 }
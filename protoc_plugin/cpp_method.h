@@ -28,7 +28,15 @@ public:
             std::map<std::string, std::string>& vars) const;
     void OutputStubAsyncMethodDefinition(google::protobuf::io::Printer& printer,
             std::map<std::string, std::string>& vars) const;
+    void OutputStubCoroutineMethodDefinition(google::protobuf::io::Printer& printer,
+            std::map<std::string, std::string>& vars) const;
+    void OutputStubParallelMethodDefinition(google::protobuf::io::Printer& printer,
+            std::map<std::string, std::string>& vars) const;
 
+    void OutputInterfaceGetRequestDescriptorImplementation(google::protobuf::io::Printer& printer,
+            std::map<std::string, std::string>& vars) const;
+    void OutputInterfaceGetResponseDescriptorImplementation(google::protobuf::io::Printer& printer,
+            std::map<std::string, std::string>& vars) const;
     void OutputInterfaceNameBasedCallMethodImplementation(google::protobuf::io::Printer& printer,
             std::map<std::string, std::string>& vars) const;
     void OutputInterfaceMrpcInternalCallMethodImplementation(google::protobuf::io::Printer& printer,
@@ -38,6 +46,10 @@ public:
             std::map<std::string, std::string>& vars) const;
     void OutputStubAsyncMethodImplementation(google::protobuf::io::Printer& printer,
             std::map<std::string, std::string>& vars) const;
+    void OutputStubCoroutineMethodImplementation(google::protobuf::io::Printer& printer,
+            std::map<std::string, std::string>& vars) const;
+    void OutputStubParallelMethodImplementation(google::protobuf::io::Printer& printer,
+            std::map<std::string, std::string>& vars) const;
 
 private:
     std::string namespace_;
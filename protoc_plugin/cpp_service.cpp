@@ -1,5 +1,6 @@
 #include <google/protobuf/descriptor.h>
 #include <google/protobuf/io/printer.h>
+#include <mrpc/options.pb.h>
 
 #include "cpp_service.h"
 #include "plugin_helper.h"
@@ -14,6 +15,7 @@ bool CppService::Parse(const google::protobuf::ServiceDescriptor* desc, std::str
 {
     service_proto_full_name_ = desc->full_name();
     service_proto_full_name_hash_ = APHash(service_proto_full_name_);
+    coroutine_ = desc->options().GetExtension(mrpc::coroutine);
 
     // methods
     for (int i = 0; i < desc->method_count(); ++i)
@@ -33,6 +35,7 @@ void CppService::OutputToHeaderFile(google::protobuf::io::Printer& printer,
         std::map<std::string, std::string>& vars) const
 {
     vars["service_name"] = service_name_;
+    vars["handler_return_type"] = coroutine_ ? "mrpc::Task<int32_t>" : "int32_t";
 
     // service interface
     printer.Print(vars, "class $service_name$ : public mrpc::Service\n");
@@ -53,15 +56,21 @@ void CppService::OutputToHeaderFile(google::protobuf::io::Printer& printer,
             "    const mrpc::Descriptor* GetResponseDescriptor(const std::string& method_name) const override;\n"
             "    int32_t CallMethod(const std::string& method_name, const mrpc::Message& req, mrpc::Message& rsp) override;\n"
             "\n"
-            "    int32_t CallMethod(uint32_t method_code, const std::string& req_data, std::string& rsp_data) override;\n"
+            "    int32_t CallMethod(uint32_t method_code, const std::string& req_data, const std::string& rsp_field_mask, std::string& rsp_data) override;\n"
             "\n");
+    if (coroutine_)
+    {
+        printer.Print(
+                "    bool IsCoroutine() const override { return true; }\n"
+                "    mrpc::Task<int32_t> CallMethodCo(const std::string& method_name, const mrpc::Message& req, mrpc::Message& rsp) override;\n"
+                "    mrpc::Task<int32_t> CallMethodCo(uint32_t method_code, const std::string& req_data, const std::string& rsp_field_mask, std::string& rsp_data) override;\n"
+                "\n");
+    }
 
     // service interface
     printer.Print("private:\n"
             "    const static std::map<std::string_view, int32_t> kMethodNameToIndex;\n"
             "    const static std::map<uint32_t, int32_t> kMethodNameHashToIndex;\n"
-            "    const static std::map<std::string_view, std::string_view> kMethodNameToRequestDescriptorName;\n"
-            "    const static std::map<std::string_view, std::string_view> kMethodNameToResponseDescriptorName;\n"
             "};\n"
             "\n");
 
@@ -81,6 +90,16 @@ void CppService::OutputToHeaderFile(google::protobuf::io::Printer& printer,
         method.OutputStubAsyncMethodDefinition(printer, vars);
     }
     printer.Print("\n");
+    for (auto& method : methods_)
+    {
+        method.OutputStubCoroutineMethodDefinition(printer, vars);
+    }
+    printer.Print("\n");
+    for (auto& method : methods_)
+    {
+        method.OutputStubParallelMethodDefinition(printer, vars);
+    }
+    printer.Print("\n");
 
     // service stub 
     printer.Print("};\n"
@@ -132,58 +151,26 @@ void CppService::OutputToSourceFile(google::protobuf::io::Printer& printer,
     printer.Print("};\n"
             "\n");
 
-    // service static field kMethodNameToRequestDescriptorName
-    printer.Print(vars, "const std::map<std::string_view, std::string_view> $namespace$::$service_name$::kMethodNameToRequestDescriptorName = {\n");
-    for (size_t i = 0; i < methods_.size(); ++i)
-    {
-        vars["method_name"] = methods_[i].method_name_;
-        vars["method_name_length"] = std::to_string(methods_[i].method_name_.length());
-        vars["input_type_proto_name"] = methods_[i].input_type_proto_full_name_;
-        vars["input_type_proto_name_length"] = std::to_string(methods_[i].input_type_proto_full_name_.length());
-        printer.Print(vars, "    { std::string_view(\"$method_name$\", $method_name_length$), std::string_view(\"$input_type_proto_name$\", $input_type_proto_name_length$) }");
-        if (i != methods_.size() - 1)
-        {
-            printer.Print(",\n");
-        }
-        else
-        {
-            printer.Print("\n");
-        }
-    }
-    printer.Print("};\n"
-            "\n");
-
-    // service static field kMethodNameToResponseDescriptorName
-    printer.Print(vars, "const std::map<std::string_view, std::string_view> $namespace$::$service_name$::kMethodNameToResponseDescriptorName = {\n");
-    for (size_t i = 0; i < methods_.size(); ++i)
-    {
-        vars["method_name"] = methods_[i].method_name_;
-        vars["method_name_length"] = std::to_string(methods_[i].method_name_.length());
-        vars["output_type_proto_name"] = methods_[i].output_type_proto_full_name_;
-        vars["output_type_proto_name_length"] = std::to_string(methods_[i].output_type_proto_full_name_.length());
-        printer.Print(vars, "    { std::string_view(\"$method_name$\", $method_name_length$), std::string_view(\"$output_type_proto_name$\", $output_type_proto_name_length$) }");
-        if (i != methods_.size() - 1)
-        {
-            printer.Print(",\n");
-        }
-        else
-        {
-            printer.Print("\n");
-        }
-    }
-    printer.Print("};\n"
-            "\n");
-
     // service method GetRequestDescriptor
     printer.Print(vars, 
             "const mrpc::Descriptor* $namespace$::$service_name$::GetRequestDescriptor(const std::string& method_name) const\n"
             "{\n"
-            "    auto it = kMethodNameToRequestDescriptorName.find(method_name);\n"
-            "    if (it == kMethodNameToRequestDescriptorName.end())\n"
+            "    auto it = kMethodNameToIndex.find(method_name);\n"
+            "    if (it == kMethodNameToIndex.end())\n"
             "    {\n"
             "        return nullptr;\n"
             "    }\n"
-            "    return mrpc::DescriptorPool::FindDescriptorByFullName(it->second);\n"
+            "\n"
+            "    switch (it->second)\n"
+            "    {\n"
+            );
+    for (size_t i = 0; i < methods_.size(); ++i)
+    {
+        vars["method_index"] = std::to_string(i);
+        methods_[i].OutputInterfaceGetRequestDescriptorImplementation(printer, vars);
+    }
+    printer.Print("    }\n"
+            "    return nullptr;\n"
             "}\n"
             "\n");
 
@@ -191,23 +178,85 @@ void CppService::OutputToSourceFile(google::protobuf::io::Printer& printer,
     printer.Print(vars, 
             "const mrpc::Descriptor* $namespace$::$service_name$::GetResponseDescriptor(const std::string& method_name) const\n"
             "{\n"
-            "    auto it = kMethodNameToResponseDescriptorName.find(method_name);\n"
-            "    if (it == kMethodNameToResponseDescriptorName.end())\n"
+            "    auto it = kMethodNameToIndex.find(method_name);\n"
+            "    if (it == kMethodNameToIndex.end())\n"
             "    {\n"
             "        return nullptr;\n"
             "    }\n"
-            "    return mrpc::DescriptorPool::FindDescriptorByFullName(it->second);\n"
+            "\n"
+            "    switch (it->second)\n"
+            "    {\n"
+            );
+    for (size_t i = 0; i < methods_.size(); ++i)
+    {
+        vars["method_index"] = std::to_string(i);
+        methods_[i].OutputInterfaceGetResponseDescriptorImplementation(printer, vars);
+    }
+    printer.Print("    }\n"
+            "    return nullptr;\n"
             "}\n"
             "\n");
 
+    if (coroutine_)
+    {
+        // 协程服务的同步接口不可用
+        printer.Print(vars,
+                "int32_t $namespace$::$service_name$::CallMethod(const std::string& /*method_name*/, const mrpc::Message& /*req*/, mrpc::Message& /*rsp*/)\n"
+                "{\n"
+                "    return mrpc::ERROR_SYNC_CALL_NOT_SUPPORTED;\n"
+                "}\n"
+                "\n"
+                "int32_t $namespace$::$service_name$::CallMethod(uint32_t /*method_code*/, const std::string& /*req_data*/, const std::string& /*rsp_field_mask*/, std::string& /*rsp_data*/)\n"
+                "{\n"
+                "    return mrpc::ERROR_SYNC_CALL_NOT_SUPPORTED;\n"
+                "}\n"
+                "\n");
+
+        vars["call_method"] = "CallMethodCo";
+        vars["call_method_return_type"] = "mrpc::Task<int32_t>";
+        vars["return"] = "co_return";
+        vars["await"] = "co_await ";
+    }
+    else
+    {
+        vars["call_method"] = "CallMethod";
+        vars["call_method_return_type"] = "int32_t";
+        vars["return"] = "return";
+        vars["await"] = "";
+    }
+    OutputCallMethodImplementation(printer, vars);
+
+    // stub methods
+    for (auto& method : methods_)
+    {
+        vars["service_name_hash"] = std::to_string(service_proto_full_name_hash_);
+        method.OutputStubSyncMethodImplementation(printer, vars);
+    }
+    for (auto& method : methods_)
+    {
+        method.OutputStubAsyncMethodImplementation(printer, vars);
+    }
+    for (auto& method : methods_)
+    {
+        method.OutputStubCoroutineMethodImplementation(printer, vars);
+    }
+    for (auto& method : methods_)
+    {
+        method.OutputStubParallelMethodImplementation(printer, vars);
+    }
+}
+
+void CppService::OutputCallMethodImplementation(google::protobuf::io::Printer& printer,
+        std::map<std::string, std::string>& vars) const
+{
     // service method CallMethod
     printer.Print(vars, 
-            "int32_t $namespace$::$service_name$::CallMethod(const std::string& method_name, const mrpc::Message& req, mrpc::Message& rsp)\n"
+            "$call_method_return_type$ $namespace$::$service_name$::$call_method$(const std::string& method_name, const mrpc::Message& req, mrpc::Message& rsp)\n"
             "{\n"
             "    auto it = kMethodNameToIndex.find(method_name);\n"
             "    if (it == kMethodNameToIndex.end())\n"
             "    {\n"
-            "        return mrpc::ERROR_INVALID_METHOD_NAME;\n"
+            "        $return$ mrpc::ERROR_INVALID_METHOD_NAME;\n"
             "    }\n"
             "\n"
             "    switch (it->second)\n"
@@ -218,19 +267,19 @@ void CppService::OutputToSourceFile(google::protobuf::io::Printer& printer,
         vars["method_index"] = std::to_string(i);
         methods_[i].OutputInterfaceNameBasedCallMethodImplementation(printer, vars);
     }
-    printer.Print("    }\n"
-            "    return mrpc::ERROR_INVALID_METHOD_NAME;\n"
+    printer.Print(vars, "    }\n"
+            "    $return$ mrpc::ERROR_INVALID_METHOD_NAME;\n"
             "}\n"
             "\n");
 
     // service method CallMethod
     printer.Print(vars, 
-            "int32_t $namespace$::$service_name$::CallMethod(uint32_t method_code, const std::string& req_data, std::string& rsp_data)\n"
+            "$call_method_return_type$ $namespace$::$service_name$::$call_method$(uint32_t method_code, const std::string& req_data, const std::string& rsp_field_mask, std::string& rsp_data)\n"
             "{\n"
             "    auto it = kMethodNameHashToIndex.find(method_code);\n"
             "    if (it == kMethodNameHashToIndex.end())\n"
             "    {\n"
-            "        return mrpc::ERROR_INVALID_METHOD_NAME_HASH;\n"
+            "        $return$ mrpc::ERROR_INVALID_METHOD_NAME_HASH;\n"
             "    }\n"
             "\n"
             "    int32_t ret = 0;\n"
@@ -242,20 +291,8 @@ void CppService::OutputToSourceFile(google::protobuf::io::Printer& printer,
         vars["method_index"] = std::to_string(i);
         methods_[i].OutputInterfaceMrpcInternalCallMethodImplementation(printer, vars);
     }
-    printer.Print("    }\n"
-            "    return mrpc::ERROR_INVALID_METHOD_NAME_HASH;\n"
+    printer.Print(vars, "    }\n"
+            "    $return$ mrpc::ERROR_INVALID_METHOD_NAME_HASH;\n"
             "}\n"
             "\n");
-
-    // stub methods
-    for (auto& method : methods_)
-    {
-        vars["service_name_hash"] = std::to_string(service_proto_full_name_hash_);
-        method.OutputStubSyncMethodImplementation(printer, vars);
-    }
-    for (auto& method : methods_)
-    {
-        method.OutputStubAsyncMethodImplementation(printer, vars);
-    }
 }
-
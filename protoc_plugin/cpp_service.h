@@ -29,9 +29,13 @@ public:
             std::map<std::string, std::string>& vars) const;
 
 private:
+    void OutputCallMethodImplementation(google::protobuf::io::Printer& printer,
+            std::map<std::string, std::string>& vars) const;
+
     std::string namespace_;
     std::string service_name_;
     std::string service_proto_full_name_;
     uint32_t service_proto_full_name_hash_;
+    bool coroutine_ = false;
     std::vector<CppMethod> methods_;
 };
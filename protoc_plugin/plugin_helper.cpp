@@ -1,3 +1,5 @@
+#include <mrpc/util/hash.h>
+
 #include "plugin_helper.h"
 
 bool IsImportIgnored(const std::string &dot_name)
@@ -29,17 +31,5 @@ std::string DotNameToCppTypeName(const std::string &dot_name)
 
 uint32_t APHash(std::string_view str)
 {
-    uint32_t hash = 0;
-    for (size_t i = 0; i < str.length(); i++)
-    {
-        if ((i & 1) == 0)
-        {
-            hash ^= ((hash << 7) ^ str[i] ^ (hash >> 3));
-        }
-        else
-        {
-            hash ^= (~((hash << 11) ^ str[i] ^ (hash >> 5)));
-        }
-    }
-    return hash;
+    return mrpc::APHash(str);
 }
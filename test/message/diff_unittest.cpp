@@ -0,0 +1,124 @@
+#include <gtest/gtest.h>
+#include <mrpc/message/diff.h>
+#include "mine.mrpc.h"
+
+static void ExpectSame(const test::mine::TestObject& a, const test::mine::TestObject& b)
+{
+    std::string s1, s2;
+    a.SerializeToString(s1);
+    b.SerializeToString(s2);
+    EXPECT_EQ(s1, s2);
+}
+
+static void ExpectPatchApplied(const test::mine::TestObject& from, const test::mine::TestObject& to)
+{
+    std::string patch = mrpc::Diff(from, to);
+
+    test::mine::TestObject msg = from;
+    EXPECT_TRUE(mrpc::ApplyPatch(msg, patch));
+    ExpectSame(msg, to);
+
+    // 应用后再次比较应没有差异
+    EXPECT_TRUE(mrpc::Diff(msg, to).empty());
+}
+
+TEST(Diff, Scalar)
+{
+    test::mine::TestObject from, to;
+    EXPECT_TRUE(mrpc::Diff(from, to).empty());
+
+    to.int32_value = -1;
+    to.uint64_value = 100;
+    to.double_value = -0.0;
+    to.bool_value = true;
+    to.enum_value = test::mine::CORPUS_WEB;
+    to.string_value = "string";
+    to.obj_value.int32_value = 2;
+    ExpectPatchApplied(from, to);
+
+    // 改回默认值
+    ExpectPatchApplied(to, from);
+
+    // 只有变化的字段进入补丁
+    from = to;
+    to.int32_value = 1;
+    std::string patch = mrpc::Diff(from, to);
+    EXPECT_EQ(patch.size(), 2u);
+    ExpectPatchApplied(from, to);
+}
+
+TEST(Diff, Repeated)
+{
+    test::mine::TestObject from, to;
+    from.int32_repeat = { 1, 2, 3, 4 };
+    from.bool_repeat = { true, false };
+    from.string_repeat = { "a", "b" };
+    from.obj_repeat.resize(2);
+    from.obj_repeat[1].int32_value = 1;
+
+    // 修改
+    to = from;
+    to.int32_repeat[2] = 5;
+    to.bool_repeat.back() = true;
+    to.obj_repeat[1].int32_value = 2;
+    ExpectPatchApplied(from, to);
+
+    // 增长
+    to = from;
+    to.int32_repeat.push_back(0);
+    to.int32_repeat.push_back(6);
+    to.string_repeat.push_back("c");
+    to.obj_repeat.resize(4);
+    to.obj_repeat[3].int32_value = 3;
+    ExpectPatchApplied(from, to);
+
+    // 缩短
+    to = from;
+    to.int32_repeat.resize(1);
+    to.bool_repeat.clear();
+    to.obj_repeat.resize(1);
+    ExpectPatchApplied(from, to);
+}
+
+TEST(Diff, Map)
+{
+    test::mine::TestObject from, to;
+    from.map_i2i[1] = 1;
+    from.map_i2i[2] = 2;
+    from.map_u2s[1] = "a";
+    from.map_i2o[1].int32_value = 1;
+    from.map_i2o[2].int32_value = 2;
+    from.map_s2o["a"].int32_value = 1;
+
+    to = from;
+    to.map_i2i[2] = 3;
+    to.map_i2i[4] = 4;
+    to.map_u2s.erase(1);
+    to.map_i2o[1].int32_value = 3;
+    to.map_i2o.erase(2);
+    to.map_i2o[5].int32_value = 5;
+    to.map_s2o["b"];
+    to.map_b2u[true] = 1;
+    ExpectPatchApplied(from, to);
+    ExpectPatchApplied(to, from);
+}
+
+TEST(Diff, InvalidPatch)
+{
+    test::mine::TestObject from, to;
+    to.string_value = "string";
+    to.int32_repeat = { 1, 2, 3 };
+    to.map_i2o[1].int32_value = 1;
+    std::string patch = mrpc::Diff(from, to);
+
+    test::mine::TestObject msg;
+    EXPECT_FALSE(mrpc::ApplyPatch(msg, patch.substr(0, patch.size() - 1)));
+
+    // 不存在的字段
+    msg.Clear();
+    EXPECT_FALSE(mrpc::ApplyPatch(msg, std::string("\xf8\x07\x00", 3)));
+
+    // 操作类型与字段类型不符
+    msg.Clear();
+    EXPECT_FALSE(mrpc::ApplyPatch(msg, std::string("\x09\x00", 2)));
+}
@@ -0,0 +1,139 @@
+#include <gtest/gtest.h>
+#include <mrpc/message/field_mask.h>
+#include "defaults.mrpc.h"
+#include "mine.mrpc.h"
+
+TEST(FieldMask, Parse)
+{
+    const mrpc::Descriptor* desc = test::mine::TestObject::GetClassDescriptor();
+    mrpc::FieldMask mask;
+
+    EXPECT_TRUE(mask.IsEmpty());
+    EXPECT_TRUE(mask.ParseFromString(desc, "string_value,obj_value.int32_value,int32_value"));
+    EXPECT_FALSE(mask.IsEmpty());
+    EXPECT_EQ(mask.ToString(), "int32_value,string_value,obj_value.int32_value");
+    EXPECT_NE(mask.FindChild(1), nullptr);
+    EXPECT_EQ(mask.FindChild(2), nullptr);
+
+    // 父路径覆盖子路径
+    EXPECT_TRUE(mask.AddPath(desc, "obj_value"));
+    EXPECT_TRUE(mask.AddPath(desc, "obj_value.int32_value"));
+    EXPECT_EQ(mask.ToString(), "int32_value,string_value,obj_value");
+
+    EXPECT_TRUE(mask.ParseFromString(desc, "obj_repeat.int32_value,map_i2o.int32_value"));
+    EXPECT_EQ(mask.ToString(), "obj_repeat.int32_value,map_i2o.int32_value");
+
+    EXPECT_FALSE(mask.ParseFromString(desc, "not_exist"));
+    EXPECT_TRUE(mask.IsEmpty());
+    EXPECT_FALSE(mask.ParseFromString(desc, "int32_value.int32_value"));
+    EXPECT_FALSE(mask.ParseFromString(desc, "obj_value."));
+    EXPECT_FALSE(mask.ParseFromString(desc, "int32_value,,string_value"));
+}
+
+TEST(FieldMask, Serialize)
+{
+    const mrpc::Descriptor* desc = test::mine::TestObject::GetClassDescriptor();
+
+    test::mine::TestObject src;
+    src.int32_value = 1;
+    src.string_value = "string";
+    src.obj_value.int32_value = 2;
+    src.int32_repeat = { 1, 2, 3 };
+    src.obj_repeat.resize(2);
+    src.obj_repeat[0].int32_value = 3;
+    src.map_i2o[1].int32_value = 4;
+
+    mrpc::FieldMask mask;
+    EXPECT_TRUE(mask.ParseFromString(desc, "string_value,obj_value.int32_value,obj_repeat.int32_value,map_i2o"));
+
+    std::string s;
+    src.SerializeToString(s, mask);
+
+    test::mine::TestObject expect;
+    expect.string_value = src.string_value;
+    expect.obj_value.int32_value = src.obj_value.int32_value;
+    expect.obj_repeat.resize(2);
+    expect.obj_repeat[0].int32_value = 3;
+    expect.map_i2o[1].int32_value = 4;
+
+    std::string expect_s;
+    expect.SerializeToString(expect_s);
+    EXPECT_EQ(s, expect_s);
+
+    // 空掩码等价于全部字段
+    std::string s1, s2;
+    src.SerializeToString(s1);
+    src.SerializeToString(s2, mrpc::FieldMask());
+    EXPECT_EQ(s1, s2);
+}
+
+TEST(FieldMask, PartialParse)
+{
+    const mrpc::Descriptor* desc = test::mine::TestObject::GetClassDescriptor();
+
+    test::mine::TestObject src;
+    src.int32_value = 1;
+    src.string_value = "string";
+    src.obj_value.int32_value = 2;
+    src.int32_repeat = { 1, 2, 3 };
+    src.map_i2o[1].int32_value = 4;
+
+    std::string s;
+    src.SerializeToString(s);
+
+    mrpc::FieldMask mask;
+    EXPECT_TRUE(mask.ParseFromString(desc, "int32_value,map_i2o.int32_value"));
+
+    test::mine::TestObject dst;
+    EXPECT_TRUE(dst.ParseFromString(s, mask));
+    EXPECT_EQ(dst.int32_value, 1);
+    EXPECT_EQ(dst.string_value, "");
+    EXPECT_EQ(dst.obj_value.int32_value, 0);
+    EXPECT_TRUE(dst.int32_repeat.empty());
+    EXPECT_EQ(dst.map_i2o.size(), 1u);
+    EXPECT_EQ(dst.map_i2o[1].int32_value, 4);
+
+    // 掩码之外的字段即使数据不合法也不会被解析
+    dst.Clear();
+    s.push_back(static_cast<char>(0x12)); // uint32_value, 错误的wire type
+    s.push_back(0);
+    EXPECT_FALSE(dst.ParseFromString(s));
+    EXPECT_TRUE(dst.ParseFromString(s, mask));
+}
+
+TEST(FieldMask, Proto2Default)
+{
+    const mrpc::Descriptor* desc = test::defaults::DefaultsObject::GetClassDescriptor();
+
+    // 掩码内显式设置为0的字段需要写入, 等于声明默认值的字段不写入
+    test::defaults::DefaultsObject src;
+    src.int32_value = 0;
+    src.bool_value = false;
+    src.string_value = "abc";
+    src.obj_value.int32_value = 0;
+    src.zero_value = 3;
+
+    mrpc::FieldMask mask;
+    EXPECT_TRUE(mask.ParseFromString(desc, "int32_value,bool_value,string_value,obj_value.int32_value"));
+
+    std::string s;
+    src.SerializeToString(s, mask);
+
+    test::defaults::DefaultsObject expect;
+    expect.int32_value = 0;
+    expect.bool_value = false;
+    expect.obj_value.int32_value = 0;
+
+    std::string expect_s;
+    expect.SerializeToString(expect_s);
+    EXPECT_EQ(s, expect_s);
+
+    test::defaults::DefaultsObject dst;
+    EXPECT_TRUE(dst.ParseFromString(s, mask));
+    EXPECT_EQ(dst.int32_value, 0);
+    EXPECT_FALSE(dst.bool_value);
+    EXPECT_EQ(dst.string_value, "abc");
+    EXPECT_EQ(dst.obj_value.int32_value, 0);
+    EXPECT_EQ(dst.zero_value, 0);
+    EXPECT_EQ(dst.uint64_value, 5u);
+}
@@ -0,0 +1,201 @@
+#include <gtest/gtest.h>
+#include <mrpc/message/dynamic_message.h>
+#include <mrpc/message/reflection_codec.h>
+#include "defaults.mrpc.h"
+#include "mine.mrpc.h"
+
+static void FillTestObject(test::mine::TestObject& msg)
+{
+    msg.int32_value = -1;
+    msg.uint32_value = 300;
+    msg.sint32_value = -300;
+    msg.fixed32_value = 4;
+    msg.sfixed32_value = -5;
+    msg.int64_value = -6;
+    msg.uint64_value = 1ul << 40;
+    msg.sint64_value = -(1l << 40);
+    msg.fixed64_value = 9;
+    msg.sfixed64_value = -10;
+    msg.float_value = 1.5f;
+    msg.double_value = -2.25;
+    msg.bool_value = true;
+    msg.enum_value = test::mine::CORPUS_NEWS;
+    msg.string_value = "string";
+    msg.bytes_value = std::string("\x00\x01\x02", 3);
+    msg.obj_value.int32_value = 17;
+
+    msg.int32_repeat = { -1, 0, 1 };
+    msg.uint32_repeat = { 0, 300 };
+    msg.sint32_repeat = { -300, 300 };
+    msg.fixed32_repeat = { 1, 2 };
+    msg.sfixed32_repeat = { -1, -2 };
+    msg.int64_repeat = { -1l, 1l << 40 };
+    msg.uint64_repeat = { 1ul << 63 };
+    msg.sint64_repeat = { -(1l << 40) };
+    msg.fixed64_repeat = { 1, 2, 3 };
+    msg.sfixed64_repeat = { -3 };
+    msg.float_repeat = { 0.5f, -0.5f };
+    msg.double_repeat = { 0.0, 1e100 };
+    msg.bool_repeat = { true, false, true };
+    msg.enum_repeat = { test::mine::CORPUS_WEB, test::mine::CORPUS_UNSPECIFIED };
+    msg.string_repeat = { "a", "", "abc" };
+    msg.bytes_repeat = { std::string("\x00", 1) };
+    msg.obj_repeat.resize(3);
+    msg.obj_repeat[0].int32_value = 1;
+    msg.obj_repeat[2].int32_value = 3;
+
+    msg.map_i2i = { { -1, 1 }, { 0, 0 } };
+    msg.map_i2e = { { 1, test::mine::CORPUS_VIDEO } };
+    msg.map_s2u = { { "key", 1 } };
+    msg.map_u2s = { { 1, "value" }, { 2, "" } };
+    msg.map_s2s = { { "", "" } };
+    msg.map_i2o[1].int32_value = 1;
+    msg.map_i2o[2];
+    msg.map_s2o["key"].int32_value = -1;
+    msg.map_b2u = { { false, 0 }, { true, 1 } };
+}
+
+TEST(ReflectionCodec, Descriptor)
+{
+    const mrpc::Descriptor* desc = test::mine::TestObject::GetClassDescriptor();
+
+    const mrpc::FieldDescriptor* field_desc = desc->FindFieldByNumber(3);
+    EXPECT_NE(field_desc, nullptr);
+    EXPECT_EQ(field_desc->GetName(), "sint32_value");
+    EXPECT_EQ(field_desc->GetFieldType(), mrpc::TYPE_ZIGZAG_INT32);
+    EXPECT_EQ(field_desc->GetWireType(), mrpc::WIRETYPE_VARINT);
+
+    field_desc = desc->FindFieldByNumber(17);
+    EXPECT_NE(field_desc, nullptr);
+    EXPECT_EQ(field_desc->GetFieldType(), mrpc::TYPE_MESSAGE);
+
+    field_desc = desc->FindFieldByNumber(35);
+    EXPECT_NE(field_desc, nullptr);
+    EXPECT_EQ(field_desc->GetFieldType(), mrpc::TYPE_FIXED_INT32);
+
+    field_desc = desc->FindFieldByNumber(62);
+    EXPECT_NE(field_desc, nullptr);
+    const mrpc::MapFieldDescriptor* map_desc = dynamic_cast<const mrpc::MapFieldDescriptor*>(field_desc);
+    EXPECT_NE(map_desc, nullptr);
+    EXPECT_EQ(map_desc->GetKeyFieldType(), mrpc::TYPE_ZIGZAG_INT32);
+    EXPECT_EQ(map_desc->GetValueFieldType(), mrpc::TYPE_VAR_INT32);
+
+    EXPECT_EQ(desc->FindFieldByNumber(0), nullptr);
+    EXPECT_EQ(desc->FindFieldByNumber(18), nullptr);
+    EXPECT_EQ(desc->FindFieldByNumber(1000), nullptr);
+}
+
+TEST(ReflectionCodec, Serialize)
+{
+    test::mine::TestObject msg;
+    std::string s1, s2;
+
+    msg.SerializeToString(s1);
+    mrpc::ReflectionCodec::SerializeToString(msg, s2);
+    EXPECT_EQ(s1, s2);
+    EXPECT_EQ(mrpc::ReflectionCodec::ByteSize(msg), 0u);
+
+    FillTestObject(msg);
+
+    msg.SerializeToString(s1);
+    mrpc::ReflectionCodec::SerializeToString(msg, s2);
+    EXPECT_EQ(s1, s2);
+    EXPECT_EQ(mrpc::ReflectionCodec::ByteSize(msg), s1.size());
+
+    msg.SerializeToString(s1, false);
+    mrpc::ReflectionCodec::SerializeToString(msg, s2, false);
+    EXPECT_EQ(s1, s2);
+    EXPECT_EQ(mrpc::ReflectionCodec::ByteSize(msg, false), s1.size());
+}
+
+TEST(ReflectionCodec, Parse)
+{
+    test::mine::TestObject src;
+    FillTestObject(src);
+
+    std::string s1, s2;
+    src.SerializeToString(s1);
+
+    test::mine::TestObject dst;
+    EXPECT_TRUE(mrpc::ReflectionCodec::ParseFromString(dst, s1));
+    dst.SerializeToString(s2);
+    EXPECT_EQ(s1, s2);
+
+    EXPECT_EQ(dst.sint64_value, src.sint64_value);
+    EXPECT_EQ(dst.bytes_value, src.bytes_value);
+    EXPECT_EQ(dst.obj_value.int32_value, 17);
+    EXPECT_EQ(dst.bool_repeat, src.bool_repeat);
+    EXPECT_EQ(dst.obj_repeat.size(), 3u);
+    EXPECT_EQ(dst.map_i2o.size(), 2u);
+    EXPECT_EQ(dst.map_s2o["key"].int32_value, -1);
+
+    // Truncated input.
+    test::mine::TestObject bad;
+    EXPECT_FALSE(mrpc::ReflectionCodec::ParseFromString(bad, std::string_view(s1.data(), s1.size() - 1)));
+}
+
+TEST(ReflectionCodec, DynamicMessage)
+{
+    mrpc::DynamicMessage invalid("test.mine.NotExist");
+    EXPECT_FALSE(invalid.IsValid());
+
+    test::mine::TestObject src;
+    FillTestObject(src);
+    std::string s1, s2;
+    src.SerializeToString(s1);
+
+    mrpc::DynamicMessage msg("test.mine.TestObject");
+    EXPECT_TRUE(msg.IsValid());
+    EXPECT_EQ(msg.GetDescriptor(), test::mine::TestObject::GetClassDescriptor());
+    EXPECT_TRUE(msg.ParseFromString(s1));
+    EXPECT_EQ(msg.ByteSize(), s1.size());
+
+    msg.SerializeToString(s2);
+    EXPECT_EQ(s1, s2);
+
+    msg.Clear();
+    EXPECT_EQ(msg.ByteSize(), 0u);
+}
+
+TEST(ReflectionCodec, Proto2Default)
+{
+    test::defaults::DefaultsObject msg;
+    std::string s1, s2;
+
+    // 等于声明的默认值时不写入
+    msg.SerializeToString(s1);
+    mrpc::ReflectionCodec::SerializeToString(msg, s2);
+    EXPECT_TRUE(s1.empty());
+    EXPECT_EQ(s1, s2);
+    EXPECT_EQ(mrpc::ReflectionCodec::ByteSize(msg), 0u);
+
+    // 显式设置为0也与默认值不同, 需要写入
+    msg.int32_value = 0;
+    msg.uint64_value = 0;
+    msg.double_value = 0;
+    msg.bool_value = false;
+    msg.enum_value = test::defaults::LEVEL_LOW;
+    msg.string_value.clear();
+    msg.zero_value = 0;
+    msg.obj_value.int32_value = 0;
+
+    msg.SerializeToString(s1);
+    mrpc::ReflectionCodec::SerializeToString(msg, s2);
+    EXPECT_FALSE(s1.empty());
+    EXPECT_EQ(s1, s2);
+    EXPECT_EQ(mrpc::ReflectionCodec::ByteSize(msg), s1.size());
+
+    test::defaults::DefaultsObject dst;
+    EXPECT_TRUE(mrpc::ReflectionCodec::ParseFromString(dst, s2));
+    EXPECT_EQ(dst.int32_value, 0);
+    EXPECT_EQ(dst.uint64_value, 0u);
+    EXPECT_EQ(dst.double_value, 0);
+    EXPECT_FALSE(dst.bool_value);
+    EXPECT_EQ(dst.enum_value, test::defaults::LEVEL_LOW);
+    EXPECT_TRUE(dst.string_value.empty());
+    EXPECT_EQ(dst.obj_value.int32_value, 0);
+
+    msg.SerializeToString(s1, false);
+    mrpc::ReflectionCodec::SerializeToString(msg, s2, false);
+    EXPECT_EQ(s1, s2);
+}
@@ -1,4 +1,6 @@
 #include <memory>
+#include <thread>
+#include <vector>
 #include <gtest/gtest.h>
 #include <mrpc/message/reflection.h>
 #include "mine.mrpc.h"
@@ -29,6 +31,83 @@ TEST(Reflection, Descriptor)
     delete a_msg;
 }
 
+TEST(Reflection, DescriptorPool)
+{
+    mrpc::DescriptorPool::Freeze();
+
+    std::vector<std::thread> threads;
+    for (int i = 0; i < 4; ++i)
+    {
+        threads.emplace_back([]()
+                {
+                    for (int j = 0; j < 10000; ++j)
+                    {
+                        EXPECT_EQ(mrpc::DescriptorPool::FindDescriptorByFullName("test.mine.TestObject"),
+                                test::mine::TestObject::GetClassDescriptor());
+                        EXPECT_EQ(mrpc::DescriptorPool::FindDescriptorByFullName("test.mine.NotExist"), nullptr);
+                    }
+                });
+    }
+    for (auto& thread : threads)
+    {
+        thread.join();
+    }
+}
+
+TEST(Reflection, PodRun)
+{
+    const mrpc::Descriptor* desc = test::mine::TestObject::GetClassDescriptor();
+    const std::vector<mrpc::PodRun>& runs = desc->GetPodRuns();
+    EXPECT_FALSE(runs.empty());
+
+    // 每段内的字段首尾相接, 没有填充
+    size_t field_count = desc->GetNonPodFields().size();
+    for (size_t i = 0; i < runs.size(); ++i)
+    {
+        size_t offset = runs[i].offset;
+        for (const mrpc::FieldDescriptor* field : desc->GetPodRunFields(i))
+        {
+            EXPECT_EQ(field->GetOffset(), offset);
+            offset += field->GetSize();
+            ++field_count;
+        }
+        EXPECT_EQ(offset, runs[i].offset + runs[i].size);
+    }
+    EXPECT_EQ(field_count, desc->GetFields().size());
+    EXPECT_EQ(desc->FindFieldByName("string_value")->GetSize(), 0u);
+    EXPECT_EQ(test::mine::TestInnerObject::GetClassDescriptor()->GetPodRuns().size(), 1u);
+
+    test::mine::TestObject a, b;
+    a.int32_value = 1;
+    a.fixed64_value = 2;
+    a.double_value = 3.0;
+    a.bool_value = true;
+    a.enum_value = test::mine::CORPUS_WEB;
+    a.string_value = "string";
+    EXPECT_FALSE(mrpc::Reflection::PodFieldsEqual(a, b));
+    EXPECT_NE(mrpc::Reflection::HashPodFields(a), mrpc::Reflection::HashPodFields(b));
+
+    mrpc::Reflection::CopyPodFields(a, b);
+    EXPECT_TRUE(mrpc::Reflection::PodFieldsEqual(a, b));
+    EXPECT_EQ(mrpc::Reflection::HashPodFields(a), mrpc::Reflection::HashPodFields(b));
+    EXPECT_EQ(b.fixed64_value, 2u);
+    EXPECT_EQ(b.enum_value, test::mine::CORPUS_WEB);
+    EXPECT_TRUE(b.string_value.empty());
+
+    mrpc::Reflection::ClearPodFields(a);
+    EXPECT_EQ(a.int32_value, 0);
+    EXPECT_EQ(a.double_value, 0.0);
+    EXPECT_FALSE(a.bool_value);
+    EXPECT_EQ(a.string_value, "string");
+
+    // 生成的Clear按段memset
+    b.Clear();
+    a.Clear();
+    EXPECT_TRUE(mrpc::Reflection::PodFieldsEqual(a, b));
+    EXPECT_EQ(b.int32_value, 0);
+    EXPECT_EQ(b.enum_value, test::mine::CORPUS_UNSPECIFIED);
+}
+
 TEST(Reflection, Get)
 {
     test::mine::TestObject msg;
@@ -0,0 +1,277 @@
+#include <gtest/gtest.h>
+#include <chrono>
+#include <cstring>
+#include <thread>
+#include <vector>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <mrpc/error_code.mrpc.h>
+#include <mrpc/service/application_config.mrpc.h>
+#include <mrpc/service/network_client.h>
+#include <mrpc/util/io_uring.h>
+
+// 测试用的包: 4字节总长度 + 8字节seq_id + 数据, 服务端原样返回
+static constexpr size_t kHeaderSize = 12;
+static const std::string kSlowPayload = "slow";
+
+static std::string PackFrame(uint64_t seq_id, const std::string& payload)
+{
+    uint32_t length = kHeaderSize + payload.length();
+    std::string frame((const char*)&length, sizeof(length));
+    frame.append((const char*)&seq_id, sizeof(seq_id));
+    frame += payload;
+    return frame;
+}
+
+static bool HandleResponse(const char*& ptr, size_t size, bool& has_error, uint64_t& seq_id, int32_t& ret, std::string& response_payload)
+{
+    if (size < kHeaderSize)
+    {
+        return false;
+    }
+    uint32_t length = 0;
+    memcpy(&length, ptr, sizeof(length));
+    if (length < kHeaderSize)
+    {
+        has_error = true;
+        return false;
+    }
+    if (size < length)
+    {
+        return false;
+    }
+    memcpy(&seq_id, ptr + sizeof(length), sizeof(seq_id));
+    ret = 0;
+    response_payload.assign(ptr + kHeaderSize, length - kHeaderSize);
+    ptr += length;
+    if (response_payload == kSlowPayload)
+    {
+        // 让IO线程暂停, 期间发生的完成事件在下一轮一起处理
+        std::this_thread::sleep_for(std::chrono::milliseconds(200));
+    }
+    return true;
+}
+
+static bool ReadFull(int fd, char* data, size_t size)
+{
+    while (size > 0)
+    {
+        ssize_t n = recv(fd, data, size, 0);
+        if (n <= 0)
+        {
+            return false;
+        }
+        data += n;
+        size -= n;
+    }
+    return true;
+}
+
+static bool ReadFrame(int fd, std::string& frame)
+{
+    uint32_t length = 0;
+    if (!ReadFull(fd, (char*)&length, sizeof(length)) || length < kHeaderSize)
+    {
+        return false;
+    }
+    frame.assign((const char*)&length, sizeof(length));
+    frame.resize(length);
+    return ReadFull(fd, frame.data() + sizeof(length), length - sizeof(length));
+}
+
+static bool WriteFull(int fd, const std::string& data)
+{
+    size_t written = 0;
+    while (written < data.length())
+    {
+        ssize_t n = send(fd, data.data() + written, data.length() - written, MSG_NOSIGNAL);
+        if (n <= 0)
+        {
+            return false;
+        }
+        written += n;
+    }
+    return true;
+}
+
+class NetworkClientUringTest : public testing::Test
+{
+protected:
+    void SetUp() override
+    {
+        if (!mrpc::IoUring::IsSupported())
+        {
+            GTEST_SKIP() << "io_uring is not supported";
+        }
+
+        listen_fd = socket(AF_INET, SOCK_STREAM, 0);
+        ASSERT_GE(listen_fd, 0);
+        struct sockaddr_in addr;
+        memset(&addr, 0, sizeof(addr));
+        addr.sin_family = AF_INET;
+        addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        ASSERT_EQ(bind(listen_fd, (const struct sockaddr*)&addr, sizeof(addr)), 0);
+        ASSERT_EQ(listen(listen_fd, 16), 0);
+        socklen_t addr_len = sizeof(addr);
+        ASSERT_EQ(getsockname(listen_fd, (struct sockaddr*)&addr, &addr_len), 0);
+
+        endpoint.protocol = mrpc::tcp;
+        endpoint.host = "127.0.0.1";
+        endpoint.port = ntohs(addr.sin_port);
+        endpoint.io_backend = mrpc::io_uring;
+        endpoint.address_id = 1;
+
+        client_thread = std::thread([this] { client.Start(); });
+    }
+
+    void TearDown() override
+    {
+        if (client_thread.joinable())
+        {
+            client.Stop();
+            client_thread.join();
+        }
+        if (listen_fd >= 0)
+        {
+            close(listen_fd);
+        }
+    }
+
+    std::shared_ptr<mrpc::ServiceStubContext> Send(const std::string& payload)
+    {
+        std::shared_ptr<mrpc::ServiceStubContext> context = std::make_shared<mrpc::ServiceStubContext>();
+        context->stub_id = 1;
+        context->seq_id = ++seq_id;
+        context->endpoint = endpoint;
+        context->protocol.handle_response = HandleResponse;
+        context->request = PackFrame(context->seq_id, payload);
+        context->notifier.reset(new mrpc::ServiceStubContextNotifier());
+        client.SendRequest(context);
+        return context;
+    }
+
+    // 超时返回-1
+    static int32_t Wait(const std::shared_ptr<mrpc::ServiceStubContext>& context)
+    {
+        std::unique_lock<std::mutex> lock(context->notifier->mtx);
+        if (!context->notifier->cv.wait_for(lock, std::chrono::seconds(10), [&context] { return context->notifier->done; }))
+        {
+            return -1;
+        }
+        return context->ret;
+    }
+
+    // 建立连接并完成一次请求, 之后的请求都走io_uring
+    int Connect()
+    {
+        std::shared_ptr<mrpc::ServiceStubContext> context = Send("hello");
+        int fd = accept(listen_fd, nullptr, nullptr);
+        std::string frame;
+        if (fd < 0 || !ReadFrame(fd, frame) || !WriteFull(fd, frame) || Wait(context) != 0)
+        {
+            return -1;
+        }
+        return fd;
+    }
+
+    int listen_fd = -1;
+    mrpc::Endpoint endpoint;
+    mrpc::NetworkClient client;
+    std::thread client_thread;
+    uint64_t seq_id = 0;
+};
+
+TEST_F(NetworkClientUringTest, LargeRequests)
+{
+    int fd = Connect();
+    ASSERT_GE(fd, 0);
+
+    // 远大于socket缓冲区, sendmsg只能部分发送, 需要从未发送的位置继续
+    std::vector<std::shared_ptr<mrpc::ServiceStubContext>> contexts;
+    std::vector<std::string> payloads;
+    for (int i = 0; i < 200; ++i)
+    {
+        payloads.emplace_back(i % 10 == 0 ? 1024 * 1024 + i : 100 + i, 'a' + i % 26);
+        contexts.push_back(Send(payloads.back()));
+    }
+
+    std::thread server([fd, num = contexts.size()] {
+        std::string frame;
+        for (size_t i = 0; i < num && ReadFrame(fd, frame); ++i)
+        {
+            WriteFull(fd, frame);
+        }
+    });
+    for (size_t i = 0; i < contexts.size(); ++i)
+    {
+        ASSERT_EQ(Wait(contexts[i]), 0);
+        EXPECT_EQ(contexts[i]->response_payload, payloads[i]);
+    }
+    server.join();
+    close(fd);
+}
+
+TEST_F(NetworkClientUringTest, CloseWithPendingOps)
+{
+    int fd = Connect();
+    ASSERT_GE(fd, 0);
+
+    // 服务端不读取, sendmsg阻塞在发送缓冲区上
+    std::vector<std::shared_ptr<mrpc::ServiceStubContext>> contexts;
+    for (int i = 0; i < 32; ++i)
+    {
+        contexts.push_back(Send(std::string(1024 * 1024, 'x')));
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(200));
+
+    // IO线程暂停期间服务端读走一部分请求, 再发送错误的包. 客户端在同一批完成事件中
+    // 先重新提交剩下部分的sendmsg, 再因为错误的包关闭连接, 这个sendmsg在连接关闭之后才完成.
+    ASSERT_TRUE(WriteFull(fd, PackFrame(0, kSlowPayload)));
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    std::string data(4 * 1024 * 1024, '\0');
+    ASSERT_TRUE(ReadFull(fd, data.data(), data.length()));
+    ASSERT_TRUE(WriteFull(fd, std::string(kHeaderSize, '\0')));
+    for (auto& context : contexts)
+    {
+        EXPECT_EQ(Wait(context), mrpc::ERROR_CONNECTION_CLOSED);
+    }
+    close(fd);
+
+    // 旧连接释放之后可以建立新连接
+    fd = Connect();
+    EXPECT_GE(fd, 0);
+    close(fd);
+}
+
+TEST_F(NetworkClientUringTest, SendBufferFull)
+{
+    endpoint.max_send_buffer_bytes = 1024 * 1024;
+    int fd = Connect();
+    ASSERT_GE(fd, 0);
+
+    // 服务端不读取, socket缓冲区满之后未发送的请求超过上限
+    std::vector<std::shared_ptr<mrpc::ServiceStubContext>> contexts;
+    for (int i = 0; i < 64; ++i)
+    {
+        contexts.push_back(Send(std::string(512 * 1024, 'x')));
+        std::this_thread::sleep_for(std::chrono::milliseconds(2));
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(200));
+    close(fd);
+
+    int full = 0;
+    for (auto& context : contexts)
+    {
+        int32_t ret = Wait(context);
+        if (ret == mrpc::ERROR_SEND_BUFFER_FULL)
+        {
+            ++full;
+        }
+        else
+        {
+            EXPECT_EQ(ret, mrpc::ERROR_CONNECTION_CLOSED);
+        }
+    }
+    EXPECT_GT(full, 0);
+}
@@ -0,0 +1,32 @@
+#include <gtest/gtest.h>
+#include <mrpc/util/backoff.h>
+
+TEST(Backoff, Exponential)
+{
+    mrpc::Backoff backoff(100, 1000);
+    uint32_t bounds[] = { 100, 200, 400, 800, 1000, 1000 };
+    for (uint32_t bound : bounds)
+    {
+        uint32_t delay = backoff.Fail();
+        EXPECT_GE(delay, bound / 2);
+        EXPECT_LE(delay, bound);
+    }
+    EXPECT_EQ(backoff.GetFailures(), 6u);
+
+    for (int i = 0; i < 100; ++i)
+    {
+        EXPECT_LE(backoff.Fail(), 1000u);
+    }
+
+    backoff.Reset();
+    EXPECT_EQ(backoff.GetFailures(), 0u);
+    EXPECT_LE(backoff.Fail(), 100u);
+}
+
+TEST(Backoff, Disabled)
+{
+    mrpc::Backoff backoff;
+    EXPECT_EQ(backoff.Fail(), 0u);
+    EXPECT_EQ(backoff.Fail(), 0u);
+    EXPECT_EQ(backoff.GetFailures(), 2u);
+}
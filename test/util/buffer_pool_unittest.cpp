@@ -0,0 +1,27 @@
+#include <gtest/gtest.h>
+#include <mrpc/util/buffer_pool.h>
+
+TEST(BufferPool, Reuse)
+{
+    mrpc::BufferPool pool(1024, 2);
+    EXPECT_EQ(pool.GetBlockSize(), 1024u);
+    EXPECT_EQ(pool.GetFreeBlockNum(), 0u);
+
+    char* a = pool.Allocate();
+    a[1023] = 'a';
+    pool.Free(a);
+    EXPECT_EQ(pool.GetFreeBlockNum(), 1u);
+    EXPECT_EQ(pool.Allocate(), a);
+    EXPECT_EQ(pool.GetFreeBlockNum(), 0u);
+
+    // 超过上限的空闲块直接释放
+    char* b = pool.Allocate();
+    char* c = pool.Allocate();
+    pool.Free(a);
+    pool.Free(b);
+    pool.Free(c);
+    EXPECT_EQ(pool.GetFreeBlockNum(), 2u);
+
+    pool.Free(nullptr);
+    EXPECT_EQ(pool.GetFreeBlockNum(), 2u);
+}
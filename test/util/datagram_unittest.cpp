@@ -0,0 +1,73 @@
+#include <gtest/gtest.h>
+#include <cerrno>
+#include <cstring>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <mrpc/util/datagram.h>
+
+static std::string Receive(int fd)
+{
+    char buf[2048];
+    ssize_t n = recv(fd, buf, sizeof(buf), MSG_DONTWAIT);
+    return n < 0 ? std::string() : std::string(buf, n);
+}
+
+TEST(Datagram, Connected)
+{
+    int fds[2] = { -1, -1 };
+    ASSERT_EQ(socketpair(AF_UNIX, SOCK_DGRAM, 0, fds), 0);
+
+    mrpc::Datagram datagrams[3];
+    datagrams[0].data = "a";
+    datagrams[1].data = "bb";
+    datagrams[2].data = std::string(1000, 'c');
+    EXPECT_EQ(mrpc::SendDatagrams(fds[0], datagrams, 0), 0);
+    EXPECT_EQ(mrpc::SendDatagrams(fds[0], datagrams, 3), 3);
+
+    // 保留数据报边界
+    EXPECT_EQ(Receive(fds[1]), "a");
+    EXPECT_EQ(Receive(fds[1]), "bb");
+    EXPECT_EQ(Receive(fds[1]), datagrams[2].data);
+    EXPECT_EQ(Receive(fds[1]), "");
+
+    close(fds[0]);
+    close(fds[1]);
+}
+
+TEST(Datagram, Address)
+{
+    int receivers[2] = { -1, -1 };
+    mrpc::Datagram datagrams[2];
+    for (int i = 0; i < 2; ++i)
+    {
+        receivers[i] = socket(AF_INET, SOCK_DGRAM, 0);
+        ASSERT_GE(receivers[i], 0);
+        struct sockaddr_in addr;
+        memset(&addr, 0, sizeof(addr));
+        addr.sin_family = AF_INET;
+        addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        ASSERT_EQ(bind(receivers[i], (struct sockaddr*)&addr, sizeof(addr)), 0);
+
+        socklen_t addr_len = sizeof(datagrams[i].addr);
+        ASSERT_EQ(getsockname(receivers[i], (struct sockaddr*)&datagrams[i].addr, &addr_len), 0);
+        datagrams[i].addr_len = addr_len;
+        datagrams[i].data = std::to_string(i);
+    }
+
+    int sender = socket(AF_INET, SOCK_DGRAM, 0);
+    ASSERT_GE(sender, 0);
+    EXPECT_EQ(mrpc::SendDatagrams(sender, datagrams, 2), 2);
+    for (int i = 0; i < 2; ++i)
+    {
+        char buf[16];
+        ssize_t n = recv(receivers[i], buf, sizeof(buf), 0);
+        EXPECT_EQ(std::string(buf, n > 0 ? n : 0), std::to_string(i));
+        close(receivers[i]);
+    }
+
+    // 超过最大长度
+    datagrams[0].data.assign(mrpc::kMaxDatagramSize + 1, 'x');
+    EXPECT_EQ(mrpc::SendDatagrams(sender, datagrams, 1), -EMSGSIZE);
+    close(sender);
+}
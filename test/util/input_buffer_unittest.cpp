@@ -0,0 +1,65 @@
+#include <gtest/gtest.h>
+#include <mrpc/util/input_buffer.h>
+
+TEST(InputBuffer, AppendConsume)
+{
+    mrpc::InputBuffer buffer;
+    EXPECT_TRUE(buffer.Empty());
+    EXPECT_EQ(buffer.GetCapacity(), 0u);
+
+    buffer.Append("hello world", 11);
+    EXPECT_EQ(buffer.GetReadableSize(), 11u);
+    EXPECT_EQ(std::string(buffer.GetReadPtr(), buffer.GetReadableSize()), "hello world");
+    EXPECT_GE(buffer.GetCapacity(), mrpc::InputBuffer::kMinCapacity);
+
+    buffer.Consume(6);
+    EXPECT_EQ(std::string(buffer.GetReadPtr(), buffer.GetReadableSize()), "world");
+
+    // 消费完后游标回到头部
+    buffer.Consume(5);
+    EXPECT_TRUE(buffer.Empty());
+    EXPECT_EQ(buffer.GetWritableSize(), buffer.GetCapacity());
+}
+
+TEST(InputBuffer, Compact)
+{
+    mrpc::InputBuffer buffer;
+    std::string data(mrpc::InputBuffer::kMinCapacity, 'a');
+    buffer.Append(data.data(), data.size());
+    size_t capacity = buffer.GetCapacity();
+    EXPECT_EQ(buffer.GetWritableSize(), 0u);
+
+    // 未读数据少于一半时整理, 不扩容
+    buffer.Consume(capacity - 10);
+    buffer.EnsureWritable(100);
+    EXPECT_EQ(buffer.GetCapacity(), capacity);
+    EXPECT_EQ(buffer.GetReadableSize(), 10u);
+    EXPECT_GE(buffer.GetWritableSize(), 100u);
+
+    memcpy(buffer.GetWritePtr(), "0123456789", 10);
+    buffer.Commit(10);
+    EXPECT_EQ(std::string(buffer.GetReadPtr(), buffer.GetReadableSize()), std::string(10, 'a') + "0123456789");
+}
+
+TEST(InputBuffer, Reserve)
+{
+    mrpc::InputBuffer buffer;
+    buffer.Append("head", 4);
+
+    // 按帧长预留后, 后续数据写入不再扩容
+    buffer.Reserve(1000000);
+    size_t capacity = buffer.GetCapacity();
+    EXPECT_GE(buffer.GetReadableSize() + buffer.GetWritableSize(), 1000000u);
+    std::string chunk(1000, 'b');
+    while (buffer.GetReadableSize() + chunk.size() <= 1000000)
+    {
+        buffer.Append(chunk.data(), chunk.size());
+    }
+    EXPECT_EQ(buffer.GetCapacity(), capacity);
+    EXPECT_EQ(std::string(buffer.GetReadPtr(), 4), "head");
+
+    // 大容量的缓冲区在数据消费完后释放
+    buffer.Reserve(2 * mrpc::InputBuffer::kMaxIdleCapacity);
+    buffer.Consume(buffer.GetReadableSize());
+    EXPECT_EQ(buffer.GetCapacity(), 0u);
+}
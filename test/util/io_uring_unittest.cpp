@@ -0,0 +1,103 @@
+#include <gtest/gtest.h>
+#include <cstring>
+#include <linux/io_uring.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <mrpc/util/io_uring.h>
+
+class IoUringTest : public testing::Test
+{
+protected:
+    void SetUp() override
+    {
+        if (!mrpc::IoUring::IsSupported())
+        {
+            GTEST_SKIP() << "io_uring is not supported";
+        }
+        ASSERT_EQ(ring.Initialize(8), 0);
+    }
+
+    struct io_uring_cqe* Wait()
+    {
+        struct io_uring_cqe* cqe = nullptr;
+        while (ring.PeekCqes(&cqe, 1) == 0)
+        {
+            int ret = ring.Submit(1, 1000);
+            if (ret == -ETIME) return nullptr;
+        }
+        return cqe;
+    }
+
+    mrpc::IoUring ring;
+};
+
+TEST_F(IoUringTest, Nop)
+{
+    for (uint64_t i = 1; i <= 3; ++i)
+    {
+        struct io_uring_sqe* sqe = ring.GetSqe();
+        ASSERT_NE(sqe, nullptr);
+        sqe->opcode = IORING_OP_NOP;
+        sqe->user_data = i;
+    }
+    EXPECT_EQ(ring.Submit(), 3);
+
+    for (uint64_t i = 1; i <= 3; ++i)
+    {
+        struct io_uring_cqe* cqe = Wait();
+        ASSERT_NE(cqe, nullptr);
+        EXPECT_EQ(cqe->user_data, i);
+        EXPECT_EQ(cqe->res, 0);
+        ring.AdvanceCq(1);
+    }
+
+    // 超时
+    EXPECT_EQ(ring.Submit(1, 10), -ETIME);
+}
+
+TEST_F(IoUringTest, ProvidedBuffer)
+{
+    ASSERT_EQ(ring.RegisterBufferRing(1, 2, 16), 0);
+    EXPECT_EQ(ring.GetBufferGroupId(), 1);
+    EXPECT_EQ(ring.GetBufferSize(), 16u);
+
+    int fds[2] = { -1, -1 };
+    ASSERT_EQ(socketpair(AF_UNIX, SOCK_STREAM, 0, fds), 0);
+
+    // multishot recv, 由内核选择缓冲区
+    struct io_uring_sqe* sqe = ring.GetSqe();
+    ASSERT_NE(sqe, nullptr);
+    sqe->opcode = IORING_OP_RECV;
+    sqe->fd = fds[1];
+    sqe->ioprio = IORING_RECV_MULTISHOT;
+    sqe->flags = IOSQE_BUFFER_SELECT;
+    sqe->buf_group = ring.GetBufferGroupId();
+    sqe->user_data = 42;
+    ASSERT_EQ(ring.Submit(), 1);
+
+    for (int i = 0; i < 4; ++i)
+    {
+        std::string data = "hello" + std::to_string(i);
+        ASSERT_EQ(write(fds[0], data.data(), data.length()), (ssize_t)data.length());
+
+        struct io_uring_cqe* cqe = Wait();
+        ASSERT_NE(cqe, nullptr);
+        EXPECT_EQ(cqe->user_data, 42u);
+        ASSERT_EQ(cqe->res, (int)data.length());
+        ASSERT_TRUE(cqe->flags & IORING_CQE_F_BUFFER);
+        EXPECT_TRUE(cqe->flags & IORING_CQE_F_MORE);
+        uint16_t buffer_id = cqe->flags >> IORING_CQE_BUFFER_SHIFT;
+        EXPECT_EQ(std::string(ring.GetBuffer(buffer_id), cqe->res), data);
+        ring.AdvanceCq(1);
+        // 只有两个缓冲区, 不归还就会ENOBUFS
+        ring.RecycleBuffer(buffer_id);
+    }
+
+    close(fds[0]);
+    struct io_uring_cqe* cqe = Wait();
+    ASSERT_NE(cqe, nullptr);
+    EXPECT_EQ(cqe->res, 0);
+    EXPECT_FALSE(cqe->flags & IORING_CQE_F_MORE);
+    ring.AdvanceCq(1);
+    close(fds[1]);
+}
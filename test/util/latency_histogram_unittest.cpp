@@ -0,0 +1,60 @@
+#include <gtest/gtest.h>
+#include <mrpc/util/latency_histogram.h>
+
+TEST(LatencyHistogram, Percentile)
+{
+    mrpc::LatencyHistogram histogram;
+    for (uint64_t i = 1; i < mrpc::LatencyHistogram::kMinSamples; ++i)
+    {
+        histogram.Add(1000);
+    }
+    EXPECT_EQ(histogram.GetPercentile(95), 0u);
+
+    // 90个1ms, 10个100ms
+    mrpc::LatencyHistogram mixed;
+    for (int i = 0; i < 90; ++i)
+    {
+        mixed.Add(1000);
+    }
+    for (int i = 0; i < 10; ++i)
+    {
+        mixed.Add(100000);
+    }
+    uint64_t p50 = mixed.GetPercentile(50);
+    EXPECT_GE(p50, 1000u);
+    EXPECT_LT(p50, 1250u);
+    EXPECT_LT(mixed.GetPercentile(90), 1250u);
+    uint64_t p95 = mixed.GetPercentile(95);
+    EXPECT_GE(p95, 100000u);
+    EXPECT_LT(p95, 125000u);
+    EXPECT_EQ(mixed.GetPercentile(100), p95);
+}
+
+TEST(LatencyHistogram, Bounds)
+{
+    mrpc::LatencyHistogram histogram;
+    for (uint64_t i = 0; i < 4 * mrpc::LatencyHistogram::kMinSamples; ++i)
+    {
+        histogram.Add(i < 2 * mrpc::LatencyHistogram::kMinSamples ? 0 : UINT64_MAX);
+    }
+    EXPECT_EQ(histogram.GetPercentile(50), 0u);
+    EXPECT_GE(histogram.GetPercentile(99), UINT32_MAX);
+}
+
+TEST(LatencyHistogram, Decay)
+{
+    mrpc::LatencyHistogram histogram;
+    for (uint32_t i = 0; i < mrpc::LatencyHistogram::kMaxSamples; ++i)
+    {
+        histogram.Add(100000);
+    }
+    EXPECT_EQ(histogram.GetSampleNum(), mrpc::LatencyHistogram::kMaxSamples / 2);
+
+    // 耗时下降后, 旧样本逐渐被淘汰
+    for (uint32_t i = 0; i < 4 * mrpc::LatencyHistogram::kMaxSamples; ++i)
+    {
+        histogram.Add(1000);
+    }
+    EXPECT_LT(histogram.GetSampleNum(), mrpc::LatencyHistogram::kMaxSamples);
+    EXPECT_LT(histogram.GetPercentile(95), 1250u);
+}
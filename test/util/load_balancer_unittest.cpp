@@ -0,0 +1,155 @@
+#include <map>
+#include <gtest/gtest.h>
+#include <mrpc/util/load_balancer.h>
+
+static const std::vector<std::pair<std::string, uint32_t>> kBackends = { { "a", 100 }, { "b", 100 }, { "c", 100 } };
+
+TEST(LoadBalancer, RoundRobin)
+{
+    auto balancer = mrpc::LoadBalancer::Create(mrpc::LB_ROUND_ROBIN, kBackends);
+    for (uint32_t i = 0; i < 6; ++i)
+    {
+        EXPECT_EQ(balancer->Select(false, 0), i % 3);
+    }
+}
+
+TEST(LoadBalancer, Weighted)
+{
+    auto balancer = mrpc::LoadBalancer::Create(mrpc::LB_WEIGHTED, { { "a", 300 }, { "b", 100 } });
+    uint32_t count[2] = { 0, 0 };
+    for (int i = 0; i < 4000; ++i)
+    {
+        ++count[balancer->Select(false, 0)];
+    }
+    EXPECT_GT(count[0], 2 * count[1]);
+
+    // 失败率高的后端权重降低, 但仍有请求用于探测
+    for (int i = 0; i < 64; ++i)
+    {
+        balancer->OnRequestStart(0);
+        balancer->OnRequestDone(0, false, 0);
+    }
+    count[0] = count[1] = 0;
+    for (int i = 0; i < 4000; ++i)
+    {
+        ++count[balancer->Select(false, 0)];
+    }
+    EXPECT_GT(count[1], count[0]);
+    EXPECT_GT(count[0], 0u);
+}
+
+TEST(LoadBalancer, LeastPending)
+{
+    auto balancer = mrpc::LoadBalancer::Create(mrpc::LB_LEAST_PENDING, kBackends);
+    balancer->OnRequestStart(0);
+    balancer->OnRequestStart(2);
+    for (int i = 0; i < 3; ++i)
+    {
+        EXPECT_EQ(balancer->Select(false, 0), 1u);
+    }
+
+    balancer->OnRequestStart(1);
+    balancer->OnRequestStart(1);
+    balancer->OnRequestDone(2, true, 100);
+    EXPECT_EQ(balancer->Select(false, 0), 2u);
+    EXPECT_EQ(balancer->GetBackend(1).pending.load(), 2u);
+}
+
+TEST(LoadBalancer, PowerOfTwoChoices)
+{
+    auto balancer = mrpc::LoadBalancer::Create(mrpc::LB_POWER_OF_TWO_CHOICES, kBackends);
+    // 慢的后端只有在两次都随机到它时才会被选中
+    for (uint32_t i = 0; i < 3; ++i)
+    {
+        balancer->OnRequestStart(i);
+        balancer->OnRequestDone(i, true, i == 0 ? 100000 : 100);
+    }
+    EXPECT_EQ(balancer->GetBackend(0).latency.load(), 100000u);
+    for (int i = 0; i < 100; ++i)
+    {
+        EXPECT_NE(balancer->Select(false, 0), 0u);
+    }
+}
+
+TEST(LoadBalancer, ConsistentHash)
+{
+    auto balancer = mrpc::LoadBalancer::Create(mrpc::LB_CONSISTENT_HASH, kBackends);
+    std::map<uint32_t, uint32_t> mapping;
+    uint32_t count[3] = { 0, 0, 0 };
+    for (uint32_t code = 0; code < 3000; ++code)
+    {
+        mapping[code] = balancer->Select(true, code);
+        EXPECT_EQ(balancer->Select(true, code), mapping[code]);
+        ++count[mapping[code]];
+    }
+    for (uint32_t n : count)
+    {
+        EXPECT_GT(n, 700u);
+    }
+
+    // 减少一个后端时, 其它后端上的key不受影响
+    auto smaller = mrpc::LoadBalancer::Create(mrpc::LB_CONSISTENT_HASH, { { "a", 100 }, { "b", 100 } });
+    for (auto& [code, index] : mapping)
+    {
+        if (index != 2)
+        {
+            EXPECT_EQ(smaller->Select(true, code), index);
+        }
+    }
+
+    // 失败率过半的后端由哈希环上的下一个后端代替
+    for (int i = 0; i < 16; ++i)
+    {
+        balancer->OnRequestStart(0);
+        balancer->OnRequestDone(0, false, 0);
+    }
+    for (auto& [code, index] : mapping)
+    {
+        uint32_t selected = balancer->Select(true, code);
+        EXPECT_NE(selected, 0u);
+        if (index != 0)
+        {
+            EXPECT_EQ(selected, index);
+        }
+    }
+}
+
+TEST(LoadBalancer, SelectOther)
+{
+    auto balancer = mrpc::LoadBalancer::Create(mrpc::LB_ROUND_ROBIN, kBackends);
+    EXPECT_EQ(balancer->SelectOther(0), 1u);
+    EXPECT_EQ(balancer->SelectOther(2), 0u);
+
+    // 跳过失败率高和未完成请求多的后端, 不影响轮询
+    for (int i = 0; i < 16; ++i)
+    {
+        balancer->OnRequestStart(1);
+        balancer->OnRequestDone(1, false, 0);
+    }
+    EXPECT_EQ(balancer->SelectOther(0), 2u);
+    balancer->OnRequestStart(2);
+    balancer->OnRequestStart(2);
+    EXPECT_EQ(balancer->SelectOther(1), 0u);
+    EXPECT_EQ(balancer->Select(false, 0), 0u);
+
+    auto single = mrpc::LoadBalancer::Create(mrpc::LB_ROUND_ROBIN, { { "a", 100 } });
+    EXPECT_EQ(single->SelectOther(0), 0u);
+}
+
+TEST(LoadBalancer, ErrorRateRecovery)
+{
+    auto balancer = mrpc::LoadBalancer::Create(mrpc::LB_ROUND_ROBIN, kBackends);
+    for (int i = 0; i < 64; ++i)
+    {
+        balancer->OnRequestStart(0);
+        balancer->OnRequestDone(0, false, 0);
+    }
+    EXPECT_EQ(balancer->GetBackend(0).error_rate.load(), mrpc::LoadBalancer::kErrorRateScale);
+    for (int i = 0; i < 64; ++i)
+    {
+        balancer->OnRequestStart(0);
+        balancer->OnRequestDone(0, true, 0);
+    }
+    EXPECT_EQ(balancer->GetBackend(0).error_rate.load(), 0u);
+    EXPECT_EQ(balancer->GetBackend(0).pending.load(), 0u);
+}
@@ -0,0 +1,107 @@
+#include <thread>
+#include <vector>
+#include <gtest/gtest.h>
+#include <mrpc/util/mpsc_queue.h>
+
+TEST(MpscQueue, Order)
+{
+    mrpc::MpscQueue<int> queue;
+    int value = 0;
+    EXPECT_FALSE(queue.TryPop(value));
+
+    EXPECT_TRUE(queue.Push(1));     // 从空变为非空
+    EXPECT_FALSE(queue.Push(2));
+    EXPECT_FALSE(queue.Push(3));
+
+    EXPECT_TRUE(queue.TryPop(value));
+    EXPECT_EQ(value, 1);
+    // 已经取走的一批之外的新元素需要重新唤醒
+    EXPECT_TRUE(queue.Push(4));
+    for (int expected : { 2, 3, 4 })
+    {
+        EXPECT_TRUE(queue.TryPop(value));
+        EXPECT_EQ(value, expected);
+    }
+    EXPECT_FALSE(queue.TryPop(value));
+    EXPECT_TRUE(queue.Push(5));
+}
+
+TEST(MpscQueue, PushBatch)
+{
+    mrpc::MpscQueue<int> queue;
+    std::vector<int> batch = { 2, 3, 4 };
+    EXPECT_FALSE(queue.PushBatch(batch.begin(), batch.begin()));
+    EXPECT_TRUE(queue.Push(1));
+    EXPECT_FALSE(queue.PushBatch(batch.begin(), batch.end()));
+    EXPECT_FALSE(queue.Push(5));
+
+    int value = 0;
+    for (int expected : { 1, 2, 3, 4, 5 })
+    {
+        EXPECT_TRUE(queue.TryPop(value));
+        EXPECT_EQ(value, expected);
+    }
+    EXPECT_FALSE(queue.TryPop(value));
+    EXPECT_TRUE(queue.PushBatch(batch.begin(), batch.end()));
+}
+
+TEST(MpscQueue, MultiProducer)
+{
+    constexpr int kThreadNum = 4;
+    constexpr int kPushNum = 10000;
+    mrpc::MpscQueue<int> queue;
+    std::atomic<int> wakeups = 0;
+
+    std::vector<std::thread> threads;
+    for (int t = 0; t < kThreadNum; ++t)
+    {
+        threads.emplace_back([&, t]()
+        {
+            for (int i = 0; i < kPushNum; ++i)
+            {
+                if (queue.Push(t * kPushNum + i))
+                {
+                    ++wakeups;
+                }
+            }
+        });
+    }
+
+    // 每个生产者的元素保持入队顺序
+    std::vector<int> last(kThreadNum, -1);
+    int popped = 0;
+    int value = 0;
+    while (popped < kThreadNum * kPushNum)
+    {
+        if (!queue.TryPop(value))
+        {
+            std::this_thread::yield();
+            continue;
+        }
+        int t = value / kPushNum;
+        EXPECT_GT(value % kPushNum, last[t]);
+        last[t] = value % kPushNum;
+        ++popped;
+    }
+    for (auto& thread : threads)
+    {
+        thread.join();
+    }
+    EXPECT_FALSE(queue.TryPop(value));
+    EXPECT_GE(wakeups.load(), 1);
+}
+
+TEST(MpscQueue, Destroy)
+{
+    auto value = std::make_shared<int>(1);
+    {
+        mrpc::MpscQueue<std::shared_ptr<int>> queue;
+        queue.Push(value);
+        queue.Push(value);
+        std::shared_ptr<int> popped;
+        EXPECT_TRUE(queue.TryPop(popped));
+        EXPECT_EQ(value.use_count(), 3);
+    }
+    // 析构时释放队列中剩下的元素
+    EXPECT_EQ(value.use_count(), 1);
+}
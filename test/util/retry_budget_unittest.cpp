@@ -0,0 +1,38 @@
+#include <gtest/gtest.h>
+#include <mrpc/util/retry_budget.h>
+
+TEST(RetryBudget, Burst)
+{
+    mrpc::RetryBudget budget(10, 3);
+    for (int i = 0; i < 3; ++i)
+    {
+        EXPECT_TRUE(budget.TryAcquire());
+    }
+    EXPECT_FALSE(budget.TryAcquire());
+    EXPECT_EQ(budget.GetBalance(), 0u);
+}
+
+TEST(RetryBudget, Ratio)
+{
+    mrpc::RetryBudget budget(10, 1);
+    EXPECT_TRUE(budget.TryAcquire());
+
+    // 每10个请求允许1次重试
+    uint32_t retries = 0;
+    for (int i = 0; i < 1000; ++i)
+    {
+        budget.OnRequest();
+        if (budget.TryAcquire())
+        {
+            ++retries;
+        }
+    }
+    EXPECT_EQ(retries, 100u);
+
+    // 令牌不超过上限
+    for (int i = 0; i < 1000; ++i)
+    {
+        budget.OnRequest();
+    }
+    EXPECT_EQ(budget.GetBalance(), 100u);
+}
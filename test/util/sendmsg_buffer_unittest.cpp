@@ -0,0 +1,150 @@
+#include <gtest/gtest.h>
+#include <cerrno>
+#include <climits>
+#include <linux/io_uring.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <mrpc/util/io_uring.h>
+#include <mrpc/util/sendmsg_buffer.h>
+
+static std::string GetIovData(const struct msghdr* msg)
+{
+    std::string data;
+    for (size_t i = 0; i < msg->msg_iovlen; ++i)
+    {
+        data.append((const char*)msg->msg_iov[i].iov_base, msg->msg_iov[i].iov_len);
+    }
+    return data;
+}
+
+TEST(SendmsgBuffer, Advance)
+{
+    mrpc::SendmsgBuffer buffer;
+    EXPECT_FALSE(buffer.Prepare());
+
+    buffer.Append("abc");
+    buffer.Append("de");
+    buffer.Append("fghi");
+    EXPECT_TRUE(buffer.HasPending());
+    ASSERT_TRUE(buffer.Prepare());
+    EXPECT_TRUE(buffer.IsSending());
+    EXPECT_FALSE(buffer.HasPending());
+    EXPECT_EQ(buffer.GetMsg()->msg_iovlen, 3u);
+    EXPECT_EQ(GetIovData(buffer.GetMsg()), "abcdefghi");
+
+    // 发送期间追加的数据等下一个sendmsg
+    buffer.Append("jk");
+    EXPECT_FALSE(buffer.Prepare());
+    EXPECT_EQ(buffer.GetBytes(), 11u);
+
+    // 部分发送, 包括停在iovec中间和正好停在边界上
+    ASSERT_TRUE(buffer.Advance(4));
+    EXPECT_EQ(GetIovData(buffer.GetMsg()), "efghi");
+    EXPECT_EQ(buffer.GetBytes(), 7u);
+    ASSERT_TRUE(buffer.Advance(1));
+    EXPECT_EQ(buffer.GetMsg()->msg_iovlen, 1u);
+    EXPECT_EQ(GetIovData(buffer.GetMsg()), "fghi");
+    EXPECT_FALSE(buffer.Advance(4));
+    EXPECT_FALSE(buffer.IsSending());
+
+    ASSERT_TRUE(buffer.Prepare());
+    EXPECT_EQ(GetIovData(buffer.GetMsg()), "jk");
+    buffer.Clear();
+    EXPECT_EQ(buffer.GetBytes(), 0u);
+    EXPECT_FALSE(buffer.IsSending());
+    EXPECT_FALSE(buffer.Prepare());
+}
+
+TEST(SendmsgBuffer, IovMax)
+{
+    // 一次sendmsg最多IOV_MAX个iovec, 剩下的在发送完之后继续
+    mrpc::SendmsgBuffer buffer;
+    for (int i = 0; i < IOV_MAX + 10; ++i)
+    {
+        buffer.Append("x");
+    }
+    ASSERT_TRUE(buffer.Prepare());
+    EXPECT_EQ(buffer.GetMsg()->msg_iovlen, (size_t)IOV_MAX);
+    ASSERT_TRUE(buffer.Advance(IOV_MAX));
+    EXPECT_EQ(buffer.GetMsg()->msg_iovlen, 10u);
+    EXPECT_EQ(buffer.GetBytes(), 10u);
+    EXPECT_FALSE(buffer.Advance(10));
+}
+
+TEST(SendmsgBuffer, PartialSendmsg)
+{
+    if (!mrpc::IoUring::IsSupported())
+    {
+        GTEST_SKIP() << "io_uring is not supported";
+    }
+    mrpc::IoUring ring;
+    ASSERT_EQ(ring.Initialize(8), 0);
+
+    int fds[2] = { -1, -1 };
+    ASSERT_EQ(socketpair(AF_UNIX, SOCK_STREAM, 0, fds), 0);
+    int size = 4096;
+    ASSERT_EQ(setsockopt(fds[0], SOL_SOCKET, SO_SNDBUF, &size, sizeof(size)), 0);
+
+    // 远大于发送缓冲区, sendmsg每次只能发送一部分
+    mrpc::SendmsgBuffer buffer;
+    std::string expected;
+    for (int i = 0; i < 64; ++i)
+    {
+        std::string data(4000 + i, 'a' + i % 26);
+        expected += data;
+        buffer.Append(std::move(data));
+    }
+    ASSERT_TRUE(buffer.Prepare());
+
+    std::string received;
+    int partial = 0;
+    bool sending = true;
+    while (sending)
+    {
+        struct io_uring_sqe* sqe = ring.GetSqe();
+        ASSERT_NE(sqe, nullptr);
+        sqe->opcode = IORING_OP_SENDMSG;
+        sqe->fd = fds[0];
+        sqe->addr = (uint64_t)(uintptr_t)buffer.GetMsg();
+        sqe->len = 1;
+        sqe->msg_flags = MSG_NOSIGNAL;
+        ASSERT_EQ(ring.Submit(), 1);
+
+        // 读走对端的数据, 让阻塞在发送缓冲区上的sendmsg完成
+        struct io_uring_cqe* cqe = nullptr;
+        while (ring.PeekCqes(&cqe, 1) == 0)
+        {
+            char buf[65536];
+            ssize_t n = recv(fds[1], buf, sizeof(buf), MSG_DONTWAIT);
+            if (n > 0)
+            {
+                received.append(buf, n);
+            }
+            else
+            {
+                ring.Submit(1, 10);
+            }
+        }
+        ASSERT_GT(cqe->res, 0);
+        size_t written = cqe->res;
+        ring.AdvanceCq(1);
+
+        sending = buffer.Advance(written);
+        if (sending)
+        {
+            ++partial;
+        }
+    }
+    EXPECT_GT(partial, 0);
+    EXPECT_FALSE(buffer.IsSending());
+
+    close(fds[0]);
+    char buf[65536];
+    ssize_t n = 0;
+    while ((n = recv(fds[1], buf, sizeof(buf), 0)) > 0)
+    {
+        received.append(buf, n);
+    }
+    EXPECT_EQ(received, expected);
+    close(fds[1]);
+}
@@ -0,0 +1,145 @@
+#include <gtest/gtest.h>
+#include <cerrno>
+#include <thread>
+#include <fcntl.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <mrpc/util/input_buffer.h>
+#include <mrpc/util/shm_channel.h>
+
+static bool HasEvent(int event_fd)
+{
+    uint64_t value = 0;
+    return read(event_fd, &value, sizeof(value)) == sizeof(value);
+}
+
+class ShmChannelTest : public testing::Test
+{
+protected:
+    void SetUp() override
+    {
+        ASSERT_EQ(socketpair(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK, 0, fds_), 0);
+
+        // 对端发送之前没有数据可读
+        EXPECT_EQ(client_.ReceiveFrom(fds_[1]), EAGAIN);
+
+        ASSERT_TRUE(server_.Create(100));
+        EXPECT_EQ(server_.GetRingSize(), 4096u);
+        ASSERT_TRUE(server_.SendTo(fds_[0]));
+        ASSERT_EQ(client_.ReceiveFrom(fds_[1]), 0);
+        EXPECT_EQ(client_.GetRingSize(), server_.GetRingSize());
+    }
+
+    void TearDown() override
+    {
+        close(fds_[0]);
+        close(fds_[1]);
+    }
+
+    int fds_[2] = { -1, -1 };
+    mrpc::ShmChannel server_;
+    mrpc::ShmChannel client_;
+};
+
+TEST_F(ShmChannelTest, ReadWrite)
+{
+    mrpc::InputBuffer buffer;
+    EXPECT_EQ(server_.Read(buffer), 0u);
+
+    EXPECT_EQ(client_.Write("hello", 5), 5u);
+    EXPECT_EQ(client_.Write(" world", 6), 6u);
+    // 连续写入只唤醒一次
+    EXPECT_TRUE(HasEvent(server_.GetEventFd()));
+    EXPECT_FALSE(HasEvent(server_.GetEventFd()));
+
+    EXPECT_EQ(server_.Read(buffer), 11u);
+    EXPECT_EQ(std::string(buffer.GetReadPtr(), buffer.GetReadableSize()), "hello world");
+    buffer.Clear();
+
+    EXPECT_EQ(server_.Write("response", 8), 8u);
+    EXPECT_TRUE(HasEvent(client_.GetEventFd()));
+    EXPECT_EQ(client_.Read(buffer), 8u);
+    EXPECT_EQ(std::string(buffer.GetReadPtr(), buffer.GetReadableSize()), "response");
+}
+
+TEST_F(ShmChannelTest, Full)
+{
+    mrpc::InputBuffer buffer;
+    std::string data(10000, 'a');
+    for (size_t i = 0; i < data.size(); ++i)
+    {
+        data[i] = 'a' + i % 26;
+    }
+
+    // 写满后等待对端读取, 对端读取后唤醒本端
+    size_t written = client_.Write(data.data(), data.size());
+    EXPECT_EQ(written, client_.GetRingSize());
+    EXPECT_TRUE(HasEvent(server_.GetEventFd()));
+    EXPECT_EQ(client_.Write(data.data() + written, data.size() - written), 0u);
+    EXPECT_FALSE(HasEvent(client_.GetEventFd()));
+
+    EXPECT_EQ(server_.Read(buffer), written);
+    EXPECT_TRUE(HasEvent(client_.GetEventFd()));
+
+    // 写入的数据跨过环的尾部
+    while (written < data.size())
+    {
+        written += client_.Write(data.data() + written, data.size() - written);
+        server_.Read(buffer);
+    }
+    EXPECT_EQ(std::string(buffer.GetReadPtr(), buffer.GetReadableSize()), data);
+}
+
+TEST_F(ShmChannelTest, Thread)
+{
+    std::string data(1024 * 1024, 0);
+    for (size_t i = 0; i < data.size(); ++i)
+    {
+        data[i] = (char)(i * 7 + i / 4096);
+    }
+
+    std::thread producer([&]()
+    {
+        size_t written = 0;
+        while (written < data.size())
+        {
+            size_t length = client_.Write(data.data() + written, std::min<size_t>(1000, data.size() - written));
+            if (length == 0)
+            {
+                std::this_thread::yield();
+            }
+            written += length;
+        }
+    });
+
+    mrpc::InputBuffer buffer;
+    std::string received;
+    while (received.size() < data.size())
+    {
+        if (server_.Read(buffer) == 0)
+        {
+            std::this_thread::yield();
+        }
+        received.append(buffer.GetReadPtr(), buffer.GetReadableSize());
+        buffer.Consume(buffer.GetReadableSize());
+    }
+    producer.join();
+    EXPECT_TRUE(received == data);
+}
+
+TEST(ShmChannel, InvalidPeer)
+{
+    int fds[2] = { -1, -1 };
+    ASSERT_EQ(socketpair(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK, 0, fds), 0);
+
+    // 没有附带fd
+    mrpc::ShmChannel client;
+    ASSERT_EQ(write(fds[0], "x", 1), 1);
+    EXPECT_EQ(client.ReceiveFrom(fds[1]), EPROTO);
+    EXPECT_FALSE(client.IsOpen());
+
+    close(fds[0]);
+    mrpc::ShmChannel closed;
+    EXPECT_EQ(closed.ReceiveFrom(fds[1]), ECONNRESET);
+    close(fds[1]);
+}
@@ -0,0 +1,100 @@
+#include <coroutine>
+#include <stdexcept>
+#include <vector>
+#include <gtest/gtest.h>
+#include <mrpc/util/task.h>
+
+// 手动恢复的等待对象, 模拟回包到达
+struct ManualEvent
+{
+    std::vector<std::coroutine_handle<>> waiters;
+
+    auto Wait()
+    {
+        struct Awaiter
+        {
+            ManualEvent& event;
+            bool await_ready() const noexcept { return false; }
+            void await_suspend(std::coroutine_handle<> handle) { event.waiters.push_back(handle); }
+            void await_resume() const noexcept {}
+        };
+        return Awaiter{ *this };
+    }
+
+    void Resume()
+    {
+        std::vector<std::coroutine_handle<>> waiters;
+        waiters.swap(this->waiters);
+        for (auto handle : waiters)
+        {
+            handle.resume();
+        }
+    }
+};
+
+static mrpc::Task<int> Add(ManualEvent& event, int a, int b)
+{
+    co_await event.Wait();
+    co_return a + b;
+}
+
+static mrpc::Task<> Sum(ManualEvent& event, int& result)
+{
+    int x = co_await Add(event, 1, 2);
+    int y = co_await Add(event, x, 3);
+    result = y;
+}
+
+TEST(Task, Spawn)
+{
+    ManualEvent event;
+    int result = 0;
+    mrpc::Spawn(Sum(event, result));
+    EXPECT_EQ(event.waiters.size(), 1u);
+
+    event.Resume();
+    EXPECT_EQ(result, 0);
+    EXPECT_EQ(event.waiters.size(), 1u);
+
+    event.Resume();
+    EXPECT_EQ(result, 6);
+    EXPECT_TRUE(event.waiters.empty());
+}
+
+TEST(Task, Lazy)
+{
+    ManualEvent event;
+    int result = 0;
+    {
+        mrpc::Task<> task = Sum(event, result);
+        EXPECT_FALSE(task.Done());
+        EXPECT_TRUE(event.waiters.empty());
+    }
+    // 没有启动的协程随Task析构
+    EXPECT_EQ(result, 0);
+}
+
+static mrpc::Task<int> Throw()
+{
+    throw std::runtime_error("error");
+    co_return 0;
+}
+
+static mrpc::Task<> Catch(bool& caught)
+{
+    try
+    {
+        co_await Throw();
+    }
+    catch (const std::runtime_error&)
+    {
+        caught = true;
+    }
+}
+
+TEST(Task, Exception)
+{
+    bool caught = false;
+    mrpc::Spawn(Catch(caught));
+    EXPECT_TRUE(caught);
+}
@@ -0,0 +1,69 @@
+#include <algorithm>
+#include <gtest/gtest.h>
+#include <mrpc/util/timer_wheel.h>
+
+TEST(TimerWheel, Expire)
+{
+    mrpc::TimerWheel wheel(1000, 10, 8);
+    wheel.Add(1, 1050);
+    wheel.Add(2, 1100);
+    wheel.Add(3, 500);  // 已过期
+    EXPECT_EQ(wheel.Size(), 3u);
+
+    std::vector<uint64_t> expired;
+    wheel.Advance(1005, expired);
+    EXPECT_TRUE(expired.empty());
+
+    wheel.Advance(1010, expired);
+    EXPECT_EQ(expired, std::vector<uint64_t>({ 3 }));
+
+    expired.clear();
+    wheel.Advance(1060, expired);
+    EXPECT_EQ(expired, std::vector<uint64_t>({ 1 }));
+
+    expired.clear();
+    wheel.Advance(1100, expired);
+    EXPECT_EQ(expired, std::vector<uint64_t>({ 2 }));
+    EXPECT_TRUE(wheel.Empty());
+}
+
+TEST(TimerWheel, Rounds)
+{
+    // 一圈为80, 超出一圈的定时器要等到对应轮次才到期
+    mrpc::TimerWheel wheel(0, 10, 8);
+    wheel.Add(1, 250);
+    wheel.Add(2, 90);
+
+    std::vector<uint64_t> expired;
+    for (uint64_t now = 0; now < 250; now += 10)
+    {
+        wheel.Advance(now, expired);
+        if (now < 90)
+        {
+            EXPECT_TRUE(expired.empty());
+        }
+    }
+    EXPECT_EQ(expired, std::vector<uint64_t>({ 2 }));
+
+    wheel.Advance(250, expired);
+    EXPECT_EQ(expired, std::vector<uint64_t>({ 2, 1 }));
+}
+
+TEST(TimerWheel, Jump)
+{
+    // 一次推进超过一圈
+    mrpc::TimerWheel wheel(0, 10, 8);
+    for (uint64_t i = 0; i < 100; ++i)
+    {
+        wheel.Add(i, i * 10);
+    }
+
+    std::vector<uint64_t> expired;
+    wheel.Advance(495, expired);
+    EXPECT_EQ(expired.size(), 50u);
+    EXPECT_EQ(wheel.Size(), 50u);
+
+    std::sort(expired.begin(), expired.end());
+    EXPECT_EQ(expired.front(), 0u);
+    EXPECT_EQ(expired.back(), 49u);
+}